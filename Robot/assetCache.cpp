@@ -0,0 +1,259 @@
+#include "assetCache.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//FNV-1a, 64 bits so distinct sources practically never share an entry
+	uint64_t ContentHash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool IsDDS(const wstring& path)
+	{
+		const wstring ext{ L".dds" };
+		return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+	}
+
+	//Layout of the DDS headers, see DDSTextureLoader.cpp
+	struct DDSPixelFormat
+	{
+		uint32_t size, flags, fourCC, rgbBitCount, rMask, gMask, bMask, aMask;
+	};
+
+	struct DDSHeader
+	{
+		uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount, reserved1[11];
+		DDSPixelFormat format;
+		uint32_t caps, caps2, caps3, caps4, reserved2;
+	};
+	static_assert(sizeof(DDSHeader) == 124, "DDSHeader is written to disk as is");
+
+	struct DDSHeaderDX10
+	{
+		uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+	};
+
+	const uint32_t DDS_MAGIC = 0x20534444;	//"DDS "
+	const size_t DDS_HEADERS_SIZE = sizeof(DDS_MAGIC) + sizeof(DDSHeader) + sizeof(DDSHeaderDX10);
+	const uint32_t ENTRY_TAG = 0x494e494d;	//"MINI"
+
+	//Texture entries keep the size and the hash of their pixels in the reserved header fields,
+	//which the DDS loaders skip: tag, size, hash low and high bits
+	void SealEntry(vector<BYTE>& dds)
+	{
+		DDSHeader header;
+		memcpy(&header, dds.data() + sizeof(DDS_MAGIC), sizeof(header));
+		auto hash = ContentHash(dds.data() + DDS_HEADERS_SIZE, dds.size() - DDS_HEADERS_SIZE);
+		header.reserved1[0] = ENTRY_TAG;
+		header.reserved1[1] = static_cast<uint32_t>(dds.size() - DDS_HEADERS_SIZE);
+		header.reserved1[2] = static_cast<uint32_t>(hash);
+		header.reserved1[3] = static_cast<uint32_t>(hash >> 32);
+		memcpy(dds.data() + sizeof(DDS_MAGIC), &header, sizeof(header));
+	}
+
+	bool IsIntactEntry(const MappedFile& file)
+	{
+		if (file.size() < DDS_HEADERS_SIZE)
+			return false;
+		DDSHeader header;
+		memcpy(&header, file.data() + sizeof(DDS_MAGIC), sizeof(header));
+		if (header.reserved1[0] != ENTRY_TAG || header.reserved1[1] != file.size() - DDS_HEADERS_SIZE)
+			return false;
+		auto hash = ContentHash(file.data() + DDS_HEADERS_SIZE, file.size() - DDS_HEADERS_SIZE);
+		return header.reserved1[2] == static_cast<uint32_t>(hash) && header.reserved1[3] == static_cast<uint32_t>(hash >> 32);
+	}
+
+	//Sizes of the uncompressed formats the WIC loader creates
+	UINT BytesPerPixel(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return 16;
+		case DXGI_FORMAT_R32G32B32_FLOAT:
+			return 12;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			return 8;
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_R10G10B10A2_UNORM:
+		case DXGI_FORMAT_R32_FLOAT:
+			return 4;
+		case DXGI_FORMAT_B5G6R5_UNORM:
+		case DXGI_FORMAT_B5G5R5A1_UNORM:
+		case DXGI_FORMAT_R16_UNORM:
+		case DXGI_FORMAT_R16_FLOAT:
+			return 2;
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+			return 1;
+		default:
+			return 0;
+		}
+	}
+}
+
+AssetCache::AssetCache(wstring directory)
+	: m_directory(move(directory))
+{
+	if (m_directory.empty())
+		return;
+	error_code error;
+	filesystem::create_directories(m_directory, error);
+	//without the directory every lookup would miss and every store fail
+	if (error)
+		m_directory.clear();
+}
+
+wstring AssetCache::EntryPath(const MappedFile& source, const wstring& options, const wstring& extension) const
+{
+	auto hash = ContentHash(&VERSION, sizeof(VERSION));
+	hash = ContentHash(options.data(), options.size() * sizeof(wchar_t), hash);
+	hash = ContentHash(source.data(), source.size(), hash);
+	wchar_t name[17];
+	swprintf(name, 17, L"%016llx", static_cast<unsigned long long>(hash));
+	return (filesystem::path(m_directory) / name).wstring() + extension;
+}
+
+optional<MappedFile> AssetCache::Find(const wstring& entryPath)
+{
+	error_code error;
+	if (!filesystem::is_regular_file(entryPath, error))
+	{
+		++m_misses;
+		return nullopt;
+	}
+	++m_hits;
+	return MappedFile(entryPath);
+}
+
+bool AssetCache::Store(const wstring& entryPath, const function<void(const wstring&)>& write)
+{
+	auto temp = entryPath + L".tmp";
+	error_code error;
+	try
+	{
+		write(temp);
+		filesystem::rename(temp, entryPath, error);
+	}
+	catch (const Exception&)
+	{
+		error = make_error_code(errc::io_error);
+	}
+	if (!error)
+		return true;
+	filesystem::remove(temp, error);
+	return false;
+}
+
+TextureFile mini::ReadTexture(AssetCache& cache, const wstring& path)
+{
+	if (!cache.enabled() || IsDDS(path))
+		return { path, MappedFile(path), {} };
+	MappedFile source(path);
+	auto entry = cache.EntryPath(source, L"WIC, generated mips", L".dds");
+	auto cached = cache.Find(entry);
+	//a damaged entry is created from the source and written again
+	if (cached && IsIntactEntry(*cached))
+		return { entry, move(*cached), {} };
+	return { path, move(source), entry };
+}
+
+dx_ptr<ID3D11ShaderResourceView> mini::CreateTexture(const DxDevice& device, AssetCache& cache, const TextureFile& texture)
+{
+	auto view = device.CreateShaderResourceView(texture.file.data(), texture.file.size(), texture.path);
+	if (texture.entry.empty())
+		return view;
+	auto dds = ReadBackDDS(device, view.get());
+	if (!dds.empty())
+	{
+		SealEntry(dds);
+		cache.Store(texture.entry, [&dds](const wstring& path)
+		{
+			ofstream output(filesystem::path(path), ios::out | ios::binary | ios::trunc);
+			output.write(reinterpret_cast<const char*>(dds.data()), dds.size());
+			if (!output)
+				THROW(L"Error writing " + path);
+		});
+	}
+	return view;
+}
+
+vector<BYTE> mini::ReadBackDDS(const DxDevice& device, ID3D11ShaderResourceView* view)
+{
+	ID3D11Resource* r = nullptr;
+	view->GetResource(&r);
+	dx_ptr<ID3D11Resource> resource(r);
+	ID3D11Texture2D* t = nullptr;
+	if (FAILED(resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&t))))
+		return {};
+	dx_ptr<ID3D11Texture2D> texture(t);
+	D3D11_TEXTURE2D_DESC desc;
+	texture->GetDesc(&desc);
+	auto pixelSize = BytesPerPixel(desc.Format);
+	if (pixelSize == 0 || desc.ArraySize != 1 || desc.SampleDesc.Count != 1)
+		return {};
+
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.BindFlags = 0;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.MiscFlags = 0;
+	auto staging = device.CreateTexture(desc);
+	auto& context = device.context();
+	context->CopyResource(staging.get(), texture.get());
+
+	//magic, then the header with the DX10 extension naming the DXGI format
+	const uint32_t magic = DDS_MAGIC;
+	DDSHeader header = {};
+	header.size = sizeof(DDSHeader);
+	header.flags = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | 0x20000;	//caps, height, width, pitch, pixel format, mip count
+	header.height = desc.Height;
+	header.width = desc.Width;
+	header.pitchOrLinearSize = desc.Width * pixelSize;
+	header.mipMapCount = desc.MipLevels;
+	header.format.size = sizeof(DDSPixelFormat);
+	header.format.flags = 0x4;	//fourCC
+	header.format.fourCC = 0x30315844;	//"DX10"
+	header.caps = 0x1000 | (desc.MipLevels > 1 ? 0x400008 : 0);	//texture, mipmap and complex
+	DDSHeaderDX10 header10 = { static_cast<uint32_t>(desc.Format), 3, 0, 1, 0 };	//texture 2D
+
+	vector<BYTE> dds(sizeof(magic) + sizeof(header) + sizeof(header10));
+	memcpy(dds.data(), &magic, sizeof(magic));
+	memcpy(dds.data() + sizeof(magic), &header, sizeof(header));
+	memcpy(dds.data() + sizeof(magic) + sizeof(header), &header10, sizeof(header10));
+	//mips follow each other with tightly packed rows
+	for (UINT mip = 0; mip < desc.MipLevels; ++mip)
+	{
+		auto width = max(desc.Width >> mip, 1u), height = max(desc.Height >> mip, 1u);
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		auto hr = context->Map(staging.get(), mip, D3D11_MAP_READ, 0, &mapped);
+		if (FAILED(hr))
+			THROW_DX(hr);
+		auto rowSize = width * pixelSize;
+		auto offset = dds.size();
+		dds.resize(offset + static_cast<size_t>(rowSize) * height);
+		for (UINT y = 0; y < height; ++y)
+			memcpy(dds.data() + offset + static_cast<size_t>(y) * rowSize,
+				static_cast<const BYTE*>(mapped.pData) + static_cast<size_t>(y) * mapped.RowPitch, rowSize);
+		context->Unmap(staging.get(), mip);
+	}
+	return dds;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include "dxDevice.h"
+#include "meshFile.h"
+
+namespace mini
+{
+	//Directory of processed assets. Entries are named after a hash of the source file's contents,
+	//the processing options and VERSION, so any change to them leads to a different entry and
+	//stale ones are never looked up again. A cache with no directory is disabled.
+	class AssetCache
+	{
+	public:
+		//Bump whenever the processing or the format of any entry changes
+		static constexpr uint32_t VERSION = 1;
+
+		AssetCache() = default;
+		explicit AssetCache(std::wstring directory);
+		AssetCache(const AssetCache&) = delete;
+		AssetCache& operator=(const AssetCache&) = delete;
+
+		bool enabled() const { return !m_directory.empty(); }
+
+		//Path of the entry for the contents of source processed with options, extension names the entry's format
+		std::wstring EntryPath(const MappedFile& source, const std::wstring& options, const std::wstring& extension) const;
+		//Maps the entry if it's there, counting hits and misses
+		std::optional<MappedFile> Find(const std::wstring& entryPath);
+		//write(path) creates the entry under a temporary path which is renamed afterwards, so a
+		//failed or interrupted write never leaves a partial entry. Failures only mean a miss next time.
+		bool Store(const std::wstring& entryPath, const std::function<void(const std::wstring&)>& write);
+
+		unsigned int hits() const { return m_hits; }
+		unsigned int misses() const { return m_misses; }
+
+	private:
+		std::wstring m_directory;
+		std::atomic<unsigned int> m_hits{ 0 }, m_misses{ 0 };
+	};
+
+	//Texture file mapped by ReadTexture, either the source image or a cached DDS of it
+	struct TextureFile
+	{
+		//extension of path picks the loader
+		std::wstring path;
+		MappedFile file;
+		//entry to write once the texture is created, empty when it came from the cache
+		std::wstring entry;
+	};
+
+	//Read and create halves of loading a texture through the cache. DDS files are uploaded as
+	//they are, other images are decoded by WIC, get their mips and are stored as DDS files.
+	//Entries whose size or checksum don't match are replaced from the source.
+	TextureFile ReadTexture(AssetCache& cache, const std::wstring& path);
+	dx_ptr<ID3D11ShaderResourceView> CreateTexture(const DxDevice& device, AssetCache& cache, const TextureFile& texture);
+
+	//Copies every mip of a 2D texture back from the GPU into a DDS file image. Empty for texture
+	//arrays, multisampled and block compressed formats.
+	std::vector<BYTE> ReadBackDDS(const DxDevice& device, ID3D11ShaderResourceView* view);
+}
@@ -0,0 +1,84 @@
+#include "assetLoader.h"
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	wstring Milliseconds(AssetLoader::Clock::duration d)
+	{
+		wostringstream text;
+		text << fixed << setprecision(2) << chrono::duration<double, milli>(d).count() << L" ms";
+		return text.str();
+	}
+}
+
+AssetLoader::AssetLoader(WorkerPool& workers)
+	: m_workers(&workers)
+{ }
+
+AssetLoader::~AssetLoader()
+{
+	if (m_reader.joinable())
+		m_reader.join();
+}
+
+void AssetLoader::AddEntry(wstring name, function<void()> read, function<void()> create)
+{
+	m_entries.push_back({ move(name), move(read), move(create), nullptr });
+}
+
+void AssetLoader::Read(Entry& entry)
+{
+	auto start = Clock::now();
+	entry.readStart = start - m_start;
+	try
+	{
+		entry.read();
+	}
+	catch (...)
+	{
+		entry.error = current_exception();
+	}
+	entry.readTime = Clock::now() - start;
+}
+
+void AssetLoader::Start()
+{
+	m_start = Clock::now();
+	//the reader thread takes part in the loop, so reads go on even with a pool of no workers
+	m_reader = thread([this]
+	{
+		m_workers->ParallelFor(m_entries.size(), [this](size_t i) { Read(m_entries[i]); });
+	});
+}
+
+void AssetLoader::Wait()
+{
+	auto waitStart = Clock::now();
+	if (m_reader.joinable())
+		m_reader.join();
+	m_waitTime = Clock::now() - waitStart;
+	for (auto& entry : m_entries)
+		if (entry.error)
+			rethrow_exception(entry.error);
+	for (auto& entry : m_entries)
+	{
+		auto start = Clock::now();
+		entry.create();
+		entry.createTime = Clock::now() - start;
+	}
+	m_totalTime = Clock::now() - m_start;
+}
+
+wstring AssetLoader::Trace() const
+{
+	wstring trace = to_wstring(m_entries.size()) + L" assets loaded in " + Milliseconds(m_totalTime) +
+		L", " + Milliseconds(m_waitTime) + L" spent waiting for reads\n";
+	for (auto& entry : m_entries)
+		trace += L"  " + entry.name + L": read at +" + Milliseconds(entry.readStart) + L" for " +
+			Milliseconds(entry.readTime) + L", create " + Milliseconds(entry.createTime) + L"\n";
+	return trace;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "workerPool.h"
+
+namespace mini
+{
+	//Handle of an asset added to an AssetLoader, the value is there once the loader's Wait returned
+	template<typename T>
+	class Asset
+	{
+	public:
+		Asset() = default;
+
+		bool ready() const { return m_value && m_value->has_value(); }
+		T& get() const { return **m_value; }
+
+	private:
+		friend class AssetLoader;
+		explicit Asset(std::shared_ptr<std::optional<T>> value) : m_value(std::move(value)) { }
+
+		std::shared_ptr<std::optional<T>> m_value;
+	};
+
+	//Loads assets in two steps. Reads (file access and CPU decoding) of all assets run together
+	//on a worker pool, creates run afterwards in the order the assets were added, on the thread
+	//calling Wait - the one that owns the device context. Work that doesn't need the assets can be
+	//done between Start and Wait. The pool must not be used for anything else in the meantime,
+	//its ParallelFor throws while the reads run on it.
+	class AssetLoader
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		explicit AssetLoader(WorkerPool& workers);
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		//Waits for reads still running, nothing is created
+		~AssetLoader();
+
+		//read() runs on the pool, create(<result of read>) on the thread calling Wait
+		template<typename Read, typename Create>
+		auto Add(std::wstring name, Read read, Create create)
+		{
+			using Data = std::invoke_result_t<Read&>;
+			using T = std::invoke_result_t<Create&, Data&&>;
+			auto data = std::make_shared<std::optional<Data>>();
+			auto value = std::make_shared<std::optional<T>>();
+			AddEntry(std::move(name), [read, data] { data->emplace(read()); },
+				[create, data, value]
+				{
+					value->emplace(create(std::move(**data)));
+					data->reset();
+				});
+			return Asset<T>(std::move(value));
+		}
+
+		//Asset that needs no device, e.g. shader byte code
+		template<typename Read>
+		auto Add(std::wstring name, Read read)
+		{
+			return Add(std::move(name), std::move(read), [](auto&& data) { return std::move(data); });
+		}
+
+		//Starts reading every asset added so far and returns immediately
+		void Start();
+		//Waits for the reads and creates the assets. The first error of a read is rethrown here,
+		//errors of creates are thrown as they happen.
+		void Wait();
+
+		//Startup trace, one line per asset with times relative to Start
+		std::wstring Trace() const;
+
+	private:
+		struct Entry
+		{
+			std::wstring name;
+			std::function<void()> read, create;
+			std::exception_ptr error;
+			Clock::duration readStart{}, readTime{}, createTime{};
+		};
+
+		void AddEntry(std::wstring name, std::function<void()> read, std::function<void()> create);
+		void Read(Entry& entry);
+
+		WorkerPool* m_workers;
+		std::vector<Entry> m_entries;
+		std::thread m_reader;
+		Clock::time_point m_start;
+		//how long Wait blocked on the reads and how long all of it took
+		Clock::duration m_waitTime{}, m_totalTime{};
+	};
+}
@@ -0,0 +1,117 @@
+#include "constantRing.h"
+#include "exceptions.h"
+#include <cstring>
+
+using namespace std;
+using namespace mini;
+
+ConstantRing::ConstantRing(const DxDevice& device, size_t capacity, unsigned int framesInFlight)
+	: m_device(&device), m_allocator(capacity, ALIGNMENT, framesInFlight)
+{
+	//writing to a buffer the GPU is reading from needs Map(NO_OVERWRITE) on constant buffers too
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (device.context1() && SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		m_offsets = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+	if (m_offsets)
+		m_buffer = device.CreateBuffer(nullptr, BufferDescription::ConstantBufferDescription(m_allocator.capacity()));
+	else
+		m_cpuRing.resize(m_allocator.capacity());
+}
+
+ConstantRing::~ConstantRing()
+{
+	//the cache keys contents by address, a later buffer could take the place of a released one
+	if (m_state)
+		for (auto& stage : m_slotBuffers)
+			for (auto& buffer : stage)
+				if (buffer)
+					m_state->Forget(buffer.get());
+}
+
+void ConstantRing::Map(const dx_ptr<ID3D11DeviceContext>& context)
+{
+	if (!m_offsets)
+	{
+		m_mapped = m_cpuRing.data();
+		return;
+	}
+	//the allocator keeps the blocks in flight, so only the first Map has to discard
+	D3D11_MAPPED_SUBRESOURCE res;
+	auto hr = context->Map(m_buffer.get(), 0, m_discarded ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD, 0, &res);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	m_discarded = true;
+	m_mapped = static_cast<BYTE*>(res.pData);
+}
+
+ConstantRange ConstantRing::Push(const void* data, size_t size)
+{
+	auto offset = m_allocator.Allocate(size);
+	if (offset == RingAllocator::NO_SPACE)
+		THROW(L"Constant ring is full");
+	memcpy(m_mapped + offset, data, size);
+	auto aligned = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	return { static_cast<UINT>(offset / 16), static_cast<UINT>(aligned / 16) };
+}
+
+void ConstantRing::Unmap(const dx_ptr<ID3D11DeviceContext>& context)
+{
+	if (m_offsets)
+		context->Unmap(m_buffer.get(), 0);
+	m_mapped = nullptr;
+}
+
+void ConstantRing::Bind(StateCache& state, Stage stage, UINT slot, ConstantRange range)
+{
+	if (m_offsets)
+	{
+		auto buffer = m_buffer.get();
+		switch (stage)
+		{
+		case Vertex:
+			state.VSSetConstantBuffers1(slot, 1, &buffer, &range.firstConstant, &range.constantCount);
+			break;
+		case Geometry:
+			state.GSSetConstantBuffers1(slot, 1, &buffer, &range.firstConstant, &range.constantCount);
+			break;
+		case Pixel:
+			state.PSSetConstantBuffers1(slot, 1, &buffer, &range.firstConstant, &range.constantCount);
+			break;
+		default:
+			THROW(L"Invalid shader stage");
+		}
+		return;
+	}
+
+	if (stage >= StageCount)
+		THROW(L"Invalid shader stage");
+	if (m_state && m_state != &state)
+		THROW(L"Constant ring slots are bound through a single state cache");
+	m_state = &state;
+	size_t size = range.constantCount * 16;
+	auto& slotBuffer = m_slotBuffers[stage][slot];
+	if (m_slotSizes[stage][slot] < size)
+	{
+		if (slotBuffer)
+			state.Forget(slotBuffer.get());
+		slotBuffer = m_device->CreateBuffer(nullptr, BufferDescription::ConstantBufferDescription(size));
+		m_slotSizes[stage][slot] = size;
+	}
+	//the state cache skips the copy when the slot already holds these constants
+	state.UpdateBuffer(slotBuffer.get(), m_cpuRing.data() + range.firstConstant * 16, size);
+	auto buffer = slotBuffer.get();
+	switch (stage)
+	{
+	case Vertex:
+		state.VSSetConstantBuffers(slot, 1, &buffer);
+		break;
+	case Geometry:
+		state.GSSetConstantBuffers(slot, 1, &buffer);
+		break;
+	case Pixel:
+		state.PSSetConstantBuffers(slot, 1, &buffer);
+		break;
+	default:
+		break;
+	}
+}
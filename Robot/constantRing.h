@@ -0,0 +1,59 @@
+#pragma once
+
+#include "dxDevice.h"
+#include "stateCache.h"
+#include "ringAllocator.h"
+
+namespace mini
+{
+	//Part of a ConstantRing in 16-byte shader constants, as *SetConstantBuffers1 takes it
+	struct ConstantRange
+	{
+		UINT firstConstant = 0;
+		UINT constantCount = 0;
+	};
+
+	//One large dynamic constant buffer that per-draw constants are pushed into between a single
+	//Map and Unmap, and bound with offsets. Without Direct3D 11.1 offsets the constants are kept
+	//on the CPU instead and copied to a small buffer per shader slot when bound.
+	class ConstantRing
+	{
+	public:
+		enum Stage { Vertex, Geometry, Pixel, StageCount };
+		//*SetConstantBuffers1 takes multiples of 16 constants
+		static constexpr size_t ALIGNMENT = 256;
+
+		ConstantRing() = default;
+		//capacity has to hold framesInFlight + 1 frames of constants
+		ConstantRing(const DxDevice& device, size_t capacity, unsigned int framesInFlight = 3);
+		ConstantRing(const ConstantRing&) = delete;
+		ConstantRing& operator=(const ConstantRing&) = delete;
+		//Slot buffers are forgotten by the state cache they were last bound with, which has to outlive the ring
+		~ConstantRing();
+
+		bool offsetsSupported() const { return m_offsets; }
+
+		//Keeps the constants of the last framesInFlight frames, the GPU might still read them
+		void BeginFrame() { m_allocator.BeginFrame(); }
+		void Map(const dx_ptr<ID3D11DeviceContext>& context);
+		ConstantRange Push(const void* data, size_t size);
+		template<typename T>
+		ConstantRange Push(const T& data) { return Push(&data, sizeof(T)); }
+		void Unmap(const dx_ptr<ID3D11DeviceContext>& context);
+
+		void Bind(StateCache& state, Stage stage, UINT slot, ConstantRange range);
+
+	private:
+		const DxDevice* m_device = nullptr;
+		bool m_offsets = false;
+		RingAllocator m_allocator;
+		dx_ptr<ID3D11Buffer> m_buffer;
+		bool m_discarded = false;
+		//ring contents while mapped, or the CPU copy of the ring when offsets are not supported
+		BYTE* m_mapped = nullptr;
+		std::vector<BYTE> m_cpuRing;
+		dx_ptr<ID3D11Buffer> m_slotBuffers[StageCount][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		StateCache* m_state = nullptr;	//updated the slot buffers
+		size_t m_slotSizes[StageCount][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = {};
+	};
+}
@@ -7,7 +7,7 @@ using namespace std;
 
 DxApplication::DxApplication(HINSTANCE hInstance, int wndWidth, int wndHeight, std::wstring wndTitle)
 	: WindowApplication(hInstance, wndWidth, wndHeight, wndTitle),
-	m_device(m_window), m_inputDevice(hInstance),
+	m_device(m_window), m_state(m_device.context().get(), m_device.context1().get()), m_inputDevice(hInstance),
 	m_mouse(m_inputDevice.CreateMouseDevice(m_window.getHandle())),
 	m_keyboard(m_inputDevice.CreateKeyboardDevice(m_window.getHandle())),
 	m_camera(XMFLOAT3(0, -0.0f, 0.0f)), m_viewport{ m_window.getClientSize() }
@@ -54,12 +54,7 @@ void DxApplication::Render()
 
 void mini::DxApplication::UpdateBuffer(const dx_ptr<ID3D11Buffer>& buffer, const void* data, size_t count)
 {
-	D3D11_MAPPED_SUBRESOURCE res;
-	auto hr = m_device.context()->Map(buffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &res);
-	if (FAILED(hr))
-		THROW_DX(hr);
-	memcpy(res.pData, data, count);
-	m_device.context()->Unmap(buffer.get(), 0);
+	m_state.UpdateBuffer(buffer.get(), data, count);
 }
 
 bool DxApplication::HandleCameraInput(double dt)
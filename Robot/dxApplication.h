@@ -8,6 +8,7 @@
 #include "keyboard.h"
 #include "mouse.h"
 #include "camera.h"
+#include "stateCache.h"
 
 //***************** NEW *****************
 //This is now a base class for future tasks.
@@ -50,6 +51,8 @@ namespace mini
 		void ResetRenderTarget();
 
 		DxDevice m_device;
+		//Shaders, states and constant buffers are bound and updated through it to skip redundant calls
+		StateCache m_state;
 
 		DiInstance m_inputDevice;
 		Mouse m_mouse;
@@ -0,0 +1,43 @@
+#include "dxCommandBackend.h"
+
+using namespace std;
+using namespace mini;
+
+DxCommandBackend::DxCommandBackend(StateCache& state, const PipelineCache& pipelines, ConstantRing& constants)
+	: m_state(&state), m_pipelines(&pipelines), m_constants(&constants)
+{ }
+
+uint32_t DxCommandBackend::AddTextures(TextureSet textures)
+{
+	m_textures.push_back(move(textures));
+	return static_cast<uint32_t>(m_textures.size() - 1);
+}
+
+uint32_t DxCommandBackend::AddMesh(const Mesh& mesh)
+{
+	m_meshes.push_back(&mesh);
+	return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+void DxCommandBackend::SetPipeline(uint32_t pipeline)
+{
+	m_pipelines->Bind(*m_state, pipeline);
+}
+
+void DxCommandBackend::BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount)
+{
+	m_constants->Bind(*m_state, static_cast<ConstantRing::Stage>(stage), slot, { firstConstant, constantCount });
+}
+
+void DxCommandBackend::BindTextures(uint32_t textures)
+{
+	auto& t = m_textures[textures];
+	m_state->PSSetShaderResources(0, static_cast<UINT>(t.views.size()), t.views.data());
+	m_state->PSSetSamplers(0, 1, &t.sampler);
+}
+
+void DxCommandBackend::Draw(uint32_t mesh, uint32_t lod)
+{
+	//the mesh sets its own topology and vertex buffers
+	m_meshes[mesh]->Render(*m_state, lod);
+}
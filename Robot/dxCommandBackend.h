@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include "renderCommands.h"
+#include "stateCache.h"
+#include "constantRing.h"
+#include "pipelineState.h"
+#include "mesh.h"
+
+namespace mini
+{
+	//Replays render commands on a context through its StateCache. Pipelines are ids of a PipelineCache,
+	//other ids are indices into the tables below and stages of BindConstants are ConstantRing::Stage
+	//values. The tables only keep raw pointers, the objects have to outlive the backend.
+	class DxCommandBackend : public CommandBackend
+	{
+	public:
+		//Shader resources bound from pixel shader slot 0, with a sampler in slot 0
+		struct TextureSet
+		{
+			std::vector<ID3D11ShaderResourceView*> views;
+			ID3D11SamplerState* sampler = nullptr;
+		};
+
+		DxCommandBackend() = default;
+		DxCommandBackend(StateCache& state, const PipelineCache& pipelines, ConstantRing& constants);
+
+		uint32_t AddTextures(TextureSet textures);
+		uint32_t AddMesh(const Mesh& mesh);
+
+		void SetPipeline(uint32_t pipeline) override;
+		void BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount) override;
+		void BindTextures(uint32_t textures) override;
+		void Draw(uint32_t mesh, uint32_t lod) override;
+
+	private:
+		StateCache* m_state = nullptr;
+		const PipelineCache* m_pipelines = nullptr;
+		ConstantRing* m_constants = nullptr;
+		std::vector<TextureSet> m_textures;
+		std::vector<const Mesh*> m_meshes;
+	};
+}
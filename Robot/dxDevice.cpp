@@ -1,5 +1,6 @@
 #include "dxDevice.h"
 #include "exceptions.h"
+#include <filesystem>
 #include <fstream>
 #include "DDSTextureLoader.h"
 #include "WICTextureLoader.h"
@@ -21,6 +22,9 @@ DxDevice::DxDevice(const Window& window)
 	m_swapChain.reset(sc);
 	if (FAILED(hr))
 		THROW_DX(hr);
+	ID3D11DeviceContext1* dc1 = nullptr;
+	if (SUCCEEDED(m_context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&dc1))))
+		m_context1.reset(dc1);
 }
 
 dx_ptr<ID3D11RenderTargetView> DxDevice::CreateRenderTargetView(const dx_ptr<ID3D11Texture2D>& texture) const
@@ -35,7 +39,7 @@ dx_ptr<ID3D11RenderTargetView> DxDevice::CreateRenderTargetView(const dx_ptr<ID3
 
 vector<BYTE> DxDevice::LoadByteCode(const wstring& filename)
 {
-	ifstream sIn(filename, ios::in | ios::binary);
+	ifstream sIn(filesystem::path(filename), ios::in | ios::binary);
 	if (!sIn)
 		THROW(L"Unable to open " + filename);
 	sIn.seekg(0, ios::end);
@@ -103,6 +107,15 @@ dx_ptr<ID3D11GeometryShader> DxDevice::CreateGeometryShader(std::vector<BYTE> gs
 	return geometryShader;
 }
 
+dx_ptr<ID3D11ComputeShader> DxDevice::CreateComputeShader(std::vector<BYTE> csCode) const
+{
+	ID3D11ComputeShader* cs = nullptr;
+	auto hr = m_device->CreateComputeShader(csCode.data(), csCode.size(), nullptr, &cs);
+	dx_ptr<ID3D11ComputeShader> computeShader(cs);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	return computeShader;
+}
 
 dx_ptr<ID3D11InputLayout>
 DxDevice::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, unsigned int count, const vector<BYTE>& vsCode) const
@@ -175,13 +188,42 @@ dx_ptr<ID3D11ShaderResourceView> mini::DxDevice::CreateShaderResourceView(const
 	return resourceView;
 }
 
+dx_ptr<ID3D11ShaderResourceView> mini::DxDevice::CreateShaderResourceView(const dx_ptr<ID3D11Buffer>& buffer,
+	const D3D11_SHADER_RESOURCE_VIEW_DESC& desc) const
+{
+	ID3D11ShaderResourceView* srv = nullptr;
+	auto hr = m_device->CreateShaderResourceView(buffer.get(), &desc, &srv);
+	dx_ptr<ID3D11ShaderResourceView> resourceView(srv);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	return resourceView;
+}
+
+dx_ptr<ID3D11UnorderedAccessView> mini::DxDevice::CreateUnorderedAccessView(const dx_ptr<ID3D11Buffer>& buffer,
+	const D3D11_UNORDERED_ACCESS_VIEW_DESC& desc) const
+{
+	ID3D11UnorderedAccessView* uav = nullptr;
+	auto hr = m_device->CreateUnorderedAccessView(buffer.get(), &desc, &uav);
+	dx_ptr<ID3D11UnorderedAccessView> accessView(uav);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	return accessView;
+}
+
+namespace
+{
+	bool IsDDS(const wstring& texPath)
+	{
+		const wstring ext{ L".dds" };
+		return texPath.size() > ext.size() && texPath.compare(texPath.size() - ext.size(), ext.size(), ext) == 0;
+	}
+}
 
 dx_ptr<ID3D11ShaderResourceView> DxDevice::CreateShaderResourceView(const std::wstring& texPath) const
 {
 	ID3D11ShaderResourceView* rv = nullptr;;
 	HRESULT hr = 0;
-	const wstring ext{ L".dds" };
-	if (texPath.size() > ext.size() && texPath.compare(texPath.size() - ext.size(), ext.size(), ext) == 0)
+	if (IsDDS(texPath))
 		hr = DirectX::CreateDDSTextureFromFile(m_device.get(), m_context.get(), texPath.c_str(), nullptr, &rv);
 	else
 		hr = DirectX::CreateWICTextureFromFile(m_device.get(), m_context.get(), texPath.c_str(), nullptr, &rv);
@@ -192,6 +234,20 @@ dx_ptr<ID3D11ShaderResourceView> DxDevice::CreateShaderResourceView(const std::w
 	return resourceView;
 }
 
+dx_ptr<ID3D11ShaderResourceView> DxDevice::CreateShaderResourceView(const BYTE* fileData, size_t fileSize, const wstring& texPath) const
+{
+	ID3D11ShaderResourceView* rv = nullptr;
+	HRESULT hr = 0;
+	if (IsDDS(texPath))
+		hr = DirectX::CreateDDSTextureFromMemory(m_device.get(), m_context.get(), fileData, fileSize, nullptr, &rv);
+	else
+		hr = DirectX::CreateWICTextureFromMemory(m_device.get(), m_context.get(), fileData, fileSize, nullptr, &rv);
+	dx_ptr<ID3D11ShaderResourceView> resourceView(rv);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	return resourceView;
+}
+
 dx_ptr<ID3D11SamplerState> mini::DxDevice::CreateSamplerState(const SamplerDescription& desc) const
 {
 	ID3D11SamplerState* s = nullptr;
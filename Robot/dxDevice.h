@@ -3,6 +3,7 @@
 #include "dxptr.h"
 #include "window.h"
 #include "dxStructures.h"
+#include <d3d11_1.h>
 #include <vector>
 
 namespace mini
@@ -12,6 +13,8 @@ namespace mini
 	public:
 		explicit DxDevice(const mini::Window& window);
 		const mini::dx_ptr<ID3D11DeviceContext>& context() const { return m_context; }
+		//Direct3D 11.1 interface of the context, empty when the runtime doesn't have it
+		const mini::dx_ptr<ID3D11DeviceContext1>& context1() const { return m_context1; }
 		const mini::dx_ptr<IDXGISwapChain>& swapChain() const { return m_swapChain; }
 		ID3D11Device* operator->() const { return m_device.get(); }
 		mini::dx_ptr<ID3D11RenderTargetView> CreateRenderTargetView(const mini::dx_ptr<ID3D11Texture2D>& texture) const;
@@ -21,6 +24,7 @@ namespace mini
 		mini::dx_ptr<ID3D11VertexShader> CreateVertexShader(std::vector<BYTE> vsCode) const;
 		mini::dx_ptr<ID3D11PixelShader> CreatePixelShader(std::vector<BYTE> psCode) const;
 		mini::dx_ptr<ID3D11GeometryShader> CreateGeometryShader(std::vector<BYTE> psCode) const;
+		mini::dx_ptr<ID3D11ComputeShader> CreateComputeShader(std::vector<BYTE> csCode) const;
 
 		//***************** NEW *****************
 		//Additional overloads for Input Layout cration
@@ -111,15 +115,24 @@ namespace mini
 		//from DirectXTex texture processing library: https://github.com/microsoft/DirectXTex
 		//dx_ptr<ID3D11ShaderResourceView> CreateShaderResourceView(const std::wstring& texPath) const;
 
+		//Views of structured and raw buffers used by compute shaders
+		dx_ptr<ID3D11ShaderResourceView> CreateShaderResourceView(const dx_ptr<ID3D11Buffer>& buffer,
+			const D3D11_SHADER_RESOURCE_VIEW_DESC& desc) const;
+		dx_ptr<ID3D11UnorderedAccessView> CreateUnorderedAccessView(const dx_ptr<ID3D11Buffer>& buffer,
+			const D3D11_UNORDERED_ACCESS_VIEW_DESC& desc) const;
+
 		dx_ptr<ID3D11SamplerState> CreateSamplerState(const SamplerDescription& desc) const;
 
 		//Loading textures from image/dds files using stand-alone DDS/WIC loaders
 		//from DirectXTex texture processing library: https://github.com/microsoft/DirectXTex
 		dx_ptr<ID3D11ShaderResourceView> CreateShaderResourceView(const std::wstring& texPath) const;
+		//Same from the contents of a file read or mapped earlier, texPath only picks the loader
+		dx_ptr<ID3D11ShaderResourceView> CreateShaderResourceView(const BYTE* fileData, size_t fileSize, const std::wstring& texPath) const;
 
 	private:
 		mini::dx_ptr<ID3D11Device> m_device;
 		mini::dx_ptr<ID3D11DeviceContext> m_context;
+		mini::dx_ptr<ID3D11DeviceContext1> m_context1;
 		mini::dx_ptr<IDXGISwapChain> m_swapChain;
 	};
 }
\ No newline at end of file
@@ -77,6 +77,21 @@ BufferDescription BufferDescription::ConstantBufferDescription(size_t byteWidth)
 	return desc;
 }
 
+BufferDescription BufferDescription::StructuredBufferDescription(size_t elementSize, size_t count)
+{
+	BufferDescription desc{ D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS, elementSize * count };
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = elementSize;
+	return desc;
+}
+
+BufferDescription BufferDescription::IndirectArgsBufferDescription(size_t byteWidth)
+{
+	BufferDescription desc{ D3D11_BIND_UNORDERED_ACCESS, byteWidth };
+	desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+	return desc;
+}
+
 //********************* NEW *********************
 
 BlendDescription::BlendDescription()
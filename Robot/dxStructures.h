@@ -31,6 +31,10 @@ namespace mini
 			return { D3D11_BIND_INDEX_BUFFER, byteWidth };
 		}
 		static BufferDescription ConstantBufferDescription(size_t byteWidth);
+		//Structured buffer readable and writable from shaders (e.g. append/consume buffers)
+		static BufferDescription StructuredBufferDescription(size_t elementSize, size_t count);
+		//Arguments of DrawInstancedIndirect/DispatchIndirect, writable from compute shaders as a raw buffer
+		static BufferDescription IndirectArgsBufferDescription(size_t byteWidth);
 	};
 
 	//******************* NEW *******************
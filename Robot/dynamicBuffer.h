@@ -0,0 +1,73 @@
+#pragma once
+
+#include "dxDevice.h"
+#include "exceptions.h"
+
+namespace mini
+{
+	//Dynamic vertex buffer written as a ring. Consecutive writes append with
+	//D3D11_MAP_WRITE_NO_OVERWRITE, so data still used by the GPU is never touched,
+	//and the buffer is orphaned with D3D11_MAP_WRITE_DISCARD only when it wraps.
+	template<typename T>
+	class DynamicVertexRing
+	{
+	public:
+		DynamicVertexRing() = default;
+		DynamicVertexRing(const DxDevice& device, unsigned int capacity)
+			: m_buffer(device.CreateVertexBuffer<T>(capacity)), m_capacity(capacity)
+		{ }
+
+		unsigned int capacity() const { return m_capacity; }
+		//First vertex and number of vertices written by the last Map/Unmap pair
+		unsigned int baseVertex() const { return m_base; }
+		unsigned int vertexCount() const { return m_count; }
+
+		//Returns space for at most maxCount vertices (clamped to the capacity).
+		//Must be followed by Unmap with the number of vertices actually written.
+		T* Map(const dx_ptr<ID3D11DeviceContext>& context, unsigned int maxCount)
+		{
+			if (maxCount > m_capacity)
+				maxCount = m_capacity;
+			auto type = D3D11_MAP_WRITE_NO_OVERWRITE;
+			if (m_offset == 0 || m_offset + maxCount > m_capacity)
+			{
+				type = D3D11_MAP_WRITE_DISCARD;
+				m_offset = 0;
+			}
+			D3D11_MAPPED_SUBRESOURCE res;
+			auto hr = context->Map(m_buffer.get(), 0, type, 0, &res);
+			if (FAILED(hr))
+				THROW_DX(hr);
+			return reinterpret_cast<T*>(res.pData) + m_offset;
+		}
+
+		void Unmap(const dx_ptr<ID3D11DeviceContext>& context, unsigned int written)
+		{
+			context->Unmap(m_buffer.get(), 0);
+			m_base = m_offset;
+			m_count = written;
+			m_offset += written;
+		}
+
+		void Bind(const dx_ptr<ID3D11DeviceContext>& context, unsigned int slot = 0) const
+		{
+			auto b = m_buffer.get();
+			unsigned int stride = sizeof(T), offset = 0;
+			context->IASetVertexBuffers(slot, 1, &b, &stride, &offset);
+		}
+
+		//Draws the vertices written by the last Map/Unmap pair
+		void Draw(const dx_ptr<ID3D11DeviceContext>& context) const
+		{
+			if (m_count)
+				context->Draw(m_count, m_base);
+		}
+
+	private:
+		dx_ptr<ID3D11Buffer> m_buffer;
+		unsigned int m_capacity = 0;
+		unsigned int m_offset = 0;
+		unsigned int m_base = 0;
+		unsigned int m_count = 0;
+	};
+}
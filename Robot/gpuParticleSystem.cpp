@@ -0,0 +1,207 @@
+#include "gpuParticleSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <cmath>
+
+#include "exceptions.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	void Upload(const dx_ptr<ID3D11DeviceContext>& context, const dx_ptr<ID3D11Buffer>& buffer, const void* data, size_t size)
+	{
+		D3D11_MAPPED_SUBRESOURCE res;
+		auto hr = context->Map(buffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &res);
+		if (FAILED(hr))
+			THROW_DX(hr);
+		memcpy(res.pData, data, size);
+		context->Unmap(buffer.get(), 0);
+	}
+}
+
+GpuParticleSystem::GpuParticleSystem(const DxDevice& device, size_t capacity, unsigned int seed)
+	: m_capacity(capacity), m_seed(seed)
+{
+	//simulation is dispatched indirectly with a one dimensional grid
+	assert(capacity <= static_cast<size_t>(D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION) * SIMULATE_GROUP);
+	m_emitters.Reserve(MAX_STEP_EMITTERS);
+	m_stepEmitters.reserve(MAX_STEP_EMITTERS);
+
+	for (auto& s : m_state)
+	{
+		s.buffer = device.CreateBuffer(nullptr, BufferDescription::StructuredBufferDescription(sizeof(GpuParticle), capacity));
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc{};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.NumElements = static_cast<UINT>(capacity);
+		uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_APPEND;
+		s.uav = device.CreateUnorderedAccessView(s.buffer, uavDesc);
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.NumElements = static_cast<UINT>(capacity);
+		s.srv = device.CreateShaderResourceView(s.buffer, srvDesc);
+	}
+
+	BufferDescription tableDesc{ D3D11_BIND_SHADER_RESOURCE, sizeof(EmitterData) * MAX_STEP_EMITTERS };
+	tableDesc.Usage = D3D11_USAGE_DYNAMIC;
+	tableDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	tableDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	tableDesc.StructureByteStride = sizeof(EmitterData);
+	m_emitterTable = device.CreateBuffer(nullptr, tableDesc);
+	D3D11_SHADER_RESOURCE_VIEW_DESC tableView{};
+	tableView.Format = DXGI_FORMAT_UNKNOWN;
+	tableView.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	tableView.Buffer.NumElements = MAX_STEP_EMITTERS;
+	m_emitterTableView = device.CreateShaderResourceView(m_emitterTable, tableView);
+
+	m_cbSimulation = device.CreateConstantBuffer<SimulationParams>();
+	//CopyStructureCount can't write to dynamic buffers
+	m_cbCount = device.CreateBuffer(nullptr, BufferDescription{ D3D11_BIND_CONSTANT_BUFFER, 4 * sizeof(UINT) });
+
+	const UINT dispatchArgs[4] = { 0, 1, 1, 0 };
+	m_dispatchArgs = device.CreateBuffer(dispatchArgs, BufferDescription::IndirectArgsBufferDescription(sizeof(dispatchArgs)));
+	D3D11_UNORDERED_ACCESS_VIEW_DESC argsView{};
+	argsView.Format = DXGI_FORMAT_R32_TYPELESS;
+	argsView.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+	argsView.Buffer.NumElements = 4;
+	argsView.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+	m_dispatchArgsView = device.CreateUnorderedAccessView(m_dispatchArgs, argsView);
+	//vertex count is overwritten with the particle count every update
+	const UINT drawArgs[4] = { 0, 1, 0, 0 };
+	m_drawArgs = device.CreateBuffer(drawArgs, BufferDescription::IndirectArgsBufferDescription(sizeof(drawArgs)));
+
+	m_argsCS = device.CreateComputeShader(device.LoadByteCode(L"particleArgsCS.cso"));
+	m_simulateCS = device.CreateComputeShader(device.LoadByteCode(L"particleSimulateCS.cso"));
+	m_emitCS = device.CreateComputeShader(device.LoadByteCode(L"particleEmitCS.cso"));
+}
+
+void GpuParticleSystem::AddEmitter(XMFLOAT3 position, XMMATRIX orientation, float rate, float lifetime)
+{
+	m_emitters.Add(MakeEmitter(position, orientation, rate, lifetime, m_seed, m_emittersCreated++));
+}
+
+void GpuParticleSystem::AddBurst(XMFLOAT3 position, XMMATRIX orientation, unsigned int count)
+{
+	m_emitters.Add(MakeEmitter(position, orientation, 0.0f, 0.0f, m_seed, m_emittersCreated++)).burst = count;
+}
+
+unsigned int GpuParticleSystem::PrepareEmitters(float dt)
+{
+	m_stepEmitters.clear();
+	unsigned int total = 0;
+	for (size_t k = 0; k < m_emitters.size(); ++k)
+	{
+		auto& e = m_emitters[k];
+		auto n = static_cast<unsigned int>(e.TakeCount(dt));
+		if (n == 0)
+			continue;
+		if (m_stepEmitters.size() == MAX_STEP_EMITTERS)
+		{
+			//table is full, spawn these in the next step
+			e.burst += n;
+			continue;
+		}
+		EmitterData d;
+		d.position = XMFLOAT4(e.position.x, e.position.y, e.position.z, 1.0f);
+		//same spawn direction transform as ParticleSystem::RandomVelocity
+		XMFLOAT4X4 m;
+		XMStoreFloat4x4(&m, XMMatrixRotationX(-XM_PIDIV2) * XMLoadFloat4x4(&e.orientation));
+		for (int r = 0; r < 3; ++r)
+			d.direction[r] = XMFLOAT4(m.m[r][0], m.m[r][1], m.m[r][2], 0.0f);
+		d.first = total;
+		d.count = n;
+		d.seed = static_cast<unsigned int>(e.random());
+		d.padding = 0;
+		m_stepEmitters.push_back(d);
+		total += n;
+	}
+	//emitters holding back a burst must survive until it's spawned
+	for (size_t k = 0; k < m_emitters.size(); ++k)
+		if (m_emitters[k].burst && m_emitters[k].lifetime >= 0.0f && m_emitters[k].lifetime <= dt)
+			m_emitters[k].lifetime = 2.0f * dt;
+	m_emitters.Expire(dt);
+	return total;
+}
+
+void GpuParticleSystem::Update(const dx_ptr<ID3D11DeviceContext>& context, float dt)
+{
+	auto& current = m_state[m_current];
+	auto& next = m_state[1 - m_current];
+
+	unsigned int emitCount = PrepareEmitters(dt);
+	SimulationParams params;
+	params.acceleration = ParticleSystem::ACCELERATION;
+	params.dt = dt;
+	params.sizeIncrement = ParticleSystem::PARTICLE_SCALE * ParticleSystem::PARTICLE_SIZE * dt;
+	params.timeToLive = ParticleSystem::TIME_TO_LIVE;
+	params.killLevel = m_killLevel;
+	params.trailTime = ParticleStore::HISTORY_LENGTH * dt;
+	params.capacity = static_cast<unsigned int>(m_capacity);
+	params.emitCount = emitCount;
+	params.emitterCount = static_cast<unsigned int>(m_stepEmitters.size());
+	params.padding = 0;
+	params.minVelocity = ParticleSystem::MIN_VELOCITY;
+	params.maxVelocity = ParticleSystem::MAX_VELOCITY;
+	params.tanMaxAngle = tan(ParticleSystem::MAX_ANGLE);
+	params.particleSize = ParticleSystem::PARTICLE_SIZE;
+	Upload(context, m_cbSimulation, &params, sizeof(params));
+	if (emitCount)
+		Upload(context, m_emitterTable, m_stepEmitters.data(), m_stepEmitters.size() * sizeof(EmitterData));
+
+	ID3D11Buffer* cbs[] = { m_cbSimulation.get(), m_cbCount.get() };
+	context->CSSetConstantBuffers(0, 2, cbs);
+	ID3D11UnorderedAccessView* noUavs[2] = { nullptr, nullptr };
+
+	//thread group count for the simulation, computed from the number of live particles
+	context->CopyStructureCount(m_cbCount.get(), 0, current.uav.get());
+	auto argsUav = m_dispatchArgsView.get();
+	context->CSSetShader(m_argsCS.get(), nullptr, 0);
+	context->CSSetUnorderedAccessViews(0, 1, &argsUav, nullptr);
+	context->Dispatch(1, 1, 1);
+	context->CSSetUnorderedAccessViews(0, 1, noUavs, nullptr);
+
+	//consume from the current buffer, survivors are appended to the next one
+	ID3D11UnorderedAccessView* uavs[2] = { current.uav.get(), next.uav.get() };
+	const UINT counts[2] = { static_cast<UINT>(-1), 0 };	//keep the current count, reset the next one
+	context->CSSetShader(m_simulateCS.get(), nullptr, 0);
+	context->CSSetUnorderedAccessViews(0, 2, uavs, counts);
+	context->DispatchIndirect(m_dispatchArgs.get(), 0);
+	context->CSSetUnorderedAccessViews(0, 2, noUavs, nullptr);
+
+	if (emitCount)
+	{
+		//emission is clamped on the GPU to the space left after the simulation
+		context->CopyStructureCount(m_cbCount.get(), 0, next.uav.get());
+		auto table = m_emitterTableView.get();
+		auto nextUav = next.uav.get();
+		const UINT keep = static_cast<UINT>(-1);
+		context->CSSetShader(m_emitCS.get(), nullptr, 0);
+		context->CSSetShaderResources(0, 1, &table);
+		context->CSSetUnorderedAccessViews(0, 1, &nextUav, &keep);
+		context->Dispatch((emitCount + EMIT_GROUP - 1) / EMIT_GROUP, 1, 1);
+		ID3D11ShaderResourceView* noSrv = nullptr;
+		context->CSSetShaderResources(0, 1, &noSrv);
+		context->CSSetUnorderedAccessViews(0, 1, noUavs, nullptr);
+	}
+	context->CSSetShader(nullptr, nullptr, 0);
+
+	//vertex count of the indirect draw
+	context->CopyStructureCount(m_drawArgs.get(), 0, next.uav.get());
+	m_current = 1 - m_current;
+}
+
+void GpuParticleSystem::Draw(const dx_ptr<ID3D11DeviceContext>& context, unsigned int slot) const
+{
+	auto srv = m_state[m_current].srv.get();
+	context->VSSetShaderResources(slot, 1, &srv);
+	context->DrawInstancedIndirect(m_drawArgs.get(), 0);
+	//the buffer is bound for writing in the next update
+	ID3D11ShaderResourceView* noSrv = nullptr;
+	context->VSSetShaderResources(slot, 1, &noSrv);
+}
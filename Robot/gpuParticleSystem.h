@@ -0,0 +1,125 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <random>
+#include "dxDevice.h"
+#include "particleSystem.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Particle as stored on the GPU, must match GpuParticle in particleGpu.hlsli
+		struct GpuParticle
+		{
+			DirectX::XMFLOAT3 Pos;
+			float Age;
+			DirectX::XMFLOAT3 Velocity;
+			float Size;
+			DirectX::XMFLOAT3 LastPos;
+			float Padding;
+		};
+
+		//GPU-resident counterpart of ParticleSystem. Particles live in a pair of
+		//append/consume structured buffers swapped every step and are never read back,
+		//the CPU only keeps track of emitters. Uses the same simulation parameters as
+		//ParticleSystem, which stays the reference implementation. Differences:
+		//particles are drawn unsorted, the trail end is computed analytically instead
+		//of being kept in a history ring and random velocities come from a hash.
+		class GpuParticleSystem
+		{
+		public:
+			static constexpr unsigned int SIMULATE_GROUP = 256;	//threads in a group of particleSimulateCS
+			static constexpr unsigned int EMIT_GROUP = 64;		//threads in a group of particleEmitCS
+			static constexpr unsigned int MAX_STEP_EMITTERS = 64;	//emitters spawning particles in a single step
+
+			GpuParticleSystem() = default;
+			GpuParticleSystem(const DxDevice& device, size_t capacity, unsigned int seed = std::random_device{}());
+
+			GpuParticleSystem(GpuParticleSystem&& other) = default;
+			GpuParticleSystem& operator=(GpuParticleSystem&& other) = default;
+
+			//Same semantics as in ParticleSystem
+			void AddEmitter(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, float rate, float lifetime = -1.0f);
+			void AddBurst(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, unsigned int count);
+			size_t emittersCount() const { return m_emitters.size(); }
+
+			//Particles moving down below the level are removed during the update.
+			//Unlike ParticleSystem::RemoveBelow their positions are not reported back.
+			void SetKillLevel(float level) { m_killLevel = level; }
+
+			//Records simulation of a single step followed by emission of new particles
+			void Update(const dx_ptr<ID3D11DeviceContext>& context, float dt);
+			//Draws a point per particle with DrawInstancedIndirect. Particles are bound as
+			//a structured buffer to the given vertex shader slot, the bound vertex shader
+			//fetches them by SV_VertexID (see particleGpuVS.hlsl). The bound pipeline state
+			//needs a point list topology and no input layout.
+			void Draw(const dx_ptr<ID3D11DeviceContext>& context, unsigned int slot = 0) const;
+
+			size_t capacity() const { return m_capacity; }
+
+		private:
+			//Must match GpuEmitter in particleEmitCS.hlsl
+			struct EmitterData
+			{
+				DirectX::XMFLOAT4 position;
+				DirectX::XMFLOAT4 direction[3];	//rows transforming the local spawn direction to world space
+				unsigned int first;		//index of the first particle spawned in this step
+				unsigned int count;
+				unsigned int seed;
+				unsigned int padding;
+			};
+
+			//Must match cbSimulation in particleSimulateCS.hlsl and particleEmitCS.hlsl
+			struct SimulationParams
+			{
+				DirectX::XMFLOAT3 acceleration;
+				float dt;
+				float sizeIncrement;
+				float timeToLive;
+				float killLevel;
+				float trailTime;
+				unsigned int capacity;
+				unsigned int emitCount;
+				unsigned int emitterCount;
+				unsigned int padding;
+				float minVelocity;
+				float maxVelocity;
+				float tanMaxAngle;
+				float particleSize;
+			};
+
+			struct StateBuffer
+			{
+				dx_ptr<ID3D11Buffer> buffer;
+				dx_ptr<ID3D11UnorderedAccessView> uav;	//append/consume view
+				dx_ptr<ID3D11ShaderResourceView> srv;
+			};
+
+			unsigned int PrepareEmitters(float dt);
+
+			size_t m_capacity = 0;
+			float m_killLevel = -D3D11_FLOAT32_MAX;
+			EmitterSet m_emitters;
+			std::vector<EmitterData> m_stepEmitters;
+			unsigned int m_seed = 0;
+			unsigned int m_emittersCreated = 0;
+
+			StateBuffer m_state[2];
+			unsigned int m_current = 0;		//buffer holding the particles after the last update
+
+			dx_ptr<ID3D11Buffer> m_emitterTable;
+			dx_ptr<ID3D11ShaderResourceView> m_emitterTableView;
+			dx_ptr<ID3D11Buffer> m_cbSimulation;
+			//Particle count copied from a buffer's hidden counter with CopyStructureCount
+			dx_ptr<ID3D11Buffer> m_cbCount;
+			dx_ptr<ID3D11Buffer> m_dispatchArgs;
+			dx_ptr<ID3D11UnorderedAccessView> m_dispatchArgsView;
+			dx_ptr<ID3D11Buffer> m_drawArgs;
+
+			dx_ptr<ID3D11ComputeShader> m_argsCS;
+			dx_ptr<ID3D11ComputeShader> m_simulateCS;
+			dx_ptr<ID3D11ComputeShader> m_emitCS;
+		};
+	}
+}
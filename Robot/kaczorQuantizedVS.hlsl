@@ -0,0 +1,63 @@
+cbuffer cbWorld : register(b0) //Vertex Shader constant buffer slot 0 - matches slot in vsBilboard.hlsl
+{
+	matrix worldMatrix;
+};
+
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1 - matches slot in vsBilboard.hlsl
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2 - matches slot in vsBilboard.hlsl
+{
+	matrix projMatrix;
+};
+
+cbuffer cbDequantization : register(b4) //PositionDequantization of the mesh, b3 is the clip plane in vs.hlsl
+{
+	float4 positionOffset;
+	float4 positionScale;
+};
+
+//VertexPositionNormalTexQuantized, the input assembler already converts
+//the UNORM/SNORM/FLOAT formats to floats
+struct VSInput
+{
+	float4 pos : POSITION;
+	float2 norm : NORMAL;
+	float2 tex : TEXCOORD;
+};
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION;
+	float2 tex : TEXCOORD;
+	float3 norm : NORMAL;
+	float3 view : VIEW;
+};
+
+//Octahedral decoding, matches OctahedralDecode in vertexQuantization.cpp
+float3 DecodeNormal(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+PSInput main(VSInput i)
+{
+	PSInput o;
+	float3 pos = positionOffset.xyz + i.pos.xyz * positionScale.xyz;
+	o.tex = i.tex;
+	o.worldPos = mul(worldMatrix, float4(pos, 1.0f)).xyz;
+	o.pos = mul(viewMatrix, float4(o.worldPos, 1.0f));
+	o.pos = mul(projMatrix, o.pos);
+	o.norm = mul(worldMatrix, float4(DecodeNormal(i.norm), 0.0f)).xyz;
+	float3 camPos = mul(invViewMatrix, float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+	o.view = camPos - o.worldPos;
+
+	return o;
+}
@@ -0,0 +1,174 @@
+#include "lightFrustum.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+LightFrustum mini::FitLightFrustum(const XMFLOAT4& light, const XMFLOAT3* points, size_t count, float minNear, float maxSlope)
+{
+	LightFrustum result;
+	XMVECTOR center = XMVectorZero();
+	for (size_t i = 0; i < count; ++i)
+		center += XMLoadFloat3(&points[i]);
+	if (count > 0)
+		center /= static_cast<float>(count);
+
+	bool directional = light.w == 0.0f;
+	XMVECTOR position = XMVectorSet(light.x, light.y, light.z, 1.0f);
+	XMVECTOR dir = directional ? -position : center - position;
+	dir = XMVector3Equal(dir, XMVectorZero()) ? XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f) : XMVector3Normalize(dir);
+	XMVECTOR up = fabs(XMVectorGetY(dir)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+	if (directional)
+	{
+		float radius = 0.0f;
+		for (size_t i = 0; i < count; ++i)
+			radius = max(radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&points[i]) - center)));
+		auto view = XMMatrixLookToLH(center - dir * (radius + minNear), dir, up);
+		XMFLOAT3 lo(FLT_MAX, FLT_MAX, FLT_MAX), hi(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT3 p;
+			XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&points[i]), view));
+			lo = { min(lo.x, p.x), min(lo.y, p.y), min(lo.z, p.z) };
+			hi = { max(hi.x, p.x), max(hi.y, p.y), max(hi.z, p.z) };
+		}
+		if (count == 0)
+		{
+			lo = { -1.0f, -1.0f, minNear };
+			hi = { 1.0f, 1.0f, 2.0f * minNear };
+		}
+		XMStoreFloat4x4(&result.view, view);
+		XMStoreFloat4x4(&result.proj, XMMatrixOrthographicOffCenterLH(lo.x, hi.x, lo.y, hi.y, max(lo.z, minNear) * 0.99f, hi.z * 1.01f));
+		return result;
+	}
+
+	auto view = XMMatrixLookToLH(position, dir, up);
+	//bounds of the points' slopes x/z and y/z in light view space
+	float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, nearZ = FLT_MAX, farZ = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMFLOAT3 p;
+		XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&points[i]), view));
+		if (p.z < minNear)
+		{
+			nearZ = minNear;
+			continue;
+		}
+		float sx = clamp(p.x / p.z, -maxSlope, maxSlope), sy = clamp(p.y / p.z, -maxSlope, maxSlope);
+		minX = min(minX, sx);
+		maxX = max(maxX, sx);
+		minY = min(minY, sy);
+		maxY = max(maxY, sy);
+		nearZ = min(nearZ, p.z);
+		farZ = max(farZ, p.z);
+	}
+	if (farZ == 0.0f)
+	{
+		minX = minY = -1.0f;
+		maxX = maxY = 1.0f;
+		nearZ = minNear;
+		farZ = 2.0f * minNear;
+	}
+	//margins keep the points off the clipping planes
+	nearZ *= 0.99f;
+	farZ *= 1.01f;
+	XMStoreFloat4x4(&result.view, view);
+	XMStoreFloat4x4(&result.proj, XMMatrixPerspectiveOffCenterLH(minX * nearZ, maxX * nearZ, minY * nearZ, maxY * nearZ, nearZ, farZ));
+	return result;
+}
+
+void mini::SplitCascades(float nearZ, float farZ, unsigned int count, float lambda, float* splits)
+{
+	for (unsigned int i = 1; i <= count; ++i)
+	{
+		float t = static_cast<float>(i) / count;
+		float logarithmic = nearZ * pow(farZ / nearZ, t);
+		float uniform = nearZ + (farZ - nearZ) * t;
+		splits[i - 1] = lambda * logarithmic + (1.0f - lambda) * uniform;
+	}
+	if (count > 0)
+		splits[count - 1] = farZ;
+}
+
+ShadowCascades mini::FitCascades(const XMFLOAT4& light, const XMFLOAT3* receivers, size_t receiverCount,
+	const CascadeCamera& camera, unsigned int count, float lambda)
+{
+	ShadowCascades result;
+	result.count = clamp(count, 1u, MAX_SHADOW_CASCADES);
+	auto frustum = FitLightFrustum(light, receivers, receiverCount);
+	auto lightViewProj = XMLoadFloat4x4(&frustum.view) * XMLoadFloat4x4(&frustum.proj);
+
+	//only the part of the camera frustum that can see receivers is split
+	auto view = XMLoadFloat4x4(&camera.view);
+	float nearZ = FLT_MAX, farZ = 0.0f;
+	XMVECTOR lo = XMVectorReplicate(FLT_MAX), hi = XMVectorReplicate(-FLT_MAX);
+	for (size_t i = 0; i < receiverCount; ++i)
+	{
+		auto p = XMLoadFloat3(&receivers[i]);
+		lo = XMVectorMin(lo, p);
+		hi = XMVectorMax(hi, p);
+		float z = XMVectorGetZ(XMVector3TransformCoord(p, view));
+		nearZ = min(nearZ, z);
+		farZ = max(farZ, z);
+	}
+	nearZ = max(nearZ, camera.nearZ);
+	farZ = clamp(farZ, nearZ * 1.001f, camera.farZ);
+	SplitCascades(nearZ, farZ, result.count, lambda, result.splits);
+
+	XMVECTOR det;
+	auto invView = XMMatrixInverse(&det, view);
+	float tanY = tan(0.5f * camera.fovY), tanX = tanY * camera.aspect;
+	for (unsigned int c = 0; c < result.count; ++c)
+	{
+		XMStoreFloat4x4(&result.viewProj[c], lightViewProj);
+		if (result.count == 1)
+			break;
+		//world space box of the slice clipped to the receivers' box
+		float sliceZ[2] = { c == 0 ? nearZ : result.splits[c - 1], result.splits[c] };
+		XMVECTOR sliceLo = XMVectorReplicate(FLT_MAX), sliceHi = XMVectorReplicate(-FLT_MAX);
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			float z = sliceZ[corner >> 2];
+			auto p = XMVector3TransformCoord(XMVectorSet((corner & 1 ? tanX : -tanX) * z, (corner & 2 ? tanY : -tanY) * z, z, 1.0f), invView);
+			sliceLo = XMVectorMin(sliceLo, p);
+			sliceHi = XMVectorMax(sliceHi, p);
+		}
+		sliceLo = XMVectorMax(sliceLo, lo);
+		sliceHi = XMVectorMin(sliceHi, hi);
+		if (!XMVector3LessOrEqual(sliceLo, sliceHi))
+			continue;
+
+		float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX;
+		bool behindLight = false;
+		for (int corner = 0; corner < 8 && !behindLight; ++corner)
+		{
+			auto p = XMVectorSelect(sliceLo, sliceHi, XMVectorSelectControl(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1, 0));
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(p, 1.0f), lightViewProj));
+			behindLight = clip.w <= 1e-4f;
+			minX = min(minX, clip.x / clip.w);
+			maxX = max(maxX, clip.x / clip.w);
+			minY = min(minY, clip.y / clip.w);
+			maxY = max(maxY, clip.y / clip.w);
+		}
+		//boxes reaching behind the light keep the whole map
+		minX = max(minX, -1.0f);
+		maxX = min(maxX, 1.0f);
+		minY = max(minY, -1.0f);
+		maxY = min(maxY, 1.0f);
+		if (behindLight || minX >= maxX || minY >= maxY)
+			continue;
+		float sx = 2.0f / (maxX - minX), sy = 2.0f / (maxY - minY);
+		XMMATRIX crop(
+			sx, 0.0f, 0.0f, 0.0f,
+			0.0f, sy, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			-0.5f * (maxX + minX) * sx, -0.5f * (maxY + minY) * sy, 0.0f, 1.0f);
+		XMStoreFloat4x4(&result.viewProj[c], lightViewProj * crop);
+	}
+	return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+namespace mini
+{
+	constexpr unsigned int MAX_SHADOW_CASCADES = 4;
+
+	//Light view and projection of a shadow map (row vectors, as everywhere in DirectXMath)
+	struct LightFrustum
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 proj;
+	};
+
+	//Fits a light frustum around world space points. light.w = 1 gives a perspective frustum from
+	//a point light looking at the points, light.w = 0 an orthographic one shining along -light.xyz.
+	//Points closer to a point light than minNear, or further than maxSlope off its axis, are cut off,
+	//so receivers right next to the light don't blow the field of view up to 180 degrees.
+	LightFrustum FitLightFrustum(const DirectX::XMFLOAT4& light, const DirectX::XMFLOAT3* points, size_t count,
+		float minNear = 0.05f, float maxSlope = 4.0f);
+
+	//Camera whose view depth is split into cascades
+	struct CascadeCamera
+	{
+		DirectX::XMFLOAT4X4 view;
+		float fovY, aspect, nearZ, farZ;
+	};
+
+	struct ShadowCascades
+	{
+		unsigned int count = 0;
+		//light frustum cropped to the camera slice of every cascade
+		DirectX::XMFLOAT4X4 viewProj[MAX_SHADOW_CASCADES];
+		//view depth where every cascade ends, the last one covers everything beyond
+		float splits[MAX_SHADOW_CASCADES];
+	};
+
+	//Practical split scheme, lambda blends uniform (0) and logarithmic (1) splits of [nearZ, farZ]
+	void SplitCascades(float nearZ, float farZ, unsigned int count, float lambda, float* splits);
+
+	//Fits the light frustum to the receivers, then crops it in light clip space to slices of the
+	//camera frustum between the nearest and furthest receiver. With one cascade nothing is cropped.
+	ShadowCascades FitCascades(const DirectX::XMFLOAT4& light, const DirectX::XMFLOAT3* receivers, size_t receiverCount,
+		const CascadeCamera& camera, unsigned int count, float lambda = 0.5f);
+}
@@ -1,5 +1,7 @@
 ﻿#include "exceptions.h"
 #include "robot.h"
+#include "meshFile.h"
+#include <shellapi.h>
 
 using namespace std;
 using namespace mini;
@@ -8,12 +10,33 @@ using namespace gk2;
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine, int cmdShow)
 {
 	UNREFERENCED_PARAMETER(prevInstance);
-	UNREFERENCED_PARAMETER(cmdLine);
 	auto exitCode = EXIT_FAILURE;
+	bool gpuParticles = cmdLine && wcsstr(cmdLine, L"-gpuparticles") != nullptr;
+	bool cpuShadowVolumes = cmdLine && wcsstr(cmdLine, L"-cpushadows") != nullptr;
+	//-nocache processes every asset from its source, for timing cold starts
+	bool assetCache = !(cmdLine && wcsstr(cmdLine, L"-nocache") != nullptr);
+	//-shadowmap[=resolution] and -cascades=count switch the shadow volumes to a shadow map
+	ShadowMapSettings shadowMapSettings;
+	auto shadowMap = cmdLine ? wcsstr(cmdLine, L"-shadowmap") : nullptr;
+	if (shadowMap && shadowMap[10] == L'=')
+		shadowMapSettings.resolution = _wtoi(shadowMap + 11);
+	if (auto cascades = cmdLine ? wcsstr(cmdLine, L"-cascades=") : nullptr)
+		shadowMapSettings.cascadeCount = _wtoi(cascades + 10);
 	CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 	try
 	{
-		Robot app(hInstance);
+		//offline conversion: -convertmesh <text mesh> <binary mesh>
+		int argc = 0;
+		auto argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+		if (argv && argc == 4 && wcscmp(argv[1], L"-convertmesh") == 0)
+		{
+			wstring src = argv[2], dst = argv[3];
+			LocalFree(argv);
+			ConvertTextMesh(src, dst);
+			return EXIT_SUCCESS;
+		}
+		LocalFree(argv);
+		Robot app(hInstance, gpuParticles, cpuShadowVolumes, shadowMap ? &shadowMapSettings : nullptr, assetCache);
 		exitCode = app.Run();
 	}
 	catch (Exception& e)
@@ -1,20 +1,30 @@
 #include "mesh.h"
+#include "meshFile.h"
+#include "meshOptimizer.h"
+#include "vertexQuantization.h"
+#include "meshLod.h"
+#include "silhouette.h"
+#include "assetCache.h"
+#include "exceptions.h"
 #include <algorithm>
 #include <fstream>
+#include <cassert>
 using namespace std;
 using namespace mini;
 using namespace DirectX;
 
 Mesh::Mesh()
-	: m_indexCount(0), m_primitiveType(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED)
+	: m_indexCount(0), m_primitiveType(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED), m_indexFormat(DXGI_FORMAT_R16_UINT)
 { }
 
 Mesh::Mesh(dx_ptr_vector<ID3D11Buffer>&& vbuffers, vector<unsigned int>&& vstrides, vector<unsigned int>&& voffsets,
-	dx_ptr<ID3D11Buffer>&& indices, unsigned int indexCount, D3D_PRIMITIVE_TOPOLOGY primitiveType)
+	dx_ptr<ID3D11Buffer>&& indices, unsigned int indexCount, D3D_PRIMITIVE_TOPOLOGY primitiveType, DXGI_FORMAT indexFormat)
 {
 	assert(vbuffers.size() == voffsets.size() && vbuffers.size() == vstrides.size());
+	assert(indexFormat == DXGI_FORMAT_R16_UINT || indexFormat == DXGI_FORMAT_R32_UINT);
 	m_indexCount = indexCount;
 	m_primitiveType = primitiveType;
+	m_indexFormat = indexFormat;
 	m_indexBuffer = move(indices);
 
 	m_vertexBuffers = std::move(vbuffers);
@@ -25,12 +35,10 @@ Mesh::Mesh(dx_ptr_vector<ID3D11Buffer>&& vbuffers, vector<unsigned int>&& vstrid
 Mesh::Mesh(Mesh&& right) noexcept
 	: m_indexBuffer(move(right.m_indexBuffer)), m_vertexBuffers(move(right.m_vertexBuffers)),
 	m_strides(move(right.m_strides)), m_offsets(move(right.m_offsets)),
-	m_indexCount(right.m_indexCount), m_primitiveType(right.m_primitiveType), indices_(), vertex_(), wszystko(right.wszystko)
+	vertex_(move(right.vertex_)), indices_(move(right.indices_)), m_adjacency(move(right.m_adjacency)),
+	m_indexCount(right.m_indexCount), m_primitiveType(right.m_primitiveType), m_indexFormat(right.m_indexFormat),
+	m_lods(move(right.m_lods))
 {
-	for (auto& ver : right.vertex_)
-		vertex_.push_back(ver);
-	for (auto& ver : right.indices_)
-		indices_.push_back(ver);
 	right.Release();
 }
 
@@ -40,38 +48,87 @@ void Mesh::Release()
 	m_strides.clear();
 	m_offsets.clear();
 	m_indexBuffer.reset();
+	vertex_.clear();
+	indices_.clear();
+	m_adjacency = {};
+	m_lods.clear();
 	m_indexCount = 0;
 	m_primitiveType = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	m_indexFormat = DXGI_FORMAT_R16_UINT;
 }
 
 Mesh& Mesh::operator=(Mesh&& right) noexcept
 {
+	if (this == &right)
+		return *this;
 	Release();
 	m_vertexBuffers = move(right.m_vertexBuffers);
 	m_indexBuffer = move(right.m_indexBuffer);
 	m_strides = move(right.m_strides);
 	m_offsets = move(right.m_offsets);
+	vertex_ = move(right.vertex_);
+	indices_ = move(right.indices_);
+	m_adjacency = move(right.m_adjacency);
 	m_indexCount = right.m_indexCount;
 	m_primitiveType = right.m_primitiveType;
-	wszystko = right.wszystko;
-	for (auto& ver : right.vertex_)
-		vertex_.push_back(ver);
-	for (auto& ver : right.indices_)
-		indices_.push_back(ver);
+	m_indexFormat = right.m_indexFormat;
+	m_lods = move(right.m_lods);
 	right.Release();
 	return *this;
 }
 
+//Mesh factories return by value and members are assigned from them, both must stay cheap
+static_assert(is_nothrow_move_constructible_v<Mesh> && is_nothrow_move_assignable_v<Mesh>, "Mesh moves must not throw");
+static_assert(is_nothrow_move_constructible_v<MeshAdjacency> && is_nothrow_move_assignable_v<MeshAdjacency>, "MeshAdjacency moves must not throw");
+
 void Mesh::Render(const dx_ptr<ID3D11DeviceContext>& context) const
 {
 	if (!m_indexBuffer || m_vertexBuffers.empty())
 		return;
 	context->IASetPrimitiveTopology(m_primitiveType);
-	context->IASetIndexBuffer(m_indexBuffer.get(), DXGI_FORMAT_R16_UINT, 0);
+	context->IASetIndexBuffer(m_indexBuffer.get(), m_indexFormat, 0);
 	context->IASetVertexBuffers(0, m_vertexBuffers.size(), m_vertexBuffers.data(), m_strides.data(), m_offsets.data());
 	context->DrawIndexed(m_indexCount, 0, 0);
 }
 
+void Mesh::Render(const dx_ptr<ID3D11DeviceContext>& context, size_t lod) const
+{
+	if (m_lods.empty())
+		return Render(context);
+	if (!m_indexBuffer || m_vertexBuffers.empty())
+		return;
+	auto& level = m_lods[min(lod, m_lods.size() - 1)];
+	context->IASetPrimitiveTopology(m_primitiveType);
+	context->IASetIndexBuffer(m_indexBuffer.get(), m_indexFormat, 0);
+	context->IASetVertexBuffers(0, m_vertexBuffers.size(), m_vertexBuffers.data(), m_strides.data(), m_offsets.data());
+	context->DrawIndexed(level.indexCount, level.firstIndex, 0);
+}
+
+void Mesh::Render(StateCache& state, size_t lod) const
+{
+	if (!m_indexBuffer || m_vertexBuffers.empty())
+		return;
+	auto context = state.context();
+	state.IASetPrimitiveTopology(m_primitiveType);
+	context->IASetIndexBuffer(m_indexBuffer.get(), m_indexFormat, 0);
+	context->IASetVertexBuffers(0, m_vertexBuffers.size(), m_vertexBuffers.data(), m_strides.data(), m_offsets.data());
+	if (m_lods.empty())
+		context->DrawIndexed(m_indexCount, 0, 0);
+	else
+	{
+		auto& level = m_lods[min(lod, m_lods.size() - 1)];
+		context->DrawIndexed(level.indexCount, level.firstIndex, 0);
+	}
+}
+
+void Mesh::SetLods(vector<MeshLodLevel>&& lods)
+{
+	m_lods = move(lods);
+	//plain Render draws the full detail level only
+	if (!m_lods.empty())
+		m_indexCount = m_lods[0].indexCount;
+}
+
 Mesh::~Mesh()
 {
 	Release();
@@ -310,144 +367,181 @@ std::vector<unsigned short> mini::Mesh::RectangleIdxs()
 	};
 }
 
-Mesh mini::Mesh::ShadowBox(const DxDevice& device, Mesh& source, DirectX::XMFLOAT4 lightPosition, DirectX::XMFLOAT4X4 world)
+Mesh mini::Mesh::ShadowBox(const DxDevice& device, const Mesh& source, DirectX::XMFLOAT4 lightPosition, DirectX::XMFLOAT4X4 world)
 {
-	if (source.wszystko.edges.size() == 0) return {};
+	if (source.m_adjacency.empty()) return {};
 	auto lightPos = XMLoadFloat4(&lightPosition);
 	auto world_ = XMLoadFloat4x4(&world);
 
 	XMVECTOR det;
 	auto inv = XMMatrixInverse(&det, world_);
-	lightPos = XMVector4Transform(lightPos, inv);
-
-	std::vector<DirectX::XMFLOAT3> verts;
-	std::vector<unsigned short> indices;
-
-	//for (int i = 0; i < source.vertex_.size(); i++) {
-	//	verts[2 * i] = source.vertex_[i];
-	//	verts[2 * i + 1] = source.vertex_[i];
-	//	auto vertPos = XMLoadFloat3(&(verts[2 * i]));
-	//	auto from_light = XMVector3Normalize(vertPos - lightPos);
+	XMFLOAT4 light;
+	XMStoreFloat4(&light, XMVector4Transform(lightPos, inv));
+
+	//one-off immutable version of ShadowVolume
+	SilhouetteExtractor silhouette(source.m_adjacency);
+	auto edges = silhouette.Extract(light);
+	std::vector<DirectX::XMFLOAT3> verts(6 * (edges + silhouette.darkFaceCount()));
+	auto sides = silhouette.WriteQuads(verts.data(), verts.size(), 10.0f);
+	silhouette.WriteCaps(verts.data() + sides, verts.size() - sides, 10.0f);
+	std::vector<unsigned int> indices(verts.size());
+	for (unsigned int i = 0; i < indices.size(); ++i)
+		indices[i] = i;
+	return CompactTriMesh(device, verts, indices);
+}
 
-	//	XMStoreFloat3(&(verts[2 * i + 1]), vertPos + 10 * from_light);
-	//}
-	unsigned short index = 0;
-	for (int i = 0; i < source.wszystko.edges.size(); i++)
+namespace
+{
+	//Adjacency of the full detail level
+	MeshAdjacency FullDetailAdjacency(const MeshData& mesh)
 	{
-		DirectX::XMVECTOR v11 = XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr1].p2) - XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr1].p1);
-		DirectX::XMVECTOR v12 = XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr1].p3) - XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr1].p2);
-		DirectX::XMVECTOR v21 = XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr2].p2) - XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr2].p1);
-		DirectX::XMVECTOR v22 = XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr2].p3) - XMLoadFloat3(&source.wszystko.triangles[source.wszystko.edges[i].tr2].p2);
-
-		auto from = source.wszystko.edges[i].posFrom;
-		auto to = source.wszystko.edges[i].posTo;
-
-		auto toLight = XMVector3Normalize(lightPos - XMLoadFloat3(&from));
-
-
-		DirectX::XMVECTOR cross1 = XMVector3Cross(v11, v12);
-		DirectX::XMVECTOR cross2 = XMVector3Cross(v21, v22);
-
-		DirectX::XMFLOAT3 dott1;
-		DirectX::XMFLOAT3 dott2;
-
-		XMStoreFloat3(&dott1, XMVector3Dot(cross1, toLight));
-		XMStoreFloat3(&dott2, XMVector3Dot(cross2, toLight));
+		auto fullIndexCount = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+		return BuildAdjacency(mesh.vertices, vector<unsigned int>(mesh.indices.begin(), mesh.indices.begin() + fullIndexCount));
+	}
 
-		float dot1 = dott1.x;
-		float dot2 = dott2.x;
+	//FullDetailAdjacency of a mapped binary mesh, quantized positions are decoded on the side
+	MeshAdjacency FullDetailAdjacency(const MeshFileView& view)
+	{
+		auto& header = *view.header;
+		auto first = header.lodCount ? view.lods[0].firstIndex : 0;
+		vector<unsigned int> indices(header.lodCount ? view.lods[0].indexCount : header.indexCount);
+		for (size_t i = 0; i < indices.size(); ++i)
+			indices[i] = header.indexSize == 4 ? reinterpret_cast<const uint32_t*>(view.indices)[first + i]
+				: reinterpret_cast<const uint16_t*>(view.indices)[first + i];
+		if (!view.dequantization)
+			return BuildAdjacency(reinterpret_cast<const float*>(view.vertices), header.vertexStride, header.vertexCount, indices);
+		auto& offset = view.dequantization->offset;
+		auto& scale = view.dequantization->scale;
+		auto vertices = reinterpret_cast<const VertexPositionNormalTexQuantized*>(view.vertices);
+		vector<XMFLOAT3> positions(header.vertexCount);
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			auto& p = vertices[i].position;
+			positions[i] = { offset.x + p.x / 65535.0f * scale.x, offset.y + p.y / 65535.0f * scale.y,
+				offset.z + p.z / 65535.0f * scale.z };
+		}
+		return BuildAdjacency(&positions.data()->x, sizeof(XMFLOAT3), positions.size(), indices);
+	}
 
-		if (dot1 * dot2 < 0.0f || (dot1 == 0.0f && dot2 > 0.0f) || (dot2 == 0.0f && dot1 > 0.0f))
+	DecodedMesh DecodeTextMesh(const MappedFile& source, const wstring& path, bool quantize)
+	{
+		DecodedMesh decoded;
+		auto& mesh = decoded.mesh;
+		auto text = reinterpret_cast<const char*>(source.data());
+		mesh = ParseTextMesh(text, text + source.size(), path);
+		OptimizeMesh(mesh);
+		BuildLodChain(mesh);
+		if (quantize)
 		{
-			Triangle t = dot1 > dot2 ? source.wszystko.triangles[source.wszystko.edges[i].tr1] : source.wszystko.triangles[source.wszystko.edges[i].tr2];
-
-			DirectX::XMFLOAT3 from_light_from; XMStoreFloat3(&from_light_from, XMVector3Normalize(XMLoadFloat3(&from) - lightPos));
-			DirectX::XMFLOAT3 inf_from; XMStoreFloat3(&inf_from, XMLoadFloat3(&from) + 10.0f * XMLoadFloat3(&from_light_from));
-			DirectX::XMFLOAT3 from_light_to; XMStoreFloat3(&from_light_to, XMVector3Normalize(XMLoadFloat3(&to) - lightPos));
-			DirectX::XMFLOAT3 inf_to; XMStoreFloat3(&inf_to, XMLoadFloat3(&to) + 10.0f * XMLoadFloat3(&from_light_to));
-
-			verts.push_back(from);
-			verts.push_back(inf_from);
-			verts.push_back(inf_to);
-			verts.push_back(to);
-
-
-			if ((t.p1.x == from.x && t.p1.y == from.y && t.p1.z == from.z &&
-				t.p2.x == to.x && t.p2.y == to.y && t.p2.z == to.z) ||
-				(t.p2.x == from.x && t.p2.y == from.y && t.p2.z == from.z &&
-					t.p3.x == to.x && t.p3.y == to.y && t.p3.z == to.z) ||
-				(t.p3.x == from.x && t.p3.y == from.y && t.p3.z == from.z &&
-					t.p1.x == to.x && t.p1.y == to.y && t.p1.z == to.z))
-			{
-				indices.push_back(index);
-				indices.push_back(index + 2);
-				indices.push_back(index + 1);
-
-				indices.push_back(index);
-				indices.push_back(index + 3);
-				indices.push_back(index + 2);
-			}
+			decoded.quantized = QuantizeVertices(mesh.vertices);
+			decoded.encoding.quantized = AcceptQuantization(MeasureQuantizationError(mesh.vertices, decoded.quantized),
+				BoundingDiagonal(mesh.vertices));
+			if (decoded.encoding.quantized)
+				decoded.encoding.dequantization = decoded.quantized.dequantization;
 			else
-			{
-				indices.push_back(index);
-				indices.push_back(index + 1);
-				indices.push_back(index + 2);
-
-				indices.push_back(index);
-				indices.push_back(index + 2);
-				indices.push_back(index + 3);
-			}
-			index += 4;
-
-
+				decoded.quantized = {};
 		}
+		decoded.adjacency = FullDetailAdjacency(mesh);
+		return decoded;
 	}
 
-	return SimpleTriMesh(device, verts, indices);
+	//The vertex layout is the one stored in the file, the buffers are created from the mapping
+	DecodedMesh DecodeMappedMesh(MappedFile&& file, const wstring& path, bool quantize)
+	{
+		DecodedMesh decoded;
+		auto view = ParseBinaryMesh(file, path);
+		if (view.dequantization && !quantize)
+		{
+			//the caller can't draw quantized vertices
+			decoded.mesh = ReadBinaryMesh(file, path);
+			decoded.adjacency = FullDetailAdjacency(decoded.mesh);
+			return decoded;
+		}
+		decoded.encoding.quantized = view.dequantization != nullptr;
+		if (view.dequantization)
+			decoded.encoding.dequantization = *view.dequantization;
+		decoded.mesh.lods.assign(view.lods, view.lods + view.header->lodCount);
+		decoded.adjacency = FullDetailAdjacency(view);
+		//moving the file keeps the mapping, so the view stays valid
+		decoded.view = view;
+		decoded.file = move(file);
+		return decoded;
+	}
 }
 
-Mesh mini::Mesh::LoadMesh(const DxDevice& device, const std::wstring& meshPath)
+DecodedMesh mini::Mesh::DecodeMesh(const std::wstring& meshPath, bool binary, bool quantize, AssetCache* cache)
 {
-	//File format for VN vertices and IN indices (IN divisible by 3, i.e. IN/3 triangles):
-	//VN IN
-	//pos.x pos.y pos.z norm.x norm.y norm.z tex.x tex.y [VN times, i.e. for each vertex]
-	//t.i1 t.i2 t.i3 [IN/3 times, i.e. for each triangle]
-
-	ifstream input;
-	// In general we shouldn't throw exceptions on end-of-file,
-	// however, in case of this file format if we reach the end
-	// of a file before we read all values, the file is
-	// ill-formated and we would need to throw an exception anyway
-	input.exceptions(ios::badbit | ios::failbit | ios::eofbit);
-	input.open(meshPath);
-
-	int vn, in, kn;
-	input >> vn;
-
-	vector<DirectX::XMFLOAT3> verts_tmp(vn);
-	vector<DirectX::XMFLOAT3> norms_tmp(vn);
-	vector<DirectX::XMFLOAT2> tex_tmp(vn);
-	for (auto i = 0; i < vn; ++i)
+	if (binary)
+		return DecodeMappedMesh(MappedFile(meshPath), meshPath, quantize);
+	MappedFile source(meshPath);
+	if (!cache || !cache->enabled())
+		return DecodeTextMesh(source, meshPath, quantize);
+	auto entry = cache->EntryPath(source, wstring(L"optimized, LODs, ") + (quantize ? L"quantized, " : L"") +
+		L"mesh version " + to_wstring(MeshFileHeader::VERSION), L".mesh");
+	if (auto cached = cache->Find(entry))
 	{
-		input >> verts_tmp[i].x >> verts_tmp[i].y >> verts_tmp[i].z;
-		input >> norms_tmp[i].x >> norms_tmp[i].y >> norms_tmp[i].z;
-		input >> tex_tmp[i].x >> tex_tmp[i].y;
+		try
+		{
+			return DecodeMappedMesh(move(*cached), entry, quantize);
+		}
+		//a damaged entry fails the checksum and is written again
+		catch (const Exception&) { }
 	}
+	auto decoded = DecodeTextMesh(source, meshPath, quantize);
+	cache->Store(entry, [&decoded](const wstring& file)
+	{
+		WriteBinaryMesh(file, decoded.mesh, decoded.encoding.quantized ? &decoded.quantized : nullptr);
+	});
+	return decoded;
+}
 
-	vector<VertexPositionNormalTex> verts(vn);
-	int ind;
-	for (auto i = 0; i < vn; ++i)
+Mesh mini::Mesh::CreateMesh(const DxDevice& device, DecodedMesh&& decoded)
+{
+	if (!decoded.file)
 	{
-		verts[i].position = verts_tmp[i];
-		verts[i].normal = norms_tmp[i];
-		verts[i].tex = tex_tmp[i];
+		auto& mesh = decoded.mesh;
+		auto result = decoded.encoding.quantized ? CompactTriMesh(device, decoded.quantized.vertices, mesh.indices)
+			: CompactTriMesh(device, mesh.vertices, mesh.indices);
+		result.SetLods(move(mesh.lods));
+		result.SetAdjacency(move(decoded.adjacency));
+		return result;
 	}
+	auto& view = decoded.view;
+	auto& header = *view.header;
+	if (header.indexCount == 0)
+		return {};
+	//buffers are filled straight from the mapped blobs
+	Mesh result;
+	result.m_indexBuffer = device.CreateBuffer(view.indices,
+		BufferDescription::IndexBufferDescription(header.indexCount * header.indexSize));
+	result.m_vertexBuffers.push_back(device.CreateBuffer(view.vertices,
+		BufferDescription::VertexBufferDescription(header.vertexCount * header.vertexStride)));
+	result.m_strides.push_back(header.vertexStride);
+	result.m_offsets.push_back(0);
+	result.m_indexCount = header.indexCount;
+	result.m_primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	result.m_indexFormat = header.indexSize == 4 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+	result.SetLods(move(decoded.mesh.lods));
+	result.SetAdjacency(move(decoded.adjacency));
+	return result;
+}
 
-	input >> in;
-	vector<unsigned short> inds(3 * in);
-	for (auto i = 0; i < in; ++i) {
-		input >> inds[3 * i] >> inds[3 * i + 1] >> inds[3 * i + 2];
-	}
+Mesh mini::Mesh::LoadMesh(const DxDevice& device, const std::wstring& meshPath, VertexEncoding* encoding)
+{
+	//File format for VN vertices and IN indices (IN divisible by 3, i.e. IN/3 triangles):
+	//VN IN
+	//pos.x pos.y pos.z norm.x norm.y norm.z tex.x tex.y [VN times, i.e. for each vertex]
+	//t.i1 t.i2 t.i3 [IN/3 times, i.e. for each triangle]
+	auto decoded = DecodeMesh(meshPath, false, encoding != nullptr);
+	if (encoding)
+		*encoding = decoded.encoding;
+	return CreateMesh(device, move(decoded));
+}
 
-	return SimpleTriMesh(device, verts, inds);
-}
\ No newline at end of file
+Mesh mini::Mesh::LoadBinaryMesh(const DxDevice& device, const std::wstring& meshPath, VertexEncoding* encoding)
+{
+	auto decoded = DecodeMesh(meshPath, true, encoding != nullptr);
+	if (encoding)
+		*encoding = decoded.encoding;
+	return CreateMesh(device, move(decoded));
+}
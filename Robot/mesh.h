@@ -2,68 +2,33 @@
 
 #include "dxptr.h"
 #include <vector>
+#include <type_traits>
+#include <optional>
 #include <DirectXMath.h>
-#include <D3D11.h>
+#include <d3d11.h>
 #include "vertexTypes.h"
 #include "dxDevice.h"
+#include "meshFile.h"
+#include "meshAdjacency.h"
+#include "vertexQuantization.h"
+#include "stateCache.h"
 
 namespace mini
 {
-	struct Triangle {
-		DirectX::XMFLOAT3 p1;
-		DirectX::XMFLOAT3 p2;
-		DirectX::XMFLOAT3 p3;
-	};
-
-	struct Edge
-	{
-		DirectX::XMFLOAT3 posFrom;
-		DirectX::XMFLOAT3 posTo;
-		int tr1;
-		int tr2;
-	};
+	class AssetCache;
 
-	struct Wszystko
+	//Everything Mesh::LoadMesh reads and computes before creating the buffers
+	struct DecodedMesh
 	{
-		Wszystko() = default;
-		void operator=(Wszystko&& src) {
-			for (auto& ver : src.edges) {
-				edges.push_back(ver);
-			}
-			for (auto& ver : src.triangles) {
-				triangles.push_back(ver);
-			}
-		}
-
-		void operator=(const Wszystko& src) {
-			for (auto& ver : src.edges) {
-				edges.push_back(ver);
-			}
-			for (auto& ver : src.triangles) {
-				triangles.push_back(ver);
-			}
-		}
-
-		Wszystko(Wszystko&& src) {
-			for (auto& ver : src.edges) {
-				edges.push_back(ver);
-			}
-			for (auto& ver : src.triangles) {
-				triangles.push_back(ver);
-			}
-		}
-
-		Wszystko(const Wszystko& src) {
-			for (auto& ver : src.edges) {
-				edges.push_back(ver);
-			}
-			for (auto& ver : src.triangles) {
-				triangles.push_back(ver);
-			}
-		}
-
-		std::vector<Edge> edges;
-		std::vector<Triangle> triangles;
+		MeshData mesh;
+		//vertices used instead of mesh.vertices when encoding.quantized
+		QuantizedVertices quantized;
+		VertexEncoding encoding;
+		MeshAdjacency adjacency;
+		//binary mesh the buffers are created from in place of the vertices and indices above,
+		//only mesh.lods is filled then
+		std::optional<MappedFile> file;
+		MeshFileView view = {};
 	};
 
 	class Mesh
@@ -74,16 +39,18 @@ namespace mini
 			std::vector<unsigned int>&& vstrides,
 			dx_ptr<ID3D11Buffer>&& indices,
 			unsigned int indexCount,
-			D3D_PRIMITIVE_TOPOLOGY primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+			D3D_PRIMITIVE_TOPOLOGY primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+			DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT)
 			: Mesh(std::move(vbuffers), std::move(vstrides), std::vector<unsigned>(vbuffers.size(), 0U),
-				std::move(indices), indexCount, primitiveType)
+				std::move(indices), indexCount, primitiveType, indexFormat)
 		{ }
 		Mesh(dx_ptr_vector<ID3D11Buffer>&& vbuffers,
 			std::vector<unsigned int>&& vstrides,
 			std::vector<unsigned int>&& voffsets,
 			dx_ptr<ID3D11Buffer>&& indices,
 			unsigned int indexCount,
-			D3D_PRIMITIVE_TOPOLOGY primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			D3D_PRIMITIVE_TOPOLOGY primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+			DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT);
 
 		Mesh(Mesh&& right) noexcept;
 		Mesh(const Mesh& right) = delete;
@@ -93,9 +60,23 @@ namespace mini
 		Mesh& operator=(const Mesh& right) = delete;
 		Mesh& operator=(Mesh&& right) noexcept;
 		void Render(const dx_ptr<ID3D11DeviceContext>& context) const;
+		//Draws one level of detail, 0 is the full detail mesh (see meshLod.h)
+		void Render(const dx_ptr<ID3D11DeviceContext>& context, size_t lod) const;
+		//Same, setting the topology through the state cache so it stays in sync
+		void Render(StateCache& state, size_t lod = 0) const;
+		size_t lodCount() const { return m_lods.empty() ? 1 : m_lods.size(); }
+		float lodError(size_t lod) const { return m_lods.empty() ? 0.0f : m_lods[lod].error; }
+
+		template<typename IndexType>
+		static constexpr DXGI_FORMAT IndexFormat()
+		{
+			static_assert(std::is_same_v<IndexType, unsigned short> || std::is_same_v<IndexType, unsigned int>,
+				"Only 16 and 32-bit indices are supported");
+			return sizeof(IndexType) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		}
 
-		template<typename VertexType>
-		static Mesh SimpleTriMesh(const DxDevice& device, const std::vector<VertexType> verts, const std::vector<unsigned short> idxs)
+		template<typename VertexType, typename IndexType>
+		static Mesh SimpleTriMesh(const DxDevice& device, const std::vector<VertexType>& verts, const std::vector<IndexType>& idxs)
 		{
 			if (idxs.empty())
 				return {};
@@ -106,9 +87,26 @@ namespace mini
 			result.m_offsets.push_back(0);
 			result.m_indexCount = idxs.size();
 			result.m_primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+			result.m_indexFormat = IndexFormat<IndexType>();
 			return result;
 		}
 
+		//Uses 16-bit indices when all vertices can be addressed with them, 32-bit otherwise
+		template<typename VertexType>
+		static Mesh CompactTriMesh(const DxDevice& device, const std::vector<VertexType>& verts, const std::vector<unsigned int>& idxs)
+		{
+			if (!Needs32BitIndices(verts.size()))
+				return SimpleTriMesh(device, verts, std::vector<unsigned short>(idxs.begin(), idxs.end()));
+			return SimpleTriMesh(device, verts, idxs);
+		}
+		static bool Needs32BitIndices(size_t vertexCount) { return vertexCount > 0x10000; }
+
+		DXGI_FORMAT indexFormat() const { return m_indexFormat; }
+
+		//Edge adjacency used for silhouettes, loaded meshes get it built, see meshAdjacency.h
+		const MeshAdjacency& adjacency() const { return m_adjacency; }
+		void SetAdjacency(MeshAdjacency&& adjacency) { m_adjacency = std::move(adjacency); }
+
 		//Box Mesh Creation
 
 		static std::vector<VertexPositionColor> ColoredBoxVerts(float width, float height, float depth);
@@ -130,7 +128,9 @@ namespace mini
 		static Mesh Rectangle(const DxDevice& device, float width = 1.0f, float height = 1.0f) { return SimpleTriMesh(device, RectangleVerts(width, height), RectangleIdxs()); }
 
 		//Shadow Box
-		static Mesh ShadowBox(const DxDevice& device, Mesh& source, DirectX::XMFLOAT4 lightPosition, DirectX::XMFLOAT4X4 world);
+		//Closed shadow volume (sides extruded from the silhouette of source as seen from the light
+		//and caps), needs the adjacency of source. Creates new buffers, use ShadowVolume every frame.
+		static Mesh ShadowBox(const DxDevice& device, const Mesh& source, DirectX::XMFLOAT4 lightPosition, DirectX::XMFLOAT4X4 world);
 
 
 		static std::vector<VertexPositionNormal> ShadedSheetVerts(float side, int number_of_divisions);
@@ -149,16 +149,32 @@ namespace mini
 		static Mesh Billboard(const DxDevice& device, float width, float height) { return SimpleTriMesh(device, BillboardVerts(width, height), BillboardIdx()); }
 		static Mesh Billboard(const DxDevice& device, float side = 1.0f) { return Billboard(device, side, side); }
 
-		static Mesh LoadMesh(const DxDevice& device, const std::wstring& meshPath);
+		//When encoding is given the vertices are quantized (see vertexQuantization.h) if the error
+		//is small enough, encoding then tells which layout and shaders the mesh needs.
+		//The LOD chain is built at load time for text meshes and read from binary ones.
+		static Mesh LoadMesh(const DxDevice& device, const std::wstring& meshPath, VertexEncoding* encoding = nullptr);
+		//Loads a mesh converted offline to the binary format (see meshFile.h), the buffers are
+		//filled straight from the mapped file. The converter chose the vertex layout, without
+		//an encoding quantized vertices are dequantized in memory.
+		static Mesh LoadBinaryMesh(const DxDevice& device, const std::wstring& meshPath, VertexEncoding* encoding = nullptr);
+		//The two halves of LoadMesh and LoadBinaryMesh. DecodeMesh only touches files and memory,
+		//so it can run on any thread, CreateMesh makes the buffers. With a cache text meshes are
+		//optimized, quantized and get their LODs once, later runs map the binary result.
+		static DecodedMesh DecodeMesh(const std::wstring& meshPath, bool binary, bool quantize, AssetCache* cache = nullptr);
+		static Mesh CreateMesh(const DxDevice& device, DecodedMesh&& decoded);
 	private:
+		void SetLods(std::vector<MeshLodLevel>&& lods);
+
 		dx_ptr<ID3D11Buffer> m_indexBuffer;
 		dx_ptr_vector<ID3D11Buffer> m_vertexBuffers;
 		std::vector<unsigned int> m_strides;
 		std::vector<unsigned int> m_offsets;
 		std::vector<DirectX::XMFLOAT3> vertex_;
 		std::vector<DirectX::XMFLOAT2> indices_;
-		Wszystko wszystko;
+		MeshAdjacency m_adjacency;
 		unsigned int m_indexCount;
 		D3D_PRIMITIVE_TOPOLOGY m_primitiveType;
+		DXGI_FORMAT m_indexFormat;
+		std::vector<MeshLodLevel> m_lods;
 	};
 }
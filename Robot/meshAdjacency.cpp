@@ -0,0 +1,174 @@
+#include "meshAdjacency.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Positions within the tolerance of each other end up in the same or neighbouring
+	//cells of a grid with tolerance-sized cells, only those are compared
+	class WeldGrid
+	{
+	public:
+		WeldGrid(float cellSize, size_t capacity)
+			: m_cellSize(cellSize)
+		{
+			m_cells.reserve(capacity);
+		}
+
+		//Index of a position already added within the tolerance, or of the new one
+		unsigned int Weld(const XMFLOAT3& p, vector<XMFLOAT3>& positions)
+		{
+			int64_t cx = Cell(p.x), cy = Cell(p.y), cz = Cell(p.z);
+			float tolerance2 = m_cellSize * m_cellSize;
+			for (int64_t dx = -1; dx <= 1; ++dx)
+				for (int64_t dy = -1; dy <= 1; ++dy)
+					for (int64_t dz = -1; dz <= 1; ++dz)
+					{
+						auto it = m_cells.find(Key(cx + dx, cy + dy, cz + dz));
+						if (it == m_cells.end())
+							continue;
+						for (auto w = it->second; w != NONE; w = m_next[w])
+						{
+							auto& q = positions[w];
+							float x = p.x - q.x, y = p.y - q.y, z = p.z - q.z;
+							if (x * x + y * y + z * z <= tolerance2)
+								return w;
+						}
+					}
+			auto index = static_cast<unsigned int>(positions.size());
+			positions.push_back(p);
+			auto& head = m_cells.emplace(Key(cx, cy, cz), NONE).first->second;
+			m_next.push_back(head);
+			head = index;
+			return index;
+		}
+
+	private:
+		static constexpr unsigned int NONE = ~0u;
+
+		int64_t Cell(float v) const { return static_cast<int64_t>(floor(v / m_cellSize)); }
+		static uint64_t Key(int64_t x, int64_t y, int64_t z)
+		{
+			return static_cast<uint64_t>(x) * 73856093u ^ static_cast<uint64_t>(y) * 19349663u ^ static_cast<uint64_t>(z) * 83492791u;
+		}
+
+		float m_cellSize;
+		//cells whose keys collide share a list, which only costs extra comparisons
+		unordered_map<uint64_t, unsigned int> m_cells;
+		vector<unsigned int> m_next;
+	};
+}
+
+MeshAdjacency mini::BuildAdjacency(const float* positions, size_t stride, size_t vertexCount,
+	const vector<unsigned int>& idxs, float weldTolerance)
+{
+	MeshAdjacency result;
+	if (vertexCount == 0 || idxs.size() < 3)
+		return result;
+	auto position = [positions, stride](unsigned int v)
+	{
+		auto p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+		return XMFLOAT3(p[0], p[1], p[2]);
+	};
+
+	XMFLOAT3 lo = position(0), hi = lo;
+	for (unsigned int v = 1; v < vertexCount; ++v)
+	{
+		auto p = position(v);
+		lo = { min(lo.x, p.x), min(lo.y, p.y), min(lo.z, p.z) };
+		hi = { max(hi.x, p.x), max(hi.y, p.y), max(hi.z, p.z) };
+	}
+	float dx = hi.x - lo.x, dy = hi.y - lo.y, dz = hi.z - lo.z;
+	float diagonal = sqrt(dx * dx + dy * dy + dz * dz);
+	//cells smaller than the float precision of the coordinates would only overflow the grid
+	float cellSize = max(weldTolerance, 1e-7f) * diagonal;
+	WeldGrid grid(cellSize > 0.0f ? cellSize : 1.0f, vertexCount);
+	vector<unsigned int> welded(vertexCount);
+	result.positions.reserve(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; ++v)
+		welded[v] = grid.Weld(position(v), result.positions);
+
+	size_t faceCount = idxs.size() / 3;
+	result.faces.reserve(idxs.size());
+	result.faceNormals.reserve(faceCount);
+	result.edges.reserve(idxs.size() / 2 + 1);
+	unordered_map<uint64_t, unsigned int> edgeAt;
+	edgeAt.reserve(idxs.size());
+	for (size_t t = 0; t < faceCount; ++t)
+	{
+		unsigned int f[3] = { welded[idxs[3 * t]], welded[idxs[3 * t + 1]], welded[idxs[3 * t + 2]] };
+		if (f[0] == f[1] || f[1] == f[2] || f[2] == f[0])
+			continue;
+		auto p0 = XMLoadFloat3(&result.positions[f[0]]);
+		auto normal = XMVector3Cross(XMLoadFloat3(&result.positions[f[1]]) - p0, XMLoadFloat3(&result.positions[f[2]]) - p0);
+		if (XMVector3Equal(normal, XMVectorZero()))
+			continue;
+		auto face = static_cast<unsigned int>(result.faceNormals.size());
+		result.faces.insert(result.faces.end(), f, f + 3);
+		result.faceNormals.emplace_back();
+		XMStoreFloat3(&result.faceNormals.back(), XMVector3Normalize(normal));
+
+		for (int k = 0; k < 3; ++k)
+		{
+			auto a = f[k], b = f[(k + 1) % 3];
+			uint64_t key = a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+			auto it = edgeAt.find(key);
+			if (it != edgeAt.end())
+			{
+				auto& edge = result.edges[it->second];
+				if (edge.face1 == MeshAdjacency::NO_FACE && edge.v0 == b && edge.v1 == a)
+				{
+					edge.face1 = face;
+					continue;
+				}
+			}
+			//new edge, or one that can't be paired with the previous entry
+			edgeAt[key] = static_cast<unsigned int>(result.edges.size());
+			result.edges.push_back({ a, b, face, MeshAdjacency::NO_FACE });
+		}
+	}
+	return result;
+}
+
+vector<unsigned int> mini::BuildAdjacencyIndices(const MeshAdjacency& adjacency)
+{
+	auto& faces = adjacency.faces;
+	vector<unsigned int> result(2 * faces.size());
+	//without a neighbour the face's own third vertex is used, the adjacent triangle is then
+	//the face flipped over and the border edge is a silhouette whenever the face is dark
+	for (size_t f = 0; f < adjacency.faceCount(); ++f)
+		for (int k = 0; k < 3; ++k)
+		{
+			result[6 * f + 2 * k] = faces[3 * f + k];
+			result[6 * f + 2 * k + 1] = faces[3 * f + (k + 2) % 3];
+		}
+	auto third = [&faces](unsigned int face, unsigned int a, unsigned int b)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			auto v = faces[3 * face + k];
+			if (v != a && v != b)
+				return v;
+		}
+		return faces[3 * face];
+	};
+	auto link = [&](unsigned int face, unsigned int from, unsigned int to, unsigned int opposite)
+	{
+		for (int k = 0; k < 3; ++k)
+			if (faces[3 * face + k] == from && faces[3 * face + (k + 1) % 3] == to)
+				result[6 * face + 2 * k + 1] = opposite;
+	};
+	for (auto& e : adjacency.edges)
+	{
+		if (e.face1 == MeshAdjacency::NO_FACE)
+			continue;
+		link(e.face0, e.v0, e.v1, third(e.face1, e.v0, e.v1));
+		link(e.face1, e.v1, e.v0, third(e.face0, e.v0, e.v1));
+	}
+	return result;
+}
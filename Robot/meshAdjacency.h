@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+
+namespace mini
+{
+	//Edge between two faces of a welded mesh. v0 -> v1 follows the winding of face0,
+	//face1 (if any) winds it the other way.
+	struct AdjacencyEdge
+	{
+		unsigned int v0, v1;
+		unsigned int face0, face1;
+	};
+
+	//Topology of a triangle mesh for silhouette extraction. Vertices at (nearly) the same
+	//position are welded, so UV and normal seams don't break the surface into pieces.
+	struct MeshAdjacency
+	{
+		static constexpr unsigned int NO_FACE = ~0u;
+
+		std::vector<DirectX::XMFLOAT3> positions;	//welded
+		std::vector<unsigned int> faces;			//three positions per face, degenerate faces are dropped
+		std::vector<DirectX::XMFLOAT3> faceNormals;	//unit length
+		std::vector<AdjacencyEdge> edges;			//border edges have face1 == NO_FACE
+
+		size_t faceCount() const { return faceNormals.size(); }
+		bool empty() const { return edges.empty(); }
+	};
+
+	//Builds the adjacency in expected O(V + E) time with a spatial hash for welding and
+	//a hash of sorted position pairs for the edges. Edges shared by more than two faces,
+	//or by two faces with inconsistent winding, are split into separate entries.
+	//positions point to the first vertex position, consecutive positions are stride bytes apart.
+	//weldTolerance is relative to the bounding box diagonal.
+	MeshAdjacency BuildAdjacency(const float* positions, size_t stride, size_t vertexCount,
+		const std::vector<unsigned int>& idxs, float weldTolerance = 1e-5f);
+
+	template<typename VertexType>
+	MeshAdjacency BuildAdjacency(const std::vector<VertexType>& verts, const std::vector<unsigned int>& idxs,
+		float weldTolerance = 1e-5f)
+	{
+		return BuildAdjacency(verts.empty() ? nullptr : &verts[0].position.x, sizeof(VertexType), verts.size(), idxs, weldTolerance);
+	}
+
+	//Index list for D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ over the welded positions, six
+	//indices per face: the face's vertices at even positions, each followed by the vertex
+	//opposite its edge to the next one. Border edges get the face's own third vertex.
+	std::vector<unsigned int> BuildAdjacencyIndices(const MeshAdjacency& adjacency);
+}
@@ -0,0 +1,353 @@
+#include "meshFile.h"
+#include "mesh.h"
+#include "meshOptimizer.h"
+#include "meshLod.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <cassert>
+#include "exceptions.h"
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	uint32_t AlignUp(uint32_t offset)
+	{
+		const auto a = MeshFileHeader::BLOB_ALIGNMENT;
+		return (offset + a - 1) / a * a;
+	}
+
+	//Bytes in front of the vertices in the vertex blob
+	uint32_t VertexPrefixSize(MeshVertexFormat format)
+	{
+		return format == MeshVertexFormat::PositionNormalTexQuantized ? sizeof(PositionDequantization) : 0;
+	}
+
+	//Whitespace separated numbers tokenized in place with from_chars,
+	//keeps track of the position for error messages
+	class TextMeshParser
+	{
+	public:
+		TextMeshParser(const char* begin, const char* end, const wstring& path)
+			: m_pos(begin), m_end(end), m_lineStart(begin), m_path(path)
+		{ }
+
+		template<typename T>
+		T Next(const wchar_t* what)
+		{
+			SkipWhitespace();
+			m_token = m_pos;
+			if (m_pos == m_end)
+				Fail(wstring(L"unexpected end of file, expected ") + what);
+			T value;
+			auto result = from_chars(m_pos, m_end, value);
+			if (result.ec != errc() || (result.ptr != m_end && !IsWhitespace(*result.ptr)))
+				Fail(wstring(L"malformed ") + what, true);
+			m_pos = result.ptr;
+			return value;
+		}
+
+		//Throws with the current position, or with the start of the last token
+		[[noreturn]] void Fail(const wstring& message, bool atToken = false) const
+		{
+			auto at = atToken ? m_token : m_pos;
+			auto column = at - m_lineStart + 1;
+			THROW(m_path + L"(" + to_wstring(m_line) + L"," + to_wstring(column) + L"): " + message);
+		}
+
+	private:
+		static bool IsWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+		void SkipWhitespace()
+		{
+			for (; m_pos != m_end && IsWhitespace(*m_pos); ++m_pos)
+				if (*m_pos == '\n')
+				{
+					++m_line;
+					m_lineStart = m_pos + 1;
+				}
+		}
+
+		const char* m_pos;
+		const char* m_end;
+		const char* m_lineStart;
+		const char* m_token = nullptr;
+		unsigned int m_line = 1;
+		const wstring& m_path;
+	};
+}
+
+MeshData mini::ParseTextMesh(const char* begin, const char* end, const wstring& path)
+{
+	TextMeshParser parser(begin, end, path);
+	MeshData mesh;
+	auto vn = parser.Next<unsigned int>(L"vertex count");
+	//every vertex takes at least 16 characters, reject counts the file can't hold
+	if (vn > static_cast<size_t>(end - begin) / 16)
+		parser.Fail(L"vertex count exceeds file size");
+	mesh.vertices.resize(vn);
+	for (auto& v : mesh.vertices)
+	{
+		v.position.x = parser.Next<float>(L"position");
+		v.position.y = parser.Next<float>(L"position");
+		v.position.z = parser.Next<float>(L"position");
+		v.normal.x = parser.Next<float>(L"normal");
+		v.normal.y = parser.Next<float>(L"normal");
+		v.normal.z = parser.Next<float>(L"normal");
+		v.tex.x = parser.Next<float>(L"texture coordinate");
+		v.tex.y = parser.Next<float>(L"texture coordinate");
+	}
+
+	auto tn = parser.Next<unsigned int>(L"triangle count");
+	if (tn > static_cast<size_t>(end - begin) / 6)
+		parser.Fail(L"triangle count exceeds file size");
+	mesh.indices.resize(3 * static_cast<size_t>(tn));
+	for (auto& i : mesh.indices)
+	{
+		auto index = parser.Next<unsigned int>(L"index");
+		if (index >= vn)
+			parser.Fail(L"index " + to_wstring(index) + L" out of range, mesh has " + to_wstring(vn) + L" vertices", true);
+		i = index;
+	}
+	return mesh;
+}
+
+MeshData mini::ReadTextMesh(const wstring& path)
+{
+	MappedFile file(path);
+	auto data = reinterpret_cast<const char*>(file.data());
+	return ParseTextMesh(data, data + file.size(), path);
+}
+
+uint32_t mini::MeshChecksum(const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+void mini::WriteBinaryMesh(const wstring& path, const MeshData& mesh, const QuantizedVertices* quantized)
+{
+	MeshFileHeader header{};
+	memcpy(header.magic, MeshFileHeader::MAGIC, sizeof(header.magic));
+	header.version = MeshFileHeader::VERSION;
+	header.vertexFormat = quantized ? MeshVertexFormat::PositionNormalTexQuantized : MeshVertexFormat::PositionNormalTex;
+	header.vertexStride = quantized ? sizeof(VertexPositionNormalTexQuantized) : sizeof(VertexPositionNormalTex);
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	bool wide = Mesh::Needs32BitIndices(mesh.vertices.size());
+	header.indexSize = wide ? sizeof(uint32_t) : sizeof(uint16_t);
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	header.vertexOffset = AlignUp(sizeof(MeshFileHeader));
+	auto prefix = VertexPrefixSize(header.vertexFormat);
+	header.indexOffset = AlignUp(header.vertexOffset + prefix + header.vertexCount * header.vertexStride);
+	header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+	header.lodOffset = AlignUp(header.indexOffset + header.indexCount * header.indexSize);
+	auto end = AlignUp(header.lodOffset + header.lodCount * static_cast<uint32_t>(sizeof(MeshLodLevel)));
+
+	//everything after the header, blobs at their offsets and zeros in between
+	vector<BYTE> body(end - sizeof(MeshFileHeader), 0);
+	auto vertices = body.data() + header.vertexOffset - sizeof(MeshFileHeader);
+	if (quantized)
+	{
+		assert(quantized->vertices.size() == mesh.vertices.size());
+		memcpy(vertices, &quantized->dequantization, prefix);
+		memcpy(vertices + prefix, quantized->vertices.data(), header.vertexCount * header.vertexStride);
+	}
+	else
+		memcpy(vertices, mesh.vertices.data(), header.vertexCount * header.vertexStride);
+	auto indices = body.data() + header.indexOffset - sizeof(MeshFileHeader);
+	if (wide)
+		memcpy(indices, mesh.indices.data(), header.indexCount * header.indexSize);
+	else
+		for (auto i : mesh.indices)
+		{
+			auto narrow = static_cast<uint16_t>(i);
+			memcpy(indices, &narrow, sizeof(narrow));
+			indices += sizeof(narrow);
+		}
+	if (!mesh.lods.empty())
+		memcpy(body.data() + header.lodOffset - sizeof(MeshFileHeader), mesh.lods.data(), mesh.lods.size() * sizeof(MeshLodLevel));
+	header.checksum = MeshChecksum(body.data(), body.size());
+
+	ofstream output(filesystem::path(path), ios::out | ios::binary | ios::trunc);
+	if (!output)
+		THROW(L"Unable to open " + path);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(body.data()), body.size());
+	if (!output)
+		THROW(L"Error writing " + path);
+}
+
+MeshData mini::ReadBinaryMesh(const wstring& path)
+{
+	return ReadBinaryMesh(MappedFile(path), path);
+}
+
+MeshData mini::ReadBinaryMesh(const MappedFile& file, const wstring& path)
+{
+	auto view = ParseBinaryMesh(file, path);
+	auto& header = *view.header;
+	MeshData mesh;
+	if (view.dequantization)
+	{
+		QuantizedVertices quantized;
+		auto vertices = reinterpret_cast<const VertexPositionNormalTexQuantized*>(view.vertices);
+		quantized.vertices.assign(vertices, vertices + header.vertexCount);
+		quantized.dequantization = *view.dequantization;
+		mesh.vertices = DequantizeVertices(quantized);
+	}
+	else
+	{
+		auto vertices = reinterpret_cast<const VertexPositionNormalTex*>(view.vertices);
+		mesh.vertices.assign(vertices, vertices + header.vertexCount);
+	}
+	mesh.indices.resize(header.indexCount);
+	for (size_t i = 0; i < mesh.indices.size(); ++i)
+		mesh.indices[i] = header.indexSize == sizeof(uint32_t) ? reinterpret_cast<const uint32_t*>(view.indices)[i]
+			: reinterpret_cast<const uint16_t*>(view.indices)[i];
+	mesh.lods.assign(view.lods, view.lods + header.lodCount);
+	return mesh;
+}
+
+void mini::ConvertTextMesh(const wstring& textPath, const wstring& binaryPath)
+{
+	auto mesh = ReadTextMesh(textPath);
+	auto stats = OptimizeMesh(mesh);
+	BuildLodChain(mesh);
+	auto quantized = QuantizeVertices(mesh.vertices);
+	bool accepted = AcceptQuantization(MeasureQuantizationError(mesh.vertices, quantized), BoundingDiagonal(mesh.vertices));
+	wstring report = textPath + L": ACMR " + to_wstring(stats.before.acmr) + L" -> " + to_wstring(stats.after.acmr) +
+		L", ATVR " + to_wstring(stats.before.atvr) + L" -> " + to_wstring(stats.after.atvr) + L", " +
+		to_wstring(max<size_t>(mesh.lods.size(), 1)) + L" LODs, " + (accepted ? L"quantized" : L"float") + L" vertices\n";
+	OutputDebugStringW(report.c_str());
+	WriteBinaryMesh(binaryPath, mesh, accepted ? &quantized : nullptr);
+}
+
+MappedFile::MappedFile(const wstring& path)
+{
+	m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		THROW_WINAPI;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size))
+	{
+		Release();
+		THROW_WINAPI;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	//empty files can't be mapped
+	if (m_size == 0)
+		return;
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		Release();
+		THROW_WINAPI;
+	}
+	m_view = static_cast<const BYTE*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_view)
+	{
+		Release();
+		THROW_WINAPI;
+	}
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: m_file(other.m_file), m_mapping(other.m_mapping), m_view(other.m_view), m_size(other.m_size)
+{
+	other.m_file = INVALID_HANDLE_VALUE;
+	other.m_mapping = nullptr;
+	other.m_view = nullptr;
+	other.m_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Release();
+		std::swap(m_file, other.m_file);
+		std::swap(m_mapping, other.m_mapping);
+		std::swap(m_view, other.m_view);
+		std::swap(m_size, other.m_size);
+	}
+	return *this;
+}
+
+void MappedFile::Release()
+{
+	if (m_view)
+		UnmapViewOfFile(m_view);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_view = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Release();
+}
+
+MeshFileView mini::ParseBinaryMesh(const MappedFile& file, const wstring& path)
+{
+	if (file.size() < sizeof(MeshFileHeader))
+		THROW(L"Truncated mesh file " + path);
+	auto header = reinterpret_cast<const MeshFileHeader*>(file.data());
+	if (memcmp(header->magic, MeshFileHeader::MAGIC, sizeof(header->magic)) != 0)
+		THROW(L"Not a binary mesh file " + path);
+	if (header->version != 1 && header->version != MeshFileHeader::VERSION)
+		THROW(L"Unsupported mesh file version " + to_wstring(header->version) + L" in " + path);
+	if (header->vertexFormat == MeshVertexFormat::PositionNormalTex ? header->vertexStride != sizeof(VertexPositionNormalTex)
+		: header->vertexFormat != MeshVertexFormat::PositionNormalTexQuantized || header->vertexStride != sizeof(VertexPositionNormalTexQuantized))
+		THROW(L"Unsupported vertex format in " + path);
+	if (header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t))
+		THROW(L"Unsupported index size in " + path);
+
+	//64-bit arithmetic, counts come from the file and can't be trusted
+	auto prefix = VertexPrefixSize(header->vertexFormat);
+	auto vertexEnd = static_cast<uint64_t>(header->vertexOffset) + prefix + static_cast<uint64_t>(header->vertexCount) * header->vertexStride;
+	auto indexEnd = static_cast<uint64_t>(header->indexOffset) + static_cast<uint64_t>(header->indexCount) * header->indexSize;
+	if (header->vertexOffset < sizeof(MeshFileHeader) || header->indexOffset < sizeof(MeshFileHeader) ||
+		header->vertexOffset % MeshFileHeader::BLOB_ALIGNMENT || header->indexOffset % MeshFileHeader::BLOB_ALIGNMENT ||
+		vertexEnd > file.size() || indexEnd > file.size())
+		THROW(L"Corrupted mesh file " + path);
+	//version 1 wrote zeros in place of the LOD fields
+	auto lodCount = header->lodCount;
+	auto lodEnd = static_cast<uint64_t>(header->lodOffset) + static_cast<uint64_t>(lodCount) * sizeof(MeshLodLevel);
+	if (lodCount > 0 && (header->lodOffset < sizeof(MeshFileHeader) || header->lodOffset % MeshFileHeader::BLOB_ALIGNMENT ||
+		lodEnd > file.size()))
+		THROW(L"Corrupted mesh file " + path);
+	if (MeshChecksum(file.data() + sizeof(MeshFileHeader), file.size() - sizeof(MeshFileHeader)) != header->checksum)
+		THROW(L"Checksum mismatch in mesh file " + path);
+
+	auto lods = lodCount > 0 ? reinterpret_cast<const MeshLodLevel*>(file.data() + header->lodOffset) : nullptr;
+	for (uint32_t i = 0; i < lodCount; ++i)
+		if (static_cast<uint64_t>(lods[i].firstIndex) + lods[i].indexCount > header->indexCount || lods[i].indexCount % 3)
+			THROW(L"Corrupted LOD table in mesh file " + path);
+	//indices go straight to the GPU, one past the vertices would read outside the vertex buffer
+	auto indices = file.data() + header->indexOffset;
+	bool indicesInRange = header->indexSize == sizeof(uint32_t)
+		? all_of(reinterpret_cast<const uint32_t*>(indices), reinterpret_cast<const uint32_t*>(indices) + header->indexCount,
+			[header](uint32_t i) { return i < header->vertexCount; })
+		: all_of(reinterpret_cast<const uint16_t*>(indices), reinterpret_cast<const uint16_t*>(indices) + header->indexCount,
+			[header](uint16_t i) { return i < header->vertexCount; });
+	if (!indicesInRange)
+		THROW(L"Index out of range in mesh file " + path);
+	auto dequantization = prefix ? reinterpret_cast<const PositionDequantization*>(file.data() + header->vertexOffset) : nullptr;
+	return { header, file.data() + header->vertexOffset + prefix, dequantization, indices, lods };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vertexTypes.h"
+#include "vertexQuantization.h"
+
+namespace mini
+{
+	//Binary mesh container (*.mesh). Layout:
+	//MeshFileHeader
+	//vertex blob at vertexOffset, vertexCount * vertexStride bytes, for quantized formats
+	//preceded by the PositionDequantization of the mesh
+	//index blob at indexOffset, indexCount * indexSize bytes
+	//LOD table at lodOffset, lodCount MeshLodLevels (version 2, see meshLod.h)
+	//All blobs start at multiples of BLOB_ALIGNMENT, the gaps are zero-filled.
+	//The checksum covers everything after the header.
+	enum class MeshVertexFormat : uint32_t
+	{
+		PositionNormalTex = 1,			//VertexPositionNormalTex
+		PositionNormalTexQuantized = 2	//VertexPositionNormalTexQuantized
+	};
+
+	struct MeshFileHeader
+	{
+		static constexpr char MAGIC[4] = { 'M', 'E', 'S', 'H' };
+		static constexpr uint32_t VERSION = 2;	//version 1 files have no LOD table
+		static constexpr uint32_t BLOB_ALIGNMENT = 16;
+
+		char magic[4];
+		uint32_t version;
+		MeshVertexFormat vertexFormat;
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexSize;		//bytes per index, 2 or 4
+		uint32_t indexCount;
+		uint32_t vertexOffset;
+		uint32_t indexOffset;
+		uint32_t checksum;
+		uint32_t lodCount;		//0 when the whole index blob is a single level
+		uint32_t lodOffset;
+	};
+	static_assert(sizeof(MeshFileHeader) == 48, "MeshFileHeader is written to disk as is");
+
+	//Range of the index buffer drawn for one level of detail
+	struct MeshLodLevel
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;			//largest distance from the full detail surface, in model units
+		uint32_t reserved;
+	};
+	static_assert(sizeof(MeshLodLevel) == 16, "MeshLodLevel is written to disk as is");
+
+	//CPU-side mesh in the layout used by Mesh::LoadMesh
+	struct MeshData
+	{
+		std::vector<VertexPositionNormalTex> vertices;
+		std::vector<unsigned int> indices;	//narrowed to 16 bits when the vertex count allows
+		std::vector<MeshLodLevel> lods;		//empty when indices hold a single level
+	};
+
+	//Reads the text format described in Mesh::LoadMesh. The whole file is read at once
+	//and parsed straight into the vertex array, malformed input and indices out of range
+	//are reported with the line and column.
+	MeshData ReadTextMesh(const std::wstring& path);
+	//Parses text mesh data in memory, path is used in error messages only
+	MeshData ParseTextMesh(const char* begin, const char* end, const std::wstring& path);
+	//When quantized is given its vertices are stored in place of mesh.vertices
+	void WriteBinaryMesh(const std::wstring& path, const MeshData& mesh, const QuantizedVertices* quantized = nullptr);
+	//Copies a binary mesh into memory, quantized vertices are dequantized
+	MeshData ReadBinaryMesh(const std::wstring& path);
+	//Offline conversion from the text format to the binary one, the mesh is optimized
+	//for the vertex cache (see meshOptimizer.h) and gets a LOD chain before it is written.
+	//Vertices are stored quantized when the error is within the default tolerance.
+	void ConvertTextMesh(const std::wstring& textPath, const std::wstring& binaryPath);
+
+	//FNV-1a hash of the data
+	uint32_t MeshChecksum(const void* data, size_t size);
+
+	//Whole file mapped read-only into memory
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::wstring& path);
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		~MappedFile();
+
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const BYTE* data() const { return m_view; }
+		size_t size() const { return m_size; }
+
+	private:
+		void Release();
+
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+		const BYTE* m_view = nullptr;
+		size_t m_size = 0;
+	};
+
+	//Validated view of a binary mesh inside a mapped file
+	struct MeshFileView
+	{
+		const MeshFileHeader* header;
+		const BYTE* vertices;
+		const PositionDequantization* dequantization;	//null unless the vertices are quantized
+		const BYTE* indices;
+		const MeshLodLevel* lods;	//header->lodCount levels
+	};
+	//Checks the header, blob bounds, LOD ranges, checksum and index values, throws on malformed files
+	MeshFileView ParseBinaryMesh(const MappedFile& file, const std::wstring& path);
+	//ReadBinaryMesh of a file mapped already
+	MeshData ReadBinaryMesh(const MappedFile& file, const std::wstring& path);
+}
@@ -0,0 +1,321 @@
+#include "meshLod.h"
+#include "meshFile.h"
+#include "meshOptimizer.h"
+#include "mesh.h"
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <cassert>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Weight of the planes added along open borders relative to the faces
+	constexpr double BORDER_WEIGHT = 10.0;
+	//Collapses turning a face by more than this (cosine) are rejected
+	constexpr double MIN_NORMAL_COSINE = 0.25;
+
+	//Symmetric 4x4 matrix of the plane equations summed over the faces around a vertex,
+	//the weight turns the sum of squared distances into their mean
+	struct Quadric
+	{
+		double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+		double weight;
+
+		void AddPlane(double nx, double ny, double nz, double d, double w)
+		{
+			a00 += w * nx * nx; a01 += w * nx * ny; a02 += w * nx * nz; a03 += w * nx * d;
+			a11 += w * ny * ny; a12 += w * ny * nz; a13 += w * ny * d;
+			a22 += w * nz * nz; a23 += w * nz * d;
+			a33 += w * d * d;
+			weight += w;
+		}
+
+		Quadric& operator+=(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+			weight += q.weight;
+			return *this;
+		}
+
+		//Mean squared distance of p from the planes
+		double Error(const XMFLOAT3& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+				2.0 * (a01 * x * y + a02 * x * z + a03 * x + a12 * y * z + a13 * y + a23 * z);
+			return weight > 0.0 ? max(e, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Vector3d
+	{
+		double x, y, z;
+	};
+
+	Vector3d Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	Vector3d Cross(const Vector3d& a, const Vector3d& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	double Dot(const Vector3d& a, const Vector3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	double Length(const Vector3d& a) { return sqrt(Dot(a, a)); }
+
+	Vector3d FaceNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		return Cross(Sub(p1, p0), Sub(p2, p0));
+	}
+
+	struct Collapse
+	{
+		unsigned int from, to;
+		double error;
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const XMFLOAT3& p) const
+		{
+			uint32_t bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const XMFLOAT3& a, const XMFLOAT3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	};
+
+	//Vertex to triangle lists in a single array
+	struct Adjacency
+	{
+		vector<unsigned int> offsets;
+		vector<unsigned int> triangles;
+
+		Adjacency(const vector<unsigned int>& idxs, size_t vertexCount)
+			: offsets(vertexCount + 1, 0), triangles(idxs.size())
+		{
+			for (auto i : idxs)
+				++offsets[i + 1];
+			for (size_t v = 0; v < vertexCount; ++v)
+				offsets[v + 1] += offsets[v];
+			vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < idxs.size(); ++i)
+				triangles[fill[idxs[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	};
+
+	//Whether moving from onto to keeps all the remaining faces around from facing the same way
+	bool KeepsOrientation(const vector<VertexPositionNormalTex>& verts, const vector<unsigned int>& idxs,
+		const Adjacency& adjacency, unsigned int from, unsigned int to)
+	{
+		for (auto a = adjacency.offsets[from]; a < adjacency.offsets[from + 1]; ++a)
+		{
+			auto t = adjacency.triangles[a];
+			const unsigned int* tri = &idxs[3 * t];
+			if (tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;	//the face degenerates and is removed
+			XMFLOAT3 p[3], q[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				p[k] = verts[tri[k]].position;
+				q[k] = tri[k] == from ? verts[to].position : p[k];
+			}
+			auto before = FaceNormal(p[0], p[1], p[2]), after = FaceNormal(q[0], q[1], q[2]);
+			double lengths = Length(before) * Length(after);
+			if (lengths == 0.0 || Dot(before, after) < MIN_NORMAL_COSINE * lengths)
+				return false;
+		}
+		return true;
+	}
+}
+
+vector<unsigned int> mini::SimplifyMesh(const vector<VertexPositionNormalTex>& verts, const vector<unsigned int>& idxs,
+	size_t targetIndexCount, float maxError, float* resultError)
+{
+	assert(idxs.size() % 3 == 0);
+	size_t vertexCount = verts.size();
+	double maxSquaredError = static_cast<double>(maxError) * maxError;
+	double largestError = 0.0;
+
+	//vertices at the same position form one corner of the surface, corners with more
+	//than one vertex lie on a seam and stay in place
+	vector<unsigned int> corner(vertexCount);
+	vector<bool> locked(vertexCount, false);
+	{
+		unordered_map<XMFLOAT3, unsigned int, PositionHash, PositionEqual> firstAt;
+		firstAt.reserve(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; ++v)
+		{
+			auto it = firstAt.emplace(verts[v].position, v).first;
+			corner[v] = it->second;
+			if (it->second != v)
+				locked[v] = locked[it->second] = true;
+		}
+	}
+
+	vector<Quadric> quadrics(vertexCount, Quadric{});
+	{
+		//edges used by a single face are open borders, corner pairs are
+		//used so that seams don't count as borders
+		unordered_map<uint64_t, unsigned int> edgeUse;
+		auto edgeKey = [&corner](unsigned int a, unsigned int b)
+		{
+			uint64_t ca = corner[a], cb = corner[b];
+			return ca < cb ? (ca << 32) | cb : (cb << 32) | ca;
+		};
+		for (size_t t = 0; t < idxs.size(); t += 3)
+			for (int k = 0; k < 3; ++k)
+				++edgeUse[edgeKey(idxs[t + k], idxs[t + (k + 1) % 3])];
+
+		for (size_t t = 0; t < idxs.size(); t += 3)
+		{
+			auto& p0 = verts[idxs[t]].position;
+			auto normal = FaceNormal(p0, verts[idxs[t + 1]].position, verts[idxs[t + 2]].position);
+			double area = Length(normal);
+			if (area == 0.0)
+				continue;
+			Vector3d n = { normal.x / area, normal.y / area, normal.z / area };
+			double d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+			for (int k = 0; k < 3; ++k)
+			{
+				quadrics[corner[idxs[t + k]]].AddPlane(n.x, n.y, n.z, d, area);
+				auto a = idxs[t + k], b = idxs[t + (k + 1) % 3];
+				if (edgeUse[edgeKey(a, b)] != 1)
+					continue;
+				//plane through the border edge perpendicular to the face
+				auto edge = Sub(verts[b].position, verts[a].position);
+				auto side = Cross(edge, n);
+				double length = Length(side);
+				if (length == 0.0)
+					continue;
+				Vector3d s = { side.x / length, side.y / length, side.z / length };
+				auto& pa = verts[a].position;
+				double sd = -(s.x * pa.x + s.y * pa.y + s.z * pa.z);
+				double w = BORDER_WEIGHT * Dot(edge, edge);
+				quadrics[corner[a]].AddPlane(s.x, s.y, s.z, sd, w);
+				quadrics[corner[b]].AddPlane(s.x, s.y, s.z, sd, w);
+			}
+		}
+	}
+
+	vector<unsigned int> result = idxs;
+	vector<Collapse> collapses;
+	vector<unsigned int> remap(vertexCount);
+	vector<bool> touched(vertexCount);
+	//every pass collapses independent edges in order of increasing error
+	while (result.size() > targetIndexCount)
+	{
+		Adjacency adjacency(result, vertexCount);
+		collapses.clear();
+		for (size_t t = 0; t < result.size(); t += 3)
+			for (int k = 0; k < 3; ++k)
+			{
+				auto from = result[t + k], to = result[t + (k + 1) % 3];
+				for (int direction = 0; direction < 2; ++direction, std::swap(from, to))
+				{
+					if (locked[from])
+						continue;
+					Quadric q = quadrics[corner[from]];
+					q += quadrics[corner[to]];
+					collapses.push_back({ from, to, q.Error(verts[to].position) });
+				}
+			}
+		sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		for (unsigned int v = 0; v < vertexCount; ++v)
+			remap[v] = v;
+		fill(touched.begin(), touched.end(), false);
+		//every collapse removes about two faces
+		size_t collapsesLeft = (result.size() - targetIndexCount) / 6 + 1;
+		size_t collapsed = 0;
+		for (auto& c : collapses)
+		{
+			if (c.error > maxSquaredError || collapsed == collapsesLeft)
+				break;
+			if (touched[c.from] || touched[c.to])
+				continue;
+			if (!KeepsOrientation(verts, result, adjacency, c.from, c.to))
+				continue;
+			remap[c.from] = c.to;
+			quadrics[corner[c.to]] += quadrics[corner[c.from]];
+			largestError = max(largestError, c.error);
+			++collapsed;
+			//faces around the collapsed vertex change, so do their other collapses
+			for (auto a = adjacency.offsets[c.from]; a < adjacency.offsets[c.from + 1]; ++a)
+				for (int k = 0; k < 3; ++k)
+					touched[result[3 * adjacency.triangles[a] + k]] = true;
+		}
+		if (collapsed == 0)
+			break;
+
+		size_t write = 0;
+		for (size_t t = 0; t < result.size(); t += 3)
+		{
+			auto a = remap[result[t]], b = remap[result[t + 1]], c = remap[result[t + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	if (resultError)
+		*resultError = static_cast<float>(sqrt(largestError));
+	return result;
+}
+
+void mini::BuildLodChain(MeshData& mesh, const LodChainOptions& options)
+{
+	mesh.lods.clear();
+	if (mesh.indices.empty())
+		return;
+	auto fullCount = static_cast<uint32_t>(mesh.indices.size());
+	mesh.lods.push_back({ 0, fullCount, 0.0f, 0 });
+
+	XMFLOAT3 lo = mesh.vertices[0].position, hi = lo;
+	for (auto& v : mesh.vertices)
+	{
+		lo = { min(lo.x, v.position.x), min(lo.y, v.position.y), min(lo.z, v.position.z) };
+		hi = { max(hi.x, v.position.x), max(hi.y, v.position.y), max(hi.z, v.position.z) };
+	}
+	auto diagonal = static_cast<float>(Length(Sub(hi, lo)));
+
+	vector<unsigned int> full(mesh.indices.begin(), mesh.indices.end());
+	size_t previousCount = full.size();
+	while (mesh.lods.size() < options.maxLevels && previousCount / 3 > options.minTriangles)
+	{
+		size_t target = static_cast<size_t>(previousCount / 3 * options.reduction) * 3;
+		float error;
+		auto level = SimplifyMesh(mesh.vertices, full, target, options.maxError * diagonal, &error);
+		//stop when the error limit or seams prevent a real reduction
+		if (level.size() > previousCount * 9 / 10)
+			break;
+		level = OptimizeVertexCache(level, mesh.vertices.size());
+		mesh.lods.push_back({ static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(level.size()), error, 0 });
+		mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+		previousCount = level.size();
+	}
+	if (mesh.lods.size() == 1)
+		mesh.lods.clear();
+}
+
+size_t mini::SelectLod(const Mesh& mesh, float worldScale, const XMFLOAT3& worldCenter,
+	const OrbitCamera& camera, float projectionScale, float maxPixelError)
+{
+	auto eye = camera.getCameraPosition();
+	float dx = worldCenter.x - eye.x, dy = worldCenter.y - eye.y, dz = worldCenter.z - eye.z;
+	float distance = sqrt(dx * dx + dy * dy + dz * dz);
+	size_t lod = 0;
+	for (size_t i = 1; i < mesh.lodCount(); ++i)
+		//error projected at the object's center, levels are ordered by increasing error
+		if (mesh.lodError(i) * worldScale * projectionScale <= maxPixelError * distance)
+			lod = i;
+	return lod;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <DirectXMath.h>
+#include "vertexTypes.h"
+#include "camera.h"
+
+namespace mini
+{
+	struct MeshData;
+	class Mesh;
+
+	//Quadric error metric edge collapse (Garland-Heckbert) restricted to collapses onto existing
+	//vertices, so the result is a new index buffer over the same vertices. Vertices shared by
+	//a UV or normal seam are never moved, open borders are kept with extra border quadrics.
+	//Stops at targetIndexCount or when the next collapse would move the surface by more than
+	//maxError (in model units). resultError receives the largest error introduced.
+	std::vector<unsigned int> SimplifyMesh(const std::vector<VertexPositionNormalTex>& verts,
+		const std::vector<unsigned int>& idxs, size_t targetIndexCount, float maxError, float* resultError = nullptr);
+
+	struct LodChainOptions
+	{
+		unsigned int maxLevels = 5;			//including the full detail level
+		float reduction = 0.5f;				//triangle count of every level relative to the previous one
+		float maxError = 0.02f;				//relative to the bounding box diagonal
+		unsigned int minTriangles = 64;
+	};
+
+	//Appends simplified index lists to mesh.indices and describes all levels in mesh.lods.
+	//Every level is simplified from the full detail one and cache optimized.
+	void BuildLodChain(MeshData& mesh, const LodChainOptions& options = {});
+
+	//Pixels per model unit at unit distance for a perspective projection
+	inline float ProjectionScale(float fovY, float viewportHeight)
+	{
+		return viewportHeight / (2.0f * std::tan(fovY / 2.0f));
+	}
+
+	//Coarsest level of the mesh whose error projected on the screen stays below maxPixelError.
+	//worldScale converts model units to world units, worldCenter is the object's position.
+	size_t SelectLod(const Mesh& mesh, float worldScale, const DirectX::XMFLOAT3& worldCenter,
+		const OrbitCamera& camera, float projectionScale, float maxPixelError = 1.0f);
+}
@@ -0,0 +1,266 @@
+#include "meshOptimizer.h"
+#include "meshFile.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//Parameters from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	constexpr int CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	float VertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		//vertices without triangles left are never used again
+		if (remainingTriangles == 0)
+			return -1.0f;
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			//the last triangle's vertices get a fixed score to avoid
+			//using them twice in a row, which is bad for strips
+			if (cachePosition < 3)
+				score = LAST_TRIANGLE_SCORE;
+			else
+				score = pow(1.0f - static_cast<float>(cachePosition - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+		//boost vertices with few triangles left, so that lone triangles aren't left behind
+		return score + VALENCE_BOOST_SCALE * pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+	}
+
+	//Number of newly transformed vertices for every triangle with a FIFO cache
+	vector<unsigned char> SimulateMisses(const vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+	{
+		//a vertex is in the cache while less than cacheSize misses happened since it was loaded
+		vector<size_t> loadedAt(vertexCount, 0);
+		size_t misses = 0;
+		vector<unsigned char> result(indices.size() / 3);
+		for (size_t t = 0; t < result.size(); ++t)
+			for (int k = 0; k < 3; ++k)
+			{
+				auto v = indices[3 * t + k];
+				if (loadedAt[v] == 0 || misses - (loadedAt[v] - 1) >= cacheSize)
+				{
+					loadedAt[v] = ++misses;
+					++result[t];
+				}
+			}
+		return result;
+	}
+}
+
+VertexCacheStats mini::AnalyzeVertexCache(const vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	auto misses = SimulateMisses(indices, vertexCount, cacheSize);
+	size_t transformed = 0;
+	for (auto m : misses)
+		transformed += m;
+	VertexCacheStats stats;
+	stats.acmr = misses.empty() ? 0.0f : static_cast<float>(transformed) / misses.size();
+	stats.atvr = vertexCount == 0 ? 0.0f : static_cast<float>(transformed) / vertexCount;
+	return stats;
+}
+
+vector<unsigned int> mini::OptimizeVertexCache(const vector<unsigned int>& indices, size_t vertexCount)
+{
+	assert(indices.size() % 3 == 0);
+	size_t triangleCount = indices.size() / 3;
+	vector<unsigned int> result;
+	result.reserve(indices.size());
+	if (triangleCount == 0)
+		return result;
+
+	//triangles adjacent to every vertex, the ones not emitted yet are kept
+	//at the front of each vertex' range
+	vector<unsigned int> remaining(vertexCount, 0);
+	for (auto i : indices)
+		++remaining[i];
+	vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+	vector<unsigned int> adjacency(indices.size());
+	{
+		vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+			for (int k = 0; k < 3; ++k)
+				adjacency[fill[indices[3 * t + k]]++] = static_cast<unsigned int>(t);
+	}
+
+	vector<int> cachePosition(vertexCount, -1);
+	vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	vector<float> triangleScore(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+		triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+	vector<bool> emitted(triangleCount, false);
+
+	//three extra entries hold vertices pushed out by the last triangle
+	vector<unsigned int> cache, nextCache;
+	cache.reserve(CACHE_SIZE + 3);
+	nextCache.reserve(CACHE_SIZE + 3);
+
+	size_t inputCursor = 0;	//fallback when no triangle in the cache is left
+	auto best = static_cast<size_t>(max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		if (best == triangleCount)
+		{
+			while (emitted[inputCursor])
+				++inputCursor;
+			best = inputCursor;
+		}
+
+		emitted[best] = true;
+		nextCache.clear();
+		for (int k = 0; k < 3; ++k)
+		{
+			auto v = indices[3 * best + k];
+			result.push_back(v);
+			nextCache.push_back(v);
+			//move the triangle past the end of the vertex' remaining range
+			auto first = adjacency.begin() + adjacencyOffset[v];
+			auto last = first + remaining[v];
+			iter_swap(find(first, last, static_cast<unsigned int>(best)), last - 1);
+			--remaining[v];
+		}
+		for (auto v : cache)
+			if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2])
+				nextCache.push_back(v);
+		//vertices falling out of the cache lose their position score
+		for (size_t p = CACHE_SIZE; p < nextCache.size(); ++p)
+		{
+			cachePosition[nextCache[p]] = -1;
+			vertexScore[nextCache[p]] = VertexScore(-1, remaining[nextCache[p]]);
+		}
+		if (nextCache.size() > CACHE_SIZE)
+			nextCache.resize(CACHE_SIZE);
+		for (size_t p = 0; p < nextCache.size(); ++p)
+		{
+			cachePosition[nextCache[p]] = static_cast<int>(p);
+			vertexScore[nextCache[p]] = VertexScore(static_cast<int>(p), remaining[nextCache[p]]);
+		}
+		cache.swap(nextCache);
+
+		//only triangles touching the cache changed their score
+		best = triangleCount;
+		float bestScore = -1.0f;
+		for (auto v : cache)
+			for (auto a = adjacencyOffset[v]; a < adjacencyOffset[v] + remaining[v]; ++a)
+			{
+				auto t = adjacency[a];
+				float score = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+				triangleScore[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+	}
+	return result;
+}
+
+vector<unsigned int> mini::OptimizeOverdraw(const vector<unsigned int>& indices, const float* positions, size_t vertexCount,
+	size_t stride, unsigned int cacheSize)
+{
+	auto position = [positions, stride](unsigned int v)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+	};
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return indices;
+
+	//clusters start at triangles missing the cache with all their vertices
+	auto misses = SimulateMisses(indices, vertexCount, cacheSize);
+	vector<size_t> clusterStart;
+	for (size_t t = 0; t < triangleCount; ++t)
+		if (t == 0 || misses[t] == 3)
+			clusterStart.push_back(t);
+	clusterStart.push_back(triangleCount);
+	size_t clusterCount = clusterStart.size() - 1;
+
+	float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+	for (auto i : indices)
+		for (int c = 0; c < 3; ++c)
+			meshCenter[c] += position(i)[c];
+	for (auto& c : meshCenter)
+		c /= indices.size();
+
+	//clusters facing away from the center are likely in front of the others
+	vector<float> sortKey(clusterCount);
+	for (size_t k = 0; k < clusterCount; ++k)
+	{
+		float center[3] = { 0.0f, 0.0f, 0.0f }, normal[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t t = clusterStart[k]; t < clusterStart[k + 1]; ++t)
+		{
+			auto p0 = position(indices[3 * t]), p1 = position(indices[3 * t + 1]), p2 = position(indices[3 * t + 2]);
+			float e1[3], e2[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				e1[c] = p1[c] - p0[c];
+				e2[c] = p2[c] - p0[c];
+				center[c] += p0[c] + p1[c] + p2[c];
+			}
+			//area-weighted face normal
+			normal[0] += e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] += e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] += e1[0] * e2[1] - e1[1] * e2[0];
+		}
+		float n = 3.0f * (clusterStart[k + 1] - clusterStart[k]);
+		float length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+		if (length > 0.0f)
+			for (int c = 0; c < 3; ++c)
+				key += (center[c] / n - meshCenter[c]) * normal[c] / length;
+		sortKey[k] = key;
+	}
+
+	vector<size_t> order(clusterCount);
+	for (size_t k = 0; k < clusterCount; ++k)
+		order[k] = k;
+	stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+	vector<unsigned int> result;
+	result.reserve(indices.size());
+	for (auto k : order)
+		result.insert(result.end(), indices.begin() + 3 * clusterStart[k], indices.begin() + 3 * clusterStart[k + 1]);
+	return result;
+}
+
+vector<unsigned int> mini::VertexFetchRemap(const vector<unsigned int>& indices, size_t vertexCount, size_t& usedCount)
+{
+	vector<unsigned int> remap(vertexCount, UNUSED_VERTEX);
+	unsigned int next = 0;
+	for (auto i : indices)
+		if (remap[i] == UNUSED_VERTEX)
+			remap[i] = next++;
+	usedCount = next;
+	return remap;
+}
+
+MeshOptimizationStats mini::OptimizeMesh(MeshData& mesh, bool sortOverdraw)
+{
+	MeshOptimizationStats stats;
+	stats.before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	if (mesh.indices.empty())
+	{
+		stats.after = stats.before;
+		return stats;
+	}
+	mesh.indices = OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	if (sortOverdraw)
+		mesh.indices = OptimizeOverdraw(mesh.indices, &mesh.vertices[0].position.x, mesh.vertices.size(),
+			sizeof(VertexPositionNormalTex));
+	OptimizeVertexFetch(mesh.vertices, mesh.indices);
+	stats.after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	return stats;
+}
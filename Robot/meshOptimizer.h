@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace mini
+{
+	struct MeshData;
+
+	//Post-transform vertex cache efficiency of an index buffer
+	struct VertexCacheStats
+	{
+		float acmr;		//average cache miss ratio, transformed vertices per triangle (0.5 - 3.0)
+		float atvr;		//average transform to vertex ratio, transformed vertices per vertex (1.0 best)
+	};
+
+	//Simulates a FIFO post-transform cache of the given size
+	VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+		unsigned int cacheSize = 16);
+
+	//Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+	std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount);
+
+	//Reorders clusters of cache-optimized triangles so that those facing away from the mesh
+	//center (and thus likely to occlude the others) are drawn first. Clusters start where the
+	//cache simulation restarts from scratch, so cache efficiency is mostly preserved.
+	//positions point to the first vertex position, consecutive positions are stride bytes apart.
+	std::vector<unsigned int> OptimizeOverdraw(const std::vector<unsigned int>& indices,
+		const float* positions, size_t vertexCount, size_t stride, unsigned int cacheSize = 16);
+
+	//Remap table ordering vertices by first use in the index buffer. Unused vertices get
+	//UNUSED_VERTEX. Returns the number of used vertices in usedCount.
+	std::vector<unsigned int> VertexFetchRemap(const std::vector<unsigned int>& indices, size_t vertexCount, size_t& usedCount);
+	static constexpr unsigned int UNUSED_VERTEX = ~0u;
+
+	//Reorders vertices by first use so that fetches walk the vertex buffer linearly,
+	//unused vertices are dropped
+	template<typename VertexType>
+	void OptimizeVertexFetch(std::vector<VertexType>& verts, std::vector<unsigned int>& idxs)
+	{
+		size_t used;
+		auto remap = VertexFetchRemap(idxs, verts.size(), used);
+		std::vector<VertexType> result(used);
+		for (size_t v = 0; v < verts.size(); ++v)
+			if (remap[v] != UNUSED_VERTEX)
+				result[remap[v]] = verts[v];
+		for (auto& i : idxs)
+			i = remap[i];
+		verts.swap(result);
+	}
+
+	struct MeshOptimizationStats
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	//Vertex cache ordering, optional overdraw sorting and vertex fetch ordering
+	MeshOptimizationStats OptimizeMesh(MeshData& mesh, bool sortOverdraw = true);
+}
@@ -0,0 +1,11 @@
+#include "particleSimulation.hlsli"
+
+RWByteAddressBuffer dispatchArgs : register(u0);
+
+static const uint SimulateGroup = 256; //GpuParticleSystem::SIMULATE_GROUP
+
+[numthreads(1, 1, 1)]
+void main()
+{
+	dispatchArgs.Store3(0, uint3((particleCount + SimulateGroup - 1) / SimulateGroup, 1, 1));
+}
@@ -0,0 +1,67 @@
+#include "particleSimulation.hlsli"
+
+//Must match GpuParticleSystem::EmitterData
+struct GpuEmitter
+{
+	float4 position;
+	float4 direction[3];
+	uint first;
+	uint count;
+	uint seed;
+	uint padding;
+};
+
+StructuredBuffer<GpuEmitter> emitters : register(t0);
+AppendStructuredBuffer<GpuParticle> next : register(u0);
+
+static const float TwoPi = 6.28318530718f;
+
+uint Hash(uint x)
+{
+	//PCG output permutation
+	uint state = x * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+float Random(inout uint state)
+{
+	state = Hash(state);
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+	//particleCount holds the number of particles left by the simulation
+	if (id.x >= emitCount || particleCount + id.x >= capacity)
+		return;
+
+	//emitters are sorted by first, find the last one starting at or before this particle
+	uint lo = 0, hi = emitterCount - 1;
+	while (lo < hi)
+	{
+		uint mid = (lo + hi + 1) / 2;
+		if (emitters[mid].first <= id.x)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	GpuEmitter e = emitters[lo];
+
+	//same distribution as ParticleSystem::RandomVelocity
+	uint state = e.seed ^ Hash(id.x - e.first);
+	float angle = Random(state) * TwoPi;
+	float magnitude = Random(state) * tanMaxAngle;
+	float3 local = float3(cos(angle) * magnitude, 1.0f, sin(angle) * magnitude);
+	float3 dir = normalize(local.x * e.direction[0].xyz + local.y * e.direction[1].xyz + local.z * e.direction[2].xyz);
+
+	GpuParticle p;
+	p.pos = e.position.xyz;
+	p.age = 0.0f;
+	p.velocity = lerp(minVelocity, maxVelocity, Random(state)) * dir;
+	p.size = particleSize;
+	p.lastPos = p.pos;
+	p.padding = 0.0f;
+	next.Append(p);
+}
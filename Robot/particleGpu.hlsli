@@ -0,0 +1,10 @@
+//Particle as stored on the GPU, must match GpuParticle in gpuParticleSystem.h
+struct GpuParticle
+{
+	float3 pos;
+	float age;
+	float3 velocity;
+	float size;
+	float3 lastPos;
+	float padding;
+};
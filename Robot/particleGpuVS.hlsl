@@ -0,0 +1,29 @@
+#include "particleGpu.hlsli"
+
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1
+{
+	matrix viewMatrix;
+};
+
+StructuredBuffer<GpuParticle> particles : register(t0);
+
+struct GSInput
+{
+	float4 pos : POSITION;
+	float age : TEXCOORD0;
+	float size : TEXCOORD1;
+	float4 lastPos : TEXCOORD2;
+};
+
+//Same output as particleVS, but the particle is fetched from the buffer
+//written by the compute shaders instead of a vertex buffer
+GSInput main(uint id : SV_VertexID)
+{
+	GpuParticle p = particles[id];
+	GSInput o = (GSInput)0;
+	o.pos = mul(viewMatrix, float4(p.pos, 1.0f));
+	o.age = p.age;
+	o.size = p.size;
+	o.lastPos = mul(viewMatrix, float4(p.lastPos, 1.0f));
+	return o;
+}
@@ -0,0 +1,260 @@
+#include "particleIntegrator.h"
+
+#include <bit>
+
+//MSVC compiles the intrinsics of any instruction set anywhere, GCC and Clang only inside
+//functions targeting it
+#if defined(_M_X64) || defined(_M_IX86)
+#define PARTICLES_X86_SIMD
+#include <intrin.h>
+#include <immintrin.h>
+#define TARGET_AVX2
+#define TARGET_AVX512
+#elif defined(__x86_64__) || defined(__i386__)
+#define PARTICLES_X86_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	struct IntegrationStreams
+	{
+		float *posX, *posY, *posZ;
+		float *velX, *velY, *velZ;
+		float *age, *size;
+		float *lastX, *lastY, *lastZ;
+		float *histX, *histY, *histZ;
+	};
+
+	IntegrationStreams GetStreams(ParticleStore& p)
+	{
+		auto h = p.historyHead;
+		return {
+			p.posX.data(), p.posY.data(), p.posZ.data(),
+			p.velX.data(), p.velY.data(), p.velZ.data(),
+			p.age.data(), p.size_.data(),
+			p.lastX.data(), p.lastY.data(), p.lastZ.data(),
+			p.HistoryX(h), p.HistoryY(h), p.HistoryZ(h)
+		};
+	}
+
+	size_t IntegrateScalar(const IntegrationStreams& s, const ParticleIntegrationParams& params,
+		size_t begin, size_t end, uint32_t* dead)
+	{
+		const float dt = params.dt;
+		size_t deadCount = 0;
+		for (size_t i = begin; i < end; ++i)
+		{
+			s.lastX[i] = s.histX[i]; s.lastY[i] = s.histY[i]; s.lastZ[i] = s.histZ[i];
+			s.age[i] += dt;
+
+			float vx = s.velX[i], vy = s.velY[i], vz = s.velZ[i];
+			s.velX[i] = vx + dt * params.acceleration.x;
+			s.velY[i] = vy + dt * params.acceleration.y;
+			s.velZ[i] = vz + dt * params.acceleration.z;
+			s.histX[i] = s.posX[i] += dt * vx;
+			s.histY[i] = s.posY[i] += dt * vy;
+			s.histZ[i] = s.posZ[i] += dt * vz;
+
+			s.size[i] += params.sizeIncrement;
+			if (s.age[i] >= params.timeToLive)
+				dead[deadCount++] = static_cast<uint32_t>(i);
+		}
+		return deadCount;
+	}
+
+#ifdef PARTICLES_X86_SIMD
+	void CpuId(int info[4], int leaf, int subleaf)
+	{
+#ifdef _MSC_VER
+		__cpuidex(info, leaf, subleaf);
+#else
+		__cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+	}
+
+	//Register state the OS saves, XCR0
+	unsigned long long EnabledXState()
+	{
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned int low, high;
+		__asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return static_cast<unsigned long long>(high) << 32 | low;
+#endif
+	}
+
+	bool CpuHasAVX2(bool& avx512)
+	{
+		int info[4];
+		CpuId(info, 0, 0);
+		int maxLeaf = info[0];
+		avx512 = false;
+		if (maxLeaf < 7)
+			return false;
+		CpuId(info, 1, 0);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx)
+			return false;
+		auto xcr0 = EnabledXState();
+		//XMM and YMM state enabled by the OS
+		if ((xcr0 & 0x6) != 0x6)
+			return false;
+		CpuId(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		//AVX-512F and opmask/ZMM state enabled by the OS
+		avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+		return avx2;
+	}
+
+	TARGET_AVX2 size_t IntegrateAVX2(const IntegrationStreams& s, const ParticleIntegrationParams& params,
+		size_t begin, size_t end, uint32_t* dead)
+	{
+		const __m256 dt = _mm256_set1_ps(params.dt);
+		const __m256 dvx = _mm256_set1_ps(params.dt * params.acceleration.x);
+		const __m256 dvy = _mm256_set1_ps(params.dt * params.acceleration.y);
+		const __m256 dvz = _mm256_set1_ps(params.dt * params.acceleration.z);
+		const __m256 ds = _mm256_set1_ps(params.sizeIncrement);
+		const __m256 ttl = _mm256_set1_ps(params.timeToLive);
+
+		size_t deadCount = 0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			_mm256_storeu_ps(s.lastX + i, _mm256_loadu_ps(s.histX + i));
+			_mm256_storeu_ps(s.lastY + i, _mm256_loadu_ps(s.histY + i));
+			_mm256_storeu_ps(s.lastZ + i, _mm256_loadu_ps(s.histZ + i));
+
+			__m256 age = _mm256_add_ps(_mm256_loadu_ps(s.age + i), dt);
+			_mm256_storeu_ps(s.age + i, age);
+
+			__m256 vx = _mm256_loadu_ps(s.velX + i);
+			__m256 vy = _mm256_loadu_ps(s.velY + i);
+			__m256 vz = _mm256_loadu_ps(s.velZ + i);
+			_mm256_storeu_ps(s.velX + i, _mm256_add_ps(vx, dvx));
+			_mm256_storeu_ps(s.velY + i, _mm256_add_ps(vy, dvy));
+			_mm256_storeu_ps(s.velZ + i, _mm256_add_ps(vz, dvz));
+
+			__m256 px = _mm256_add_ps(_mm256_loadu_ps(s.posX + i), _mm256_mul_ps(dt, vx));
+			__m256 py = _mm256_add_ps(_mm256_loadu_ps(s.posY + i), _mm256_mul_ps(dt, vy));
+			__m256 pz = _mm256_add_ps(_mm256_loadu_ps(s.posZ + i), _mm256_mul_ps(dt, vz));
+			_mm256_storeu_ps(s.posX + i, px); _mm256_storeu_ps(s.histX + i, px);
+			_mm256_storeu_ps(s.posY + i, py); _mm256_storeu_ps(s.histY + i, py);
+			_mm256_storeu_ps(s.posZ + i, pz); _mm256_storeu_ps(s.histZ + i, pz);
+
+			_mm256_storeu_ps(s.size + i, _mm256_add_ps(_mm256_loadu_ps(s.size + i), ds));
+
+			auto mask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(age, ttl, _CMP_GE_OQ)));
+			for (; mask; mask &= mask - 1)
+				dead[deadCount++] = static_cast<uint32_t>(i + countr_zero(mask));
+		}
+		return deadCount + IntegrateScalar(s, params, i, end, dead + deadCount);
+	}
+
+	TARGET_AVX512 size_t IntegrateAVX512(const IntegrationStreams& s, const ParticleIntegrationParams& params,
+		size_t begin, size_t end, uint32_t* dead)
+	{
+		const __m512 dt = _mm512_set1_ps(params.dt);
+		const __m512 dvx = _mm512_set1_ps(params.dt * params.acceleration.x);
+		const __m512 dvy = _mm512_set1_ps(params.dt * params.acceleration.y);
+		const __m512 dvz = _mm512_set1_ps(params.dt * params.acceleration.z);
+		const __m512 ds = _mm512_set1_ps(params.sizeIncrement);
+		const __m512 ttl = _mm512_set1_ps(params.timeToLive);
+		const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+		size_t deadCount = 0;
+		size_t i = begin;
+		for (; i + 16 <= end; i += 16)
+		{
+			_mm512_storeu_ps(s.lastX + i, _mm512_loadu_ps(s.histX + i));
+			_mm512_storeu_ps(s.lastY + i, _mm512_loadu_ps(s.histY + i));
+			_mm512_storeu_ps(s.lastZ + i, _mm512_loadu_ps(s.histZ + i));
+
+			__m512 age = _mm512_add_ps(_mm512_loadu_ps(s.age + i), dt);
+			_mm512_storeu_ps(s.age + i, age);
+
+			__m512 vx = _mm512_loadu_ps(s.velX + i);
+			__m512 vy = _mm512_loadu_ps(s.velY + i);
+			__m512 vz = _mm512_loadu_ps(s.velZ + i);
+			_mm512_storeu_ps(s.velX + i, _mm512_add_ps(vx, dvx));
+			_mm512_storeu_ps(s.velY + i, _mm512_add_ps(vy, dvy));
+			_mm512_storeu_ps(s.velZ + i, _mm512_add_ps(vz, dvz));
+
+			__m512 px = _mm512_add_ps(_mm512_loadu_ps(s.posX + i), _mm512_mul_ps(dt, vx));
+			__m512 py = _mm512_add_ps(_mm512_loadu_ps(s.posY + i), _mm512_mul_ps(dt, vy));
+			__m512 pz = _mm512_add_ps(_mm512_loadu_ps(s.posZ + i), _mm512_mul_ps(dt, vz));
+			_mm512_storeu_ps(s.posX + i, px); _mm512_storeu_ps(s.histX + i, px);
+			_mm512_storeu_ps(s.posY + i, py); _mm512_storeu_ps(s.histY + i, py);
+			_mm512_storeu_ps(s.posZ + i, pz); _mm512_storeu_ps(s.histZ + i, pz);
+
+			_mm512_storeu_ps(s.size + i, _mm512_add_ps(_mm512_loadu_ps(s.size + i), ds));
+
+			__mmask16 mask = _mm512_cmp_ps_mask(age, ttl, _CMP_GE_OQ);
+			if (mask)
+			{
+				__m512i idx = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(i)), lanes);
+				_mm512_mask_compressstoreu_epi32(dead + deadCount, mask, idx);
+				deadCount += popcount(static_cast<unsigned int>(mask));
+			}
+		}
+		return deadCount + IntegrateScalar(s, params, i, end, dead + deadCount);
+	}
+#endif
+}
+
+SimdLevel mini::gk2::DetectSimdLevel()
+{
+#ifdef PARTICLES_X86_SIMD
+	static const SimdLevel level = []
+	{
+		bool avx512;
+		bool avx2 = CpuHasAVX2(avx512);
+		if (avx2 && avx512)
+			return SimdLevel::AVX512;
+		return avx2 ? SimdLevel::AVX2 : SimdLevel::Scalar;
+	}();
+	return level;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+size_t mini::gk2::IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead)
+{
+	return IntegrateParticles(store, params, dead, DetectSimdLevel());
+}
+
+size_t mini::gk2::IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead, SimdLevel level)
+{
+	return IntegrateParticles(store, params, dead, 0, store.size(), level);
+}
+
+size_t mini::gk2::IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead,
+	size_t begin, size_t end, SimdLevel level)
+{
+	auto streams = GetStreams(store);
+#ifdef PARTICLES_X86_SIMD
+	switch (level)
+	{
+	case SimdLevel::AVX512:
+		return IntegrateAVX512(streams, params, begin, end, dead);
+	case SimdLevel::AVX2:
+		return IntegrateAVX2(streams, params, begin, end, dead);
+	default:
+		break;
+	}
+#else
+	static_cast<void>(level);
+#endif
+	return IntegrateScalar(streams, params, begin, end, dead);
+}
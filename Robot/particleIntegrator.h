@@ -0,0 +1,40 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include "particleSystem.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Instruction set used by the particle integrator
+		enum class SimdLevel
+		{
+			Scalar,
+			AVX2,
+			AVX512
+		};
+
+		struct ParticleIntegrationParams
+		{
+			float dt;
+			DirectX::XMFLOAT3 acceleration;
+			float sizeIncrement;	//added to every particle's size in this step
+			float timeToLive;
+		};
+
+		//Best instruction set supported by the CPU and the OS, detected once
+		SimdLevel DetectSimdLevel();
+
+		//Advances every particle in the store by one step: stores the oldest trail position
+		//in last*, integrates velocity, position, age and size and overwrites the trail plane
+		//at historyHead with the new position. Indices of particles whose age reached
+		//timeToLive are written to dead in ascending order, their count is returned.
+		//Does not advance the history ring nor remove dead particles.
+		size_t IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead);
+		size_t IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead, SimdLevel level);
+		//Same as above for particles [begin, end) only. Ranges may be processed concurrently.
+		size_t IntegrateParticles(ParticleStore& store, const ParticleIntegrationParams& params, uint32_t* dead,
+			size_t begin, size_t end, SimdLevel level = DetectSimdLevel());
+	}
+}
@@ -1,6 +1,3 @@
-Texture2D dropMap : register(t0);
-SamplerState colorSampler : register(s0);
-
 struct PSInput
 {
 	float4 pos : SV_POSITION;
@@ -9,13 +6,15 @@ struct PSInput
 };
 
 static const float TimeToLive = 3.0f;
+static const float3 DropColor = float3(0.8f, 0.9f, 1.0f);
 
 float4 main(PSInput i) : SV_TARGET
 {
-	float4 color = dropMap.Sample(colorSampler, i.tex);
+	//soft edges across the streak instead of a drop texture
+	float edge = 1.0f - abs(2.0f * i.tex.x - 1.0f);
 	float alpha = 1.0f - i.age / TimeToLive;
 	if (alpha > 1.0f) alpha = 1.0f;
-	if (alpha == 0.0f)
+	if (alpha <= 0.0f)
 		discard;
-	return float4(color.xyz,color.w * alpha);
-};
\ No newline at end of file
+	return float4(DropColor, 0.6f * edge * alpha);
+};
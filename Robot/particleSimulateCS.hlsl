@@ -0,0 +1,28 @@
+#include "particleSimulation.hlsli"
+
+ConsumeStructuredBuffer<GpuParticle> current : register(u0);
+AppendStructuredBuffer<GpuParticle> next : register(u1);
+
+[numthreads(256, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+	if (id.x >= particleCount)
+		return;
+	GpuParticle p = current.Consume();
+
+	//same order of operations as the CPU integrator
+	p.age += dt;
+	float3 v = p.velocity;
+	p.velocity = v + dt * acceleration;
+	p.pos += dt * v;
+	p.size += sizeIncrement;
+	if (p.age >= timeToLive || (p.pos.y < killLevel && p.velocity.y < 0.0f))
+		return;
+
+	//position trailTime ago, or the spawn position for younger particles. Positions are
+	//advanced with the velocity from before the step, hence (t + dt) and not t in the last term,
+	//which puts the trail end exactly where the CPU history ring has it.
+	float t = min(p.age, trailTime);
+	p.lastPos = p.pos - t * p.velocity + 0.5f * t * (t + dt) * acceleration;
+	next.Append(p);
+}
@@ -0,0 +1,26 @@
+#include "particleGpu.hlsli"
+
+//Must match GpuParticleSystem::SimulationParams
+cbuffer cbSimulation : register(b0)
+{
+	float3 acceleration;
+	float dt;
+	float sizeIncrement;
+	float timeToLive;
+	float killLevel;
+	float trailTime;
+	uint capacity;
+	uint emitCount;
+	uint emitterCount;
+	uint simulationPadding;
+	float minVelocity;
+	float maxVelocity;
+	float tanMaxAngle;
+	float particleSize;
+};
+
+//Filled with CopyStructureCount
+cbuffer cbCount : register(b1)
+{
+	uint particleCount;
+};
@@ -0,0 +1,68 @@
+#include "particleSort.h"
+#include <cstring>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+void DepthSorter::Reserve(size_t capacity)
+{
+	m_keys.reserve(capacity);
+	m_keysTmp.reserve(capacity);
+	m_indices.reserve(capacity);
+	m_indicesTmp.reserve(capacity);
+}
+
+const vector<uint32_t>& DepthSorter::Sort(const float* x, const float* y, const float* z, size_t count,
+	XMFLOAT4 cameraPosition)
+{
+	m_keys.resize(count);
+	m_keysTmp.resize(count);
+	m_indices.resize(count);
+	m_indicesTmp.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float dx = x[i] - cameraPosition.x;
+		float dy = y[i] - cameraPosition.y;
+		float dz = z[i] - cameraPosition.z;
+		float d2 = dx * dx + dy * dy + dz * dz;
+		//bit patterns of non-negative floats order the same way as the values,
+		//inverting them makes the ascending sort put the farthest particle first
+		uint32_t bits;
+		memcpy(&bits, &d2, sizeof(bits));
+		m_keys[i] = ~bits;
+		m_indices[i] = static_cast<uint32_t>(i);
+	}
+
+	uint32_t histogram[sizeof(uint32_t) * 8 / RADIX_BITS][RADIX_SIZE] = {};
+	for (size_t i = 0; i < count; ++i)
+		for (unsigned int pass = 0; pass < size(histogram); ++pass)
+			++histogram[pass][(m_keys[i] >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+
+	for (unsigned int pass = 0; pass < size(histogram); ++pass)
+	{
+		auto& h = histogram[pass];
+		//all keys share this digit, the pass wouldn't change the order
+		if (count == 0 || h[(m_keys[0] >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)] == count)
+			continue;
+		uint32_t offset = 0;
+		for (auto& bucket : h)
+		{
+			auto c = bucket;
+			bucket = offset;
+			offset += c;
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto digit = (m_keys[i] >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1);
+			auto dst = h[digit]++;
+			m_keysTmp[dst] = m_keys[i];
+			m_indicesTmp[dst] = m_indices[i];
+		}
+		swap(m_keys, m_keysTmp);
+		swap(m_indices, m_indicesTmp);
+	}
+	return m_indices;
+}
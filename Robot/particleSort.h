@@ -0,0 +1,36 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Orders particles back-to-front relative to the camera. Squared distance
+		//is computed once per particle and sorted as a 32-bit key with an LSD radix
+		//sort, all buffers are kept between frames.
+		class DepthSorter
+		{
+		public:
+			DepthSorter() = default;
+			explicit DepthSorter(size_t capacity) { Reserve(capacity); }
+
+			void Reserve(size_t capacity);
+
+			//Sorts count particles given by their coordinate arrays. Returns particle
+			//indices from the farthest to the nearest, valid until the next call.
+			const std::vector<uint32_t>& Sort(const float* x, const float* y, const float* z, size_t count,
+				DirectX::XMFLOAT4 cameraPosition);
+
+			const std::vector<uint32_t>& order() const { return m_indices; }
+
+		private:
+			static constexpr unsigned int RADIX_BITS = 8;
+			static constexpr unsigned int RADIX_SIZE = 1 << RADIX_BITS;
+
+			std::vector<uint32_t> m_keys, m_keysTmp;
+			std::vector<uint32_t> m_indices, m_indicesTmp;
+		};
+	}
+}
@@ -1,6 +1,9 @@
 #include "particleSystem.h"
+#include "particleIntegrator.h"
 
 #include <iterator>
+#include <algorithm>
+#include <cassert>
 
 #include "dxDevice.h"
 #include "exceptions.h"
@@ -27,102 +30,298 @@ const float ParticleSystem::PARTICLE_SIZE = 0.08f;
 const float ParticleSystem::PARTICLE_SCALE = 1.0f;
 const int ParticleSystem::MAX_PARTICLES = 10000;
 const XMFLOAT3 ParticleSystem::ACCELERATION = XMFLOAT3(0.0f, -1.5f, 0.0f);
+const size_t ParticleSystem::PARALLEL_CHUNK = 16384;
+const size_t ParticleSystem::MAX_EMITTERS = 64;
 
-ParticleSystem::ParticleSystem(DirectX::XMMATRIX emmiterMatrix, DirectX::XMFLOAT3 emitterPosition)
-	: m_emitterPos(emitterPosition), m_emitterMtx(emmiterMatrix), m_particlesToCreate(0.0f), m_random(random_device{}())
+ParticleStore::ParticleStore(size_t capacity)
+	: posX(capacity), posY(capacity), posZ(capacity),
+	velX(capacity), velY(capacity), velZ(capacity),
+	age(capacity), size_(capacity),
+	lastX(capacity), lastY(capacity), lastZ(capacity),
+	historyX(capacity * HISTORY_LENGTH), historyY(capacity * HISTORY_LENGTH), historyZ(capacity * HISTORY_LENGTH),
+	m_capacity(capacity), m_count(0)
 { }
 
-vector<ParticleVertex> ParticleSystem::Update(float dt, DirectX::XMFLOAT4 cameraPosition)
+size_t ParticleStore::Push(XMFLOAT3 pos, XMFLOAT3 velocity, float size)
 {
-	size_t removeCount = 0;
-	for (auto& p : m_particles)
+	assert(m_count < m_capacity);
+	size_t i = m_count++;
+	Set(i, pos, velocity, size);
+	return i;
+}
+
+size_t ParticleStore::Allocate(size_t& n)
+{
+	n = min(n, m_capacity - m_count);
+	size_t first = m_count;
+	m_count += n;
+	return first;
+}
+
+void ParticleStore::Set(size_t i, XMFLOAT3 pos, XMFLOAT3 velocity, float size)
+{
+	posX[i] = pos.x; posY[i] = pos.y; posZ[i] = pos.z;
+	velX[i] = velocity.x; velY[i] = velocity.y; velZ[i] = velocity.z;
+	lastX[i] = pos.x; lastY[i] = pos.y; lastZ[i] = pos.z;
+	age[i] = 0.0f;
+	size_[i] = size;
+	for (unsigned int h = 0; h < HISTORY_LENGTH; ++h)
 	{
-		UpdateParticle(p, dt);
-		if (p.Vertex.Age >= TIME_TO_LIVE)
-			++removeCount;
+		HistoryX(h)[i] = pos.x;
+		HistoryY(h)[i] = pos.y;
+		HistoryZ(h)[i] = pos.z;
 	}
-	m_particles.erase(m_particles.begin(), m_particles.begin() + removeCount);
+}
 
-	m_particlesToCreate += dt * EMISSION_RATE;
-	while (m_particlesToCreate >= 1.0f)
+void ParticleStore::SwapRemove(size_t i)
+{
+	assert(i < m_count);
+	size_t last = --m_count;
+	if (i == last)
+		return;
+	posX[i] = posX[last]; posY[i] = posY[last]; posZ[i] = posZ[last];
+	velX[i] = velX[last]; velY[i] = velY[last]; velZ[i] = velZ[last];
+	lastX[i] = lastX[last]; lastY[i] = lastY[last]; lastZ[i] = lastZ[last];
+	age[i] = age[last];
+	size_[i] = size_[last];
+	for (unsigned int h = 0; h < HISTORY_LENGTH; ++h)
 	{
-		--m_particlesToCreate;
-		if (m_particles.size() < MAX_PARTICLES)
-			m_particles.push_back(RandomParticle());
+		HistoryX(h)[i] = HistoryX(h)[last];
+		HistoryY(h)[i] = HistoryY(h)[last];
+		HistoryZ(h)[i] = HistoryZ(h)[last];
 	}
-	return GetParticleVerts(cameraPosition);
 }
 
-XMFLOAT3 ParticleSystem::RandomVelocity()
+ParticleEmitter mini::gk2::MakeEmitter(XMFLOAT3 position, XMMATRIX orientation, float rate, float lifetime,
+	unsigned int seed, unsigned int index)
 {
-	static const uniform_real_distribution<float> angleDist(0, XM_2PI);
-	float t = tan(MAX_ANGLE);
-	static const uniform_real_distribution<float> magnitudeDist(0, tan(MAX_ANGLE));
-	static const uniform_real_distribution<float> velDist(MIN_VELOCITY, MAX_VELOCITY);
-	float angle = angleDist(m_random);
-	float magnitude = magnitudeDist(m_random);
-	XMFLOAT3 v{ cos(angle) * magnitude, 1.0f, sin(angle) * magnitude };
-	XMStoreFloat3(&v, XMVector3TransformNormal(XMLoadFloat3(&v), XMMatrixRotationX(-DirectX::XM_PIDIV2) * m_emitterMtx));
-	auto velocity = XMLoadFloat3(&v);
-	auto len = velDist(m_random);
-	velocity = len * XMVector3Normalize(velocity);
-	XMStoreFloat3(&v, velocity);
-	return v;
+	ParticleEmitter e;
+	e.position = position;
+	XMStoreFloat4x4(&e.orientation, orientation);
+	e.rate = rate;
+	e.lifetime = lifetime;
+	e.burst = 0;
+	e.toCreate = 0.0f;
+	seed_seq seq{ seed, index };
+	e.random.seed(seq);
+	e.first = e.count = 0;
+	return e;
+}
+
+size_t ParticleEmitter::TakeCount(float dt)
+{
+	toCreate += dt * rate;
+	size_t n = static_cast<size_t>(toCreate);
+	toCreate -= static_cast<float>(n);
+	n += burst;
+	burst = 0;
+	return n;
+}
+
+void EmitterSet::Reserve(size_t n)
+{
+	m_slots.reserve(n);
+	m_live.reserve(n);
+	m_free.reserve(n);
 }
 
-Particle ParticleSystem::RandomParticle()
+ParticleEmitter& EmitterSet::Add(const ParticleEmitter& emitter)
 {
-	Particle p;
-	p.Vertex = ParticleVertex();
-	p.Vertex.Age = 0;
-	p.Vertex.Size = PARTICLE_SIZE;
-	p.Vertex.Pos = m_emitterPos;
-	p.posHist.push_back(m_emitterPos);
+	uint32_t slot;
+	if (m_free.empty())
+	{
+		slot = static_cast<uint32_t>(m_slots.size());
+		m_slots.push_back(emitter);
+	}
+	else
+	{
+		slot = m_free.back();
+		m_free.pop_back();
+		m_slots[slot] = emitter;
+	}
+	m_live.push_back(slot);
+	return m_slots[slot];
+}
+
+void EmitterSet::Expire(float dt)
+{
+	for (size_t k = 0; k < m_live.size(); )
+	{
+		auto& e = m_slots[m_live[k]];
+		//emitters whose lifetime ends within this step are done,
+		//the last live index takes their place and is checked next
+		if (e.lifetime >= 0.0f && e.lifetime <= dt)
+		{
+			m_free.push_back(m_live[k]);
+			m_live[k] = m_live.back();
+			m_live.pop_back();
+			continue;
+		}
+		if (e.lifetime > 0.0f)
+			e.lifetime -= dt;
+		++k;
+	}
+}
 
-	p.Velocities = ParticleVelocities(ACCELERATION);
-	p.Velocities.Velocity = RandomVelocity();
+ParticleSystem::ParticleSystem(DirectX::XMMATRIX emmiterMatrix, DirectX::XMFLOAT3 emitterPosition, size_t capacity, unsigned int seed)
+	: ParticleSystem(capacity, seed)
+{
+	AddEmitter(emitterPosition, emmiterMatrix, EMISSION_RATE);
+}
 
-	return p;
+ParticleSystem::ParticleSystem(size_t capacity, unsigned int seed)
+	: m_seed(seed), m_particles(capacity)
+{
+	m_emitters.Reserve(MAX_EMITTERS);
+	m_vertices.reserve(capacity);
+	m_dead.resize(capacity);
+	m_chunkDead.resize((capacity + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK);
+	m_sorter.Reserve(capacity);
 }
 
-void ParticleSystem::UpdateParticle(Particle& p, float dt)
+void ParticleSystem::UpdateEmitter(DirectX::XMFLOAT3 emitterPosition, DirectX::XMMATRIX emitterMatrix)
 {
-	int ind = p.posHist.size() - 20;
-	if (ind < 0) ind = 0;
-	p.Vertex.LastPos = p.posHist[ind];
-	if (p.posHist.size() > 0)p.Vertex.Age += dt;
+	if (m_emitters.empty())
+		return;
+	m_emitters[0].position = emitterPosition;
+	XMStoreFloat4x4(&m_emitters[0].orientation, emitterMatrix);
+}
 
-	XMVECTOR v0 = XMLoadFloat3(&p.Velocities.Acceleration);
-	XMVECTOR v2 = XMLoadFloat3(&p.Velocities.Velocity);
-	XMStoreFloat3(&p.Velocities.Velocity, v2 + dt * v0);
-	XMVECTOR v1 = XMLoadFloat3(&p.Vertex.Pos);
-	XMStoreFloat3(&p.Vertex.Pos, v1 + dt * v2);
+void ParticleSystem::AddEmitter(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, float rate, float lifetime)
+{
+	m_emitters.Add(MakeEmitter(position, orientation, rate, lifetime, m_seed, m_emittersCreated++));
+}
 
-	p.Vertex.Size += PARTICLE_SCALE * PARTICLE_SIZE * dt;
-	p.posHist.push_back(p.Vertex.Pos);
+void ParticleSystem::AddBurst(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, unsigned int count)
+{
+	m_emitters.Add(MakeEmitter(position, orientation, 0.0f, 0.0f, m_seed, m_emittersCreated++)).burst = count;
 }
 
-struct myclass {
-	DirectX::XMFLOAT4 camPos;
-	bool operator() (ParticleVertex a, ParticleVertex b)
+const vector<ParticleVertex>& ParticleSystem::Update(float dt, DirectX::XMFLOAT4 cameraPosition)
+{
+	Simulate(dt);
+	m_vertices.resize(m_particles.size());
+	WriteVertices(cameraPosition, m_vertices.data(), m_vertices.size());
+	return m_vertices;
+}
+
+size_t ParticleSystem::Update(float dt, DirectX::XMFLOAT4 cameraPosition, ParticleVertex* out, size_t capacity)
+{
+	Simulate(dt);
+	return WriteVertices(cameraPosition, out, capacity);
+}
+
+size_t ParticleSystem::RemoveBelow(float level, DirectX::XMFLOAT3* impacts, size_t maxImpacts)
+{
+	auto& p = m_particles;
+	size_t reported = 0;
+	//going backwards the particle swapped into slot i has already been checked
+	for (size_t i = p.size(); i-- > 0; )
 	{
-		return dist(camPos, a.Pos) < dist(camPos, a.Pos);
+		if (p.posY[i] >= level || p.velY[i] >= 0.0f)
+			continue;
+		if (reported < maxImpacts)
+			impacts[reported++] = XMFLOAT3(p.posX[i], p.posY[i], p.posZ[i]);
+		p.SwapRemove(i);
 	}
-	float dist(XMFLOAT4 v1, XMFLOAT3 v2) {
-		return sqrt((v1.x - v2.x) * (v1.x - v2.x) +
-			(v1.y - v2.y) * (v1.y - v2.y) +
-			(v1.z - v2.z) * (v1.z - v2.z)
-		);
+	return reported;
+}
+
+void ParticleSystem::Simulate(float dt)
+{
+	UpdateParticles(dt);
+	EmitParticles(dt);
+}
+
+XMFLOAT3 ParticleSystem::RandomVelocity(ParticleEmitter& emitter)
+{
+	uniform_real_distribution<float> angleDist(0, XM_2PI);
+	uniform_real_distribution<float> magnitudeDist(0, tan(MAX_ANGLE));
+	uniform_real_distribution<float> velDist(MIN_VELOCITY, MAX_VELOCITY);
+	float angle = angleDist(emitter.random);
+	float magnitude = magnitudeDist(emitter.random);
+	XMFLOAT3 v{ cos(angle) * magnitude, 1.0f, sin(angle) * magnitude };
+	XMStoreFloat3(&v, XMVector3TransformNormal(XMLoadFloat3(&v), XMMatrixRotationX(-DirectX::XM_PIDIV2) * XMLoadFloat4x4(&emitter.orientation)));
+	auto velocity = XMLoadFloat3(&v);
+	auto len = velDist(emitter.random);
+	velocity = len * XMVector3Normalize(velocity);
+	XMStoreFloat3(&v, velocity);
+	return v;
+}
+
+void ParticleSystem::EmitParticles(float dt)
+{
+	//slots are reserved serially in emitter order, so each emitter always
+	//fills the same range no matter which thread generates its particles
+	for (size_t k = 0; k < m_emitters.size(); ++k)
+	{
+		auto& e = m_emitters[k];
+		size_t n = e.TakeCount(dt);
+		e.first = m_particles.Allocate(n);
+		e.count = n;
 	}
-} myobject;
 
-vector<ParticleVertex> ParticleSystem::GetParticleVerts(DirectX::XMFLOAT4 cameraPosition)
+	auto emit = [this](size_t k)
+	{
+		auto& e = m_emitters[k];
+		for (size_t i = e.first; i < e.first + e.count; ++i)
+			m_particles.Set(i, e.position, RandomVelocity(e), PARTICLE_SIZE);
+	};
+	if (m_pool && m_emitters.size() > 1)
+		m_pool->ParallelFor(m_emitters.size(), emit);
+	else
+		for (size_t k = 0; k < m_emitters.size(); ++k)
+			emit(k);
+
+	m_emitters.Expire(dt);
+}
+
+void ParticleSystem::UpdateParticles(float dt)
 {
-	vector<ParticleVertex> vertices;
-	for (int i = 0; i < m_particles.size(); ++i) vertices.push_back(m_particles[i].Vertex);
+	ParticleIntegrationParams params{ dt, ACCELERATION, PARTICLE_SCALE * PARTICLE_SIZE * dt, TIME_TO_LIVE };
+	auto count = m_particles.size();
+	auto chunks = (count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+	auto integrate = [&](size_t c)
+	{
+		auto begin = c * PARALLEL_CHUNK;
+		auto end = min(count, begin + PARALLEL_CHUNK);
+		m_chunkDead[c] = IntegrateParticles(m_particles, params, m_dead.data() + begin, begin, end);
+	};
+	if (m_pool && chunks > 1)
+		m_pool->ParallelFor(chunks, integrate);
+	else
+		for (size_t c = 0; c < chunks; ++c)
+			integrate(c);
+	m_particles.AdvanceHistory();
 
-	myobject.camPos = cameraPosition;
-	std::sort(vertices.begin(), vertices.end(), myobject);
+	//merge per-chunk lists in chunk order, every list only moves towards the front
+	size_t deadCount = 0;
+	for (size_t c = 0; c < chunks; ++c)
+	{
+		auto begin = m_dead.begin() + c * PARALLEL_CHUNK;
+		deadCount = copy(begin, begin + m_chunkDead[c], m_dead.begin() + deadCount) - m_dead.begin();
+	}
+
+	//dead indices are ascending, removing from the back guarantees
+	//the particle swapped into a freed slot is alive
+	for (auto d = deadCount; d-- > 0; )
+		m_particles.SwapRemove(m_dead[d]);
+}
 
-	return vertices;
-}
\ No newline at end of file
+size_t ParticleSystem::WriteVertices(DirectX::XMFLOAT4 cameraPosition, ParticleVertex* out, size_t capacity)
+{
+	auto& p = m_particles;
+	auto& order = m_sorter.Sort(p.posX.data(), p.posY.data(), p.posZ.data(), p.size(), cameraPosition);
+	//when the output is too small keep the nearest particles, they are at the end of the order
+	size_t first = order.size() > capacity ? order.size() - capacity : 0;
+	for (size_t k = first; k < order.size(); ++k, ++out)
+	{
+		auto i = order[k];
+		//write every member, out may point to write-combined GPU memory
+		out->Pos = XMFLOAT3(p.posX[i], p.posY[i], p.posZ[i]);
+		out->Age = p.age[i];
+		out->Size = p.size_[i];
+		out->LastPos = XMFLOAT3(p.lastX[i], p.lastY[i], p.lastZ[i]);
+	}
+	return order.size() - first;
+}
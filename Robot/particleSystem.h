@@ -2,7 +2,10 @@
 #include <DirectXMath.h>
 #include <vector>
 #include <random>
+#include <cstdint>
 #include <d3d11.h>
+#include "particleSort.h"
+#include "workerPool.h"
 
 namespace mini
 {
@@ -19,21 +22,96 @@ namespace mini
 			ParticleVertex() : Pos(0.0f, 0.0f, 0.0f), Age(0.0f), Size(0.0f) { }
 		};
 
-		struct ParticleVelocities
+		//Structure-of-arrays particle storage. All arrays are allocated once
+		//with a fixed capacity, dead particles are removed by swapping in the last one.
+		struct ParticleStore
 		{
-			DirectX::XMFLOAT3 Velocity;
-			DirectX::XMFLOAT3 Acceleration;
-			float AngularVelocity;
+			static constexpr unsigned int HISTORY_LENGTH = 20;	//number of past positions kept for the trail
+
+			ParticleStore() = default;
+			explicit ParticleStore(size_t capacity);
+
+			size_t capacity() const { return m_capacity; }
+			size_t size() const { return m_count; }
+			bool full() const { return m_count == m_capacity; }
+
+			//Appends a particle, returns its index. Store must not be full.
+			size_t Push(DirectX::XMFLOAT3 pos, DirectX::XMFLOAT3 velocity, float size);
+			//Appends up to n uninitialized particles, returns the index of the first one.
+			//Every added slot must be initialized with Set before the next update.
+			size_t Allocate(size_t& n);
+			void Set(size_t i, DirectX::XMFLOAT3 pos, DirectX::XMFLOAT3 velocity, float size);
+			//Moves the last particle into slot i
+			void SwapRemove(size_t i);
+
+			//Trail history is a ring of HISTORY_LENGTH planes shared by all particles,
+			//so that every particle advances it in lockstep. New particles fill all
+			//planes with their spawn position. The plane at historyHead holds the oldest
+			//position and is overwritten with the current one during the update.
+			float* HistoryX(unsigned int plane) { return historyX.data() + plane * m_capacity; }
+			float* HistoryY(unsigned int plane) { return historyY.data() + plane * m_capacity; }
+			float* HistoryZ(unsigned int plane) { return historyZ.data() + plane * m_capacity; }
+			void AdvanceHistory() { historyHead = (historyHead + 1) % HISTORY_LENGTH; }
+
+			std::vector<float> posX, posY, posZ;
+			std::vector<float> velX, velY, velZ;
+			std::vector<float> age;
+			std::vector<float> size_;
+			std::vector<float> lastX, lastY, lastZ;
+			std::vector<float> historyX, historyY, historyZ;
+			unsigned int historyHead = 0;
 
-			ParticleVelocities(DirectX::XMFLOAT3 acceleration) : Velocity(0.0f, 0.0f, 0.0f), AngularVelocity(0.0f), Acceleration(acceleration) { }
-			ParticleVelocities() : ParticleVelocities(DirectX::XMFLOAT3(0.0f,0.0f,0.0f)) { }
+		private:
+			size_t m_capacity = 0;
+			size_t m_count = 0;
 		};
 
-		struct Particle
+		//Source of new particles. Every emitter owns a random stream derived from
+		//the system seed and its creation index, so the spawned particles don't depend
+		//on how emitters are distributed between threads.
+		struct ParticleEmitter
+		{
+			DirectX::XMFLOAT3 position;
+			DirectX::XMFLOAT4X4 orientation;
+			float rate;			//particles per second
+			float lifetime;		//seconds left until removal, negative for permanent emitters
+			unsigned int burst;	//particles emitted at once in the next step
+			float toCreate;
+			std::default_random_engine random;
+
+			//filled in during emission
+			size_t first;
+			size_t count;
+
+			//Number of particles to spawn in a step of length dt, consumes the pending burst
+			size_t TakeCount(float dt);
+		};
+
+		//Emitter whose random stream is derived from the system seed and the emitter's creation index
+		ParticleEmitter MakeEmitter(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, float rate, float lifetime,
+			unsigned int seed, unsigned int index);
+
+		//Emitters stay in their slots for their whole life. The live ones are a list of slot
+		//indices, expired emitters are swap-removed from it and their slots reused, so emitter
+		//state such as the random engine is never moved after creation.
+		class EmitterSet
 		{
-			ParticleVertex Vertex;
-			ParticleVelocities Velocities;
-			std::vector<DirectX::XMFLOAT3> posHist;
+		public:
+			void Reserve(size_t n);
+			//Returns the emitter in its slot
+			ParticleEmitter& Add(const ParticleEmitter& emitter);
+			//Removes emitters whose lifetime ends within a step of length dt and ages the others
+			void Expire(float dt);
+
+			size_t size() const { return m_live.size(); }
+			bool empty() const { return m_live.empty(); }
+			ParticleEmitter& operator[](size_t k) { return m_slots[m_live[k]]; }
+			const ParticleEmitter& operator[](size_t k) const { return m_slots[m_live[k]]; }
+
+		private:
+			std::vector<ParticleEmitter> m_slots;
+			std::vector<uint32_t> m_live;
+			std::vector<uint32_t> m_free;
 		};
 
 		class ParticleSystem
@@ -43,18 +121,44 @@ namespace mini
 
 			ParticleSystem(ParticleSystem&& other) = default;
 
-			ParticleSystem(DirectX::XMMATRIX emitterMatrix, DirectX::XMFLOAT3 emitterPosition);
+			ParticleSystem(DirectX::XMMATRIX emitterMatrix, DirectX::XMFLOAT3 emitterPosition, size_t capacity = MAX_PARTICLES,
+				unsigned int seed = std::random_device{}());
+			//System without a permanent emitter, particles come only from AddEmitter/AddBurst
+			explicit ParticleSystem(size_t capacity, unsigned int seed = std::random_device{}());
 
 			ParticleSystem& operator=(ParticleSystem&& other) = default;
 
-			std::vector<ParticleVertex> Update(float dt, DirectX::XMFLOAT4 cameraPosition);
+			//Advances the simulation and returns sorted vertices in a buffer owned by the system
+			const std::vector<ParticleVertex>& Update(float dt, DirectX::XMFLOAT4 cameraPosition);
+			//Advances the simulation and writes sorted vertices directly to out (e.g. a mapped
+			//dynamic vertex buffer). Returns the number of vertices written, at most capacity.
+			size_t Update(float dt, DirectX::XMFLOAT4 cameraPosition, ParticleVertex* out, size_t capacity);
 
-			void UpdateEmitter(DirectX::XMFLOAT3 emitterPosition, DirectX::XMMATRIX emitterMatrix) { m_emitterPos = emitterPosition;  m_emitterMtx = emitterMatrix; };
+			void Simulate(float dt);
+			size_t WriteVertices(DirectX::XMFLOAT4 cameraPosition, ParticleVertex* out, size_t capacity);
+
+			//Moves the emitter passed to the constructor
+			void UpdateEmitter(DirectX::XMFLOAT3 emitterPosition, DirectX::XMMATRIX emitterMatrix);
+			//Adds an emitter spawning rate particles per second for lifetime seconds (forever if negative)
+			void AddEmitter(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, float rate, float lifetime = -1.0f);
+			//Spawns count particles in the next step, e.g. a splash
+			void AddBurst(DirectX::XMFLOAT3 position, DirectX::XMMATRIX orientation, unsigned int count);
+			size_t emittersCount() const { return m_emitters.size(); }
+
+			//Removes particles moving down below the given height. Positions of the first
+			//maxImpacts of them are written to impacts, returns the number written.
+			size_t RemoveBelow(float level, DirectX::XMFLOAT3* impacts, size_t maxImpacts);
+
+			//Splits updates into chunks executed on the pool. Results are the same
+			//for any number of workers. Pass nullptr to update on the calling thread.
+			void SetWorkerPool(WorkerPool* pool) { m_pool = pool; }
 
 			size_t particlesCount() const { return m_particles.size(); }
+			const ParticleStore& particles() const { return m_particles; }
 			static const int MAX_PARTICLES;		//maximal number of particles in the system
+			static const size_t PARALLEL_CHUNK;	//number of particles integrated by a single job
 
-		private:
+			//Simulation parameters, shared with GpuParticleSystem
 			static const float TIME_TO_LIVE;	//time of particle's life in seconds
 			static const float EMISSION_RATE;	//number of particles to be born per second
 			static const float MAX_ANGLE;		//maximal angle declination from mean direction
@@ -64,18 +168,27 @@ namespace mini
 			static const float PARTICLE_SCALE;	//size += size*scale*dtime
 			static const DirectX::XMFLOAT3 ACCELERATION;	//particle acceleration
 
-			DirectX::XMFLOAT3 m_emitterPos;
-			DirectX::XMMATRIX m_emitterMtx;
-			float m_particlesToCreate;
-
-			std::vector<Particle> m_particles;
-
-			std::default_random_engine m_random;
-
-			DirectX::XMFLOAT3 RandomVelocity();
-			Particle RandomParticle();
-			static void UpdateParticle(Particle& p, float dt);
-			std::vector<ParticleVertex> GetParticleVerts(DirectX::XMFLOAT4 cameraPosition);
+		private:
+			static const size_t MAX_EMITTERS;	//emitters storage reserved up front
+
+			EmitterSet m_emitters;
+			unsigned int m_seed = 0;
+			unsigned int m_emittersCreated = 0;
+
+			ParticleStore m_particles;
+			//Indices of particles that died during the last integration step,
+			//each chunk writes to its own range before they are merged
+			std::vector<uint32_t> m_dead;
+			std::vector<size_t> m_chunkDead;
+			//Output of the vector returning Update, sized to the store capacity up front
+			std::vector<ParticleVertex> m_vertices;
+			DepthSorter m_sorter;
+
+			WorkerPool* m_pool = nullptr;
+
+			DirectX::XMFLOAT3 RandomVelocity(ParticleEmitter& emitter);
+			void EmitParticles(float dt);
+			void UpdateParticles(float dt);
 		};
 	}
-}
\ No newline at end of file
+}
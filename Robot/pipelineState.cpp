@@ -0,0 +1,68 @@
+#include "pipelineState.h"
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	template<typename F>
+	void ForEachObject(const PipelineStateDesc& desc, F f)
+	{
+		f(desc.inputLayout);
+		f(desc.vs);
+		f(desc.gs);
+		f(desc.ps);
+		f(desc.blendState);
+		f(desc.depthStencilState);
+		f(desc.rasterizerState);
+	}
+}
+
+PipelineState::PipelineState(const PipelineStateDesc& desc)
+	: m_desc(desc)
+{
+	ForEachObject(m_desc, [](IUnknown* object) { if (object) object->AddRef(); });
+}
+
+PipelineState::~PipelineState()
+{
+	ForEachObject(m_desc, [](IUnknown* object) { if (object) object->Release(); });
+}
+
+void PipelineState::Bind(StateCache& state) const
+{
+	state.IASetInputLayout(m_desc.inputLayout);
+	state.IASetPrimitiveTopology(m_desc.topology);
+	state.VSSetShader(m_desc.vs);
+	state.GSSetShader(m_desc.gs);
+	state.PSSetShader(m_desc.ps);
+	state.OMSetBlendState(m_desc.blendState);
+	state.OMSetDepthStencilState(m_desc.depthStencilState, m_desc.stencilRef);
+	state.RSSetState(m_desc.rasterizerState);
+}
+
+size_t PipelineCache::Hash::operator()(const PipelineStateDesc& desc) const
+{
+	//FNV-1a over the object addresses and the plain values
+	uint64_t h = 14695981039346656037ull;
+	auto mix = [&h](uint64_t value)
+	{
+		h ^= value;
+		h *= 1099511628211ull;
+	};
+	ForEachObject(desc, [&mix](IUnknown* object) { mix(reinterpret_cast<uintptr_t>(object)); });
+	mix(desc.stencilRef);
+	mix(static_cast<uint64_t>(desc.topology));
+	return static_cast<size_t>(h);
+}
+
+uint32_t PipelineCache::Get(const PipelineStateDesc& desc)
+{
+	auto it = m_ids.find(desc);
+	if (it != m_ids.end())
+		return it->second;
+	auto id = static_cast<uint32_t>(m_states.size());
+	m_states.push_back(make_unique<PipelineState>(desc));
+	m_ids.emplace(desc, id);
+	return id;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "stateCache.h"
+
+namespace mini
+{
+	//Everything bound for a draw besides resources and constants. Null objects bind the defaults.
+	struct PipelineStateDesc
+	{
+		ID3D11InputLayout* inputLayout = nullptr;
+		ID3D11VertexShader* vs = nullptr;
+		ID3D11GeometryShader* gs = nullptr;
+		ID3D11PixelShader* ps = nullptr;
+		ID3D11BlendState* blendState = nullptr;
+		ID3D11DepthStencilState* depthStencilState = nullptr;
+		UINT stencilRef = 0;
+		ID3D11RasterizerState* rasterizerState = nullptr;
+		D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+		bool operator==(const PipelineStateDesc&) const = default;
+	};
+
+	//Immutable pipeline state, keeps its objects alive
+	class PipelineState
+	{
+	public:
+		explicit PipelineState(const PipelineStateDesc& desc);
+		PipelineState(const PipelineState&) = delete;
+		PipelineState& operator=(const PipelineState&) = delete;
+		~PipelineState();
+
+		//Binds the whole state in one call, the cache drops the parts that are already bound
+		void Bind(StateCache& state) const;
+
+		const PipelineStateDesc& desc() const { return m_desc; }
+
+	private:
+		PipelineStateDesc m_desc;
+	};
+
+	//Creates every distinct pipeline state once. Ids are dense and stable, so they can be used in
+	//sort keys and render commands.
+	class PipelineCache
+	{
+	public:
+		//Returns the id of the state with this description, creating it the first time
+		uint32_t Get(const PipelineStateDesc& desc);
+
+		const PipelineState& operator[](uint32_t id) const { return *m_states[id]; }
+		void Bind(StateCache& state, uint32_t id) const { m_states[id]->Bind(state); }
+		size_t size() const { return m_states.size(); }
+
+	private:
+		struct Hash
+		{
+			size_t operator()(const PipelineStateDesc& desc) const;
+		};
+
+		std::unordered_map<PipelineStateDesc, uint32_t, Hash> m_ids;
+		std::vector<std::unique_ptr<PipelineState>> m_states;
+	};
+}
@@ -139,9 +139,9 @@ namespace mini
 		{
 		public:
 			using iterator_category = std::random_access_iterator_tag;
-			using value_type = value_type;
-			using difference_type = difference_type;
-			using pointer = pointer;
+			using value_type = typename ptr_vector::value_type;
+			using difference_type = typename ptr_vector::difference_type;
+			using pointer = typename ptr_vector::pointer;
 			using reference = ptr_ref;
 
 			ptr_iterator() = default;
@@ -0,0 +1,167 @@
+#include "renderCommands.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <optional>
+
+using namespace std;
+using namespace mini;
+
+uint64_t mini::DrawKey(unsigned int pass, uint32_t pipeline, uint32_t material, float depth, bool backToFront)
+{
+	//a wider id would be cut off and sort with an unrelated one
+	assert(pass <= 0xff && pipeline <= 0xfff && material <= 0xfff && "DrawKey field out of range");
+	//bits of non-negative floats compare like the floats
+	uint32_t depthBits = 0;
+	depth = max(depth, 0.0f);
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+	if (backToFront)
+		depthBits = ~depthBits;
+	return static_cast<uint64_t>(pass & 0xff) << 56 | static_cast<uint64_t>(pipeline & 0xfff) << 44 |
+		static_cast<uint64_t>(material & 0xfff) << 32 | depthBits;
+}
+
+ReplayStats& ReplayStats::operator+=(const ReplayStats& other)
+{
+	draws += other.draws;
+	batches += other.batches;
+	stateChanges += other.stateChanges;
+	redundant += other.redundant;
+	return *this;
+}
+
+void CommandRecorder::Begin(uint64_t key)
+{
+	m_packets.push_back({ key, static_cast<uint32_t>(m_commands.size()), 0 });
+}
+
+void CommandRecorder::Add(const RenderCommand& command)
+{
+	if (m_packets.empty())
+		Begin(0);
+	m_commands.push_back(command);
+	++m_packets.back().count;
+}
+
+void CommandRecorder::SetPipeline(uint32_t pipeline)
+{
+	Add({ RenderCommand::SetPipeline, 0, 0, pipeline, 0, 0 });
+}
+
+void CommandRecorder::BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount)
+{
+	Add({ RenderCommand::BindConstants, stage, slot, 0, firstConstant, constantCount });
+}
+
+void CommandRecorder::BindTextures(uint32_t textures)
+{
+	Add({ RenderCommand::BindTextures, 0, 0, textures, 0, 0 });
+}
+
+void CommandRecorder::Draw(uint32_t mesh, uint32_t lod)
+{
+	Add({ RenderCommand::Draw, 0, 0, mesh, lod, 0 });
+}
+
+void CommandRecorder::Clear()
+{
+	m_commands.clear();
+	m_packets.clear();
+}
+
+void CommandQueue::Sort()
+{
+	m_sorted.clear();
+	for (uint32_t r = 0; r < m_recorders.size(); ++r)
+	{
+		auto& packets = m_recorders[r].m_packets;
+		for (uint32_t p = 0; p < packets.size(); ++p)
+			m_sorted.push_back({ packets[p].key, r, p });
+	}
+	//the recorder and packet indices make equal keys keep recording order
+	sort(m_sorted.begin(), m_sorted.end(), [](const SortedPacket& a, const SortedPacket& b)
+	{
+		if (a.key != b.key)
+			return a.key < b.key;
+		return a.recorder != b.recorder ? a.recorder < b.recorder : a.packet < b.packet;
+	});
+}
+
+ReplayStats CommandQueue::Replay(CommandBackend& backend, size_t first, size_t last) const
+{
+	ReplayStats stats;
+	//only what this replay bound is known, the backend's state before it isn't
+	optional<uint32_t> pipeline, textures;
+	//first constant and count bound to every stage and slot
+	optional<pair<uint32_t, uint32_t>> constants[RenderCommand::STAGES][RenderCommand::CONSTANT_SLOTS];
+	bool batchEnded = true;
+	last = min(last, m_sorted.size());
+	for (size_t i = first; i < last; ++i)
+	{
+		auto& recorder = m_recorders[m_sorted[i].recorder];
+		auto& packet = recorder.m_packets[m_sorted[i].packet];
+		for (uint32_t c = packet.first; c < packet.first + packet.count; ++c)
+		{
+			auto& command = recorder.m_commands[c];
+			switch (command.type)
+			{
+			case RenderCommand::SetPipeline:
+				if (pipeline == command.id)
+				{
+					++stats.redundant;
+					break;
+				}
+				pipeline = command.id;
+				batchEnded = true;
+				++stats.stateChanges;
+				backend.SetPipeline(command.id);
+				break;
+			case RenderCommand::BindConstants:
+			{
+				if (command.stage < RenderCommand::STAGES && command.slot < RenderCommand::CONSTANT_SLOTS)
+				{
+					auto& bound = constants[command.stage][command.slot];
+					auto range = make_pair(command.first, command.count);
+					if (bound == range)
+					{
+						++stats.redundant;
+						break;
+					}
+					bound = range;
+				}
+				++stats.stateChanges;
+				backend.BindConstants(command.stage, command.slot, command.first, command.count);
+				break;
+			}
+			case RenderCommand::BindTextures:
+				if (textures == command.id)
+				{
+					++stats.redundant;
+					break;
+				}
+				textures = command.id;
+				batchEnded = true;
+				++stats.stateChanges;
+				backend.BindTextures(command.id);
+				break;
+			case RenderCommand::Draw:
+				++stats.draws;
+				if (batchEnded)
+				{
+					++stats.batches;
+					batchEnded = false;
+				}
+				backend.Draw(command.id, command.first);
+				break;
+			}
+		}
+	}
+	return stats;
+}
+
+void CommandQueue::Clear()
+{
+	for (auto& r : m_recorders)
+		r.Clear();
+	m_sorted.clear();
+}
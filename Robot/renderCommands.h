@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mini
+{
+	//Single command of a recorded stream. Resources are referred to by ids into tables of the
+	//backend that replays it, so the stream is plain data and doesn't depend on the graphics API.
+	struct RenderCommand
+	{
+		enum Type : uint8_t { SetPipeline, BindConstants, BindTextures, Draw };
+
+		//stages and slots of BindConstants Replay keeps track of, others always reach the backend
+		static constexpr unsigned int STAGES = 4, CONSTANT_SLOTS = 16;
+
+		Type type;
+		//shader stage and slot of BindConstants, as the backend numbers them
+		uint8_t stage, slot;
+		//pipeline, texture set or mesh
+		uint32_t id;
+		//constant range of BindConstants, level of detail of Draw
+		uint32_t first, count;
+	};
+
+	//Sort key of a draw, most significant first: pass 8 bits, pipeline 12 bits, material 12 bits and
+	//view depth 32 bits. Draws of a pass are grouped by pipeline, then by material, and go front to
+	//back within a group, or back to front with backToFront. Ids must fit their fields.
+	uint64_t DrawKey(unsigned int pass, uint32_t pipeline, uint32_t material, float depth, bool backToFront = false);
+
+	//Counts of a replay. A batch is a run of draws with the same pipeline and textures,
+	//only their constants change between them.
+	struct ReplayStats
+	{
+		unsigned int draws = 0;
+		unsigned int batches = 0;
+		//commands passed to the backend, and ones dropped because they bound what was already bound
+		unsigned int stateChanges = 0;
+		unsigned int redundant = 0;
+
+		ReplayStats& operator+=(const ReplayStats& other);
+	};
+
+	//Receives the commands of a CommandQueue in replay order
+	class CommandBackend
+	{
+	public:
+		virtual ~CommandBackend() = default;
+
+		virtual void SetPipeline(uint32_t pipeline) = 0;
+		virtual void BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount) = 0;
+		virtual void BindTextures(uint32_t textures) = 0;
+		virtual void Draw(uint32_t mesh, uint32_t lod) = 0;
+	};
+
+	//Stream of commands recorded by one thread. Commands are grouped into packets, each started
+	//with a sort key, and a packet is the unit the queue orders. Packets should set everything
+	//their draws depend on, since they can end up after any other packet.
+	class CommandRecorder
+	{
+	public:
+		void Begin(uint64_t key);
+		//commands recorded before the first Begin get key 0
+		void SetPipeline(uint32_t pipeline);
+		void BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount);
+		void BindTextures(uint32_t textures);
+		void Draw(uint32_t mesh, uint32_t lod = 0);
+
+		void Clear();
+		size_t commandCount() const { return m_commands.size(); }
+		size_t packetCount() const { return m_packets.size(); }
+
+	private:
+		friend class CommandQueue;
+
+		struct Packet
+		{
+			uint64_t key;
+			uint32_t first, count;
+		};
+
+		void Add(const RenderCommand& command);
+
+		std::vector<RenderCommand> m_commands;
+		std::vector<Packet> m_packets;
+	};
+
+	//Per-thread recorders whose packets are merged, sorted by key and replayed on a backend
+	class CommandQueue
+	{
+	public:
+		explicit CommandQueue(size_t recorders = 1) : m_recorders(recorders) { }
+
+		//Different recorders can be used from different threads at the same time
+		CommandRecorder& recorder(size_t i) { return m_recorders[i]; }
+		size_t recorderCount() const { return m_recorders.size(); }
+
+		//Orders the packets of all recorders by key. Packets with equal keys keep the order of
+		//their recorders and, within a recorder, the order they were recorded in.
+		void Sort();
+		size_t packetCount() const { return m_sorted.size(); }
+		//Replays sorted packets [first, last), e.g. to split them between several contexts. Commands
+		//binding what an earlier command of the same replay bound are not passed to the backend.
+		ReplayStats Replay(CommandBackend& backend, size_t first, size_t last) const;
+		ReplayStats Replay(CommandBackend& backend) const { return Replay(backend, 0, m_sorted.size()); }
+
+		//Empties all recorders for the next frame
+		void Clear();
+
+	private:
+		struct SortedPacket
+		{
+			uint64_t key;
+			uint32_t recorder, packet;
+		};
+
+		std::vector<CommandRecorder> m_recorders;
+		std::vector<SortedPacket> m_sorted;
+	};
+}
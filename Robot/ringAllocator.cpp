@@ -0,0 +1,48 @@
+#include "ringAllocator.h"
+
+using namespace mini;
+
+RingAllocator::RingAllocator(size_t capacity, size_t alignment, unsigned int framesInFlight)
+	: m_capacity(capacity / alignment * alignment), m_alignment(alignment), m_framesInFlight(framesInFlight)
+{ }
+
+void RingAllocator::BeginFrame()
+{
+	m_frames.push_back(m_frameUsed);
+	m_frameUsed = 0;
+	while (m_frames.size() > m_framesInFlight)
+	{
+		m_used -= m_frames.front();
+		m_frames.pop_front();
+	}
+}
+
+size_t RingAllocator::Allocate(size_t size)
+{
+	size = (size + m_alignment - 1) / m_alignment * m_alignment;
+	if (size == 0 || size > m_capacity - m_used)
+		return NO_SPACE;
+	if (m_used == 0)
+		m_head = 0;
+	size_t tail = (m_head + m_capacity - m_used) % m_capacity;
+	//free space is [m_head, end) and [0, tail) when the used bytes don't wrap, [m_head, tail) otherwise
+	bool wrapped = m_used > 0 && tail >= m_head;
+	size_t offset = m_head;
+	size_t skipped = 0;
+	if (wrapped)
+	{
+		if (size > tail - m_head)
+			return NO_SPACE;
+	}
+	else if (size > m_capacity - m_head)
+	{
+		if (m_used > 0 && size > tail)
+			return NO_SPACE;
+		skipped = m_capacity - m_head;
+		offset = 0;
+	}
+	m_head = (offset + size) % m_capacity;
+	m_used += skipped + size;
+	m_frameUsed += skipped + size;
+	return offset;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace mini
+{
+	//Suballocates a ring of bytes in aligned blocks. Blocks of a frame stay allocated until
+	//framesInFlight more frames have begun, so the GPU can still read them meanwhile.
+	class RingAllocator
+	{
+	public:
+		static constexpr size_t NO_SPACE = SIZE_MAX;
+
+		RingAllocator() = default;
+		RingAllocator(size_t capacity, size_t alignment, unsigned int framesInFlight);
+
+		//Ends the current frame and frees the blocks of the oldest one still kept
+		void BeginFrame();
+		//Offset of a block of at least size bytes, or NO_SPACE when the kept frames fill the ring.
+		//A block never wraps around the end, the bytes skipped to avoid it count as used.
+		size_t Allocate(size_t size);
+
+		size_t capacity() const { return m_capacity; }
+		size_t used() const { return m_used; }
+
+	private:
+		size_t m_capacity = 0;
+		size_t m_alignment = 1;
+		unsigned int m_framesInFlight = 0;
+		//next free byte, the oldest used one is m_used bytes before it
+		size_t m_head = 0;
+		size_t m_used = 0;
+		size_t m_frameUsed = 0;
+		//bytes used by every kept frame, oldest first
+		std::deque<size_t> m_frames;
+	};
+}
@@ -1,5 +1,8 @@
 #include "robot.h"
 #include "particleSystem.h"
+#include "meshLod.h"
+#include "assetLoader.h"
+#include "assetCache.h"
 #include <cmath>
 
 
@@ -26,23 +29,81 @@ const float KACZOR_SIZE = 0.0015f;
 const float Robot::WALL_SIZE = 2.0f;
 const XMFLOAT3 Robot::WALLS_POS = XMFLOAT3(0.0f, 0.0f, 0.0f);
 const XMFLOAT4 LightPos = XMFLOAT4(0.0f, 0.5f, 1.0f, 1.0f);
+const XMFLOAT3 Robot::SHADOW_RECEIVERS[8] = {
+	{ -1.0f, SHEET_POS.y, -1.0f }, { 1.0f, SHEET_POS.y, -1.0f }, { -1.0f, SHEET_POS.y, 1.0f }, { 1.0f, SHEET_POS.y, 1.0f },
+	{ -1.0f, 0.5f, -1.0f }, { 1.0f, 0.5f, -1.0f }, { -1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 1.0f } };
+
+const float FOV_Y = XM_PIDIV4;
+const float NEAR_PLANE = 0.01f;
+const float FAR_PLANE = 100.0f;
 
 #pragma endregion
 
+static void BindConstants(CommandRecorder& recorder, ConstantRing::Stage stage, uint8_t slot, ConstantRange range)
+{
+	recorder.BindConstants(stage, slot, range.firstConstant, range.constantCount);
+}
+
 
 #pragma region Initalization
-Robot::Robot(HINSTANCE hInstance)
+Robot::Robot(HINSTANCE hInstance, bool gpuParticles, bool cpuShadowVolumes, const ShadowMapSettings* shadowMaps, bool assetCache)
 	: Base(hInstance, 1280, 720, L"Kaczor"),
-	m_cbWorld(m_device.CreateConstantBuffer<XMFLOAT4X4>()),
+	m_constants(m_device, 64 * 1024),
 	m_cbView(m_device.CreateConstantBuffer<XMFLOAT4X4, 2>()),
 	m_cbLighting(m_device.CreateConstantBuffer<Lighting>()),
-	m_cbSurfaceColor(m_device.CreateConstantBuffer<XMFLOAT4>())
+	m_cpuShadowVolumes(cpuShadowVolumes),
+	m_useGpuParticles(gpuParticles)
 {
+	//files are read and decoded on m_workers while the setup that doesn't need them runs
+	AssetCache cache(assetCache ? L"cache" : L"");
+	AssetLoader assets(m_workers);
+	auto byteCode = [&assets](const wchar_t* file) { return assets.Add(file, [file] { return DxDevice::LoadByteCode(file); }); };
+	auto texture = [this, &assets, &cache](const wchar_t* file)
+	{
+		return assets.Add(file, [&cache, file] { return ReadTexture(cache, file); },
+			[this, &cache](TextureFile&& t) { return CreateTexture(m_device, cache, t); });
+	};
+	auto vsCode = byteCode(L"vs.cso"), psCode = byteCode(L"ps.cso");
+	auto textureVSCode = byteCode(L"textureVS.cso"), texturePSCode = byteCode(L"texturePS.cso");
+	auto kaczorVSCode = byteCode(L"kaczorVS.cso"), kaczorPSCode = byteCode(L"kaczorPS.cso");
+	auto kaczorQuantizedVSCode = byteCode(L"kaczorQuantizedVS.cso");
+	auto particleVSCode = byteCode(L"particleVS.cso"), particleGSCode = byteCode(L"particleGS.cso");
+	auto particlePSCode = byteCode(L"particlePS.cso");
+	Asset<vector<BYTE>> particleGpuVSCode, shadowReceiverVSCode, shadowReceiverPSCode;
+	Asset<vector<BYTE>> shadowVolumeVSCode, shadowVolumeGSCode, shadowOverlayVSCode, shadowOverlayPSCode;
+	if (m_useGpuParticles)
+		particleGpuVSCode = byteCode(L"particleGpuVS.cso");
+	if (shadowMaps)
+	{
+		shadowReceiverVSCode = byteCode(L"shadowReceiverVS.cso");
+		shadowReceiverPSCode = byteCode(L"shadowReceiverPS.cso");
+	}
+	else
+	{
+		shadowVolumeVSCode = byteCode(L"shadowVolumeVS.cso");
+		if (!m_cpuShadowVolumes)
+			shadowVolumeGSCode = byteCode(L"shadowVolumeGS.cso");
+		shadowOverlayVSCode = byteCode(L"shadowOverlayVS.cso");
+		shadowOverlayPSCode = byteCode(L"shadowOverlayPS.cso");
+	}
+	//binary mesh is created with -convertmesh, the text one is used when it's missing
+	bool binaryDuck = GetFileAttributesW(L"resources/duck/duck.mesh") != INVALID_FILE_ATTRIBUTES;
+	auto duckPath = binaryDuck ? L"resources/duck/duck.mesh" : L"resources/duck/duck.txt";
+	auto duck = assets.Add(duckPath, [duckPath, binaryDuck, &cache] { return Mesh::DecodeMesh(duckPath, binaryDuck, true, &cache); },
+		[this](DecodedMesh&& decoded)
+		{
+			m_duckEncoding = decoded.encoding;
+			return Mesh::CreateMesh(m_device, move(decoded));
+		});
+	auto cubeTexture = texture(L"resources/textures/output_skybox2.dds");
+	auto kaczorTexture = texture(L"resources/duck/ducktex.jpg");
+	assets.Start();
+
 	//Projection matrix
 	auto s = m_window.getClientSize();
 	auto ar = static_cast<float>(s.cx) / s.cy;
 
-	XMStoreFloat4x4(&m_projMtx, XMMatrixPerspectiveFovLH(XM_PIDIV4, ar, 0.01f, 100.0f));
+	XMStoreFloat4x4(&m_projMtx, XMMatrixPerspectiveFovLH(FOV_Y, ar, NEAR_PLANE, FAR_PLANE));
 	m_cbProj = m_device.CreateConstantBuffer<XMFLOAT4X4>();
 	UpdateBuffer(m_cbProj, m_projMtx);
 
@@ -59,43 +120,37 @@ Robot::Robot(HINSTANCE hInstance)
 	sd.MaxAnisotropy = 16;
 	m_samplerWrap = m_device.CreateSamplerState(sd);
 
-	//Regular shaders
-	auto vsCode = m_device.LoadByteCode(L"vs.cso");
-	auto psCode = m_device.LoadByteCode(L"ps.cso");
-	m_vs = m_device.CreateVertexShader(vsCode);
-	m_ps = m_device.CreatePixelShader(psCode);
-	m_il = m_device.CreateInputLayout(VertexPositionNormal::Layout, vsCode);
-
-
-	// texture shaders
-	vsCode = m_device.LoadByteCode(L"textureVS.cso");
-	psCode = m_device.LoadByteCode(L"texturePS.cso");
-	m_textureVS = m_device.CreateVertexShader(vsCode);
-	m_texturePS = m_device.CreatePixelShader(psCode);
-	m_textureIL = m_device.CreateInputLayout(VertexPositionNormal::Layout, vsCode);
-
-	// texture shaders
-	vsCode = m_device.LoadByteCode(L"kaczorVS.cso");
-	psCode = m_device.LoadByteCode(L"kaczorPS.cso");
-	m_kaczorVS = m_device.CreateVertexShader(vsCode);
-	m_kaczorPS = m_device.CreatePixelShader(psCode);
-	m_kaczorIL = m_device.CreateInputLayout(VertexPositionNormalTex::Layout, vsCode);
+	if (shadowMaps)
+	{
+		m_shadowMap = ShadowMap(m_device, *shadowMaps);
+		m_cbShadowView = m_device.CreateConstantBuffer<XMFLOAT4X4, 2>();
+		XMFLOAT4X4 identity[2];
+		XMStoreFloat4x4(identity, XMMatrixIdentity());
+		identity[1] = identity[0];
+		UpdateBuffer(m_cbShadowView, identity);
+	}
 
 	//Render states
 	CreateRenderStates();
 
-	m_wall = Mesh::Rectangle(m_device);
 	m_sheet = Mesh::Rectangle(m_device);
-	m_duck = Mesh::LoadMesh(m_device, L"resources/duck/duck.txt");
-
-	SetShaders();
-	ID3D11Buffer* vsb[] = { m_cbWorld.get(),  m_cbView.get(), m_cbProj.get() };
-	m_device.context()->VSSetConstantBuffers(0, 3, vsb);
-	ID3D11Buffer* psb[] = { m_cbSurfaceColor.get(), m_cbLighting.get() };
-	m_device.context()->PSSetConstantBuffers(0, 2, psb);
-
 	CreateSheetMtx();
 	CreateWallsMtx();
+	CreateWallsMesh();
+
+	if (m_useGpuParticles)
+	{
+		m_gpuParticles = GpuParticleSystem(m_device, MAX_GPU_PARTICLES);
+		m_gpuParticles.SetKillLevel(SHEET_POS.y);
+	}
+	else
+	{
+		m_particles = ParticleSystem(MAX_SPLASH_PARTICLES);
+		m_particles.SetWorkerPool(&m_workers);
+		//room for two frames so the ring rarely has to discard
+		m_particleVerts = DynamicVertexRing<ParticleVertex>(m_device, 2 * MAX_SPLASH_PARTICLES);
+	}
+	m_splashes = SplashSystem(Nsize, SHEET_POS.y);
 
 	d = vector<vector<float>>(Nsize);
 	heightMap = vector<vector<float>>(Nsize);
@@ -137,13 +192,211 @@ Robot::Robot(HINSTANCE hInstance)
 	texDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
 	waterTex = m_device.CreateTexture(texDesc);
 	m_waterTexture = m_device.CreateShaderResourceView(waterTex);
-	m_cubeTexture = m_device.CreateShaderResourceView(L"resources/textures/output_skybox2.dds");
-	m_kaczorTexture = m_device.CreateShaderResourceView(L"resources/duck/ducktex.jpg");
+
+	assets.Wait();
+	//a cold start misses the cache for every processed asset, a warm one hits it
+	auto trace = assets.Trace() + L"asset cache: " + to_wstring(cache.hits()) + L" hits, " + to_wstring(cache.misses()) + L" misses\n";
+	OutputDebugStringW(trace.c_str());
+	m_cubeTexture = move(cubeTexture.get());
+	m_kaczorTexture = move(kaczorTexture.get());
+	m_duck = move(duck.get());
+
+	//Regular shaders
+	m_vs = m_device.CreateVertexShader(vsCode.get());
+	m_ps = m_device.CreatePixelShader(psCode.get());
+	m_il = m_device.CreateInputLayout(VertexPositionNormal::Layout, vsCode.get());
+
+	// texture shaders
+	m_textureVS = m_device.CreateVertexShader(textureVSCode.get());
+	m_texturePS = m_device.CreatePixelShader(texturePSCode.get());
+	m_textureIL = m_device.CreateInputLayout(VertexPositionNormal::Layout, textureVSCode.get());
+
+	// duck shaders
+	m_kaczorVS = m_device.CreateVertexShader(kaczorVSCode.get());
+	m_kaczorPS = m_device.CreatePixelShader(kaczorPSCode.get());
+	m_kaczorIL = m_device.CreateInputLayout(VertexPositionNormalTex::Layout, kaczorVSCode.get());
+	m_kaczorQuantizedVS = m_device.CreateVertexShader(kaczorQuantizedVSCode.get());
+	m_kaczorQuantizedIL = m_device.CreateInputLayout(VertexPositionNormalTexQuantized::Layout, kaczorQuantizedVSCode.get());
+
+	// particle shaders
+	m_particleVS = m_device.CreateVertexShader(particleVSCode.get());
+	m_particleGS = m_device.CreateGeometryShader(particleGSCode.get());
+	m_particlePS = m_device.CreatePixelShader(particlePSCode.get());
+	m_particleIL = m_device.CreateInputLayout(ParticleVertex::Layout, particleVSCode.get());
+	if (m_useGpuParticles)
+		m_particleGpuVS = m_device.CreateVertexShader(particleGpuVSCode.get());
+
+	if (shadowMaps)
+	{
+		// shadow map shaders
+		m_shadowReceiverVS = m_device.CreateVertexShader(shadowReceiverVSCode.get());
+		m_shadowReceiverPS = m_device.CreatePixelShader(shadowReceiverPSCode.get());
+		m_shadowReceiverIL = m_device.CreateInputLayout(VertexPositionNormal::Layout, shadowReceiverVSCode.get());
+	}
+	else
+	{
+		// shadow volume shaders
+		m_shadowVolumeVS = m_device.CreateVertexShader(shadowVolumeVSCode.get());
+		m_shadowVolumeIL = m_device.CreateInputLayout(VertexPosition::Layout, shadowVolumeVSCode.get());
+		if (!m_cpuShadowVolumes)
+			m_shadowVolumeGS = m_device.CreateGeometryShader(shadowVolumeGSCode.get());
+		m_shadowOverlayVS = m_device.CreateVertexShader(shadowOverlayVSCode.get());
+		m_shadowOverlayPS = m_device.CreatePixelShader(shadowOverlayPSCode.get());
+		if (m_cpuShadowVolumes)
+			m_duckShadow = ShadowVolume(m_device, m_duck.adjacency());
+		else
+			m_duckShadowGpu = GpuShadowVolume(m_device, m_duck.adjacency());
+	}
+	m_cbDequantization = m_device.CreateConstantBuffer<PositionDequantization>();
+	UpdateBuffer(m_cbDequantization, m_duckEncoding.dequantization);
+
+	//the duck's vertex format is only known once it's loaded
+	CreatePipelines();
+	//slot 0 of both stages is bound per draw from m_constants
+	ID3D11Buffer* vsb[] = { m_cbView.get(), m_cbProj.get() };
+	m_state.VSSetConstantBuffers(1, 2, vsb);
+	auto cbDequantization = m_cbDequantization.get();
+	m_state.VSSetConstantBuffers(4, 1, &cbDequantization);
+	auto cbLighting = m_cbLighting.get();
+	m_state.PSSetConstantBuffers(1, 1, &cbLighting);
+
+	CreateCommandTables();
+}
+
+void Robot::CreateCommandTables()
+//Pipelines, textures and meshes the recorded commands refer to
+{
+	m_commands = CommandQueue(PassCount);
+	m_commandBackend = DxCommandBackend(m_state, m_pipelines, m_constants);
+
+	if (!m_shadowMap.empty())
+		m_ids.shadowMapTextures = m_commandBackend.AddTextures({ { m_shadowMap.shaderResourceView() }, m_shadowMap.sampler() });
+
+	m_ids.waterTextures = m_commandBackend.AddTextures({ { m_waterTexture.get(), m_cubeTexture.get() }, m_samplerWrap.get() });
+	m_ids.kaczorTextures = m_commandBackend.AddTextures({ { m_kaczorTexture.get() }, m_samplerWrap.get() });
+	m_ids.cubeTextures = m_commandBackend.AddTextures({ { m_cubeTexture.get() }, m_samplerWrap.get() });
+
+	m_ids.sheetMesh = m_commandBackend.AddMesh(m_sheet);
+	m_ids.duckMesh = m_commandBackend.AddMesh(m_duck);
+	m_ids.wallMesh = m_commandBackend.AddMesh(m_walls);
 }
 
 void Robot::CreateRenderStates()
 //Setup render states used in various stages of the scene rendering
 {
+	BlendDescription bsDesc;
+	bsDesc.RenderTarget[0].BlendEnable = true;
+	bsDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	bsDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	m_bsAlpha = m_device.CreateBlendState(bsDesc);
+
+	DepthStencilDescription dssDesc;
+	dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	m_dssNoDepthWrite = m_device.CreateDepthStencilState(dssDesc);
+
+	//z-fail: shadow volume faces behind the scene count back faces up and front faces down,
+	//with wrapping so the count only has to come back to zero
+	dssDesc.StencilEnable = true;
+	dssDesc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_INCR;
+	dssDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_DECR;
+	m_dssStencilWriteSh = m_device.CreateDepthStencilState(dssDesc);
+
+	//pixels left with a non-zero count are in shadow
+	dssDesc = DepthStencilDescription();
+	dssDesc.DepthEnable = false;
+	dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	dssDesc.StencilEnable = true;
+	dssDesc.FrontFace.StencilFunc = dssDesc.BackFace.StencilFunc = D3D11_COMPARISON_NOT_EQUAL;
+	m_dssStencilTestSh = m_device.CreateDepthStencilState(dssDesc);
+
+	RasterizerDescription rsDesc;
+	rsDesc.CullMode = D3D11_CULL_NONE;
+	m_rsNoCullSh = m_device.CreateRasterizerState(rsDesc);
+
+	//shadows are drawn over the same triangles again, which pass with equal depth
+	dssDesc = DepthStencilDescription();
+	dssDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	dssDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+	m_dssShadowReceiver = m_device.CreateDepthStencilState(dssDesc);
+}
+
+void Robot::CreatePipelines()
+//Pipeline states of every draw, built from the shaders and render states created before
+{
+	//ids are handed out in creation order and rank the draws of a pass in their keys, so the scene's
+	//pipelines are created in the order it has always been drawn in: the sheet, the duck, the walls
+	PipelineStateDesc desc;
+	desc.inputLayout = m_textureIL.get();
+	desc.vs = m_textureVS.get();
+	desc.ps = m_texturePS.get();
+	m_pso.sheet = m_pipelines.Get(desc);
+
+	desc.inputLayout = m_duckEncoding.quantized ? m_kaczorQuantizedIL.get() : m_kaczorIL.get();
+	desc.vs = m_duckEncoding.quantized ? m_kaczorQuantizedVS.get() : m_kaczorVS.get();
+	desc.ps = m_kaczorPS.get();
+	m_pso.kaczor = m_pipelines.Get(desc);
+	if (!m_shadowMap.empty())
+	{
+		//the duck's own shaders with the light as the camera, only depth is written
+		desc.ps = nullptr;
+		desc.rasterizerState = m_shadowMap.rasterizerState();
+		m_pso.kaczorDepth = m_pipelines.Get(desc);
+	}
+
+	desc = PipelineStateDesc();
+	desc.inputLayout = m_il.get();
+	desc.vs = m_vs.get();
+	desc.ps = m_ps.get();
+	m_pso.walls = m_pipelines.Get(desc);
+
+	desc = PipelineStateDesc();
+	desc.blendState = m_bsAlpha.get();
+	desc.depthStencilState = m_dssNoDepthWrite.get();
+	desc.topology = D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+	desc.gs = m_particleGS.get();
+	desc.ps = m_particlePS.get();
+	if (m_useGpuParticles)
+		//the vertices are generated from SV_VertexID
+		desc.vs = m_particleGpuVS.get();
+	else
+	{
+		desc.inputLayout = m_particleIL.get();
+		desc.vs = m_particleVS.get();
+	}
+	m_pso.particles = m_pipelines.Get(desc);
+
+	if (!m_shadowMap.empty())
+	{
+		desc = PipelineStateDesc();
+		desc.inputLayout = m_shadowReceiverIL.get();
+		desc.vs = m_shadowReceiverVS.get();
+		desc.ps = m_shadowReceiverPS.get();
+		desc.blendState = m_bsAlpha.get();
+		desc.depthStencilState = m_dssShadowReceiver.get();
+		m_pso.shadowReceiver = m_pipelines.Get(desc);
+	}
+	else
+	{
+		//only the stencil buffer is written
+		desc = PipelineStateDesc();
+		desc.inputLayout = m_shadowVolumeIL.get();
+		desc.vs = m_shadowVolumeVS.get();
+		desc.depthStencilState = m_dssStencilWriteSh.get();
+		desc.rasterizerState = m_rsNoCullSh.get();
+		if (!m_cpuShadowVolumes)
+		{
+			desc.gs = m_shadowVolumeGS.get();
+			desc.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ;
+		}
+		m_pso.shadowVolume = m_pipelines.Get(desc);
+
+		desc = PipelineStateDesc();
+		desc.vs = m_shadowOverlayVS.get();
+		desc.ps = m_shadowOverlayPS.get();
+		desc.blendState = m_bsAlpha.get();
+		desc.depthStencilState = m_dssStencilTestSh.get();
+		m_pso.shadowOverlay = m_pipelines.Get(desc);
+	}
 }
 
 #pragma endregion
@@ -153,12 +406,40 @@ void Robot::Update(const Clock& c)
 {
 	Base::Update(c);
 	double dt = c.getFrameTime();
+	m_statsTime += dt;
+	if (m_statsTime >= 0.5)
+	{
+		m_statsTime = 0.0;
+		ShowStats();
+	}
 	if (HandleCameraInput(dt))
 	{
 		XMFLOAT4X4 cameraMtx;
 		XMStoreFloat4x4(&cameraMtx, m_camera.getViewMatrix());
 		UpdateCameraCB(cameraMtx);
 	}
+	if (m_useGpuParticles)
+		m_gpuParticles.Update(m_device.context(), static_cast<float>(dt));
+	else
+		m_particles.Simulate(static_cast<float>(dt));
+}
+
+void Robot::ShowStats()
+//The window title is the overlay, nothing in the scene draws text
+{
+	auto& counters = m_state.counters();
+	unsigned int calls = 0, elided = 0;
+	for (int i = 0; i < StateCache::BufferUpdate; ++i)
+	{
+		calls += counters.issued[i];
+		elided += counters.elided[i];
+	}
+	wstring title = L"Kaczor - " + to_wstring(static_cast<int>(getClock().getFPS())) + L" fps - " +
+		to_wstring(m_replayStats.draws) + L" draws in " + to_wstring(m_replayStats.batches) + L" batches, " +
+		to_wstring(m_replayStats.stateChanges) + L" state commands (" + to_wstring(m_replayStats.redundant) + L" redundant), " +
+		to_wstring(calls) + L" state calls (" + to_wstring(elided) + L" elided), " +
+		to_wstring(counters.issued[StateCache::BufferUpdate]) + L" buffer updates per frame";
+	SetWindowTextW(m_window.getHandle(), title.c_str());
 }
 
 void Robot::UpdateCameraCB(DirectX::XMFLOAT4X4 cameraMtx)
@@ -173,28 +454,6 @@ void Robot::UpdateCameraCB(DirectX::XMFLOAT4X4 cameraMtx)
 
 #pragma endregion
 #pragma region Frame Rendering Setup
-void Robot::SetShaders()
-{
-	m_device.context()->IASetInputLayout(m_il.get());
-	m_device.context()->VSSetShader(m_vs.get(), 0, 0);
-	m_device.context()->PSSetShader(m_ps.get(), 0, 0);
-	m_device.context()->GSSetShader(nullptr, nullptr, 0);
-	m_device.context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-}
-
-void Robot::SetShaders(const dx_ptr<ID3D11VertexShader>& vs, const dx_ptr<ID3D11PixelShader>& ps)
-{
-	m_device.context()->VSSetShader(vs.get(), nullptr, 0);
-	m_device.context()->PSSetShader(ps.get(), nullptr, 0);
-}
-
-void Robot::SetShaders(const dx_ptr<ID3D11VertexShader>& vs, const dx_ptr<ID3D11PixelShader>& ps, const dx_ptr<ID3D11InputLayout>& il)
-{
-	m_device.context()->IASetInputLayout(il.get());
-	m_device.context()->VSSetShader(vs.get(), nullptr, 0);
-	m_device.context()->PSSetShader(ps.get(), nullptr, 0);
-}
-
 void mini::gk2::Robot::KaczorowyDeBoor()
 {
 	float N[5] = { 0,1,0,0,0 };
@@ -225,13 +484,6 @@ void mini::gk2::Robot::CreateKaczorMtx()
 	m_kaczorMtx = XMMatrixScaling(KACZOR_SIZE, KACZOR_SIZE, KACZOR_SIZE)* XMMatrixRotationAxis(XMVECTOR{ 0, -1, 0 }, std::atan2f(kaczorDirection.x, kaczorDirection.z) + g_XMPi.f[0]) * XMMatrixTranslation(kaczorPosition.z, kaczorPosition.y, kaczorPosition.x);
 }
 
-void Robot::SetTextures(std::initializer_list<ID3D11ShaderResourceView*> resList, const dx_ptr<ID3D11SamplerState>& sampler)
-{
-	m_device.context()->PSSetShaderResources(0, resList.size(), resList.begin());
-	auto s_ptr = sampler.get();
-	m_device.context()->PSSetSamplers(0, 1, &s_ptr);
-}
-
 void Robot::Set1Light(XMFLOAT4 poition)
 //Setup one positional light at the camera
 {
@@ -247,37 +499,9 @@ void Robot::Set1Light(XMFLOAT4 poition)
 	UpdateBuffer(m_cbLighting, l);
 }
 
-void Robot::Set3Lights()
-//Setup one white positional light at the camera
-{
-	Lighting l{
-		/*.ambientColor = */ XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f),
-		/*.surface = */ XMFLOAT4(0.2f, 0.8f, 0.8f, 200.0f),
-		/*.lights =*/ {
-			{ /*.position =*/ XMFLOAT4(0.0f,0.5f,0.0f,1.0f), /*.color =*/ XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) }
-			//other 2 lights set to 0
-		}
-	};
-
-	//comment the following line when structure is filled
-	ZeroMemory(&l.lights[1], sizeof(Light) * 2);
-
-	UpdateBuffer(m_cbLighting, l);
-}
 #pragma endregion
 
 #pragma region Drawing
-void Robot::SetWorldMtx(DirectX::XMFLOAT4X4 mtx)
-{
-	UpdateBuffer(m_cbWorld, mtx);
-}
-
-void Robot::DrawMesh(const Mesh& m, DirectX::XMFLOAT4X4 worldMtx)
-{
-	SetWorldMtx(worldMtx);
-	m.Render(m_device.context());
-}
-
 void Robot::CreateWallsMtx()
 {
 	XMVECTOR xRot = XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
@@ -304,27 +528,52 @@ void Robot::CreateWallsMtx()
 	}
 }
 
-void Robot::DrawWalls()
+void Robot::CreateWallsMesh()
 {
-	for (int i = 0; i < 6; ++i)
+	//the walls never move, so every face is transformed once and the mesh is drawn with an identity world
+	auto faceVerts = Mesh::RectangleVerts(1.0f, 1.0f);
+	auto faceIdxs = Mesh::RectangleIdxs();
+	vector<VertexPositionNormal> verts;
+	vector<unsigned short> idxs;
+	for (auto& mtx : m_wallsMtx)
 	{
-		UpdateBuffer(m_cbWorld, m_wallsMtx[i]);
-		UpdateBuffer(m_cbSurfaceColor, XMFLOAT4(1.0f, 0.1f, 0.1f, 0.5f));
-		m_wall.Render(m_device.context());
+		auto first = static_cast<unsigned short>(verts.size());
+		for (auto v : faceVerts)
+		{
+			XMStoreFloat3(&v.position, XMVector3TransformCoord(XMLoadFloat3(&v.position), mtx));
+			XMStoreFloat3(&v.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&v.normal), mtx)));
+			verts.push_back(v);
+		}
+		for (auto i : faceIdxs)
+			idxs.push_back(first + i);
 	}
+	m_walls = Mesh::SimpleTriMesh(m_device, verts, idxs);
 }
 
-void Robot::DrawSheet(bool colors)
+void Robot::RecordWalls(CommandRecorder& recorder)
 {
+	recorder.Begin(DrawKey(ScenePass, m_pso.walls, m_ids.cubeTextures, ViewDepth(WALLS_POS)));
+	recorder.SetPipeline(m_pso.walls);
+	recorder.BindTextures(m_ids.cubeTextures);
+	BindConstants(recorder, ConstantRing::Pixel, 0, m_frame.wallColor);
+	BindConstants(recorder, ConstantRing::Vertex, 0, m_frame.wallsWorld);
+	recorder.Draw(m_ids.wallMesh);
+}
 
-	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
-	UpdateBuffer(m_cbWorld, m_sheetMtx);
-	m_sheet.Render(m_device.context());
-
-	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4(1.0f, -1.0f, 1.0f, 1.0f));
-
-	UpdateBuffer(m_cbWorld, m_revSheetMtx);
-	m_sheet.Render(m_device.context());
+void Robot::RecordSheet(CommandRecorder& recorder)
+{
+	//the flipped sheet is drawn with a negative y of the surface color
+	ConstantRange colors[] = { m_frame.sheetColor, m_frame.revSheetColor };
+	ConstantRange worlds[] = { m_frame.sheetWorld, m_frame.revSheetWorld };
+	for (int i = 0; i < 2; ++i)
+	{
+		recorder.Begin(DrawKey(ScenePass, m_pso.sheet, m_ids.waterTextures, ViewDepth(SHEET_POS)));
+		recorder.SetPipeline(m_pso.sheet);
+		recorder.BindTextures(m_ids.waterTextures);
+		BindConstants(recorder, ConstantRing::Pixel, 0, colors[i]);
+		BindConstants(recorder, ConstantRing::Vertex, 0, worlds[i]);
+		recorder.Draw(m_ids.sheetMesh);
+	}
 }
 
 void Robot::CreateSheetMtx()
@@ -340,12 +589,15 @@ void Robot::GenerateHeightMap()
 	int u = (kaczorPosition.x + 1.0f) * 0.5f * (Nsize - 1);
 	int v = (kaczorPosition.z + 1.0f) * 0.5f * (Nsize - 1);
 	heightMapOld[u][v] = 0.25f;
+	m_splashes.Disturb(u, v);
 	constexpr float A = c * c * dt * dt / (h * h);
 	constexpr float B = 2 - 4 * A;
 	for (int i = 0; i < Nsize; i++) {
 		for (int j = 0; j < Nsize; j++) {
-			if (rand() % 100000 < 1 && rand() % 20 < 1)
+			if (rand() % 100000 < 1 && rand() % 20 < 1) {
 				heightMap[i][j] = 0.25f;
+				m_splashes.Disturb(i, j);
+			}
 			else {
 				float zip = 0.0f;
 				if (i > 0)
@@ -398,32 +650,213 @@ void Robot::GenerateHeightMap()
 	m_device.context()->GenerateMips(m_waterTexture.get());
 }
 
+XMFLOAT3 Robot::KaczorCenter() const
+{
+	//the spline is evaluated with x and z swapped
+	return XMFLOAT3(kaczorPosition.z, kaczorPosition.y, kaczorPosition.x);
+}
+
+size_t Robot::KaczorLod() const
+{
+	//error of the simplified ducks is kept below a pixel
+	auto height = static_cast<float>(m_window.getClientSize().cy);
+	return SelectLod(m_duck, KACZOR_SIZE, KaczorCenter(), m_camera, ProjectionScale(FOV_Y, height));
+}
+
+float Robot::ViewDepth(XMFLOAT3 point) const
+{
+	return XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&point), m_camera.getViewMatrix()));
+}
+
+void Robot::RecordKaczor(CommandRecorder& recorder)
+{
+	//kaczorPS reads no surface color
+	recorder.Begin(DrawKey(ScenePass, m_pso.kaczor, m_ids.kaczorTextures, ViewDepth(KaczorCenter())));
+	recorder.SetPipeline(m_pso.kaczor);
+	recorder.BindTextures(m_ids.kaczorTextures);
+	BindConstants(recorder, ConstantRing::Vertex, 0, m_frame.kaczorWorld);
+	recorder.Draw(m_ids.duckMesh, static_cast<uint32_t>(KaczorLod()));
+}
+
 void Robot::DrawKaczor()
 {
-	UpdateBuffer(m_cbWorld, m_kaczorMtx);
+	m_constants.Bind(m_state, ConstantRing::Vertex, 0, m_frame.kaczorWorld);
+	m_duck.Render(m_state, KaczorLod());
+}
+
+void Robot::DrawParticles()
+{
+	auto& context = m_device.context();
+	size_t count = 0;
+	if (!m_useGpuParticles)
+	{
+		auto verts = m_particleVerts.Map(context, MAX_SPLASH_PARTICLES);
+		count = m_particles.WriteVertices(m_camera.getCameraPosition(), verts, MAX_SPLASH_PARTICLES);
+		m_particleVerts.Unmap(context, static_cast<unsigned int>(count));
+		if (count == 0)
+			return;
+	}
+
+	m_pipelines.Bind(m_state, m_pso.particles);
+	auto cbProj = m_cbProj.get();
+	m_state.GSSetConstantBuffers(0, 1, &cbProj);
+	if (m_useGpuParticles)
+		m_gpuParticles.Draw(context);
+	else
+	{
+		m_particleVerts.Bind(context);
+		m_particleVerts.Draw(context);
+	}
+}
+
+void Robot::DrawShadowVolumes()
+{
+	auto& context = m_device.context();
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, m_kaczorMtx);
+	m_constants.Bind(m_state, ConstantRing::Vertex, 0, m_frame.kaczorWorld);
+	m_pipelines.Bind(m_state, m_pso.shadowVolume);
+	if (m_cpuShadowVolumes)
+	{
+		//the volume is built in model space
+		m_duckShadow.Update(context, LightPos, world, &m_workers, SHADOW_EXTRUSION / KACZOR_SIZE);
+		m_duckShadow.Draw(context);
+	}
+	else
+	{
+		ID3D11Buffer* gsb[] = { m_cbView.get(), m_cbProj.get() };
+		m_state.GSSetConstantBuffers(0, 2, gsb);
+		m_constants.Bind(m_state, ConstantRing::Geometry, 2, m_frame.shadowVolume);
+		m_duckShadowGpu.Draw(context);
+	}
+
+	//darken everything inside the volumes
+	m_pipelines.Bind(m_state, m_pso.shadowOverlay);
+	context->Draw(3, 0);
+}
+
+void Robot::FitShadowCascades()
+{
+	auto size = m_window.getClientSize();
+	CascadeCamera camera;
+	XMStoreFloat4x4(&camera.view, m_camera.getViewMatrix());
+	camera.fovY = FOV_Y;
+	camera.aspect = static_cast<float>(size.cx) / size.cy;
+	camera.nearZ = NEAR_PLANE;
+	camera.farZ = FAR_PLANE;
+	m_shadowCascades = FitCascades(LightPos, SHADOW_RECEIVERS, 8, camera, m_shadowMap.cascadeCount());
+}
 
-	m_duck.Render(m_device.context());
+void Robot::DrawShadowMap()
+{
+	m_pipelines.Bind(m_state, m_pso.kaczorDepth);
+	auto cbShadowView = m_cbShadowView.get();
+	m_state.VSSetConstantBuffers(1, 1, &cbShadowView);
+	for (unsigned int c = 0; c < m_shadowCascades.count; ++c)
+	{
+		m_constants.Bind(m_state, ConstantRing::Vertex, 2, m_frame.shadowProj[c]);
+		m_shadowMap.Begin(m_state, c);
+		DrawKaczor();
+	}
+	ID3D11Buffer* vsb[] = { m_cbView.get(), m_cbProj.get() };
+	m_state.VSSetConstantBuffers(1, 2, vsb);
+	//the replay binds its own pipeline states, the rasterizer state included
+	ResetRenderTarget();
+}
+
+void Robot::RecordShadowReceivers(CommandRecorder& recorder)
+{
+	//the top of the sheet and the walls are drawn again, darkened where the map hides the light
+	ConstantRange worlds[] = { m_frame.sheetWorld, m_frame.wallsWorld };
+	uint32_t meshes[] = { m_ids.sheetMesh, m_ids.wallMesh };
+	XMFLOAT3 centers[] = { SHEET_POS, WALLS_POS };
+	for (int i = 0; i < 2; ++i)
+	{
+		recorder.Begin(DrawKey(ShadowReceiverPass, m_pso.shadowReceiver, m_ids.shadowMapTextures, ViewDepth(centers[i])));
+		recorder.SetPipeline(m_pso.shadowReceiver);
+		recorder.BindTextures(m_ids.shadowMapTextures);
+		BindConstants(recorder, ConstantRing::Pixel, 2, m_frame.shadowMap);
+		BindConstants(recorder, ConstantRing::Vertex, 0, worlds[i]);
+		recorder.Draw(meshes[i]);
+	}
+}
+
+void Robot::RecordFrame()
+{
+	m_commands.Clear();
+	m_workers.ParallelFor(PassCount, [this](size_t pass)
+	{
+		auto& recorder = m_commands.recorder(pass);
+		if (pass == ScenePass)
+		{
+			RecordSheet(recorder);
+			RecordKaczor(recorder);
+			RecordWalls(recorder);
+		}
+		else if (!m_shadowMap.empty())
+			RecordShadowReceivers(recorder);
+	});
+	m_commands.Sort();
+}
+
+void Robot::WriteFrameConstants()
+{
+	auto& context = m_device.context();
+	m_constants.BeginFrame();
+	m_constants.Map(context);
+	m_frame.sheetWorld = m_constants.Push(m_sheetMtx);
+	m_frame.revSheetWorld = m_constants.Push(m_revSheetMtx);
+	m_frame.kaczorWorld = m_constants.Push(m_kaczorMtx);
+	m_frame.wallsWorld = m_constants.Push(XMMatrixIdentity());
+	m_frame.sheetColor = m_constants.Push(XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	m_frame.revSheetColor = m_constants.Push(XMFLOAT4(1.0f, -1.0f, 1.0f, 1.0f));
+	m_frame.wallColor = m_constants.Push(XMFLOAT4(1.0f, 0.1f, 0.1f, 0.5f));
+	if (m_shadowMap.empty())
+		m_frame.shadowVolume = m_constants.Push(ShadowVolumeParameters{ LightPos, SHADOW_EXTRUSION });
+	else
+	{
+		FitShadowCascades();
+		for (unsigned int c = 0; c < m_shadowCascades.count; ++c)
+			m_frame.shadowProj[c] = m_constants.Push(m_shadowCascades.viewProj[c]);
+		m_frame.shadowMap = m_constants.Push(m_shadowMap.Constants(m_shadowCascades, SHADOW_STRENGTH));
+	}
+	m_constants.Unmap(context);
 }
 
 void Robot::Render()
 {
+	//counters cover one frame when ShowStats reads them
+	m_state.ResetCounters();
 	Base::Render();
 	KaczorowyDeBoor();
 	GenerateHeightMap();
-	SetShaders(m_textureVS, m_texturePS);
-	SetTextures({ m_waterTexture.get(), m_cubeTexture.get() }, m_samplerWrap);
-	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f));
-	DrawSheet(true);
+	//after GenerateHeightMap heightMapOld holds the newest step
+	if (m_useGpuParticles)
+	{
+		//GPU particles are never read back, drops landing in the water don't disturb it
+		m_splashes.Update(heightMapOld, heightMap);
+		m_splashes.Emit(m_gpuParticles);
+	}
+	else
+	{
+		m_splashes.ApplyImpacts(m_particles, heightMapOld);
+		m_splashes.Update(heightMapOld, heightMap, m_particles);
+	}
 
-	SetShaders(m_kaczorVS, m_kaczorPS, m_kaczorIL);
-	SetTextures({ m_kaczorTexture.get() }, m_samplerWrap);
 	CreateKaczorMtx();
-	DrawKaczor();
+	WriteFrameConstants();
+	RecordFrame();
 
-	SetShaders();
-	SetTextures({ m_cubeTexture.get() }, m_samplerWrap);
+	//the casters only need the light, so the map is done before any of the recorded draws
+	if (!m_shadowMap.empty())
+		DrawShadowMap();
 	Set1Light(LightPos);
-	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f));
-	DrawWalls();
+	m_replayStats = m_commands.Replay(m_commandBackend);
+
+	if (m_shadowMap.empty())
+		DrawShadowVolumes();
+	else
+		ShadowMap::Unbind(m_state);
+	DrawParticles();
 }
 #pragma endregion
\ No newline at end of file
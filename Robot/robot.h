@@ -4,6 +4,16 @@
 #include "dxApplication.h"
 #include "mesh.h"
 #include "particleSystem.h"
+#include "gpuParticleSystem.h"
+#include "splashSystem.h"
+#include "dynamicBuffer.h"
+#include "workerPool.h"
+#include "vertexQuantization.h"
+#include "silhouette.h"
+#include "shadowMap.h"
+#include "constantRing.h"
+#include "pipelineState.h"
+#include "dxCommandBackend.h"
 #include <queue>
 
 namespace mini::gk2
@@ -29,12 +39,27 @@ namespace mini::gk2
 		Light lights[3];
 	};
 
+	//Parameters of shadowVolumeGS.hlsl
+	struct ShadowVolumeParameters
+	{
+		//world space light position, w = 0 for a directional light
+		DirectX::XMFLOAT4 lightPosition;
+		//world space length of the shadow volume sides
+		float extrusion;
+		float padding[3];
+	};
+
 	class Robot : public DxApplication
 	{
 	public:
 		using Base = DxApplication;
 
-		explicit Robot(HINSTANCE hInstance);
+		//gpuParticles selects the compute shader particle simulation instead of the CPU one,
+		//cpuShadowVolumes builds the shadow volumes on the CPU instead of the geometry shader,
+		//shadowMaps replaces the shadow volumes with a shadow map pass,
+		//assetCache keeps processed meshes and textures in the cache directory between runs
+		explicit Robot(HINSTANCE hInstance, bool gpuParticles = false, bool cpuShadowVolumes = false,
+			const ShadowMapSettings* shadowMaps = nullptr, bool assetCache = true);
 
 	protected:
 		void Update(const Clock& dt) override;
@@ -44,6 +69,7 @@ namespace mini::gk2
 #pragma region CONSTANTS
 		static const unsigned int BS_MASK;
 		void CreateRenderStates();
+		void CreatePipelines();
 
 		//Static light positions
 		static const DirectX::XMFLOAT4 GREEN_LIGHT_POS;
@@ -64,6 +90,13 @@ namespace mini::gk2
 		static constexpr float kaczorSpeed = 0.01f;
 		static constexpr unsigned int c = 1;
 		static constexpr float dt = 1.0f/Nsize;
+		static constexpr unsigned int MAX_SPLASH_PARTICLES = 20000;
+		static constexpr unsigned int MAX_GPU_PARTICLES = 1 << 20;
+		//reaches past the walls from anywhere in the room
+		static constexpr float SHADOW_EXTRUSION = 4.0f;
+		static constexpr float SHADOW_STRENGTH = 0.5f;
+		//corners of the box around the sheet and the walls above it, where the duck's shadow can fall
+		static const DirectX::XMFLOAT3 SHADOW_RECEIVERS[8];
 		static const DirectX::XMFLOAT4 SHEET_COLOR;
 
 		static const float WALL_SIZE;
@@ -72,9 +105,8 @@ namespace mini::gk2
 #pragma endregion
 
 #pragma region D3D Resources
-		//Shader's constant buffer containing Local -> World matrix
-		dx_ptr<ID3D11Buffer> m_cbWorld;
-		//ConstantBuffer<DirectX::XMFLOAT4X4> m_cbWorld;
+		//Per-draw constants (world matrices, surface colors, shadow parameters), written once per frame
+		ConstantRing m_constants;
 		//Shader's constant buffer containing World -> Camera and Camera -> World matrix
 		dx_ptr<ID3D11Buffer> m_cbView;
 		//ConstantBuffer<DirectX::XMFLOAT4X4, 2> m_cbView;
@@ -84,11 +116,8 @@ namespace mini::gk2
 		//Shader's constant buffer containing lighting parameters (except surface color)
 		dx_ptr<ID3D11Buffer> m_cbLighting;
 		//ConstantBuffer<Lighting> m_cbLighting;
-
-		dx_ptr<ID3D11Buffer> m_cbMapMtx; //pixel shader constant buffer slot 2
-		//Shader's constant buffer containing surface color
-		dx_ptr<ID3D11Buffer> m_cbSurfaceColor;
-		//ConstantBuffer<DirectX::XMFLOAT4> m_cbSurfaceColor;
+		//Vertex shader constant buffer slot 4 with the duck's PositionDequantization
+		dx_ptr<ID3D11Buffer> m_cbDequantization;
 
 		dx_ptr<ID3D11SamplerState> m_sampler;
 
@@ -101,12 +130,18 @@ namespace mini::gk2
 
 		//Box mesh
 		Mesh m_box;
-		//Wall mesh
-		Mesh m_wall;
+		//All six walls in world space, drawn with a single call
+		Mesh m_walls;
 		//Wall mesh
 		Mesh m_sheet;
 		//Kaczor mesh
 		Mesh m_duck;
+		//Layout chosen for the duck at load time
+		VertexEncoding m_duckEncoding;
+		//Z-fail stencil shadow of the duck, only one of them is created
+		bool m_cpuShadowVolumes;
+		ShadowVolume m_duckShadow;
+		GpuShadowVolume m_duckShadowGpu;
 
 		//Depth stencil state used for drawing billboards without writing to the depth buffer
 		dx_ptr<ID3D11DepthStencilState> m_dssNoDepthWrite;
@@ -124,6 +159,8 @@ namespace mini::gk2
 		dx_ptr<ID3D11RasterizerState> m_rsCCW;
 		dx_ptr<ID3D11RasterizerState> m_rsCCW_backSh;
 		dx_ptr<ID3D11RasterizerState> m_rsCCW_frontSh;
+		//Rasterizer state used to draw both sides of the shadow volumes in one pass
+		dx_ptr<ID3D11RasterizerState> m_rsNoCullSh;
 		//Blend state used to draw dodecahedron faced with alpha blending.
 		dx_ptr<ID3D11BlendState> m_bsAlpha;
 		dx_ptr<ID3D11BlendState> m_bsAlphaInv;
@@ -156,8 +193,70 @@ namespace mini::gk2
 		dx_ptr<ID3D11VertexShader> m_kaczorVS;
 		dx_ptr<ID3D11PixelShader> m_kaczorPS;
 		dx_ptr<ID3D11InputLayout> m_kaczorIL;
+		dx_ptr<ID3D11VertexShader> m_kaczorQuantizedVS;
+		dx_ptr<ID3D11InputLayout> m_kaczorQuantizedIL;
+
+		//splash particles
+		dx_ptr<ID3D11VertexShader> m_particleVS;
+		dx_ptr<ID3D11GeometryShader> m_particleGS;
+		dx_ptr<ID3D11PixelShader> m_particlePS;
+		dx_ptr<ID3D11InputLayout> m_particleIL;
+		dx_ptr<ID3D11VertexShader> m_particleGpuVS;
+
+		//shadow volumes
+		dx_ptr<ID3D11VertexShader> m_shadowVolumeVS;
+		dx_ptr<ID3D11GeometryShader> m_shadowVolumeGS;
+		dx_ptr<ID3D11InputLayout> m_shadowVolumeIL;
+		dx_ptr<ID3D11VertexShader> m_shadowOverlayVS;
+		dx_ptr<ID3D11PixelShader> m_shadowOverlayPS;
+
+		//shadow map, used instead of the shadow volumes when it's not empty
+		ShadowMap m_shadowMap;
+		ShadowCascades m_shadowCascades;
+		//identity view for rendering the casters with the regular shaders, the light's projection is in m_constants
+		dx_ptr<ID3D11Buffer> m_cbShadowView;
+		dx_ptr<ID3D11VertexShader> m_shadowReceiverVS;
+		dx_ptr<ID3D11PixelShader> m_shadowReceiverPS;
+		dx_ptr<ID3D11InputLayout> m_shadowReceiverIL;
+		//Depth stencil state used to draw over already rendered surfaces
+		dx_ptr<ID3D11DepthStencilState> m_dssShadowReceiver;
+		DynamicVertexRing<ParticleVertex> m_particleVerts;
+
+		//Every combination of shaders and states the scene draws with, created up front
+		PipelineCache m_pipelines;
+		//Ids of m_pipelines, the duck's and the shadows' variants are picked when they are created
+		struct PipelineIds
+		{
+			uint32_t walls, sheet, kaczor, kaczorDepth, shadowReceiver;
+			uint32_t particles, shadowVolume, shadowOverlay;
+		};
+		PipelineIds m_pso;
+
+		//Ids of the tables of m_commandBackend
+		struct CommandIds
+		{
+			uint32_t waterTextures, kaczorTextures, cubeTextures, shadowMapTextures;
+			uint32_t sheetMesh, duckMesh, wallMesh;
+		};
+		CommandIds m_ids;
+		DxCommandBackend m_commandBackend;
 #pragma endregion
 
+		//Recorders of the queue, each pass is recorded by its own job.
+		//Packets are replayed pass by pass, in recording order within a pass.
+		enum RenderPass { ScenePass, ShadowReceiverPass, PassCount };
+		CommandQueue m_commands;
+		//Counts of the last replay and the state cache, shown in the window title
+		ReplayStats m_replayStats;
+		double m_statsTime = 0.0;
+		void ShowStats();
+
+		WorkerPool m_workers;
+		bool m_useGpuParticles;
+		ParticleSystem m_particles;
+		GpuParticleSystem m_gpuParticles;
+		SplashSystem m_splashes;
+
 #pragma region Matrices
 		DirectX::XMFLOAT4X4 m_projMtx;
 		DirectX::XMMATRIX m_wallsMtx[6];
@@ -165,26 +264,44 @@ namespace mini::gk2
 		DirectX::XMMATRIX m_revSheetMtx;
 		DirectX::XMMATRIX m_kaczorMtx;
 #pragma endregion
-		void SetWorldMtx(DirectX::XMFLOAT4X4 mtx);
-		void DrawMesh(const Mesh& m, DirectX::XMFLOAT4X4 worldMtx);
+
+		//Where this frame's per-draw constants are in m_constants
+		struct FrameConstants
+		{
+			ConstantRange sheetWorld, revSheetWorld, kaczorWorld, wallsWorld;
+			ConstantRange sheetColor, revSheetColor, wallColor;
+			//GS slot 2 of the shadow volumes
+			ConstantRange shadowVolume;
+			//PS slot 2 of the receivers and VS slot 2 of every cascade
+			ConstantRange shadowMap, shadowProj[MAX_SHADOW_CASCADES];
+		};
+		FrameConstants m_frame;
+
 		void UpdateCameraCB(DirectX::XMFLOAT4X4 cameraMtx);
 		void Set1Light(DirectX::XMFLOAT4 LightPos);
-		void SetShaders();
-		void Set3Lights();
 		void CreateWallsMtx();
-		void DrawWalls();
+		void CreateWallsMesh();
+		void RecordWalls(CommandRecorder& recorder);
 		void CreateSheetMtx();
-		void DrawSheet(bool colors);
+		void RecordSheet(CommandRecorder& recorder);
 		void CreateKaczorMtx();
+		DirectX::XMFLOAT3 KaczorCenter() const;
+		size_t KaczorLod() const;
+		float ViewDepth(DirectX::XMFLOAT3 point) const;
+		void RecordKaczor(CommandRecorder& recorder);
 		void DrawKaczor();
+		void DrawParticles();
+		void DrawShadowVolumes();
+		void DrawShadowMap();
+		void RecordShadowReceivers(CommandRecorder& recorder);
+		void CreateCommandTables();
+		void RecordFrame();
+		void FitShadowCascades();
+		//Pushes everything in FrameConstants with a single Map
+		void WriteFrameConstants();
 
 		void GenerateHeightMap();
 
 		void KaczorowyDeBoor();
-
-		void SetShaders(const dx_ptr<ID3D11VertexShader>& vs, const dx_ptr<ID3D11PixelShader>& ps);
-		void SetShaders(const dx_ptr<ID3D11VertexShader>& vs, const dx_ptr<ID3D11PixelShader>& ps, const dx_ptr<ID3D11InputLayout>& il);
-		void SetTextures(std::initializer_list<ID3D11ShaderResourceView*> resList, const dx_ptr<ID3D11SamplerState>& sampler);
-		
 	};
 }
\ No newline at end of file
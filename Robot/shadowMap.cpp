@@ -0,0 +1,90 @@
+#include "shadowMap.h"
+#include <algorithm>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+ShadowMap::ShadowMap(const DxDevice& device, const ShadowMapSettings& settings)
+	: m_settings(settings)
+{
+	m_settings.resolution = clamp(m_settings.resolution, 16u, static_cast<unsigned int>(D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION));
+	m_settings.cascadeCount = clamp(m_settings.cascadeCount, 1u, MAX_SHADOW_CASCADES);
+
+	//typeless, so the same texture can be a depth buffer and a float texture
+	Texture2DDescription texDesc(m_settings.resolution, m_settings.resolution);
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = m_settings.cascadeCount;
+	texDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+	texDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE;
+	m_texture = device.CreateTexture(texDesc);
+
+	DepthStencilViewDescription dsvDesc;
+	dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
+	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+	dsvDesc.Texture2DArray.ArraySize = 1;
+	for (unsigned int c = 0; c < m_settings.cascadeCount; ++c)
+	{
+		dsvDesc.Texture2DArray.FirstArraySlice = c;
+		m_dsv[c] = device.CreateDepthStencilView(m_texture, dsvDesc);
+	}
+
+	ShaderResourceViewDescription srvDesc;
+	srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MipLevels = 1;
+	srvDesc.Texture2DArray.ArraySize = m_settings.cascadeCount;
+	m_srv = device.CreateShaderResourceView(m_texture, srvDesc);
+
+	//hardware filtered comparisons, outside of the map everything is lit
+	SamplerDescription sd;
+	sd.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	sd.AddressU = sd.AddressV = sd.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
+	sd.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+	m_sampler = device.CreateSamplerState(sd);
+
+	RasterizerDescription rsDesc;
+	rsDesc.DepthBias = m_settings.depthBias;
+	rsDesc.SlopeScaledDepthBias = m_settings.slopeScaledDepthBias;
+	m_rasterizerState = device.CreateRasterizerState(rsDesc);
+}
+
+void ShadowMap::Begin(StateCache& state, unsigned int cascade) const
+{
+	auto context = state.context();
+	auto dsv = m_dsv[cascade].get();
+	context->ClearDepthStencilView(dsv, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	context->OMSetRenderTargets(0, nullptr, dsv);
+	Viewport viewport({ static_cast<LONG>(m_settings.resolution), static_cast<LONG>(m_settings.resolution) });
+	context->RSSetViewports(1, &viewport);
+	state.RSSetState(m_rasterizerState.get());
+}
+
+void ShadowMap::Bind(StateCache& state, unsigned int slot) const
+{
+	auto srv = m_srv.get();
+	auto sampler = m_sampler.get();
+	state.PSSetShaderResources(slot, 1, &srv);
+	state.PSSetSamplers(slot, 1, &sampler);
+}
+
+void ShadowMap::Unbind(StateCache& state, unsigned int slot)
+{
+	ID3D11ShaderResourceView* srv = nullptr;
+	state.PSSetShaderResources(slot, 1, &srv);
+}
+
+ShadowMapConstants ShadowMap::Constants(const ShadowCascades& cascades, float strength) const
+{
+	ShadowMapConstants result = {};
+	unsigned int count = min(cascades.count, m_settings.cascadeCount);
+	float splits[MAX_SHADOW_CASCADES] = {};
+	for (unsigned int c = 0; c < count; ++c)
+	{
+		result.lightViewProj[c] = cascades.viewProj[c];
+		splits[c] = cascades.splits[c];
+	}
+	result.cascadeSplits = { splits[0], splits[1], splits[2], splits[3] };
+	result.parameters = { m_settings.pcfSpacing / m_settings.resolution, static_cast<float>(count), strength, 0.0f };
+	return result;
+}
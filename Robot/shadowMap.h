@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dxDevice.h"
+#include "stateCache.h"
+#include "lightFrustum.h"
+
+namespace mini
+{
+	struct ShadowMapSettings
+	{
+		//width and height of every cascade in texels
+		unsigned int resolution = 2048;
+		//1 to MAX_SHADOW_CASCADES
+		unsigned int cascadeCount = 1;
+		//rasterizer depth bias of the casters, see D3D11_RASTERIZER_DESC
+		int depthBias = 64;
+		float slopeScaledDepthBias = 2.0f;
+		//the 3x3 PCF taps are this many texels apart
+		float pcfSpacing = 1.0f;
+	};
+
+	//Constant buffer of shadowReceiverPS.hlsl
+	struct ShadowMapConstants
+	{
+		DirectX::XMFLOAT4X4 lightViewProj[MAX_SHADOW_CASCADES];
+		DirectX::XMFLOAT4 cascadeSplits;
+		//x: PCF tap spacing in texture coordinates, y: cascade count, z: shadow strength
+		DirectX::XMFLOAT4 parameters;
+	};
+
+	//Depth only shadow map, one slice of a texture array per cascade
+	class ShadowMap
+	{
+	public:
+		ShadowMap() = default;
+		ShadowMap(const DxDevice& device, const ShadowMapSettings& settings);
+
+		//Clears a cascade and makes it the only target, with the viewport and biased rasterizer
+		//state of the map. The window's target and rasterizer state have to be restored afterwards.
+		void Begin(StateCache& state, unsigned int cascade) const;
+		//Binds the map and its comparison sampler to a pixel shader slot
+		void Bind(StateCache& state, unsigned int slot = 0) const;
+		//Unbinds the map so it can be rendered to again
+		static void Unbind(StateCache& state, unsigned int slot = 0);
+
+		ShadowMapConstants Constants(const ShadowCascades& cascades, float strength) const;
+
+		//The map and its comparison sampler, for binding them some other way than Bind
+		ID3D11ShaderResourceView* shaderResourceView() const { return m_srv.get(); }
+		ID3D11SamplerState* sampler() const { return m_sampler.get(); }
+		//Biased rasterizer state Begin binds, for pipeline states of the casters
+		ID3D11RasterizerState* rasterizerState() const { return m_rasterizerState.get(); }
+		unsigned int resolution() const { return m_settings.resolution; }
+		unsigned int cascadeCount() const { return m_settings.cascadeCount; }
+		bool empty() const { return !m_srv; }
+
+	private:
+		ShadowMapSettings m_settings;
+		dx_ptr<ID3D11Texture2D> m_texture;
+		dx_ptr<ID3D11DepthStencilView> m_dsv[MAX_SHADOW_CASCADES];
+		dx_ptr<ID3D11ShaderResourceView> m_srv;
+		dx_ptr<ID3D11SamplerState> m_sampler;
+		dx_ptr<ID3D11RasterizerState> m_rasterizerState;
+	};
+}
@@ -0,0 +1,7 @@
+//Drawn with alpha blending over the pixels marked in the stencil by the shadow volumes
+static const float shadowStrength = 0.5f;
+
+float4 main() : SV_TARGET
+{
+	return float4(0.0f, 0.0f, 0.0f, shadowStrength);
+}
@@ -0,0 +1,6 @@
+//Full screen triangle drawn with Draw(3, 0) without any vertex buffer
+float4 main(uint id : SV_VertexID) : SV_POSITION
+{
+	float2 uv = float2((id << 1) & 2, id & 2);
+	return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
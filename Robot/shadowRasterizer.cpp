@@ -0,0 +1,155 @@
+#include "shadowRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//vertex positions are snapped to 8 bits of subpixel precision
+	float Snap(float v)
+	{
+		return round(v * 256.0f) / 256.0f;
+	}
+
+	//Clips a convex polygon in clip space against the near plane z >= 0, returns the new vertex count
+	int ClipNear(const XMFLOAT4* in, int count, XMFLOAT4* out)
+	{
+		int result = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			auto& a = in[i];
+			auto& b = in[(i + 1) % count];
+			if (a.z >= 0.0f)
+				out[result++] = a;
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+			{
+				float t = a.z / (a.z - b.z);
+				out[result++] = { a.x + t * (b.x - a.x), a.y + t * (b.y - a.y), 0.0f, a.w + t * (b.w - a.w) };
+			}
+		}
+		return result;
+	}
+}
+
+ShadowRasterizer::ShadowRasterizer(unsigned int resolution)
+	: m_resolution(resolution), m_depth(static_cast<size_t>(resolution) * resolution, 1.0f)
+{ }
+
+void ShadowRasterizer::Clear()
+{
+	fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+void ShadowRasterizer::DrawTriangles(const vector<XMFLOAT3>& positions, const vector<unsigned int>& indices,
+	const XMFLOAT4X4& worldViewProj, int depthBias, float slopeScaledDepthBias)
+{
+	auto mtx = XMLoadFloat4x4(&worldViewProj);
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		XMFLOAT4 clip[3];
+		for (int k = 0; k < 3; ++k)
+			XMStoreFloat4(&clip[k], XMVector4Transform(XMVectorSetW(XMLoadFloat3(&positions[indices[t + k]]), 1.0f), mtx));
+		//a triangle clipped by the near plane becomes a fan of at most two
+		XMFLOAT4 polygon[4];
+		int count = ClipNear(clip, 3, polygon);
+		for (int k = 1; k + 1 < count; ++k)
+		{
+			XMFLOAT4 triangle[3] = { polygon[0], polygon[k], polygon[k + 1] };
+			DrawTriangle(triangle, depthBias, slopeScaledDepthBias);
+		}
+	}
+}
+
+void ShadowRasterizer::DrawTriangle(const XMFLOAT4* clip, int depthBias, float slopeScaledDepthBias)
+{
+	float size = static_cast<float>(m_resolution);
+	XMFLOAT3 s[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		float w = clip[k].w;
+		s[k] = { Snap((0.5f + 0.5f * clip[k].x / w) * size), Snap((0.5f - 0.5f * clip[k].y / w) * size), clip[k].z / w };
+	}
+	//with y pointing down the screen clockwise triangles have a positive area
+	float area = (s[1].x - s[0].x) * (s[2].y - s[0].y) - (s[1].y - s[0].y) * (s[2].x - s[0].x);
+	if (area <= 0.0f)
+		return;
+
+	float dzdx = ((s[1].z - s[0].z) * (s[2].y - s[0].y) - (s[2].z - s[0].z) * (s[1].y - s[0].y)) / area;
+	float dzdy = ((s[2].z - s[0].z) * (s[1].x - s[0].x) - (s[1].z - s[0].z) * (s[2].x - s[0].x)) / area;
+	//float depth buffers scale the constant bias by the exponent of the largest depth of the primitive
+	int exponent;
+	frexp(max({ s[0].z, s[1].z, s[2].z }), &exponent);
+	float bias = depthBias * ldexp(1.0f, exponent - 1 - 23) + slopeScaledDepthBias * max(fabs(dzdx), fabs(dzdy));
+
+	auto edge = [&s](int a, int b, float x, float y)
+	{
+		return (s[b].x - s[a].x) * (y - s[a].y) - (s[b].y - s[a].y) * (x - s[a].x);
+	};
+	//pixel centres exactly on an edge belong to the triangle only for top and left edges
+	auto topLeft = [&s](int a, int b)
+	{
+		float dx = s[b].x - s[a].x, dy = s[b].y - s[a].y;
+		return dy < 0.0f || (dy == 0.0f && dx > 0.0f);
+	};
+	bool owns[3] = { topLeft(0, 1), topLeft(1, 2), topLeft(2, 0) };
+
+	int x0 = max(static_cast<int>(floor(min({ s[0].x, s[1].x, s[2].x }))), 0);
+	int x1 = min(static_cast<int>(ceil(max({ s[0].x, s[1].x, s[2].x }))), static_cast<int>(m_resolution));
+	int y0 = max(static_cast<int>(floor(min({ s[0].y, s[1].y, s[2].y }))), 0);
+	int y1 = min(static_cast<int>(ceil(max({ s[0].y, s[1].y, s[2].y }))), static_cast<int>(m_resolution));
+	for (int y = y0; y < y1; ++y)
+		for (int x = x0; x < x1; ++x)
+		{
+			float px = x + 0.5f, py = y + 0.5f;
+			float e[3] = { edge(0, 1, px, py), edge(1, 2, px, py), edge(2, 0, px, py) };
+			bool inside = true;
+			for (int k = 0; k < 3; ++k)
+				inside = inside && (e[k] > 0.0f || (e[k] == 0.0f && owns[k]));
+			if (!inside)
+				continue;
+			float z = s[0].z + dzdx * (px - s[0].x) + dzdy * (py - s[0].y);
+			if (z < 0.0f || z > 1.0f)
+				continue;
+			z = clamp(z + bias, 0.0f, 1.0f);
+			auto& stored = m_depth[y * m_resolution + x];
+			if (z < stored)
+				stored = z;
+		}
+}
+
+float ShadowRasterizer::Compare(float u, float v, float reference) const
+{
+	float tx = u * m_resolution - 0.5f, ty = v * m_resolution - 0.5f;
+	float fx = floor(tx), fy = floor(ty);
+	int x = static_cast<int>(fx), y = static_cast<int>(fy);
+	fx = tx - fx;
+	fy = ty - fy;
+	auto lit = [this, reference](int x, int y)
+	{
+		int n = static_cast<int>(m_resolution);
+		if (x < 0 || y < 0 || x >= n || y >= n)
+			return 1.0f;
+		return reference <= m_depth[y * m_resolution + x] ? 1.0f : 0.0f;
+	};
+	return (1.0f - fy) * ((1.0f - fx) * lit(x, y) + fx * lit(x + 1, y)) + fy * ((1.0f - fx) * lit(x, y + 1) + fx * lit(x + 1, y + 1));
+}
+
+float ShadowRasterizer::Visibility(const XMFLOAT3& worldPos, const XMFLOAT4X4& viewProj, float pcfSpacing) const
+{
+	XMFLOAT4 clip;
+	XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&worldPos), 1.0f), XMLoadFloat4x4(&viewProj)));
+	if (clip.w <= 0.0f)
+		return 1.0f;
+	float x = clip.x / clip.w, y = clip.y / clip.w, z = clip.z / clip.w;
+	if (fabs(x) > 1.0f || fabs(y) > 1.0f || z > 1.0f)
+		return 1.0f;
+	float u = 0.5f + 0.5f * x, v = 0.5f - 0.5f * y, step = pcfSpacing / m_resolution;
+	float lit = 0.0f;
+	for (int j = -1; j <= 1; ++j)
+		for (int i = -1; i <= 1; ++i)
+			lit += Compare(u + i * step, v + j * step, z);
+	return lit / 9.0f;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+
+namespace mini
+{
+	//CPU reference of the shadow map pass, independent of Direct3D. Follows the D3D11 rules the
+	//GPU uses: pixel centres at half texels, top-left fill rule, clockwise front faces, depth
+	//interpolated linearly in screen space with the depth bias of a 32-bit float depth buffer,
+	//and lookups made of the bilinear LESS_EQUAL comparisons of SampleCmpLevelZero.
+	class ShadowRasterizer
+	{
+	public:
+		explicit ShadowRasterizer(unsigned int resolution);
+
+		//Fills the map with the far plane
+		void Clear();
+		//Draws a triangle list with back faces culled, see D3D11_RASTERIZER_DESC for the bias
+		void DrawTriangles(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<unsigned int>& indices,
+			const DirectX::XMFLOAT4X4& worldViewProj, int depthBias = 0, float slopeScaledDepthBias = 0.0f);
+
+		//Fraction of the 3x3 PCF taps pcfSpacing texels apart that see the light at worldPos,
+		//as in shadowReceiverPS.hlsl. Positions outside the map are lit.
+		float Visibility(const DirectX::XMFLOAT3& worldPos, const DirectX::XMFLOAT4X4& viewProj, float pcfSpacing = 1.0f) const;
+
+		float depth(unsigned int x, unsigned int y) const { return m_depth[y * m_resolution + x]; }
+		unsigned int resolution() const { return m_resolution; }
+
+	private:
+		void DrawTriangle(const DirectX::XMFLOAT4* clip, int depthBias, float slopeScaledDepthBias);
+		//Bilinear LESS_EQUAL comparison at texture coordinates uv, border texels are lit
+		float Compare(float u, float v, float reference) const;
+
+		unsigned int m_resolution;
+		std::vector<float> m_depth;
+	};
+}
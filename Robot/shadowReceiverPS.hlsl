@@ -0,0 +1,45 @@
+//Darkens surfaces already drawn where the shadow map hides them from the light,
+//ShadowRasterizer::Visibility computes the same on the CPU
+
+cbuffer cbShadowMap : register(b2) //Pixel Shader constant buffer slot 2
+{
+	matrix lightViewProj[4];
+	float4 cascadeSplits;	//view depth where every cascade ends
+	float4 parameters;		//x: PCF tap spacing in texture coordinates, y: cascade count, z: shadow strength
+};
+
+Texture2DArray shadowMap : register(t0);
+SamplerComparisonState shadowSampler : register(s0);
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION;
+	float viewDepth : TEXCOORD0;
+};
+
+float4 main(PSInput i) : SV_TARGET
+{
+	uint cascade = 0;
+	[unroll]
+	for (uint c = 0; c < 3; ++c)
+		if (c + 1 < (uint)parameters.y && i.viewDepth > cascadeSplits[c])
+			cascade = c + 1;
+
+	float4 p = mul(lightViewProj[cascade], float4(i.worldPos, 1.0f));
+	if (p.w <= 0.0f)
+		discard;
+	p.xyz /= p.w;
+	if (any(abs(p.xy) > 1.0f) || p.z > 1.0f)
+		discard;
+	float2 uv = float2(0.5f + 0.5f * p.x, 0.5f - 0.5f * p.y);
+
+	float lit = 0.0f;
+	[unroll]
+	for (int y = -1; y <= 1; ++y)
+		[unroll]
+		for (int x = -1; x <= 1; ++x)
+			lit += shadowMap.SampleCmpLevelZero(shadowSampler, float3(uv + float2(x, y) * parameters.x, cascade), p.z);
+	lit /= 9.0f;
+	return float4(0.0f, 0.0f, 0.0f, parameters.z * (1.0f - lit));
+}
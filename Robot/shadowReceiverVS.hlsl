@@ -0,0 +1,38 @@
+cbuffer cbWorld : register(b0) //Vertex Shader constant buffer slot 0 - matches slot in vsBilboard.hlsl
+{
+	matrix worldMatrix;
+};
+
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1 - matches slot in vsBilboard.hlsl
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2 - matches slot in vsBilboard.hlsl
+{
+	matrix projMatrix;
+};
+
+struct VSInput
+{
+	float3 pos : POSITION;
+	float3 norm : NORMAL;
+};
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION;
+	float viewDepth : TEXCOORD0;
+};
+
+PSInput main(VSInput i)
+{
+	PSInput o;
+	o.worldPos = mul(worldMatrix, float4(i.pos, 1.0f)).xyz;
+	float4 viewPos = mul(viewMatrix, float4(o.worldPos, 1.0f));
+	o.viewDepth = viewPos.z;
+	o.pos = mul(projMatrix, viewPos);
+	return o;
+}
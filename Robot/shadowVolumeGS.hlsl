@@ -0,0 +1,81 @@
+cbuffer cbView : register(b0)
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b1)
+{
+	matrix projMatrix;
+};
+
+cbuffer cbShadowVolume : register(b2)
+{
+	float4 lightPos;	//world space, w = 0 for a directional light shining along -xyz
+	float extrusion;	//world space distance from the mesh to the far cap
+};
+
+struct GSInput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION;
+};
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+};
+
+bool Lit(float3 a, float3 b, float3 c)
+{
+	return dot(cross(b - a, c - a), lightPos.xyz - a * lightPos.w) > 0.0f;
+}
+
+float3 Extrude(float3 p)
+{
+	float3 dir = lightPos.w == 0.0f ? -lightPos.xyz : p - lightPos.xyz;
+	return p + extrusion * normalize(dir);
+}
+
+void Emit(inout TriangleStream<PSInput> ostream, float3 p)
+{
+	PSInput o;
+	o.pos = mul(projMatrix, mul(viewMatrix, float4(p, 1.0f)));
+	ostream.Append(o);
+}
+
+//Same volume as SilhouetteExtractor: faces facing away from the light are the caps,
+//their edges shared with lit faces are extruded into the sides.
+//Border edges come with the face's own third vertex, so they always border a "lit" face.
+[maxvertexcount(18)]
+void main(triangleadj GSInput i[6], inout TriangleStream<PSInput> ostream)
+{
+	float3 p[6];
+	for (int k = 0; k < 6; ++k)
+		p[k] = i[k].worldPos;
+	if (Lit(p[0], p[2], p[4]))
+		return;
+
+	for (int e = 0; e < 3; ++e)
+	{
+		int a = 2 * e, b = (2 * e + 2) % 6;
+		//the neighbour winds the shared edge b -> a
+		if (Lit(p[b], p[a], p[a + 1]))
+		{
+			Emit(ostream, Extrude(p[b]));
+			Emit(ostream, p[b]);
+			Emit(ostream, Extrude(p[a]));
+			Emit(ostream, p[a]);
+			ostream.RestartStrip();
+		}
+	}
+
+	Emit(ostream, p[0]);
+	Emit(ostream, p[2]);
+	Emit(ostream, p[4]);
+	ostream.RestartStrip();
+	Emit(ostream, Extrude(p[0]));
+	Emit(ostream, Extrude(p[4]));
+	Emit(ostream, Extrude(p[2]));
+	ostream.RestartStrip();
+}
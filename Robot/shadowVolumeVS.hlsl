@@ -0,0 +1,36 @@
+cbuffer cbWorld : register(b0) //Vertex Shader constant buffer slot 0 - matches slot in vsBilboard.hlsl
+{
+	matrix worldMatrix;
+};
+
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1 - matches slot in vsBilboard.hlsl
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2 - matches slot in vsBilboard.hlsl
+{
+	matrix projMatrix;
+};
+
+struct VSInput
+{
+	float3 pos : POSITION;
+};
+
+//pos is used when the volume is built on the CPU, worldPos by shadowVolumeGS.hlsl
+struct VSOutput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION;
+};
+
+VSOutput main(VSInput i)
+{
+	VSOutput o;
+	o.worldPos = mul(worldMatrix, float4(i.pos, 1.0f)).xyz;
+	o.pos = mul(viewMatrix, float4(o.worldPos, 1.0f));
+	o.pos = mul(projMatrix, o.pos);
+	return o;
+}
@@ -0,0 +1,284 @@
+#include "silhouette.h"
+#include "workerPool.h"
+#include <algorithm>
+#include <bit>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#define SILHOUETTE_X86_SIMD
+#include <immintrin.h>
+#define TARGET_AVX2
+#elif defined(__x86_64__) || defined(__i386__)
+#define SILHOUETTE_X86_SIMD
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Faces or edges handled by one job, small meshes are processed in a single chunk
+	constexpr size_t CHUNK_SIZE = 16384;
+
+	//Point on the light's side of the far extrusion of p
+	XMFLOAT3 Extrude(const XMFLOAT3& p, const XMFLOAT4& light, float extrusion)
+	{
+		XMVECTOR dir = light.w == 0.0f ? XMVectorSet(-light.x, -light.y, -light.z, 0.0f)
+			: XMVectorSet(p.x - light.x, p.y - light.y, p.z - light.z, 0.0f);
+		XMFLOAT3 result;
+		XMStoreFloat3(&result, XMLoadFloat3(&p) + extrusion * XMVector3Normalize(dir));
+		return result;
+	}
+
+#ifdef SILHOUETTE_X86_SIMD
+	//Facing bits of faces [begin, end) from the padded plane arrays, 8 faces per byte
+	TARGET_AVX2 void ClassifyAVX2(const float* nx, const float* ny, const float* nz, const float* nd,
+		const XMFLOAT4& light, size_t begin, size_t end, uint8_t* facing)
+	{
+		const __m256 x = _mm256_set1_ps(light.x), y = _mm256_set1_ps(light.y), z = _mm256_set1_ps(light.z);
+		const __m256 w = _mm256_set1_ps(light.w), zero = _mm256_setzero_ps();
+		for (size_t f = begin; f < end; f += 8)
+		{
+			__m256 d = _mm256_mul_ps(_mm256_loadu_ps(nx + f), x);
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(ny + f), y));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(nz + f), z));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(nd + f), w));
+			facing[f >> 3] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_cmp_ps(d, zero, _CMP_GT_OQ)));
+		}
+	}
+#endif
+}
+
+SilhouetteExtractor::SilhouetteExtractor(const MeshAdjacency& adjacency)
+	: m_faceCount(adjacency.faceCount()), m_positions(adjacency.positions), m_faces(adjacency.faces), m_edges(adjacency.edges)
+{
+	size_t padded = (m_faceCount + 7) / 8 * 8;
+	m_nx.assign(padded, 0.0f);
+	m_ny.assign(padded, 0.0f);
+	m_nz.assign(padded, 0.0f);
+	m_nd.assign(padded, 0.0f);
+	for (size_t f = 0; f < m_faceCount; ++f)
+	{
+		auto& n = adjacency.faceNormals[f];
+		auto& p = adjacency.positions[adjacency.faces[3 * f]];
+		m_nx[f] = n.x;
+		m_ny[f] = n.y;
+		m_nz[f] = n.z;
+		m_nd[f] = -(n.x * p.x + n.y * p.y + n.z * p.z);
+	}
+	m_facing.assign(padded / 8, 0);
+}
+
+size_t SilhouetteExtractor::ChunkCount(WorkerPool* workers) const
+{
+	if (!workers || workers->workerCount() == 0)
+		return 1;
+	return max<size_t>((max(m_edges.size(), m_faceCount) + CHUNK_SIZE - 1) / CHUNK_SIZE, 1);
+}
+
+void SilhouetteExtractor::ClassifyFaces(size_t begin, size_t end, gk2::SimdLevel level)
+{
+	//begin is a multiple of 8 and the planes are padded, so whole bytes are written
+	const float lx = m_light.x, ly = m_light.y, lz = m_light.z, lw = m_light.w;
+	size_t f = begin;
+#ifdef SILHOUETTE_X86_SIMD
+	if (level != gk2::SimdLevel::Scalar)
+	{
+		ClassifyAVX2(m_nx.data(), m_ny.data(), m_nz.data(), m_nd.data(), m_light, begin, end, m_facing.data());
+		return;
+	}
+#else
+	static_cast<void>(level);
+#endif
+	for (; f < end; f += 8)
+	{
+		uint8_t bits = 0;
+		for (size_t k = 0; k < 8; ++k)
+		{
+			float d = m_nx[f + k] * lx + m_ny[f + k] * ly + m_nz[f + k] * lz + m_nd[f + k] * lw;
+			bits |= static_cast<uint8_t>(d > 0.0f) << k;
+		}
+		m_facing[f >> 3] = bits;
+	}
+}
+
+void SilhouetteExtractor::CollectEdges(size_t chunk, size_t chunkCount)
+{
+	auto& out = m_chunkEdges[chunk];
+	out.clear();
+	size_t begin = m_edges.size() * chunk / chunkCount, end = m_edges.size() * (chunk + 1) / chunkCount;
+	for (size_t e = begin; e < end; ++e)
+	{
+		auto& edge = m_edges[e];
+		bool lit0 = Facing(edge.face0);
+		//open borders are silhouettes when their only face is dark, since the caps are made of dark faces
+		bool lit1 = edge.face1 == MeshAdjacency::NO_FACE || Facing(edge.face1);
+		if (lit0 != lit1)
+			out.push_back(static_cast<uint32_t>(e) | (lit0 ? 0 : FLIPPED));
+	}
+}
+
+size_t SilhouetteExtractor::Extract(const XMFLOAT4& light, WorkerPool* workers, gk2::SimdLevel level)
+{
+	m_light = light;
+	size_t chunkCount = ChunkCount(workers);
+	if (m_chunkEdges.size() < chunkCount)
+		m_chunkEdges.resize(chunkCount);
+	m_chunkOffsets.resize(chunkCount + 1);
+	m_chunkDarkOffsets.resize(chunkCount + 1);
+
+	size_t faceBlocks = m_facing.size();
+	auto classify = [this, faceBlocks, chunkCount, level](size_t chunk)
+	{
+		ClassifyFaces(faceBlocks * chunk / chunkCount * 8, faceBlocks * (chunk + 1) / chunkCount * 8, level);
+	};
+	auto collect = [this, chunkCount](size_t chunk) { CollectEdges(chunk, chunkCount); };
+	if (chunkCount == 1)
+	{
+		classify(0);
+		collect(0);
+	}
+	else
+	{
+		workers->ParallelFor(chunkCount, classify);
+		workers->ParallelFor(chunkCount, collect);
+	}
+
+	m_chunkOffsets[0] = 0;
+	m_chunkDarkOffsets[0] = 0;
+	for (size_t c = 0; c < chunkCount; ++c)
+	{
+		m_chunkOffsets[c + 1] = m_chunkOffsets[c] + m_chunkEdges[c].size();
+		//padding faces are never lit, so only real faces are missing from the bit count
+		size_t begin = faceBlocks * c / chunkCount, end = faceBlocks * (c + 1) / chunkCount;
+		size_t lit = 0;
+		for (size_t b = begin; b < end; ++b)
+			lit += popcount(m_facing[b]);
+		size_t faces = min(8 * end, m_faceCount) - min(8 * begin, m_faceCount);
+		m_chunkDarkOffsets[c + 1] = m_chunkDarkOffsets[c] + faces - lit;
+	}
+	m_silhouetteCount = m_chunkOffsets[chunkCount];
+	m_darkCount = m_chunkDarkOffsets[chunkCount];
+	return m_silhouetteCount;
+}
+
+size_t SilhouetteExtractor::WriteQuads(XMFLOAT3* out, size_t maxVertices, float extrusion, WorkerPool* workers) const
+{
+	size_t chunkCount = m_chunkOffsets.empty() ? 0 : m_chunkOffsets.size() - 1;
+	size_t edgeLimit = min(m_silhouetteCount, maxVertices / 6);
+	auto write = [this, out, edgeLimit, extrusion](size_t chunk)
+	{
+		auto* v = out + 6 * m_chunkOffsets[chunk];
+		size_t count = min(m_chunkEdges[chunk].size(), edgeLimit - min(edgeLimit, m_chunkOffsets[chunk]));
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto e = m_chunkEdges[chunk][i];
+			auto& edge = m_edges[e & ~FLIPPED];
+			//from -> to follows the winding of the lit face
+			auto& from = m_positions[e & FLIPPED ? edge.v1 : edge.v0];
+			auto& to = m_positions[e & FLIPPED ? edge.v0 : edge.v1];
+			auto farFrom = Extrude(from, m_light, extrusion), farTo = Extrude(to, m_light, extrusion);
+			v[0] = from; v[1] = farTo; v[2] = farFrom;
+			v[3] = from; v[4] = to; v[5] = farTo;
+			v += 6;
+		}
+	};
+	if (chunkCount > 1 && workers && workers->workerCount() > 0)
+		workers->ParallelFor(chunkCount, write);
+	else
+		for (size_t c = 0; c < chunkCount; ++c)
+			write(c);
+	return 6 * edgeLimit;
+}
+
+size_t SilhouetteExtractor::WriteCaps(XMFLOAT3* out, size_t maxVertices, float extrusion, WorkerPool* workers) const
+{
+	size_t chunkCount = m_chunkDarkOffsets.empty() ? 0 : m_chunkDarkOffsets.size() - 1;
+	size_t faceLimit = min(m_darkCount, maxVertices / 6);
+	size_t faceBlocks = m_facing.size();
+	auto write = [this, out, faceLimit, extrusion, faceBlocks, chunkCount](size_t chunk)
+	{
+		if (m_chunkDarkOffsets[chunk] >= faceLimit)
+			return;
+		auto* v = out + 6 * m_chunkDarkOffsets[chunk];
+		auto* last = out + 6 * faceLimit;
+		size_t end = min(faceBlocks * (chunk + 1) / chunkCount * 8, m_faceCount);
+		for (size_t f = faceBlocks * chunk / chunkCount * 8; f < end && v < last; ++f)
+		{
+			if (Facing(static_cast<uint32_t>(f)))
+				continue;
+			auto& a = m_positions[m_faces[3 * f]];
+			auto& b = m_positions[m_faces[3 * f + 1]];
+			auto& c = m_positions[m_faces[3 * f + 2]];
+			//the far cap is wound the other way to face out of the volume as well
+			v[0] = a; v[1] = b; v[2] = c;
+			v[3] = Extrude(a, m_light, extrusion);
+			v[4] = Extrude(c, m_light, extrusion);
+			v[5] = Extrude(b, m_light, extrusion);
+			v += 6;
+		}
+	};
+	if (chunkCount > 1 && workers && workers->workerCount() > 0)
+		workers->ParallelFor(chunkCount, write);
+	else
+		for (size_t c = 0; c < chunkCount; ++c)
+			write(c);
+	return 6 * faceLimit;
+}
+
+ShadowVolume::ShadowVolume(const DxDevice& device, const MeshAdjacency& adjacency, unsigned int maxSilhouetteEdges)
+	: m_extractor(adjacency)
+{
+	if (maxSilhouetteEdges == 0)
+		maxSilhouetteEdges = static_cast<unsigned int>(m_extractor.edgeCount());
+	if (maxSilhouetteEdges > 0)
+		m_vertices = DynamicVertexRing<XMFLOAT3>(device, 6 * (maxSilhouetteEdges + static_cast<unsigned int>(m_extractor.faceCount())));
+}
+
+void ShadowVolume::Update(const dx_ptr<ID3D11DeviceContext>& context, const XMFLOAT4& lightPosition,
+	const XMFLOAT4X4& world, WorkerPool* workers, float extrusion)
+{
+	if (m_extractor.empty())
+		return;
+	XMVECTOR det;
+	auto inv = XMMatrixInverse(&det, XMLoadFloat4x4(&world));
+	XMFLOAT4 light;
+	XMStoreFloat4(&light, XMVector4Transform(XMLoadFloat4(&lightPosition), inv));
+	auto edges = m_extractor.Extract(light, workers);
+	auto count = static_cast<unsigned int>(min<size_t>(6 * (edges + m_extractor.darkFaceCount()), m_vertices.capacity()));
+	auto verts = m_vertices.Map(context, count);
+	auto written = m_extractor.WriteQuads(verts, count, extrusion, workers);
+	written += m_extractor.WriteCaps(verts + written, count - written, extrusion, workers);
+	m_vertices.Unmap(context, static_cast<unsigned int>(written));
+}
+
+void ShadowVolume::Draw(const dx_ptr<ID3D11DeviceContext>& context) const
+{
+	if (m_vertices.vertexCount() == 0)
+		return;
+	m_vertices.Bind(context);
+	m_vertices.Draw(context);
+}
+
+GpuShadowVolume::GpuShadowVolume(const DxDevice& device, const MeshAdjacency& adjacency)
+{
+	if (adjacency.faceCount() == 0)
+		return;
+	auto indices = BuildAdjacencyIndices(adjacency);
+	m_vertexBuffer = device.CreateVertexBuffer(adjacency.positions);
+	m_indexBuffer = device.CreateIndexBuffer(indices);
+	m_indexCount = static_cast<unsigned int>(indices.size());
+}
+
+void GpuShadowVolume::Draw(const dx_ptr<ID3D11DeviceContext>& context) const
+{
+	if (m_indexCount == 0)
+		return;
+	auto b = m_vertexBuffer.get();
+	unsigned int stride = sizeof(XMFLOAT3), offset = 0;
+	context->IASetVertexBuffers(0, 1, &b, &stride, &offset);
+	context->IASetIndexBuffer(m_indexBuffer.get(), DXGI_FORMAT_R32_UINT, 0);
+	context->DrawIndexed(m_indexCount, 0, 0);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+#include "meshAdjacency.h"
+#include "dynamicBuffer.h"
+#include "particleIntegrator.h"
+
+namespace mini
+{
+	class WorkerPool;
+
+	//Silhouette of a mesh as seen from a light. Face planes are kept as structure of arrays
+	//and classified against the light in one SIMD pass, silhouette edges are then gathered
+	//from the face bits. Both passes can be split into chunks run on a WorkerPool.
+	class SilhouetteExtractor
+	{
+	public:
+		SilhouetteExtractor() = default;
+		explicit SilhouetteExtractor(const MeshAdjacency& adjacency);
+
+		//Finds the silhouette for a light in model space (w = 1 point light, w = 0 directional
+		//light shining along -xyz). Returns the number of silhouette edges.
+		size_t Extract(const DirectX::XMFLOAT4& light, WorkerPool* workers = nullptr,
+			gk2::SimdLevel level = gk2::DetectSimdLevel());
+
+		//Writes the shadow volume sides of the last extracted silhouette as a triangle list,
+		//6 vertices per edge, extruded away from the light by extrusion units.
+		//Writes at most maxVertices, returns the number of vertices written.
+		size_t WriteQuads(DirectX::XMFLOAT3* out, size_t maxVertices, float extrusion, WorkerPool* workers = nullptr) const;
+		//Writes the caps for z-fail stencil shadows, 6 vertices per face facing away from the light:
+		//the face itself and its extrusion. Together with WriteQuads they close the volume.
+		size_t WriteCaps(DirectX::XMFLOAT3* out, size_t maxVertices, float extrusion, WorkerPool* workers = nullptr) const;
+
+		size_t edgeCount() const { return m_edges.size(); }
+		size_t faceCount() const { return m_faceCount; }
+		size_t silhouetteEdgeCount() const { return m_silhouetteCount; }
+		size_t darkFaceCount() const { return m_darkCount; }
+		//Whether the face is lit by the light of the last Extract
+		bool faceLit(uint32_t face) const { return Facing(face); }
+		bool empty() const { return m_edges.empty(); }
+
+	private:
+		static constexpr uint32_t FLIPPED = 0x80000000u;	//edge winds to -> from in the lit face
+
+		size_t ChunkCount(WorkerPool* workers) const;
+		void ClassifyFaces(size_t begin, size_t end, gk2::SimdLevel level);
+		void CollectEdges(size_t chunk, size_t chunkCount);
+		bool Facing(uint32_t face) const { return (m_facing[face >> 3] >> (face & 7)) & 1; }
+
+		//face planes, padded to a multiple of 8 faces with zeros
+		std::vector<float> m_nx, m_ny, m_nz, m_nd;
+		size_t m_faceCount = 0;
+		std::vector<DirectX::XMFLOAT3> m_positions;
+		std::vector<unsigned int> m_faces;
+		std::vector<AdjacencyEdge> m_edges;
+
+		DirectX::XMFLOAT4 m_light = { 0.0f, 0.0f, 0.0f, 1.0f };
+		std::vector<uint8_t> m_facing;	//one bit per face
+		//silhouette edges of every chunk, edge index | FLIPPED
+		std::vector<std::vector<uint32_t>> m_chunkEdges;
+		std::vector<size_t> m_chunkOffsets;
+		//dark faces before the faces of every chunk
+		std::vector<size_t> m_chunkDarkOffsets;
+		size_t m_silhouetteCount = 0;
+		size_t m_darkCount = 0;
+	};
+
+	//Closed shadow volume of a mesh rebuilt on the CPU every frame into a dynamic vertex ring,
+	//so no GPU resources are created after construction
+	class ShadowVolume
+	{
+	public:
+		ShadowVolume() = default;
+		//maxSilhouetteEdges limits the buffer size, 0 reserves room for every edge
+		ShadowVolume(const DxDevice& device, const MeshAdjacency& adjacency, unsigned int maxSilhouetteEdges = 0);
+
+		//Light position in world space, world transforms the mesh into world space.
+		//extrusion is in model space units.
+		void Update(const dx_ptr<ID3D11DeviceContext>& context, const DirectX::XMFLOAT4& lightPosition,
+			const DirectX::XMFLOAT4X4& world, WorkerPool* workers = nullptr, float extrusion = 10.0f);
+		//Draws the sides and caps as model space positions, with a triangle list pipeline state bound
+		void Draw(const dx_ptr<ID3D11DeviceContext>& context) const;
+
+		size_t silhouetteEdgeCount() const { return m_extractor.silhouetteEdgeCount(); }
+
+	private:
+		SilhouetteExtractor m_extractor;
+		DynamicVertexRing<DirectX::XMFLOAT3> m_vertices;
+	};
+
+	//Shadow volume extruded on the GPU. The welded positions and an adjacency index list are
+	//uploaded once, shadowVolumeGS.hlsl finds the silhouette and emits the same sides and caps
+	//as ShadowVolume, so nothing is rebuilt when the light or the mesh moves.
+	class GpuShadowVolume
+	{
+	public:
+		GpuShadowVolume() = default;
+		GpuShadowVolume(const DxDevice& device, const MeshAdjacency& adjacency);
+
+		//Draws the faces as model space positions, with a D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ
+		//pipeline state bound
+		void Draw(const dx_ptr<ID3D11DeviceContext>& context) const;
+
+		bool empty() const { return m_indexCount == 0; }
+
+	private:
+		dx_ptr<ID3D11Buffer> m_vertexBuffer;
+		dx_ptr<ID3D11Buffer> m_indexBuffer;
+		unsigned int m_indexCount = 0;
+	};
+}
@@ -0,0 +1,148 @@
+#include "splashSystem.h"
+#include <algorithm>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+SplashSystem::SplashSystem(unsigned int gridSize, float waterLevel)
+	: m_gridSize(gridSize), m_tiles((gridSize + TILE_SIZE - 1) / TILE_SIZE), m_waterLevel(waterLevel),
+	m_state(m_tiles * m_tiles), m_impacts(MAX_IMPACTS)
+{
+	m_active.reserve(m_state.size());
+	m_spawns.reserve(MAX_SPAWNS);
+}
+
+void SplashSystem::Activate(unsigned int tile)
+{
+	auto& s = m_state[tile];
+	s.activeFrames = ACTIVE_FRAMES;
+	if (!s.listed)
+	{
+		s.listed = true;
+		m_active.push_back(tile);
+	}
+}
+
+void SplashSystem::Disturb(unsigned int i, unsigned int j)
+{
+	if (i >= m_gridSize || j >= m_gridSize)
+		return;
+	Activate((i / TILE_SIZE) * m_tiles + j / TILE_SIZE);
+}
+
+void SplashSystem::Disturb(XMFLOAT3 worldPos)
+{
+	unsigned int i, j;
+	if (WorldToCell(worldPos, i, j))
+		Disturb(i, j);
+}
+
+XMFLOAT3 SplashSystem::CellToWorld(unsigned int i, unsigned int j) const
+{
+	float step = 2.0f / (m_gridSize - 1);
+	return { -1.0f + j * step, m_waterLevel, -1.0f + i * step };
+}
+
+bool SplashSystem::WorldToCell(XMFLOAT3 pos, unsigned int& i, unsigned int& j) const
+{
+	float fi = (pos.z + 1.0f) * 0.5f * (m_gridSize - 1);
+	float fj = (pos.x + 1.0f) * 0.5f * (m_gridSize - 1);
+	if (fi < 0.0f || fj < 0.0f || fi > m_gridSize - 1 || fj > m_gridSize - 1)
+		return false;
+	i = static_cast<unsigned int>(fi + 0.5f);
+	j = static_cast<unsigned int>(fj + 0.5f);
+	return true;
+}
+
+bool SplashSystem::ScanTile(unsigned int tile, const HeightField& height, const HeightField& previous)
+{
+	unsigned int ti = tile / m_tiles, tj = tile % m_tiles;
+	unsigned int iEnd = min(m_gridSize, (ti + 1) * TILE_SIZE), jEnd = min(m_gridSize, (tj + 1) * TILE_SIZE);
+	//pick the highest crest of the tile
+	float best = CREST_HEIGHT;
+	unsigned int bi = 0, bj = 0;
+	bool found = false;
+	for (unsigned int i = ti * TILE_SIZE; i < iEnd; ++i)
+		for (unsigned int j = tj * TILE_SIZE; j < jEnd; ++j)
+		{
+			float h = height[i][j];
+			if (h > best && h - previous[i][j] > CREST_VELOCITY)
+			{
+				best = h;
+				bi = i; bj = j;
+				found = true;
+			}
+		}
+	m_scanned += (iEnd - ti * TILE_SIZE) * (jEnd - tj * TILE_SIZE);
+	if (!found)
+		return false;
+
+	m_spawns.push_back(CellToWorld(bi, bj));
+	//the wave is moving on, keep the neighbourhood awake
+	for (int di = -1; di <= 1; ++di)
+		for (int dj = -1; dj <= 1; ++dj)
+		{
+			int ni = static_cast<int>(ti) + di, nj = static_cast<int>(tj) + dj;
+			if (ni >= 0 && nj >= 0 && ni < static_cast<int>(m_tiles) && nj < static_cast<int>(m_tiles))
+				Activate(ni * m_tiles + nj);
+		}
+	return true;
+}
+
+void SplashSystem::Update(const HeightField& height, const HeightField& previous, ParticleSystem& particles)
+{
+	Update(height, previous);
+	Emit(particles);
+}
+
+void SplashSystem::Update(const HeightField& height, const HeightField& previous)
+{
+	m_scanned = 0;
+	m_spawned = 0;
+	m_spawns.clear();
+	for (auto& s : m_state)
+		if (s.cooldown)
+			--s.cooldown;
+
+	//round-robin over the active list, every tile is visited at most once per frame
+	size_t visits = m_active.size();
+	while (visits-- > 0 && m_scanned + TILE_SIZE * TILE_SIZE <= MAX_SCAN_CELLS)
+	{
+		if (m_cursor >= m_active.size())
+			m_cursor = 0;
+		auto tile = m_active[m_cursor];
+		auto& s = m_state[tile];
+		if (s.activeFrames == 0)
+		{
+			//swap-remove, the swapped in tile is visited next
+			s.listed = false;
+			m_active[m_cursor] = m_active.back();
+			m_active.pop_back();
+			continue;
+		}
+		--s.activeFrames;
+		++m_cursor;
+		if (s.cooldown || m_spawned >= MAX_SPAWNS)
+			continue;
+		if (ScanTile(tile, height, previous))
+		{
+			s.cooldown = SPAWN_COOLDOWN;
+			++m_spawned;
+		}
+	}
+}
+
+void SplashSystem::ApplyImpacts(ParticleSystem& particles, HeightField& height)
+{
+	m_impactCount = static_cast<unsigned int>(particles.RemoveBelow(m_waterLevel, m_impacts.data(), m_impacts.size()));
+	for (unsigned int k = 0; k < m_impactCount; ++k)
+	{
+		unsigned int i, j;
+		if (!WorldToCell(m_impacts[k], i, j))
+			continue;
+		height[i][j] = IMPACT_HEIGHT;
+		Disturb(i, j);
+	}
+}
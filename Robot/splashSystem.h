@@ -0,0 +1,90 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "particleSystem.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		using HeightField = std::vector<std::vector<float>>;
+
+		//Couples the water height field with a particle system. Only tiles recently
+		//disturbed (by the duck, drops or waves coming from neighbouring tiles) are
+		//scanned for crests, the work done per frame is bounded by MAX_SCAN_CELLS
+		//and MAX_SPAWNS. Particles falling back into the water disturb its surface.
+		class SplashSystem
+		{
+		public:
+			static constexpr unsigned int TILE_SIZE = 16;			//tile side in grid cells
+			static constexpr unsigned int MAX_SCAN_CELLS = 4096;	//cells checked per frame
+			static constexpr unsigned int MAX_SPAWNS = 8;			//splashes spawned per frame
+			static constexpr unsigned int MAX_IMPACTS = 64;			//drops applied to the water per frame
+			static constexpr unsigned int SPLASH_PARTICLES = 12;	//particles in a single splash
+			static constexpr unsigned int ACTIVE_FRAMES = 120;		//frames a tile is scanned after a disturbance
+			static constexpr unsigned int SPAWN_COOLDOWN = 20;		//frames between splashes from the same tile
+			static constexpr float CREST_HEIGHT = 0.05f;			//minimal height of a crest
+			static constexpr float CREST_VELOCITY = 0.01f;			//minimal rise of a crest in one step
+			static constexpr float IMPACT_HEIGHT = -0.02f;			//height set where a drop hits the water
+
+			SplashSystem() = default;
+			//Grid of gridSize x gridSize cells covering [-1,1] x [-1,1] in world XZ
+			//plane at height waterLevel. Cell [i][j] lies at x = -1 + 2j/(gridSize-1),
+			//z = -1 + 2i/(gridSize-1).
+			SplashSystem(unsigned int gridSize, float waterLevel);
+
+			//Marks the tile containing cell [i][j] for scanning
+			void Disturb(unsigned int i, unsigned int j);
+			void Disturb(DirectX::XMFLOAT3 worldPos);
+
+			//Scans active tiles for crests rising above the thresholds, positions
+			//of the splashes found are kept until the next call
+			void Update(const HeightField& height, const HeightField& previous);
+			//Scans for crests and spawns the splashes in particles
+			void Update(const HeightField& height, const HeightField& previous, ParticleSystem& particles);
+			//Spawns the splashes found by the last Update in any system providing AddBurst
+			template<class Particles>
+			void Emit(Particles& particles) const
+			{
+				for (auto& pos : m_spawns)
+					particles.AddBurst(pos, DirectX::XMMatrixRotationX(DirectX::XM_PIDIV2), SPLASH_PARTICLES);
+			}
+			//Removes particles that fell below the water level and disturbs the height field where they hit
+			void ApplyImpacts(ParticleSystem& particles, HeightField& height);
+
+			DirectX::XMFLOAT3 CellToWorld(unsigned int i, unsigned int j) const;
+			bool WorldToCell(DirectX::XMFLOAT3 pos, unsigned int& i, unsigned int& j) const;
+
+			size_t activeTiles() const { return m_active.size(); }
+			//Statistics of the last Update/ApplyImpacts calls
+			unsigned int scannedCells() const { return m_scanned; }
+			unsigned int spawnedSplashes() const { return m_spawned; }
+			unsigned int appliedImpacts() const { return m_impactCount; }
+
+		private:
+			struct TileState
+			{
+				uint16_t activeFrames = 0;
+				uint16_t cooldown = 0;
+				bool listed = false;
+			};
+
+			void Activate(unsigned int tile);
+			bool ScanTile(unsigned int tile, const HeightField& height, const HeightField& previous);
+
+			unsigned int m_gridSize = 0;
+			unsigned int m_tiles = 0;		//tiles along one side of the grid
+			float m_waterLevel = 0.0f;
+			std::vector<TileState> m_state;
+			std::vector<uint32_t> m_active;
+			size_t m_cursor = 0;			//next entry of m_active to scan
+			std::vector<DirectX::XMFLOAT3> m_impacts;
+			std::vector<DirectX::XMFLOAT3> m_spawns;
+
+			unsigned int m_scanned = 0;
+			unsigned int m_spawned = 0;
+			unsigned int m_impactCount = 0;
+		};
+	}
+}
@@ -0,0 +1,180 @@
+#include "stateCache.h"
+#include "exceptions.h"
+#include <cstring>
+
+using namespace std;
+using namespace mini;
+
+StateCache::StateCache(ID3D11DeviceContext* context, ID3D11DeviceContext1* context1)
+	: m_context(context), m_context1(context1)
+{ }
+
+bool StateCache::Changed(ConstantBufferSlots& bound, UINT& startSlot, UINT& count, ID3D11Buffer* const*& buffers,
+	const UINT*& firstConstant, const UINT*& constantCount)
+{
+	UINT skipped = 0;
+	auto binding = [=](UINT i)
+	{
+		return ConstantBufferBinding{ buffers[i], firstConstant ? firstConstant[i] : 0, constantCount ? constantCount[i] : 0 };
+	};
+	if (!Changed(bound, startSlot, count, skipped, binding, ConstantBuffers))
+		return false;
+	buffers += skipped;
+	if (firstConstant)
+		firstConstant += skipped;
+	if (constantCount)
+		constantCount += skipped;
+	return true;
+}
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader)
+{
+	if (!Same(m_vs, shader, VertexShader))
+		m_context->VSSetShader(shader, nullptr, 0);
+}
+
+void StateCache::GSSetShader(ID3D11GeometryShader* shader)
+{
+	if (!Same(m_gs, shader, GeometryShader))
+		m_context->GSSetShader(shader, nullptr, 0);
+}
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader)
+{
+	if (!Same(m_ps, shader, PixelShader))
+		m_context->PSSetShader(shader, nullptr, 0);
+}
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	if (!Same(m_inputLayout, layout, InputLayout))
+		m_context->IASetInputLayout(layout);
+}
+
+void StateCache::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (!Same(m_topology, topology, Topology))
+		m_context->IASetPrimitiveTopology(topology);
+}
+
+void StateCache::PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+	if (Changed(m_psResources, startSlot, count, views, ShaderResources))
+		m_context->PSSetShaderResources(startSlot, count, views);
+}
+
+void StateCache::PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+{
+	if (Changed(m_psSamplers, startSlot, count, samplers, Samplers))
+		m_context->PSSetSamplers(startSlot, count, samplers);
+}
+
+void StateCache::VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	const UINT* none = nullptr;
+	if (Changed(m_vsConstantBuffers, startSlot, count, buffers, none, none))
+		m_context->VSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void StateCache::GSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	const UINT* none = nullptr;
+	if (Changed(m_gsConstantBuffers, startSlot, count, buffers, none, none))
+		m_context->GSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void StateCache::PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	const UINT* none = nullptr;
+	if (Changed(m_psConstantBuffers, startSlot, count, buffers, none, none))
+		m_context->PSSetConstantBuffers(startSlot, count, buffers);
+}
+
+void StateCache::VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount)
+{
+	if (Changed(m_vsConstantBuffers, startSlot, count, buffers, firstConstant, constantCount))
+		m_context1->VSSetConstantBuffers1(startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void StateCache::GSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount)
+{
+	if (Changed(m_gsConstantBuffers, startSlot, count, buffers, firstConstant, constantCount))
+		m_context1->GSSetConstantBuffers1(startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void StateCache::PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount)
+{
+	if (Changed(m_psConstantBuffers, startSlot, count, buffers, firstConstant, constantCount))
+		m_context1->PSSetConstantBuffers1(startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void StateCache::OMSetBlendState(ID3D11BlendState* state, const FLOAT* blendFactor, UINT sampleMask)
+{
+	if (blendFactor)
+	{
+		m_blendState.reset();
+		++m_counters.issued[BlendState];
+	}
+	else if (Same(m_blendState, make_pair(state, sampleMask), BlendState))
+		return;
+	m_context->OMSetBlendState(state, blendFactor, sampleMask);
+}
+
+void StateCache::OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+{
+	if (!Same(m_depthStencilState, make_pair(state, stencilRef), DepthStencilState))
+		m_context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void StateCache::RSSetState(ID3D11RasterizerState* state)
+{
+	if (!Same(m_rasterizerState, state, RasterizerState))
+		m_context->RSSetState(state);
+}
+
+void StateCache::UpdateBuffer(ID3D11Buffer* buffer, const void* data, size_t size)
+{
+	auto& contents = m_buffers[buffer];
+	if (contents.size() == size && memcmp(contents.data(), data, size) == 0)
+	{
+		++m_counters.elided[BufferUpdate];
+		return;
+	}
+	D3D11_MAPPED_SUBRESOURCE res;
+	auto hr = m_context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &res);
+	if (FAILED(hr))
+	{
+		m_buffers.erase(buffer);
+		THROW_DX(hr);
+	}
+	memcpy(res.pData, data, size);
+	m_context->Unmap(buffer, 0);
+	++m_counters.issued[BufferUpdate];
+
+	auto bytes = static_cast<const BYTE*>(data);
+	contents.assign(bytes, bytes + size);
+}
+
+void StateCache::Invalidate()
+{
+	m_vs.reset();
+	m_gs.reset();
+	m_ps.reset();
+	m_inputLayout.reset();
+	m_topology.reset();
+	for (auto& s : m_psResources)
+		s.reset();
+	for (auto& s : m_psSamplers)
+		s.reset();
+	for (auto* slots : { &m_vsConstantBuffers, &m_gsConstantBuffers, &m_psConstantBuffers })
+		for (auto& s : *slots)
+			s.reset();
+	m_blendState.reset();
+	m_depthStencilState.reset();
+	m_rasterizerState.reset();
+}
+
+void StateCache::Forget(ID3D11Buffer* buffer)
+{
+	m_buffers.erase(buffer);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <d3d11_1.h>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "dxptr.h"
+
+namespace mini
+{
+	//Remembers what is bound to the device context and drops calls that would bind the same
+	//thing again, together with constant buffer updates that don't change the contents.
+	//Everything it tracks has to be bound through it, or Invalidate() called afterwards.
+	class StateCache
+	{
+	public:
+		enum Call
+		{
+			VertexShader, GeometryShader, PixelShader, InputLayout, Topology, ShaderResources, Samplers,
+			ConstantBuffers, BlendState, DepthStencilState, RasterizerState, BufferUpdate, CallCount
+		};
+
+		//Calls made on the context and calls dropped, per kind of call
+		struct Counters
+		{
+			unsigned int issued[CallCount];
+			unsigned int elided[CallCount];
+		};
+
+		StateCache() = default;
+		//context1 is only needed for the *SetConstantBuffers1 calls
+		explicit StateCache(ID3D11DeviceContext* context, ID3D11DeviceContext1* context1 = nullptr);
+
+		void VSSetShader(ID3D11VertexShader* shader);
+		void GSSetShader(ID3D11GeometryShader* shader);
+		void PSSetShader(ID3D11PixelShader* shader);
+		void IASetInputLayout(ID3D11InputLayout* layout);
+		void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+		void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views);
+		void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers);
+		void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+		void GSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+		void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers);
+		void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount);
+		void GSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount);
+		void PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* constantCount);
+		//States set with a blend factor are never compared
+		void OMSetBlendState(ID3D11BlendState* state, const FLOAT* blendFactor = nullptr, UINT sampleMask = 0xffffffff);
+		void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef = 0);
+		void RSSetState(ID3D11RasterizerState* state);
+
+		//Map(WRITE_DISCARD) and copy, unless the buffer already holds exactly these bytes.
+		//Contents are keyed by the buffer's address without a reference, the owner calls Forget
+		//before releasing the buffer, so a new buffer at the same address starts from scratch.
+		void UpdateBuffer(ID3D11Buffer* buffer, const void* data, size_t size);
+
+		//Forgets all bindings, e.g. after code that used the context directly
+		void Invalidate();
+		//Forgets the contents of a buffer written without UpdateBuffer or about to be released
+		void Forget(ID3D11Buffer* buffer);
+
+		ID3D11DeviceContext* context() const { return m_context; }
+		ID3D11DeviceContext1* context1() const { return m_context1; }
+		const Counters& counters() const { return m_counters; }
+		void ResetCounters() { m_counters = {}; }
+
+	private:
+		template<typename T, size_t N>
+		using Slots = std::optional<T*>[N];
+		//whole buffers are bound with zero constants
+		struct ConstantBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			UINT firstConstant, constantCount;
+			bool operator==(const ConstantBufferBinding&) const = default;
+		};
+		using ConstantBufferSlots = std::optional<ConstantBufferBinding>[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+
+		//Returns true when it's the same as the bound value, otherwise remembers the new one
+		template<typename T>
+		bool Same(std::optional<T>& bound, const T& value, Call call)
+		{
+			if (bound == value)
+			{
+				++m_counters.elided[call];
+				return true;
+			}
+			bound = value;
+			++m_counters.issued[call];
+			return false;
+		}
+
+		//Narrows [startSlot, startSlot + count) to the slots that change and remembers them,
+		//skipped is set to the number of values dropped from the front. Returns false when nothing changes.
+		template<typename T, size_t N, typename Value>
+		bool Changed(std::optional<T>(&bound)[N], UINT& startSlot, UINT& count, UINT& skipped, Value value, Call call)
+		{
+			UINT first = 0, last = count;
+			while (first < last && bound[startSlot + first] == value(first))
+				++first;
+			while (last > first && bound[startSlot + last - 1] == value(last - 1))
+				--last;
+			if (first == last)
+			{
+				++m_counters.elided[call];
+				return false;
+			}
+			for (UINT i = first; i < last; ++i)
+				bound[startSlot + i] = value(i);
+			startSlot += first;
+			skipped = first;
+			count = last - first;
+			++m_counters.issued[call];
+			return true;
+		}
+
+		//Changed for slots bound to whole resources
+		template<typename T, size_t N>
+		bool Changed(Slots<T, N>& bound, UINT& startSlot, UINT& count, T* const*& values, Call call)
+		{
+			UINT skipped = 0;
+			if (!Changed(bound, startSlot, count, skipped, [values](UINT i) { return values[i]; }, call))
+				return false;
+			values += skipped;
+			return true;
+		}
+
+		bool Changed(ConstantBufferSlots& bound, UINT& startSlot, UINT& count, ID3D11Buffer* const*& buffers,
+			const UINT*& firstConstant, const UINT*& constantCount);
+
+		ID3D11DeviceContext* m_context = nullptr;
+		ID3D11DeviceContext1* m_context1 = nullptr;
+		Counters m_counters = {};
+
+		std::optional<ID3D11VertexShader*> m_vs;
+		std::optional<ID3D11GeometryShader*> m_gs;
+		std::optional<ID3D11PixelShader*> m_ps;
+		std::optional<ID3D11InputLayout*> m_inputLayout;
+		std::optional<D3D11_PRIMITIVE_TOPOLOGY> m_topology;
+		Slots<ID3D11ShaderResourceView, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> m_psResources;
+		Slots<ID3D11SamplerState, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT> m_psSamplers;
+		ConstantBufferSlots m_vsConstantBuffers;
+		ConstantBufferSlots m_gsConstantBuffers;
+		ConstantBufferSlots m_psConstantBuffers;
+		std::optional<std::pair<ID3D11BlendState*, UINT>> m_blendState;
+		std::optional<std::pair<ID3D11DepthStencilState*, UINT>> m_depthStencilState;
+		std::optional<ID3D11RasterizerState*> m_rasterizerState;
+		std::unordered_map<ID3D11Buffer*, std::vector<BYTE>> m_buffers;
+	};
+}
@@ -0,0 +1,167 @@
+#include "vertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	float SignNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+	uint16_t ToUNorm16(float v)
+	{
+		return static_cast<uint16_t>(lround(min(max(v, 0.0f), 1.0f) * 65535.0f));
+	}
+
+	int16_t ToSNorm16(float v)
+	{
+		return static_cast<int16_t>(lround(min(max(v, -1.0f), 1.0f) * 32767.0f));
+	}
+
+	//Same conversions the input assembler does for *_UNORM and *_SNORM formats
+	float FromUNorm16(uint16_t v) { return v / 65535.0f; }
+	float FromSNorm16(int16_t v) { return max(v / 32767.0f, -1.0f); }
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		float x = a.x - b.x, y = a.y - b.y, z = a.z - b.z;
+		return sqrt(x * x + y * y + z * z);
+	}
+
+	float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		float la = sqrt(a.x * a.x + a.y * a.y + a.z * a.z), lb = sqrt(b.x * b.x + b.y * b.y + b.z * b.z);
+		if (la == 0.0f || lb == 0.0f)
+			return 0.0f;
+		float c = (a.x * b.x + a.y * b.y + a.z * b.z) / (la * lb);
+		return XMConvertToDegrees(acos(min(max(c, -1.0f), 1.0f)));
+	}
+}
+
+XMFLOAT2 mini::OctahedralEncode(const XMFLOAT3& n)
+{
+	float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+	if (l1 == 0.0f)
+		return { 0.0f, 0.0f };
+	float x = n.x / l1, y = n.y / l1;
+	//the lower hemisphere is folded over the diagonals
+	if (n.z < 0.0f)
+		return { (1.0f - fabs(y)) * SignNotZero(x), (1.0f - fabs(x)) * SignNotZero(y) };
+	return { x, y };
+}
+
+XMFLOAT3 mini::OctahedralDecode(const XMFLOAT2& e)
+{
+	//matches DecodeNormal in kaczorQuantizedVS.hlsl
+	XMFLOAT3 n = { e.x, e.y, 1.0f - fabs(e.x) - fabs(e.y) };
+	float t = max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	float l = sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+	return { n.x / l, n.y / l, n.z / l };
+}
+
+float mini::BoundingDiagonal(const vector<VertexPositionNormalTex>& verts)
+{
+	if (verts.empty())
+		return 0.0f;
+	XMFLOAT3 lo = verts[0].position, hi = verts[0].position;
+	for (auto& v : verts)
+	{
+		lo = { min(lo.x, v.position.x), min(lo.y, v.position.y), min(lo.z, v.position.z) };
+		hi = { max(hi.x, v.position.x), max(hi.y, v.position.y), max(hi.z, v.position.z) };
+	}
+	return Distance(lo, hi);
+}
+
+QuantizedVertices mini::QuantizeVertices(const vector<VertexPositionNormalTex>& verts)
+{
+	QuantizedVertices result;
+	XMFLOAT3 lo = { FLT_MAX, FLT_MAX, FLT_MAX }, hi = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (auto& v : verts)
+	{
+		lo = { min(lo.x, v.position.x), min(lo.y, v.position.y), min(lo.z, v.position.z) };
+		hi = { max(hi.x, v.position.x), max(hi.y, v.position.y), max(hi.z, v.position.z) };
+	}
+	if (verts.empty())
+		lo = hi = { 0.0f, 0.0f, 0.0f };
+	//flat meshes still need a non-zero scale
+	auto extent = [](float l, float h) { return h > l ? h - l : 1.0f; };
+	result.dequantization.offset = { lo.x, lo.y, lo.z, 0.0f };
+	result.dequantization.scale = { extent(lo.x, hi.x), extent(lo.y, hi.y), extent(lo.z, hi.z), 0.0f };
+	auto& offset = result.dequantization.offset;
+	auto& scale = result.dequantization.scale;
+
+	result.vertices.resize(verts.size());
+	for (size_t i = 0; i < verts.size(); ++i)
+	{
+		auto& src = verts[i];
+		auto& dst = result.vertices[i];
+		dst.position.x = ToUNorm16((src.position.x - offset.x) / scale.x);
+		dst.position.y = ToUNorm16((src.position.y - offset.y) / scale.y);
+		dst.position.z = ToUNorm16((src.position.z - offset.z) / scale.z);
+		dst.position.w = 0;
+		auto e = OctahedralEncode(src.normal);
+		dst.normal.x = ToSNorm16(e.x);
+		dst.normal.y = ToSNorm16(e.y);
+		dst.tex.x = XMConvertFloatToHalf(src.tex.x);
+		dst.tex.y = XMConvertFloatToHalf(src.tex.y);
+	}
+	return result;
+}
+
+vector<VertexPositionNormalTex> mini::DequantizeVertices(const QuantizedVertices& quantized)
+{
+	auto& offset = quantized.dequantization.offset;
+	auto& scale = quantized.dequantization.scale;
+	vector<VertexPositionNormalTex> result(quantized.vertices.size());
+	for (size_t i = 0; i < result.size(); ++i)
+	{
+		auto& src = quantized.vertices[i];
+		auto& dst = result[i];
+		dst.position = { offset.x + FromUNorm16(src.position.x) * scale.x,
+			offset.y + FromUNorm16(src.position.y) * scale.y,
+			offset.z + FromUNorm16(src.position.z) * scale.z };
+		dst.normal = OctahedralDecode({ FromSNorm16(src.normal.x), FromSNorm16(src.normal.y) });
+		dst.tex = { XMConvertHalfToFloat(src.tex.x), XMConvertHalfToFloat(src.tex.y) };
+	}
+	return result;
+}
+
+QuantizationError mini::MeasureQuantizationError(const vector<VertexPositionNormalTex>& original,
+	const QuantizedVertices& quantized)
+{
+	QuantizationError error = {};
+	auto decoded = DequantizeVertices(quantized);
+	double position = 0.0, normal = 0.0, tex = 0.0;
+	for (size_t i = 0; i < original.size(); ++i)
+	{
+		float dp = Distance(original[i].position, decoded[i].position);
+		float dn = AngleDegrees(original[i].normal, decoded[i].normal);
+		float dt = max(fabs(original[i].tex.x - decoded[i].tex.x), fabs(original[i].tex.y - decoded[i].tex.y));
+		error.maxPosition = max(error.maxPosition, dp);
+		error.maxNormalDegrees = max(error.maxNormalDegrees, dn);
+		error.maxTex = max(error.maxTex, dt);
+		position += dp * dp;
+		normal += dn * dn;
+		tex += dt * dt;
+	}
+	if (!original.empty())
+	{
+		error.rmsPosition = static_cast<float>(sqrt(position / original.size()));
+		error.rmsNormalDegrees = static_cast<float>(sqrt(normal / original.size()));
+		error.rmsTex = static_cast<float>(sqrt(tex / original.size()));
+	}
+	return error;
+}
+
+bool mini::AcceptQuantization(const QuantizationError& error, float diagonal, const QuantizationTolerance& tolerance)
+{
+	return error.maxPosition <= tolerance.position * diagonal &&
+		error.maxNormalDegrees <= tolerance.normalDegrees &&
+		error.maxTex <= tolerance.tex;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include "vertexTypes.h"
+
+namespace mini
+{
+	//Maps 16-bit normalized positions back to model space: pos = offset + unorm * scale.
+	//Laid out to be used directly as a constant buffer.
+	struct PositionDequantization
+	{
+		DirectX::XMFLOAT4 offset;
+		DirectX::XMFLOAT4 scale;
+	};
+
+	//Vertex layout a mesh was created with
+	struct VertexEncoding
+	{
+		bool quantized = false;
+		PositionDequantization dequantization = { { 0.0f, 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+	};
+
+	struct QuantizedVertices
+	{
+		std::vector<VertexPositionNormalTexQuantized> vertices;
+		PositionDequantization dequantization;
+	};
+
+	//Differences between the original and the round-tripped vertices
+	struct QuantizationError
+	{
+		float maxPosition;		//in model units
+		float rmsPosition;
+		float maxNormalDegrees;
+		float rmsNormalDegrees;
+		float maxTex;
+		float rmsTex;
+	};
+
+	//Largest errors accepted when choosing the quantized layout at load time
+	struct QuantizationTolerance
+	{
+		float position = 1e-4f;		//relative to the bounding box diagonal
+		float normalDegrees = 0.1f;
+		float tex = 1.0f / 2048.0f;	//half a texel at 1024x1024, half UVs lose precision quickly above 1
+	};
+
+	//Octahedral normal encoding, unit vector to [-1,1]^2 and back
+	DirectX::XMFLOAT2 OctahedralEncode(const DirectX::XMFLOAT3& n);
+	DirectX::XMFLOAT3 OctahedralDecode(const DirectX::XMFLOAT2& e);
+
+	QuantizedVertices QuantizeVertices(const std::vector<VertexPositionNormalTex>& verts);
+	std::vector<VertexPositionNormalTex> DequantizeVertices(const QuantizedVertices& quantized);
+
+	QuantizationError MeasureQuantizationError(const std::vector<VertexPositionNormalTex>& original,
+		const QuantizedVertices& quantized);
+	//Whether the error fits the tolerance for vertices with the given bounding box diagonal
+	bool AcceptQuantization(const QuantizationError& error, float diagonal, const QuantizationTolerance& tolerance = {});
+	float BoundingDiagonal(const std::vector<VertexPositionNormalTex>& verts);
+}
@@ -3,6 +3,10 @@
 using namespace DirectX;
 using namespace mini;
 
+const D3D11_INPUT_ELEMENT_DESC VertexPosition::Layout[1] = {
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPosition, position), D3D11_INPUT_PER_VERTEX_DATA, 0 }
+};
+
 const D3D11_INPUT_ELEMENT_DESC VertexPositionColor::Layout[2] = {
 	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionColor, position), 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPositionColor, color), D3D11_INPUT_PER_VERTEX_DATA, 0 }
@@ -18,4 +22,10 @@ const D3D11_INPUT_ELEMENT_DESC VertexPositionNormalTex::Layout[3] = {
 	{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPositionNormalTex, normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(VertexPositionNormalTex, tex), D3D11_INPUT_PER_VERTEX_DATA, 0 }
 
+};
+
+const D3D11_INPUT_ELEMENT_DESC VertexPositionNormalTexQuantized::Layout[3] = {
+	{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(VertexPositionNormalTexQuantized, position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(VertexPositionNormalTexQuantized, normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(VertexPositionNormalTexQuantized, tex), D3D11_INPUT_PER_VERTEX_DATA, 0 }
 };
\ No newline at end of file
@@ -8,9 +8,18 @@
 
 #include <d3d11.h>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 namespace mini
 {
+	//Position only, used by shadow volumes
+	struct VertexPosition
+	{
+		DirectX::XMFLOAT3 position;
+
+		static const D3D11_INPUT_ELEMENT_DESC Layout[1];
+	};
+
 	struct VertexPositionColor
 	{
 		DirectX::XMFLOAT3 position;
@@ -35,4 +44,14 @@ namespace mini
 
 		static const D3D11_INPUT_ELEMENT_DESC Layout[3];
 	};
+
+	//Compact version of VertexPositionNormalTex, 16 instead of 32 bytes (see vertexQuantization.h)
+	struct VertexPositionNormalTexQuantized
+	{
+		DirectX::PackedVector::XMUSHORTN4 position;	//w unused, dequantized with a per-mesh offset and scale
+		DirectX::PackedVector::XMSHORTN2 normal;	//octahedral encoding
+		DirectX::PackedVector::XMHALF2 tex;
+
+		static const D3D11_INPUT_ELEMENT_DESC Layout[3];
+	};
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "workerPool.h"
+#include "exceptions.h"
+
+using namespace mini;
+using namespace std;
+
+unsigned int WorkerPool::DefaultWorkerCount()
+{
+	auto n = thread::hardware_concurrency();
+	return n > 1 ? n - 1 : 0;
+}
+
+WorkerPool::WorkerPool(unsigned int workers)
+{
+	m_threads.reserve(workers);
+	for (unsigned int i = 0; i < workers; ++i)
+		m_threads.emplace_back([this] { WorkerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& t : m_threads)
+		t.join();
+}
+
+void WorkerPool::ParallelFor(size_t count, const function<void(size_t)>& job)
+{
+	if (count == 0)
+		return;
+	if (m_threads.empty() || count == 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			job(i);
+		return;
+	}
+	{
+		lock_guard<mutex> lock(m_mutex);
+		//a second loop would overwrite the job of the running one
+		if (m_job)
+			THROW(L"Worker pool is already running a loop");
+		m_job = &job;
+		m_count = count;
+		m_next = 0;
+		m_busy = workerCount();
+		++m_generation;
+	}
+	m_wake.notify_all();
+	RunJobs();
+
+	unique_lock<mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_busy == 0; });
+	m_job = nullptr;
+}
+
+void WorkerPool::RunJobs()
+{
+	for (auto i = m_next++; i < m_count; i = m_next++)
+		(*m_job)(i);
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned long long seen = 0;
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+			seen = m_generation;
+		}
+		RunJobs();
+		{
+			lock_guard<mutex> lock(m_mutex);
+			if (--m_busy == 0)
+				m_done.notify_one();
+		}
+	}
+}
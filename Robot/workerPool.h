@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace mini
+{
+	//Fixed set of worker threads executing data-parallel loops. The calling
+	//thread takes part in the work, so a pool with zero workers runs everything
+	//serially on the caller.
+	class WorkerPool
+	{
+	public:
+		//By default one worker less than the number of hardware threads
+		explicit WorkerPool(unsigned int workers = DefaultWorkerCount());
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+		~WorkerPool();
+
+		static unsigned int DefaultWorkerCount();
+		unsigned int workerCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+		//Calls job(i) for every i in [0, count) and returns once all calls finished.
+		//Calls may run concurrently and in any order, results must not depend on it.
+		//Loops that need the workers can't overlap, starting one while another is running
+		//on some other thread, or from inside a job, throws.
+		void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+	private:
+		void WorkerLoop();
+		void RunJobs();
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+
+		const std::function<void(size_t)>* m_job = nullptr;
+		size_t m_count = 0;
+		std::atomic<size_t> m_next{ 0 };
+		unsigned int m_busy = 0;
+		unsigned long long m_generation = 0;
+		bool m_stop = false;
+	};
+}
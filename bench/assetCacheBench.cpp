@@ -0,0 +1,103 @@
+#include "assetCache.h"
+#include "mesh.h"
+#include "mockD3D.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+//Startup loading of the cached assets of Robot, the duck mesh and its texture, plus a larger text
+//mesh: without a cache, with an empty one (entries get written) and with a filled one. Runs on the
+//mock device, so texture decoding and uploads cost less than on a real one.
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+	const int RUNS = 10;
+
+	//Text mesh of a side x side grid, bumpy enough for the LOD chain to have work
+	void WriteGrid(const filesystem::path& path, unsigned int side)
+	{
+		ofstream output(path);
+		output << (side + 1) * (side + 1) << "\n";
+		char line[160];
+		for (unsigned int y = 0; y <= side; ++y)
+			for (unsigned int x = 0; x <= side; ++x)
+			{
+				float u = float(x) / side, v = float(y) / side;
+				snprintf(line, sizeof(line), "%f %f %f 0 1 0 %f %f\n", u, 0.05f * sinf(20.0f * u) * cosf(17.0f * v), v, u, v);
+				output << line;
+			}
+		output << 2 * side * side << "\n";
+		for (unsigned int y = 0; y < side; ++y)
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				unsigned int i = y * (side + 1) + x;
+				output << i << " " << i + side + 1 << " " << i + 1 << "\n" << i + 1 << " " << i + side + 1 << " " << i + side + 2 << "\n";
+			}
+	}
+
+	struct Assets
+	{
+		wstring duck, texture, grid;
+	};
+
+	//Decode and create of every asset like in the Robot constructor, on one thread
+	void Load(const DxDevice& device, AssetCache& cache, const Assets& assets)
+	{
+		for (auto& path : { assets.duck, assets.grid })
+			Mesh::CreateMesh(device, Mesh::DecodeMesh(path, false, true, &cache));
+		CreateTexture(device, cache, ReadTexture(cache, assets.texture));
+	}
+
+	//Best of RUNS in milliseconds, prepare runs before every timed load
+	template<typename Prepare>
+	double Time(const DxDevice& device, const wstring& directory, const Assets& assets, Prepare prepare)
+	{
+		double best = 1e30;
+		for (int r = 0; r < RUNS; ++r)
+		{
+			prepare();
+			AssetCache cache(directory);
+			auto start = Clock::now();
+			Load(device, cache, assets);
+			best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	//run from the build directory or the repository root
+	filesystem::path resources;
+	for (auto path : { "../Robot/resources/duck", "Robot/resources/duck" })
+		if (filesystem::exists(path))
+			resources = path;
+	if (resources.empty())
+	{
+		printf("Robot/resources/duck not found\n");
+		return 1;
+	}
+	auto temp = filesystem::temp_directory_path() / "assetCacheBench";
+	filesystem::create_directories(temp);
+	WriteGrid(temp / "grid.txt", 256);
+	Assets assets = { (resources / "duck.txt").wstring(), (resources / "ducktex.jpg").wstring(), (temp / "grid.txt").wstring() };
+	auto cache = (temp / "cache").wstring();
+
+	mock::NextDevice() = {};
+	Window window(nullptr, Window::m_defaultWindowWidth, Window::m_defaultWindowHeight);
+	DxDevice device(window);
+	auto none = Time(device, L"", assets, [] { });
+	auto cold = Time(device, cache, assets, [&cache] { filesystem::remove_all(cache); });
+	auto warm = Time(device, cache, assets, [] { });
+	printf("duck.txt, ducktex.jpg and a 256x256 grid, best of %d\n", RUNS);
+	printf("no cache      %9.3f ms\n", none);
+	printf("cold cache    %9.3f ms\n", cold);
+	printf("warm cache    %9.3f ms  %.1fx faster than without\n", warm, none / warm);
+	filesystem::remove_all(temp);
+}
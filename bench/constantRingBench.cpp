@@ -0,0 +1,98 @@
+#include "constantRing.h"
+#include "mockD3D.h"
+#include <cstdio>
+
+//Device calls per frame for the constants of the scene: one buffer per kind of constant updated
+//before every draw, against the ring bound with offsets and the ring's per-slot fallback
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	constexpr int FRAMES = 1000, DRAWS = 9;
+
+	struct Matrix
+	{
+		float m[16];
+	};
+
+	struct Color
+	{
+		float c[4];
+	};
+
+	Matrix World(int frame, int draw)
+	{
+		Matrix r;
+		for (int k = 0; k < 16; ++k)
+			r.m[k] = frame * 100.0f + draw + k * 0.01f;
+		return r;
+	}
+
+	const Color COLORS[3] = { { 1, 1, 1, 1 }, { 1, -1, 1, 1 }, { 1, 0.1f, 0.1f, 0.5f } };
+
+	//Color used by every draw, like the scene's walls, sheet and robot
+	int ColorOf(int draw) { return draw < 2 ? draw : 2; }
+
+	void Report(const char* name, const mock::Context& context)
+	{
+		printf("%-24s Map %6.3f  SetConstantBuffers %6.3f  SetConstantBuffers1 %6.3f  per frame\n", name,
+			double(context.Count("Map")) / FRAMES,
+			double(context.Count("VSSetConstantBuffers") + context.Count("PSSetConstantBuffers")) / FRAMES,
+			double(context.Count("VSSetConstantBuffers1") + context.Count("PSSetConstantBuffers1")) / FRAMES);
+	}
+
+	void PerDrawUpdates()
+	{
+		dx_ptr<mock::Context> context{ new mock::Context };
+		StateCache state(context.get());
+		dx_ptr<mock::Buffer> world{ mock::NewConstantBuffer(sizeof(Matrix)) }, color{ mock::NewConstantBuffer(sizeof(Color)) };
+		ID3D11Buffer* w = world.get();
+		ID3D11Buffer* c = color.get();
+		for (int frame = 0; frame < FRAMES; ++frame)
+			for (int draw = 0; draw < DRAWS; ++draw)
+			{
+				auto m = World(frame, draw);
+				state.UpdateBuffer(w, &m, sizeof(m));
+				state.UpdateBuffer(c, &COLORS[ColorOf(draw)], sizeof(Color));
+				state.VSSetConstantBuffers(0, 1, &w);
+				state.PSSetConstantBuffers(0, 1, &c);
+			}
+		Report("per-draw UpdateBuffer", *context);
+	}
+
+	void Ring(bool offsets)
+	{
+		mock::NextDevice() = { offsets, true, true };
+		Window window(nullptr, Window::m_defaultWindowWidth, Window::m_defaultWindowHeight);
+		DxDevice device(window);
+		StateCache state(device.context().get(), device.context1().get());
+		ConstantRing ring(device, 64 * 1024);
+		for (int frame = 0; frame < FRAMES; ++frame)
+		{
+			ring.BeginFrame();
+			ring.Map(device.context());
+			ConstantRange worlds[DRAWS], colors[3];
+			for (int draw = 0; draw < DRAWS; ++draw)
+				worlds[draw] = ring.Push(World(frame, draw));
+			for (int i = 0; i < 3; ++i)
+				colors[i] = ring.Push(COLORS[i]);
+			ring.Unmap(device.context());
+			for (int draw = 0; draw < DRAWS; ++draw)
+			{
+				ring.Bind(state, ConstantRing::Vertex, 0, worlds[draw]);
+				ring.Bind(state, ConstantRing::Pixel, 0, colors[ColorOf(draw)]);
+			}
+		}
+		Report(offsets ? "ring with offsets" : "ring without offsets", dynamic_cast<mock::Context&>(*device.context()));
+	}
+}
+
+int main()
+{
+	printf("%d draws per frame, %d frames\n", DRAWS, FRAMES);
+	PerDrawUpdates();
+	Ring(true);
+	Ring(false);
+}
@@ -0,0 +1,103 @@
+#include "particleSort.h"
+#include "particleSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+//Back-to-front ordering of the particle vertices: DepthSorter against the std::sort paths it replaced,
+//the old comparator as it was (comparing a particle with itself) and the same comparator fixed
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+
+	float Distance(XMFLOAT4 v1, XMFLOAT3 v2)
+	{
+		return sqrt((v1.x - v2.x) * (v1.x - v2.x) + (v1.y - v2.y) * (v1.y - v2.y) + (v1.z - v2.z) * (v1.z - v2.z));
+	}
+
+	struct Particles
+	{
+		vector<float> x, y, z;
+	};
+
+	Particles Random(size_t count)
+	{
+		Particles p;
+		mt19937 random(5);
+		uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+		for (size_t i = 0; i < count; ++i)
+		{
+			p.x.push_back(coordinate(random));
+			p.y.push_back(coordinate(random));
+			p.z.push_back(coordinate(random));
+		}
+		return p;
+	}
+
+	void Fill(vector<ParticleVertex>& vertices, const Particles& p, const uint32_t* order)
+	{
+		vertices.resize(p.x.size());
+		for (size_t k = 0; k < vertices.size(); ++k)
+		{
+			auto i = order ? order[k] : k;
+			vertices[k].Pos = XMFLOAT3(p.x[i], p.y[i], p.z[i]);
+			vertices[k].LastPos = vertices[k].Pos;
+		}
+	}
+
+	//Milliseconds per frame of fill and sort, the best of a few runs
+	template<typename Frame>
+	double Time(Frame frame, int runs)
+	{
+		double best = 1e30;
+		for (int r = 0; r < runs; ++r)
+		{
+			auto start = Clock::now();
+			frame();
+			best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	const XMFLOAT4 camera(0.0f, 0.6f, -0.9f, 1.0f);
+	printf("%10s %14s %14s %14s\n", "particles", "old std::sort", "fixed std::sort", "DepthSorter");
+	for (size_t count : { 10000u, 100000u, 1000000u })
+	{
+		auto p = Random(count);
+		int runs = count < 1000000 ? 20 : 5;
+		vector<ParticleVertex> vertices;
+		vertices.reserve(count);
+
+		auto old = Time([&]
+		{
+			Fill(vertices, p, nullptr);
+			//the old comparator never looked at its second argument
+			sort(vertices.begin(), vertices.end(), [&camera](const ParticleVertex& a, const ParticleVertex& /*b*/)
+				{ return Distance(camera, a.Pos) < Distance(camera, a.Pos); });
+		}, runs);
+		auto fixed = Time([&]
+		{
+			Fill(vertices, p, nullptr);
+			sort(vertices.begin(), vertices.end(), [&camera](const ParticleVertex& a, const ParticleVertex& b)
+				{ return Distance(camera, a.Pos) > Distance(camera, b.Pos); });
+		}, runs);
+		DepthSorter sorter(count);
+		auto radix = Time([&]
+		{
+			auto& order = sorter.Sort(p.x.data(), p.y.data(), p.z.data(), count, camera);
+			Fill(vertices, p, order.data());
+		}, runs);
+		printf("%10zu %11.3f ms %11.3f ms %11.3f ms\n", count, old, fixed, radix);
+	}
+}
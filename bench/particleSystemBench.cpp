@@ -0,0 +1,141 @@
+#include "particleSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+//Steady state simulation step of a full particle system: the structure-of-arrays store against the
+//layout it replaced, a vector of particles each owning a trail history growing every update
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	atomic<size_t> allocations{ 0 };
+}
+
+void* operator new(size_t size)
+{
+	++allocations;
+	if (auto p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+
+	const float DT = 1.0f / 60.0f;
+	//long enough for the first particles to die, so births and deaths balance
+	const int WARMUP = 200, FRAMES = 30;
+
+	//The particle and the update loop as they were before the store, only the spawn velocity is simplified
+	struct OldParticle
+	{
+		ParticleVertex Vertex;
+		XMFLOAT3 Velocity;
+		vector<XMFLOAT3> posHist;
+	};
+
+	class OldSystem
+	{
+	public:
+		OldSystem(size_t capacity, float rate) : m_capacity(capacity), m_rate(rate), m_random(1) { }
+
+		void Simulate(float dt)
+		{
+			size_t removeCount = 0;
+			for (auto& p : m_particles)
+			{
+				int ind = static_cast<int>(p.posHist.size()) - 20;
+				if (ind < 0) ind = 0;
+				p.Vertex.LastPos = p.posHist[ind];
+				p.Vertex.Age += dt;
+				XMVECTOR v = XMLoadFloat3(&p.Velocity);
+				XMStoreFloat3(&p.Velocity, v + dt * XMLoadFloat3(&ParticleSystem::ACCELERATION));
+				XMStoreFloat3(&p.Vertex.Pos, XMLoadFloat3(&p.Vertex.Pos) + dt * v);
+				p.Vertex.Size += ParticleSystem::PARTICLE_SCALE * ParticleSystem::PARTICLE_SIZE * dt;
+				p.posHist.push_back(p.Vertex.Pos);
+				if (p.Vertex.Age >= ParticleSystem::TIME_TO_LIVE)
+					++removeCount;
+			}
+			m_particles.erase(m_particles.begin(), m_particles.begin() + removeCount);
+
+			m_toCreate += dt * m_rate;
+			uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+			while (m_toCreate >= 1.0f)
+			{
+				--m_toCreate;
+				if (m_particles.size() >= m_capacity)
+					continue;
+				OldParticle p;
+				p.Vertex.Size = ParticleSystem::PARTICLE_SIZE;
+				p.Velocity = XMFLOAT3(velocity(m_random), 1.5f, velocity(m_random));
+				p.posHist.push_back(p.Vertex.Pos);
+				m_particles.push_back(move(p));
+			}
+		}
+
+		size_t size() const { return m_particles.size(); }
+
+	private:
+		size_t m_capacity;
+		float m_rate, m_toCreate = 0.0f;
+		default_random_engine m_random;
+		vector<OldParticle> m_particles;
+	};
+
+	struct Result
+	{
+		double ms, allocations;
+		size_t particles;
+	};
+
+	//Average time and allocations of a step after the warm up
+	template<typename System>
+	Result Measure(System& system)
+	{
+		for (int f = 0; f < WARMUP; ++f)
+			system.Simulate(DT);
+		size_t startAllocations = allocations;
+		auto start = Clock::now();
+		for (int f = 0; f < FRAMES; ++f)
+			system.Simulate(DT);
+		auto ms = chrono::duration<double, milli>(Clock::now() - start).count();
+		return { ms / FRAMES, double(allocations - startAllocations) / FRAMES, 0 };
+	}
+}
+
+int main()
+{
+	printf("%10s %26s %26s\n", "particles", "old vector of particles", "ParticleStore");
+	for (size_t count : { 10000u, 100000u, 1000000u })
+	{
+		//emitting more than dies keeps the system at its capacity
+		float rate = 1.25f * count / ParticleSystem::TIME_TO_LIVE;
+		ParticleSystem store(count, 1);
+		store.AddEmitter(XMFLOAT3(0.0f, 0.0f, 0.0f), XMMatrixRotationX(XM_PIDIV2), rate);
+		auto current = Measure(store);
+		current.particles = store.particlesCount();
+
+		char old[64] = "n/a";
+		//a million trails of up to 180 positions each don't fit in memory
+		if (count < 1000000)
+		{
+			OldSystem system(count, rate);
+			auto r = Measure(system);
+			snprintf(old, sizeof(old), "%8.3f ms %7.0f allocs", r.ms, r.allocations);
+		}
+		printf("%10zu %26s %8.3f ms %7.0f allocs\n", current.particles, old, current.ms, current.allocations);
+	}
+}
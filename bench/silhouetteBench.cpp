@@ -0,0 +1,148 @@
+#include "silhouette.h"
+#include "meshFile.h"
+#include "workerPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+//Shadow volume sides for a point light: SilhouetteExtractor against the per-edge loop of the
+//old Mesh::ShadowBox, on the duck and on a 500k triangle torus
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+	const float EXTRUSION = 10.0f;
+
+	//Mesh::ShadowBox before SilhouetteExtractor, without creating the buffers: both face normals
+	//of every edge recomputed, quads pushed into growing vectors. Indices are 32 bit here, the
+	//old 16 bit ones overflow on the large mesh.
+	size_t OldShadowBox(const MeshAdjacency& mesh, XMFLOAT4 light, vector<XMFLOAT3>& verts, vector<unsigned int>& indices)
+	{
+		verts = {};
+		indices = {};
+		auto lightPos = XMLoadFloat4(&light);
+		auto corner = [&mesh](unsigned int face, int k) { return XMLoadFloat3(&mesh.positions[mesh.faces[3 * face + k]]); };
+		unsigned int index = 0;
+		for (auto& e : mesh.edges)
+		{
+			if (e.face1 == MeshAdjacency::NO_FACE)
+				continue;
+			auto from = mesh.positions[e.v0], to = mesh.positions[e.v1];
+			auto toLight = XMVector3Normalize(lightPos - XMLoadFloat3(&from));
+			auto cross1 = XMVector3Cross(corner(e.face0, 1) - corner(e.face0, 0), corner(e.face0, 2) - corner(e.face0, 1));
+			auto cross2 = XMVector3Cross(corner(e.face1, 1) - corner(e.face1, 0), corner(e.face1, 2) - corner(e.face1, 1));
+			float dot1 = XMVectorGetX(XMVector3Dot(cross1, toLight)), dot2 = XMVectorGetX(XMVector3Dot(cross2, toLight));
+			if (!(dot1 * dot2 < 0.0f || (dot1 == 0.0f && dot2 > 0.0f) || (dot2 == 0.0f && dot1 > 0.0f)))
+				continue;
+			XMFLOAT3 infFrom, infTo;
+			XMStoreFloat3(&infFrom, XMLoadFloat3(&from) + EXTRUSION * XMVector3Normalize(XMLoadFloat3(&from) - lightPos));
+			XMStoreFloat3(&infTo, XMLoadFloat3(&to) + EXTRUSION * XMVector3Normalize(XMLoadFloat3(&to) - lightPos));
+			verts.push_back(from);
+			verts.push_back(infFrom);
+			verts.push_back(infTo);
+			verts.push_back(to);
+			//from -> to follows face0, flip the quad when face1 is the lit one
+			bool lit0 = dot1 > dot2;
+			unsigned int quad[6] = { index, index + 2, index + 1, index, index + 3, index + 2 };
+			if (!lit0)
+				swap(quad[1], quad[2]), swap(quad[4], quad[5]);
+			indices.insert(indices.end(), quad, quad + 6);
+			index += 4;
+		}
+		return index / 4;
+	}
+
+	//Closed torus with rings x segments quads split into triangles
+	MeshAdjacency Torus(unsigned int rings, unsigned int segments)
+	{
+		vector<XMFLOAT3> positions;
+		for (unsigned int r = 0; r < rings; ++r)
+			for (unsigned int s = 0; s < segments; ++s)
+			{
+				float u = XM_2PI * r / rings, v = XM_2PI * s / segments;
+				positions.emplace_back((1.0f + 0.3f * cos(v)) * cos(u), 0.3f * sin(v), (1.0f + 0.3f * cos(v)) * sin(u));
+			}
+		vector<unsigned int> indices;
+		for (unsigned int r = 0; r < rings; ++r)
+			for (unsigned int s = 0; s < segments; ++s)
+			{
+				unsigned int a = r * segments + s, b = r * segments + (s + 1) % segments;
+				unsigned int c = (r + 1) % rings * segments + s, d = (r + 1) % rings * segments + (s + 1) % segments;
+				indices.insert(indices.end(), { a, b, c, b, d, c });
+			}
+		return BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), indices);
+	}
+
+	//Best of a few runs in milliseconds
+	template<typename Run>
+	double Time(Run run, int runs)
+	{
+		double best = 1e30;
+		for (int r = 0; r < runs; ++r)
+		{
+			auto start = Clock::now();
+			run();
+			best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+
+	void Compare(const char* name, const MeshAdjacency& mesh, int runs)
+	{
+		XMFLOAT3 low = mesh.positions[0], high = low;
+		for (auto& p : mesh.positions)
+		{
+			low = XMFLOAT3(min(low.x, p.x), min(low.y, p.y), min(low.z, p.z));
+			high = XMFLOAT3(max(high.x, p.x), max(high.y, p.y), max(high.z, p.z));
+		}
+		//light above and to the side of the mesh, at twice its size from the center
+		float size = max(high.x - low.x, max(high.y - low.y, high.z - low.z));
+		XMFLOAT4 light(0.5f * (low.x + high.x) + 0.6f * size, 0.5f * (low.y + high.y) + 2.0f * size, 0.5f * (low.z + high.z) + size, 1.0f);
+
+		vector<XMFLOAT3> oldVerts;
+		vector<unsigned int> oldIndices;
+		size_t oldEdges = 0;
+		auto old = Time([&] { oldEdges = OldShadowBox(mesh, light, oldVerts, oldIndices); }, runs);
+
+		SilhouetteExtractor extractor(mesh);
+		vector<XMFLOAT3> quads(6 * extractor.edgeCount());
+		size_t edges = 0;
+		auto extract = [&](gk2::SimdLevel level, WorkerPool* workers)
+		{
+			return Time([&]
+			{
+				edges = extractor.Extract(light, workers, level);
+				extractor.WriteQuads(quads.data(), quads.size(), EXTRUSION, workers);
+			}, runs);
+		};
+		auto scalar = extract(gk2::SimdLevel::Scalar, nullptr);
+		auto simd = extract(gk2::DetectSimdLevel(), nullptr);
+		WorkerPool pool;
+		auto parallel = extract(gk2::DetectSimdLevel(), &pool);
+		printf("%-8s %7zu faces %6zu edges %6zu | %9.3f ms %9.3f ms %9.3f ms %9.3f ms (%u workers)\n", name,
+			mesh.faceCount(), oldEdges, edges, old, scalar, simd, parallel, pool.workerCount());
+	}
+}
+
+int main()
+{
+	printf("%-8s %13s %-13s %-6s | %12s %12s %12s %12s\n", "mesh", "", "silhouette", "", "old loop", "scalar", "SIMD",
+		"SIMD+pool");
+	//run from the build directory or the repository root
+	for (auto path : { "../Robot/resources/duck/duck.txt", "Robot/resources/duck/duck.txt" })
+		if (filesystem::exists(path))
+		{
+			auto duck = ReadTextMesh(filesystem::path(path).wstring());
+			Compare("duck", BuildAdjacency(duck.vertices, duck.indices), 200);
+			break;
+		}
+	Compare("torus", Torus(500, 500), 10);
+	const char* levels[] = { "scalar", "AVX2", "AVX-512" };
+	printf("SIMD level %s\n", levels[static_cast<int>(gk2::DetectSimdLevel())]);
+}
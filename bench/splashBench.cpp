@@ -0,0 +1,133 @@
+#include "splashSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+//Headless run of the water of Robot with splashes: the height field is stepped like in
+//Robot::GenerateHeightMap (without the normal map), the duck circles the sheet and drops fall
+//at random. Splash work per frame against scanning the whole grid for crests every frame.
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+
+	//Same as in Robot
+	constexpr unsigned int N = 256;
+	constexpr float H = 2.0f / (N - 1), DT = 1.0f / N, C = 1.0f;
+	constexpr float WATER_LEVEL = -0.05f;
+	constexpr size_t MAX_SPLASH_PARTICLES = 20000;
+	constexpr int FRAMES = 1200;
+
+	struct Water
+	{
+		HeightField height = HeightField(N, vector<float>(N)), old = HeightField(N, vector<float>(N));
+		HeightField damping = HeightField(N, vector<float>(N));
+		mt19937 random{ 11 };
+
+		Water()
+		{
+			for (unsigned int i = 0; i < N; ++i)
+				for (unsigned int j = 0; j < N; ++j)
+				{
+					float x = i / float(N - 1) * 2.0f - 1.0f, z = j / float(N - 1) * 2.0f - 1.0f;
+					float l = min(abs(1.0f - x), min(abs(x + 1.0f), min(abs(1.0f - z), abs(z + 1.0f))));
+					damping[i][j] = 0.95f * min(1.0f, 5.0f * l);
+				}
+		}
+
+		//One step, afterwards old holds the newest heights like in Robot
+		void Step(int frame, SplashSystem& splashes)
+		{
+			float angle = frame * 0.01f;
+			unsigned int u = static_cast<unsigned int>((0.6f * cos(angle) + 1.0f) * 0.5f * (N - 1));
+			unsigned int v = static_cast<unsigned int>((0.6f * sin(angle) + 1.0f) * 0.5f * (N - 1));
+			old[u][v] = 0.25f;
+			splashes.Disturb(u, v);
+			constexpr float A = C * C * DT * DT / (H * H), B = 2 - 4 * A;
+			uniform_int_distribution<int> drop(0, 2000000 - 1);
+			for (unsigned int i = 0; i < N; ++i)
+				for (unsigned int j = 0; j < N; ++j)
+				{
+					if (drop(random) == 0)
+					{
+						height[i][j] = 0.25f;
+						splashes.Disturb(i, j);
+						continue;
+					}
+					float sum = 0.0f;
+					if (i > 0) sum += old[i - 1][j];
+					if (j > 0) sum += old[i][j - 1];
+					if (i < N - 1) sum += old[i + 1][j];
+					if (j < N - 1) sum += old[i][j + 1];
+					height[i][j] = damping[i][j] * (A * sum + B * old[i][j] - height[i][j]);
+				}
+			swap(old, height);
+		}
+	};
+
+	//The scan the tiles replace, every cell checked against the crest thresholds
+	unsigned int FullScan(const HeightField& height, const HeightField& previous)
+	{
+		unsigned int crests = 0;
+		for (unsigned int i = 0; i < N; ++i)
+			for (unsigned int j = 0; j < N; ++j)
+				if (height[i][j] > SplashSystem::CREST_HEIGHT && height[i][j] - previous[i][j] > SplashSystem::CREST_VELOCITY)
+					++crests;
+		return crests;
+	}
+
+	double Ms(Clock::time_point start) { return chrono::duration<double, milli>(Clock::now() - start).count(); }
+}
+
+int main()
+{
+	Water water;
+	SplashSystem splashes(N, WATER_LEVEL);
+	ParticleSystem particles(MAX_SPLASH_PARTICLES, 3);
+	double waterMs = 0.0, splashMs = 0.0, worstSplashMs = 0.0, fullScanMs = 0.0, particleMs = 0.0;
+	size_t scanned = 0, spawned = 0, impacts = 0, maxScanned = 0, maxParticles = 0;
+	unsigned int crests = 0;
+	for (int frame = 0; frame < FRAMES; ++frame)
+	{
+		auto start = Clock::now();
+		water.Step(frame, splashes);
+		waterMs += Ms(start);
+
+		start = Clock::now();
+		crests += FullScan(water.old, water.height);
+		fullScanMs += Ms(start);
+
+		start = Clock::now();
+		splashes.ApplyImpacts(particles, water.old);
+		splashes.Update(water.old, water.height, particles);
+		auto ms = Ms(start);
+		splashMs += ms;
+		worstSplashMs = max(worstSplashMs, ms);
+
+		start = Clock::now();
+		particles.Simulate(1.0f / 60.0f);
+		particleMs += Ms(start);
+
+		scanned += splashes.scannedCells();
+		maxScanned = max<size_t>(maxScanned, splashes.scannedCells());
+		spawned += splashes.spawnedSplashes();
+		impacts += splashes.appliedImpacts();
+		maxParticles = max(maxParticles, particles.particlesCount());
+	}
+	printf("%d frames of a %ux%u height field\n", FRAMES, N, N);
+	printf("height field step         %8.3f ms/frame\n", waterMs / FRAMES);
+	printf("full grid crest scan      %8.3f ms/frame  %u crest cells in total\n", fullScanMs / FRAMES, crests);
+	printf("splashes                  %8.3f ms/frame  worst %.3f ms\n", splashMs / FRAMES, worstSplashMs);
+	printf("  cells scanned           %8.1f /frame    most %zu, limit %u\n", double(scanned) / FRAMES, maxScanned,
+		SplashSystem::MAX_SCAN_CELLS);
+	printf("  splashes spawned        %8.2f /frame    %zu in total\n", double(spawned) / FRAMES, spawned);
+	printf("  drops applied           %8.2f /frame    %zu in total\n", double(impacts) / FRAMES, impacts);
+	printf("particle simulation       %8.3f ms/frame  most %zu particles\n", particleMs / FRAMES, maxParticles);
+}
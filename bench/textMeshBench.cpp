@@ -0,0 +1,126 @@
+#include "meshFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+//Loading of the text mesh format: ReadTextMesh against the ifstream loader it replaced,
+//on a synthetic file with a million vertices and on the duck
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	using Clock = chrono::steady_clock;
+
+	//Mesh::LoadMesh before ReadTextMesh, without the buffer creation
+	MeshData OldLoad(const wstring& path)
+	{
+		ifstream input;
+		input.exceptions(ios::badbit | ios::failbit | ios::eofbit);
+		input.open(filesystem::path(path));
+
+		int vn, in;
+		input >> vn;
+
+		vector<XMFLOAT3> verts_tmp(vn);
+		vector<XMFLOAT3> norms_tmp(vn);
+		vector<XMFLOAT2> tex_tmp(vn);
+		for (auto i = 0; i < vn; ++i)
+		{
+			input >> verts_tmp[i].x >> verts_tmp[i].y >> verts_tmp[i].z;
+			input >> norms_tmp[i].x >> norms_tmp[i].y >> norms_tmp[i].z;
+			input >> tex_tmp[i].x >> tex_tmp[i].y;
+		}
+
+		vector<VertexPositionNormalTex> verts(vn);
+		for (auto i = 0; i < vn; ++i)
+		{
+			verts[i].position = verts_tmp[i];
+			verts[i].normal = norms_tmp[i];
+			verts[i].tex = tex_tmp[i];
+		}
+
+		input >> in;
+		vector<unsigned short> inds(3 * in);
+		for (auto i = 0; i < in; ++i)
+			input >> inds[3 * i] >> inds[3 * i + 1] >> inds[3 * i + 2];
+
+		MeshData mesh;
+		mesh.vertices = move(verts);
+		mesh.indices.assign(inds.begin(), inds.end());
+		return mesh;
+	}
+
+	//Vertices with random coordinates printed like in duck.txt, triangles indexing the first 64k of them
+	void WriteSynthetic(const filesystem::path& path, size_t vertices, size_t triangles)
+	{
+		mt19937 random(7);
+		uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+		uniform_int_distribution<unsigned int> index(0, static_cast<unsigned int>(min<size_t>(vertices, 65536) - 1));
+		ofstream output(path);
+		output << vertices << "\n";
+		char line[160];
+		for (size_t i = 0; i < vertices; ++i)
+		{
+			float v[8];
+			for (auto& x : v)
+				x = coordinate(random);
+			snprintf(line, sizeof(line), "%f %f %f %f %f %f %f %f\n", v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+			output << line;
+		}
+		output << triangles << "\n";
+		for (size_t t = 0; t < triangles; ++t)
+			output << index(random) << " " << index(random) << " " << index(random) << "\n";
+	}
+
+	bool Same(const MeshData& a, const MeshData& b)
+	{
+		return a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+			memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(VertexPositionNormalTex)) == 0;
+	}
+
+	//Best of a few loads in milliseconds
+	template<typename Load>
+	double Time(Load load, const wstring& path, MeshData& mesh, int runs)
+	{
+		double best = 1e30;
+		for (int r = 0; r < runs; ++r)
+		{
+			auto start = Clock::now();
+			mesh = load(path);
+			best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+		}
+		return best;
+	}
+
+	void Compare(const char* name, const wstring& path, int runs)
+	{
+		MeshData old, current;
+		auto oldMs = Time(OldLoad, path, old, runs);
+		auto currentMs = Time([](const wstring& p) { return ReadTextMesh(p); }, path, current, runs);
+		printf("%-28s %8zu vertices %10.3f ms %10.3f ms %6.1fx %s\n", name, current.vertices.size(), oldMs, currentMs,
+			oldMs / currentMs, Same(old, current) ? "same" : "DIFFERENT");
+	}
+}
+
+int main()
+{
+	auto synthetic = filesystem::temp_directory_path() / "textMeshBench.txt";
+	WriteSynthetic(synthetic, 1000000, 20000);
+	printf("%-28s %17s %13s %13s\n", "mesh", "", "ifstream", "ReadTextMesh");
+	Compare("synthetic", synthetic.wstring(), 3);
+	//run from the build directory or the repository root
+	for (auto duck : { "../Robot/resources/duck/duck.txt", "Robot/resources/duck/duck.txt" })
+		if (filesystem::exists(duck))
+		{
+			Compare("duck.txt", filesystem::path(duck).wstring(), 20);
+			break;
+		}
+	filesystem::remove(synthetic);
+}
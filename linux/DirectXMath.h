@@ -0,0 +1,364 @@
+#pragma once
+
+//Stand-in for the subset of DirectXMath used by the platform independent sources. Same
+//conventions as the real library: row vectors, left-handed projections, XMVECTOR is an SSE
+//register. Written for clarity rather than speed, the benchmarks time the callers' work.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+
+#define XM_CALLCONV
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_1DIVPI = 0.318309886f;
+	constexpr float XM_1DIV2PI = 0.159154943f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	constexpr uint32_t XM_SELECT_0 = 0x00000000;
+	constexpr uint32_t XM_SELECT_1 = 0xFFFFFFFF;
+
+	constexpr float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	constexpr float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	//GCC vector extensions give it the same +, -, *, / operators as DirectXMath's XMVECTOR
+	typedef __m128 XMVECTOR;
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMVECTORF32
+	{
+		alignas(16) float f[4];
+		operator XMVECTOR() const { return _mm_load_ps(f); }
+	};
+
+	struct XMVECTORU32
+	{
+		alignas(16) uint32_t u[4];
+		operator XMVECTOR() const { return _mm_load_ps(reinterpret_cast<const float*>(u)); }
+	};
+
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) { }
+		explicit XMFLOAT2(const float* p) : x(p[0]), y(p[1]) { }
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) { }
+		explicit XMFLOAT3(const float* p) : x(p[0]), y(p[1]), z(p[2]) { }
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) { }
+		explicit XMFLOAT4(const float* p) : x(p[0]), y(p[1]), z(p[2]), w(p[3]) { }
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
+			: _11(m00), _12(m01), _13(m02), _14(m03), _21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23), _41(m30), _42(m31), _43(m32), _44(m33) { }
+
+		float operator()(size_t row, size_t column) const { return m[row][column]; }
+		float& operator()(size_t row, size_t column) { return m[row][column]; }
+	};
+
+	struct XMMATRIX;
+	typedef const XMMATRIX FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+	inline XMVECTOR XMVectorReplicate(float value) { return _mm_set1_ps(value); }
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR v) { return XMVectorReplicate(v[0]); }
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR v) { return XMVectorReplicate(v[1]); }
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) { return XMVectorReplicate(v[2]); }
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR v) { return XMVectorReplicate(v[3]); }
+	inline float XMVectorGetX(FXMVECTOR v) { return v[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { return v[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { return v[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { return v[3]; }
+	inline XMVECTOR XMVectorSetX(XMVECTOR v, float x) { v[0] = x; return v; }
+	inline XMVECTOR XMVectorSetY(XMVECTOR v, float y) { v[1] = y; return v; }
+	inline XMVECTOR XMVectorSetZ(XMVECTOR v, float z) { v[2] = z; return v; }
+	inline XMVECTOR XMVectorSetW(XMVECTOR v, float w) { v[3] = w; return v; }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return a + b; }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return a - b; }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return a * b; }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return a / b; }
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float s) { return v * s; }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) { return -v; }
+	inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+	inline XMVECTOR XMVectorAbs(FXMVECTOR v) { return XMVectorMax(v, -v); }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t) { return a + (b - a) * t; }
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR v) { return _mm_sqrt_ps(v); }
+
+	inline XMVECTOR XMVectorSelectControl(uint32_t i0, uint32_t i1, uint32_t i2, uint32_t i3)
+	{
+		XMVECTORU32 control{ { i0 ? XM_SELECT_1 : XM_SELECT_0, i1 ? XM_SELECT_1 : XM_SELECT_0,
+			i2 ? XM_SELECT_1 : XM_SELECT_0, i3 ? XM_SELECT_1 : XM_SELECT_0 } };
+		return control;
+	}
+	//Bits of b where control is set, of a elsewhere
+	inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control)
+	{
+		return _mm_or_ps(_mm_andnot_ps(control, a), _mm_and_ps(control, b));
+	}
+
+	inline float XMVector3DotScalar(FXMVECTOR a, FXMVECTOR b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+	inline XMVECTOR XMVector2Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a[0] * b[0] + a[1] * b[1]); }
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(XMVector3DotScalar(a, b)); }
+	inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]); }
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) { return XMVector3Dot(v, v); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorReplicate(std::sqrt(XMVector3DotScalar(v, v))); }
+	inline XMVECTOR XMVector4Length(FXMVECTOR v) { return XMVectorSqrt(XMVector4Dot(v, v)); }
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = std::sqrt(XMVector3DotScalar(v, v));
+		return length > 0.0f ? v / length : XMVectorZero();
+	}
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v)
+	{
+		float length = XMVector4Length(v)[0];
+		return length > 0.0f ? v / length : XMVectorZero();
+	}
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0], 0.0f);
+	}
+	inline bool XMVector3Equal(FXMVECTOR a, FXMVECTOR b) { return a[0] == b[0] && a[1] == b[1] && a[2] == b[2]; }
+	inline bool XMVector3NotEqual(FXMVECTOR a, FXMVECTOR b) { return !XMVector3Equal(a, b); }
+	inline bool XMVector3Less(FXMVECTOR a, FXMVECTOR b) { return a[0] < b[0] && a[1] < b[1] && a[2] < b[2]; }
+	inline bool XMVector3LessOrEqual(FXMVECTOR a, FXMVECTOR b) { return a[0] <= b[0] && a[1] <= b[1] && a[2] <= b[2]; }
+	inline bool XMVector3Greater(FXMVECTOR a, FXMVECTOR b) { return XMVector3Less(b, a); }
+	inline bool XMVector3GreaterOrEqual(FXMVECTOR a, FXMVECTOR b) { return XMVector3LessOrEqual(b, a); }
+	inline bool XMVector3NearEqual(FXMVECTOR a, FXMVECTOR b, FXMVECTOR epsilon)
+	{
+		auto d = XMVectorAbs(a - b);
+		return d[0] <= epsilon[0] && d[1] <= epsilon[1] && d[2] <= epsilon[2];
+	}
+	inline bool XMVector4Equal(FXMVECTOR a, FXMVECTOR b) { return XMVector3Equal(a, b) && a[3] == b[3]; }
+
+	inline XMVECTOR XMLoadFloat(const float* p) { return XMVectorSet(*p, 0.0f, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* p) { return XMVectorSet(p->x, p->y, 0.0f, 0.0f); }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return XMVectorSet(p->x, p->y, p->z, 0.0f); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* p) { return XMVectorSet(p->x, p->y, p->z, p->w); }
+	inline void XMStoreFloat(float* p, FXMVECTOR v) { *p = v[0]; }
+	inline void XMStoreFloat2(XMFLOAT2* p, FXMVECTOR v) { *p = XMFLOAT2(v[0], v[1]); }
+	inline void XMStoreFloat3(XMFLOAT3* p, FXMVECTOR v) { *p = XMFLOAT3(v[0], v[1], v[2]); }
+	inline void XMStoreFloat4(XMFLOAT4* p, FXMVECTOR v) { *p = XMFLOAT4(v[0], v[1], v[2], v[3]); }
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) : r{ r0, r1, r2, r3 } { }
+		XMMATRIX(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
+			: r{ XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13),
+			XMVectorSet(m20, m21, m22, m23), XMVectorSet(m30, m31, m32, m33) } { }
+
+		XMMATRIX operator*(FXMMATRIX m) const;
+		XMMATRIX& operator*=(FXMMATRIX m) { return *this = *this * m; }
+	};
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* p)
+	{
+		return XMMATRIX(p->_11, p->_12, p->_13, p->_14, p->_21, p->_22, p->_23, p->_24,
+			p->_31, p->_32, p->_33, p->_34, p->_41, p->_42, p->_43, p->_44);
+	}
+	inline void XMStoreFloat4x4(XMFLOAT4X4* p, FXMMATRIX m)
+	{
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				p->m[i][j] = m.r[i][j];
+	}
+
+	//Row vector times matrix
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		return m.r[0] * v[0] + m.r[1] * v[1] + m.r[2] * v[2] + m.r[3] * v[3];
+	}
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) { return XMVector4Transform(XMVectorSetW(v, 1.0f), m); }
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		auto t = XMVector3Transform(v, m);
+		return t / t[3];
+	}
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m) { return XMVector4Transform(XMVectorSetW(v, 0.0f), m); }
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		return XMMATRIX(XMVector4Transform(a.r[0], b), XMVector4Transform(a.r[1], b),
+			XMVector4Transform(a.r[2], b), XMVector4Transform(a.r[3], b));
+	}
+	inline XMMATRIX XMMATRIX::operator*(FXMMATRIX m) const { return XMMatrixMultiply(*this, m); }
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		return XMMATRIX(m.r[0][0], m.r[1][0], m.r[2][0], m.r[3][0], m.r[0][1], m.r[1][1], m.r[2][1], m.r[3][1],
+			m.r[0][2], m.r[1][2], m.r[2][2], m.r[3][2], m.r[0][3], m.r[1][3], m.r[2][3], m.r[3][3]);
+	}
+	//Gauss-Jordan elimination with partial pivoting
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		double a[4][8];
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 8; ++j)
+				a[i][j] = j < 4 ? m.r[i][j] : (j - 4 == i ? 1.0 : 0.0);
+		double det = 1.0;
+		for (int c = 0; c < 4; ++c)
+		{
+			int pivot = c;
+			for (int i = c + 1; i < 4; ++i)
+				if (std::fabs(a[i][c]) > std::fabs(a[pivot][c]))
+					pivot = i;
+			if (pivot != c)
+			{
+				for (int j = 0; j < 8; ++j)
+					std::swap(a[c][j], a[pivot][j]);
+				det = -det;
+			}
+			double d = a[c][c];
+			det *= d;
+			if (d == 0.0)
+				break;
+			for (int j = 0; j < 8; ++j)
+				a[c][j] /= d;
+			for (int i = 0; i < 4; ++i)
+				if (i != c)
+				{
+					double f = a[i][c];
+					for (int j = 0; j < 8; ++j)
+						a[i][j] -= f * a[c][j];
+				}
+		}
+		if (determinant)
+			*determinant = XMVectorReplicate(static_cast<float>(det));
+		XMMATRIX result;
+		for (int i = 0; i < 4; ++i)
+			result.r[i] = XMVectorSet(static_cast<float>(a[i][4]), static_cast<float>(a[i][5]),
+				static_cast<float>(a[i][6]), static_cast<float>(a[i][7]));
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z)
+	{
+		return XMMATRIX(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1);
+	}
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR v) { return XMMatrixTranslation(v[0], v[1], v[2]); }
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z)
+	{
+		return XMMATRIX(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR v) { return XMMatrixScaling(v[0], v[1], v[2]); }
+	inline XMMATRIX XMMatrixRotationX(float angle)
+	{
+		float s = std::sin(angle), c = std::cos(angle);
+		return XMMATRIX(1, 0, 0, 0, 0, c, s, 0, 0, -s, c, 0, 0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixRotationY(float angle)
+	{
+		float s = std::sin(angle), c = std::cos(angle);
+		return XMMATRIX(c, 0, -s, 0, 0, 1, 0, 0, s, 0, c, 0, 0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixRotationZ(float angle)
+	{
+		float s = std::sin(angle), c = std::cos(angle);
+		return XMMATRIX(c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixRotationNormal(FXMVECTOR n, float angle)
+	{
+		float s = std::sin(angle), c = std::cos(angle), t = 1.0f - c;
+		float x = n[0], y = n[1], z = n[2];
+		return XMMATRIX(t * x * x + c, t * x * y + s * z, t * x * z - s * y, 0,
+			t * x * y - s * z, t * y * y + c, t * y * z + s * x, 0,
+			t * x * z + s * y, t * y * z - s * x, t * z * z + c, 0,
+			0, 0, 0, 1);
+	}
+	inline XMMATRIX XMMatrixRotationAxis(FXMVECTOR axis, float angle) { return XMMatrixRotationNormal(XMVector3Normalize(axis), angle); }
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		return XMMatrixRotationZ(roll) * XMMatrixRotationX(pitch) * XMMatrixRotationY(yaw);
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR direction, FXMVECTOR up)
+	{
+		auto z = XMVector3Normalize(direction);
+		auto x = XMVector3Normalize(XMVector3Cross(up, z));
+		auto y = XMVector3Cross(z, x);
+		return XMMATRIX(x[0], y[0], z[0], 0, x[1], y[1], z[1], 0, x[2], y[2], z[2], 0,
+			-XMVector3DotScalar(x, eye), -XMVector3DotScalar(y, eye), -XMVector3DotScalar(z, eye), 1);
+	}
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR eye, FXMVECTOR focus, FXMVECTOR up) { return XMMatrixLookToLH(eye, focus - eye, up); }
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+	{
+		float h = 1.0f / std::tan(0.5f * fovY), w = h / aspect, q = farZ / (farZ - nearZ);
+		return XMMATRIX(w, 0, 0, 0, 0, h, 0, 0, 0, 0, q, 1, 0, 0, -q * nearZ, 0);
+	}
+	inline XMMATRIX XMMatrixPerspectiveOffCenterLH(float l, float r, float b, float t, float nearZ, float farZ)
+	{
+		float q = farZ / (farZ - nearZ);
+		return XMMATRIX(2 * nearZ / (r - l), 0, 0, 0, 0, 2 * nearZ / (t - b), 0, 0,
+			-(l + r) / (r - l), -(t + b) / (t - b), q, 1, 0, 0, -q * nearZ, 0);
+	}
+	inline XMMATRIX XMMatrixOrthographicOffCenterLH(float l, float r, float b, float t, float nearZ, float farZ)
+	{
+		float q = 1.0f / (farZ - nearZ);
+		return XMMATRIX(2 / (r - l), 0, 0, 0, 0, 2 / (t - b), 0, 0, 0, 0, q, 0,
+			(l + r) / (l - r), (t + b) / (b - t), -q * nearZ, 1);
+	}
+	inline XMMATRIX XMMatrixOrthographicLH(float width, float height, float nearZ, float farZ)
+	{
+		return XMMatrixOrthographicOffCenterLH(-width / 2, width / 2, -height / 2, height / 2, nearZ, farZ);
+	}
+
+	//Angle mapped to [-pi, pi)
+	inline float XMScalarModAngle(float angle)
+	{
+		angle += XM_PI;
+		angle -= XM_2PI * std::floor(angle * XM_1DIV2PI);
+		return angle - XM_PI;
+	}
+	inline float XMScalarSin(float value) { return std::sin(value); }
+	inline float XMScalarCos(float value) { return std::cos(value); }
+	inline void XMScalarSinCos(float* sin, float* cos, float value) { *sin = std::sin(value); *cos = std::cos(value); }
+}
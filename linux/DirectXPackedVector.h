@@ -0,0 +1,90 @@
+#pragma once
+
+//Stand-in for the packed vector types of DirectXMath used by the vertex layouts
+
+#include <cstdint>
+#include <cstring>
+#include "DirectXMath.h"
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		typedef uint16_t HALF;
+
+		//IEEE 754 binary16 with rounding to nearest even, like the F16C instructions
+		inline HALF XMConvertFloatToHalf(float value)
+		{
+			uint32_t f;
+			memcpy(&f, &value, sizeof(f));
+			uint32_t sign = (f >> 16) & 0x8000;
+			uint32_t magnitude = f & 0x7fffffff;
+			if (magnitude >= 0x7f800000)	//inf or nan
+				return static_cast<HALF>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+			if (magnitude >= 0x477ff000)	//rounds to above the largest half
+				return static_cast<HALF>(sign | 0x7c00);
+			if (magnitude < 0x38800000)	//denormal half
+			{
+				if (magnitude < 0x33000000)
+					return static_cast<HALF>(sign);
+				uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+				uint32_t shift = 126 - (magnitude >> 23);
+				uint32_t half = mantissa >> (shift + 1);
+				uint32_t rest = mantissa & ((2u << shift) - 1);
+				uint32_t halfway = 1u << shift;
+				if (rest > halfway || (rest == halfway && (half & 1)))
+					++half;
+				return static_cast<HALF>(sign | half);
+			}
+			uint32_t rebiased = magnitude - 0x38000000;
+			uint32_t half = rebiased >> 13;
+			uint32_t rest = rebiased & 0x1fff;
+			if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+				++half;
+			return static_cast<HALF>(sign | half);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value)
+		{
+			uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+			uint32_t exponent = (value >> 10) & 0x1f;
+			uint32_t mantissa = value & 0x3ff;
+			uint32_t f;
+			if (exponent == 0x1f)
+				f = sign | 0x7f800000 | (mantissa << 13);
+			else if (exponent != 0)
+				f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+			else if (mantissa == 0)
+				f = sign;
+			else
+			{
+				//normalize the denormal
+				exponent = 113;
+				while (!(mantissa & 0x400))
+				{
+					mantissa <<= 1;
+					--exponent;
+				}
+				f = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+			}
+			float result;
+			memcpy(&result, &f, sizeof(result));
+			return result;
+		}
+
+		struct XMHALF2
+		{
+			HALF x, y;
+		};
+
+		struct XMSHORTN2
+		{
+			int16_t x, y;
+		};
+
+		struct XMUSHORTN4
+		{
+			uint16_t x, y, z, w;
+		};
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+//Stand-in for the parts of the Windows SDK used by the platform independent sources, so they
+//build on Linux for the tests and benchmarks. Files are mapped with mmap (see windows.cpp).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//SAL annotations used in the declarations of the texture loaders
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Outptr_
+#define _Outptr_opt_
+#define _Inout_
+#define _In_reads_(n)
+#define _In_reads_opt_(n)
+#define _In_reads_bytes_(n)
+#define _Out_writes_(n)
+#define _Out_writes_opt_(n)
+#define _Out_writes_bytes_(n)
+#define _Use_decl_annotations_
+
+#define WINAPI
+#define CALLBACK
+#define STDMETHODCALLTYPE
+
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int UINT;
+typedef int INT;
+typedef int BOOL;
+typedef float FLOAT;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int64_t LONGLONG;
+typedef int32_t HRESULT;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+typedef uintptr_t SIZE_T;
+typedef void* HANDLE;
+typedef void* HWND;
+typedef void* HINSTANCE;
+typedef void* HMODULE;
+typedef void* LPVOID;
+typedef wchar_t WCHAR;
+typedef wchar_t* LPWSTR;
+typedef const wchar_t* LPCWSTR;
+typedef const char* LPCSTR;
+
+#define TRUE 1
+#define FALSE 0
+
+struct SIZE
+{
+	LONG cx, cy;
+};
+
+struct RECT
+{
+	LONG left, top, right, bottom;
+};
+
+union LARGE_INTEGER
+{
+	LONGLONG QuadPart;
+};
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2, Data3;
+	uint8_t Data4[8];
+};
+typedef GUID IID;
+typedef const IID& REFIID;
+inline bool operator==(const GUID& a, const GUID& b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& a, const GUID& b) { return !(a == b); }
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+#define E_POINTER ((HRESULT)0x80004003L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define ERROR_FILE_NOT_FOUND 2L
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define INVALID_FILE_ATTRIBUTES ((DWORD)-1)
+#define FILE_ATTRIBUTE_DIRECTORY 0x10
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 0x1
+#define OPEN_EXISTING 3
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x4
+
+#define FORMAT_MESSAGE_ALLOCATE_BUFFER 0x100
+#define FORMAT_MESSAGE_IGNORE_INSERTS 0x200
+#define FORMAT_MESSAGE_FROM_SYSTEM 0x1000
+#define LANG_NEUTRAL 0x00
+#define SUBLANG_DEFAULT 0x01
+#define MAKELANGID(p, s) ((((WORD)(s)) << 10) | (WORD)(p))
+
+inline void ZeroMemory(void* destination, size_t length) { memset(destination, 0, length); }
+
+DWORD GetLastError();
+void SetLastError(DWORD error);
+void OutputDebugStringW(LPCWSTR text);
+DWORD FormatMessageW(DWORD flags, const void* source, DWORD messageId, DWORD languageId, LPWSTR buffer, DWORD size, void* arguments);
+void* LocalFree(void* memory);
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count);
+
+DWORD GetFileAttributesW(LPCWSTR path);
+HANDLE CreateFileW(LPCWSTR path, DWORD access, DWORD shareMode, void* security, DWORD disposition, DWORD flags, HANDLE templateFile);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size);
+HANDLE CreateFileMappingW(HANDLE file, void* security, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCWSTR name);
+void* MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size);
+BOOL UnmapViewOfFile(const void* view);
+BOOL CloseHandle(HANDLE handle);
@@ -0,0 +1,737 @@
+#pragma once
+
+//Stand-in for the Direct3D 11 API declarations used by the platform independent sources.
+//Interfaces only declare the methods those sources call, with the real signatures, so
+//MockDevice and MockContext (mockD3D.h) can implement them. Enumerations keep the real
+//values, so formats written to files match what Windows builds write.
+
+#include <Windows.h>
+#include <cstdint>
+
+#define __uuidof(type) IID_##type
+
+typedef uint8_t UINT8;
+
+//*************************** Enumerations ***************************
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R32_TYPELESS = 39,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R24G8_TYPELESS = 44,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R24_UNORM_X8_TYPELESS = 46,
+	DXGI_FORMAT_R8G8_UNORM = 49,
+	DXGI_FORMAT_R8G8_SNORM = 51,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R8_UNORM = 61,
+	DXGI_FORMAT_A8_UNORM = 65,
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_B5G6R5_UNORM = 85,
+	DXGI_FORMAT_B5G5R5A1_UNORM = 86,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+	DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+	DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91
+};
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ = 10,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ = 12,
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED,
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST = D3D_PRIMITIVE_TOPOLOGY_POINTLIST,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = D3D_PRIMITIVE_TOPOLOGY_LINELIST,
+	D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP = D3D_PRIMITIVE_TOPOLOGY_LINESTRIP,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST_ADJ = D3D_PRIMITIVE_TOPOLOGY_LINELIST_ADJ,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST_ADJ
+};
+typedef D3D_PRIMITIVE_TOPOLOGY D3D11_PRIMITIVE_TOPOLOGY;
+
+enum D3D_DRIVER_TYPE
+{
+	D3D_DRIVER_TYPE_UNKNOWN = 0,
+	D3D_DRIVER_TYPE_HARDWARE = 1,
+	D3D_DRIVER_TYPE_REFERENCE = 2,
+	D3D_DRIVER_TYPE_NULL = 3,
+	D3D_DRIVER_TYPE_SOFTWARE = 4,
+	D3D_DRIVER_TYPE_WARP = 5
+};
+
+enum D3D_FEATURE_LEVEL
+{
+	D3D_FEATURE_LEVEL_10_0 = 0xa000,
+	D3D_FEATURE_LEVEL_10_1 = 0xa100,
+	D3D_FEATURE_LEVEL_11_0 = 0xb000,
+	D3D_FEATURE_LEVEL_11_1 = 0xb100
+};
+
+enum D3D11_USAGE
+{
+	D3D11_USAGE_DEFAULT = 0,
+	D3D11_USAGE_IMMUTABLE = 1,
+	D3D11_USAGE_DYNAMIC = 2,
+	D3D11_USAGE_STAGING = 3
+};
+
+enum D3D11_BIND_FLAG
+{
+	D3D11_BIND_VERTEX_BUFFER = 0x1,
+	D3D11_BIND_INDEX_BUFFER = 0x2,
+	D3D11_BIND_CONSTANT_BUFFER = 0x4,
+	D3D11_BIND_SHADER_RESOURCE = 0x8,
+	D3D11_BIND_STREAM_OUTPUT = 0x10,
+	D3D11_BIND_RENDER_TARGET = 0x20,
+	D3D11_BIND_DEPTH_STENCIL = 0x40,
+	D3D11_BIND_UNORDERED_ACCESS = 0x80
+};
+
+enum D3D11_CPU_ACCESS_FLAG
+{
+	D3D11_CPU_ACCESS_WRITE = 0x10000,
+	D3D11_CPU_ACCESS_READ = 0x20000
+};
+
+enum D3D11_RESOURCE_MISC_FLAG
+{
+	D3D11_RESOURCE_MISC_GENERATE_MIPS = 0x1,
+	D3D11_RESOURCE_MISC_TEXTURECUBE = 0x4,
+	D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS = 0x10,
+	D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS = 0x20,
+	D3D11_RESOURCE_MISC_BUFFER_STRUCTURED = 0x40
+};
+
+enum D3D11_MAP
+{
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1
+};
+
+enum D3D11_BLEND
+{
+	D3D11_BLEND_ZERO = 1,
+	D3D11_BLEND_ONE = 2,
+	D3D11_BLEND_SRC_COLOR = 3,
+	D3D11_BLEND_INV_SRC_COLOR = 4,
+	D3D11_BLEND_SRC_ALPHA = 5,
+	D3D11_BLEND_INV_SRC_ALPHA = 6,
+	D3D11_BLEND_DEST_ALPHA = 7,
+	D3D11_BLEND_INV_DEST_ALPHA = 8,
+	D3D11_BLEND_DEST_COLOR = 9,
+	D3D11_BLEND_INV_DEST_COLOR = 10
+};
+
+enum D3D11_BLEND_OP
+{
+	D3D11_BLEND_OP_ADD = 1,
+	D3D11_BLEND_OP_SUBTRACT = 2,
+	D3D11_BLEND_OP_REV_SUBTRACT = 3,
+	D3D11_BLEND_OP_MIN = 4,
+	D3D11_BLEND_OP_MAX = 5
+};
+
+enum D3D11_COLOR_WRITE_ENABLE
+{
+	D3D11_COLOR_WRITE_ENABLE_RED = 1,
+	D3D11_COLOR_WRITE_ENABLE_GREEN = 2,
+	D3D11_COLOR_WRITE_ENABLE_BLUE = 4,
+	D3D11_COLOR_WRITE_ENABLE_ALPHA = 8,
+	D3D11_COLOR_WRITE_ENABLE_ALL = 15
+};
+
+enum D3D11_COMPARISON_FUNC
+{
+	D3D11_COMPARISON_NEVER = 1,
+	D3D11_COMPARISON_LESS = 2,
+	D3D11_COMPARISON_EQUAL = 3,
+	D3D11_COMPARISON_LESS_EQUAL = 4,
+	D3D11_COMPARISON_GREATER = 5,
+	D3D11_COMPARISON_NOT_EQUAL = 6,
+	D3D11_COMPARISON_GREATER_EQUAL = 7,
+	D3D11_COMPARISON_ALWAYS = 8
+};
+
+enum D3D11_DEPTH_WRITE_MASK
+{
+	D3D11_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D11_DEPTH_WRITE_MASK_ALL = 1
+};
+
+enum D3D11_STENCIL_OP
+{
+	D3D11_STENCIL_OP_KEEP = 1,
+	D3D11_STENCIL_OP_ZERO = 2,
+	D3D11_STENCIL_OP_REPLACE = 3,
+	D3D11_STENCIL_OP_INCR_SAT = 4,
+	D3D11_STENCIL_OP_DECR_SAT = 5,
+	D3D11_STENCIL_OP_INVERT = 6,
+	D3D11_STENCIL_OP_INCR = 7,
+	D3D11_STENCIL_OP_DECR = 8
+};
+
+enum D3D11_FILL_MODE
+{
+	D3D11_FILL_WIREFRAME = 2,
+	D3D11_FILL_SOLID = 3
+};
+
+enum D3D11_CULL_MODE
+{
+	D3D11_CULL_NONE = 1,
+	D3D11_CULL_FRONT = 2,
+	D3D11_CULL_BACK = 3
+};
+
+enum D3D11_FILTER
+{
+	D3D11_FILTER_MIN_MAG_MIP_POINT = 0,
+	D3D11_FILTER_MIN_MAG_MIP_LINEAR = 0x15,
+	D3D11_FILTER_ANISOTROPIC = 0x55,
+	D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT = 0x94,
+	D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR = 0x95
+};
+
+enum D3D11_TEXTURE_ADDRESS_MODE
+{
+	D3D11_TEXTURE_ADDRESS_WRAP = 1,
+	D3D11_TEXTURE_ADDRESS_MIRROR = 2,
+	D3D11_TEXTURE_ADDRESS_CLAMP = 3,
+	D3D11_TEXTURE_ADDRESS_BORDER = 4,
+	D3D11_TEXTURE_ADDRESS_MIRROR_ONCE = 5
+};
+
+enum D3D11_SRV_DIMENSION
+{
+	D3D11_SRV_DIMENSION_UNKNOWN = 0,
+	D3D11_SRV_DIMENSION_BUFFER = 1,
+	D3D11_SRV_DIMENSION_TEXTURE2D = 4,
+	D3D11_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+	D3D11_SRV_DIMENSION_TEXTURECUBE = 9,
+	D3D11_SRV_DIMENSION_BUFFEREX = 11
+};
+
+enum D3D11_UAV_DIMENSION
+{
+	D3D11_UAV_DIMENSION_UNKNOWN = 0,
+	D3D11_UAV_DIMENSION_BUFFER = 1,
+	D3D11_UAV_DIMENSION_TEXTURE2D = 4
+};
+
+enum D3D11_DSV_DIMENSION
+{
+	D3D11_DSV_DIMENSION_UNKNOWN = 0,
+	D3D11_DSV_DIMENSION_TEXTURE2D = 3,
+	D3D11_DSV_DIMENSION_TEXTURE2DARRAY = 4
+};
+
+enum D3D11_RTV_DIMENSION
+{
+	D3D11_RTV_DIMENSION_UNKNOWN = 0,
+	D3D11_RTV_DIMENSION_TEXTURE2D = 4
+};
+
+enum D3D11_BUFFER_UAV_FLAG
+{
+	D3D11_BUFFER_UAV_FLAG_RAW = 0x1,
+	D3D11_BUFFER_UAV_FLAG_APPEND = 0x2,
+	D3D11_BUFFER_UAV_FLAG_COUNTER = 0x4
+};
+
+enum D3D11_CLEAR_FLAG
+{
+	D3D11_CLEAR_DEPTH = 0x1,
+	D3D11_CLEAR_STENCIL = 0x2
+};
+
+enum D3D11_FEATURE
+{
+	D3D11_FEATURE_THREADING = 0,
+	D3D11_FEATURE_DOUBLES = 1,
+	D3D11_FEATURE_D3D11_OPTIONS = 5
+};
+
+enum DXGI_MODE_SCANLINE_ORDER
+{
+	DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED = 0
+};
+
+enum DXGI_MODE_SCALING
+{
+	DXGI_MODE_SCALING_UNSPECIFIED = 0
+};
+
+enum DXGI_SWAP_EFFECT
+{
+	DXGI_SWAP_EFFECT_DISCARD = 0,
+	DXGI_SWAP_EFFECT_SEQUENTIAL = 1
+};
+
+typedef UINT DXGI_USAGE;
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT 0x20UL
+
+#define D3D11_SDK_VERSION 7
+#define D3D11_FLOAT32_MAX 3.402823466e+38f
+#define D3D11_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D11_DEFAULT_STENCIL_WRITE_MASK 0xff
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D11_PS_CS_UAV_REGISTER_COUNT 8
+#define D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION 65535
+#define D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION 16384
+#define D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT 4096
+
+//*************************** Structures ***************************
+
+struct DXGI_RATIONAL
+{
+	UINT Numerator, Denominator;
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count, Quality;
+};
+
+struct DXGI_MODE_DESC
+{
+	UINT Width, Height;
+	DXGI_RATIONAL RefreshRate;
+	DXGI_FORMAT Format;
+	DXGI_MODE_SCANLINE_ORDER ScanlineOrdering;
+	DXGI_MODE_SCALING Scaling;
+};
+
+struct DXGI_SWAP_CHAIN_DESC
+{
+	DXGI_MODE_DESC BufferDesc;
+	DXGI_SAMPLE_DESC SampleDesc;
+	DXGI_USAGE BufferUsage;
+	UINT BufferCount;
+	HWND OutputWindow;
+	BOOL Windowed;
+	DXGI_SWAP_EFFECT SwapEffect;
+	UINT Flags;
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	const char* SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D11_BUFFER_DESC
+{
+	UINT ByteWidth;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+	UINT StructureByteStride;
+};
+
+struct D3D11_TEXTURE2D_DESC
+{
+	UINT Width;
+	UINT Height;
+	UINT MipLevels;
+	UINT ArraySize;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_SUBRESOURCE_DATA
+{
+	const void* pSysMem;
+	UINT SysMemPitch;
+	UINT SysMemSlicePitch;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+	void* pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+
+struct D3D11_BOX
+{
+	UINT left, top, front, right, bottom, back;
+};
+
+struct D3D11_VIEWPORT
+{
+	FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth;
+};
+
+struct D3D11_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	D3D11_BLEND SrcBlend;
+	D3D11_BLEND DestBlend;
+	D3D11_BLEND_OP BlendOp;
+	D3D11_BLEND SrcBlendAlpha;
+	D3D11_BLEND DestBlendAlpha;
+	D3D11_BLEND_OP BlendOpAlpha;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D11_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D11_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+struct D3D11_DEPTH_STENCILOP_DESC
+{
+	D3D11_STENCIL_OP StencilFailOp;
+	D3D11_STENCIL_OP StencilDepthFailOp;
+	D3D11_STENCIL_OP StencilPassOp;
+	D3D11_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D11_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D11_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D11_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D11_DEPTH_STENCILOP_DESC FrontFace;
+	D3D11_DEPTH_STENCILOP_DESC BackFace;
+};
+
+struct D3D11_RASTERIZER_DESC
+{
+	D3D11_FILL_MODE FillMode;
+	D3D11_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL ScissorEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+};
+
+struct D3D11_SAMPLER_DESC
+{
+	D3D11_FILTER Filter;
+	D3D11_TEXTURE_ADDRESS_MODE AddressU;
+	D3D11_TEXTURE_ADDRESS_MODE AddressV;
+	D3D11_TEXTURE_ADDRESS_MODE AddressW;
+	FLOAT MipLODBias;
+	UINT MaxAnisotropy;
+	D3D11_COMPARISON_FUNC ComparisonFunc;
+	FLOAT BorderColor[4];
+	FLOAT MinLOD;
+	FLOAT MaxLOD;
+};
+
+struct D3D11_BUFFER_SRV
+{
+	union
+	{
+		UINT FirstElement;
+		UINT ElementOffset;
+	};
+	union
+	{
+		UINT NumElements;
+		UINT ElementWidth;
+	};
+};
+
+struct D3D11_BUFFEREX_SRV
+{
+	UINT FirstElement, NumElements, Flags;
+};
+
+struct D3D11_TEX2D_SRV
+{
+	UINT MostDetailedMip, MipLevels;
+};
+
+struct D3D11_TEX2D_ARRAY_SRV
+{
+	UINT MostDetailedMip, MipLevels, FirstArraySlice, ArraySize;
+};
+
+struct D3D11_TEXCUBE_SRV
+{
+	UINT MostDetailedMip, MipLevels;
+};
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D11_SRV_DIMENSION ViewDimension;
+	union
+	{
+		D3D11_BUFFER_SRV Buffer;
+		D3D11_BUFFEREX_SRV BufferEx;
+		D3D11_TEX2D_SRV Texture2D;
+		D3D11_TEX2D_ARRAY_SRV Texture2DArray;
+		D3D11_TEXCUBE_SRV TextureCube;
+	};
+};
+
+struct D3D11_BUFFER_UAV
+{
+	UINT FirstElement, NumElements, Flags;
+};
+
+struct D3D11_TEX2D_UAV
+{
+	UINT MipSlice;
+};
+
+struct D3D11_UNORDERED_ACCESS_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D11_UAV_DIMENSION ViewDimension;
+	union
+	{
+		D3D11_BUFFER_UAV Buffer;
+		D3D11_TEX2D_UAV Texture2D;
+	};
+};
+
+struct D3D11_TEX2D_DSV
+{
+	UINT MipSlice;
+};
+
+struct D3D11_TEX2D_ARRAY_DSV
+{
+	UINT MipSlice, FirstArraySlice, ArraySize;
+};
+
+struct D3D11_DEPTH_STENCIL_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D11_DSV_DIMENSION ViewDimension;
+	UINT Flags;
+	union
+	{
+		D3D11_TEX2D_DSV Texture2D;
+		D3D11_TEX2D_ARRAY_DSV Texture2DArray;
+	};
+};
+
+struct D3D11_TEX2D_RTV
+{
+	UINT MipSlice;
+};
+
+struct D3D11_RENDER_TARGET_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D11_RTV_DIMENSION ViewDimension;
+	union
+	{
+		D3D11_TEX2D_RTV Texture2D;
+	};
+};
+
+struct D3D11_FEATURE_DATA_D3D11_OPTIONS
+{
+	BOOL OutputMergerLogicOp;
+	BOOL UAVOnlyRenderingForcedSampleCount;
+	BOOL DiscardAPIsSeenByDriver;
+	BOOL FlagsForUpdateAndCopySeenByDriver;
+	BOOL ClearView;
+	BOOL CopyWithOverlap;
+	BOOL ConstantBufferPartialUpdate;
+	BOOL ConstantBufferOffsetting;
+	BOOL MapNoOverwriteOnDynamicConstantBuffer;
+	BOOL MapNoOverwriteOnDynamicBufferSRV;
+	BOOL MultisampleRTVWithForcedSampleCountOne;
+	BOOL SAD4ShaderInstructions;
+	BOOL ExtendedDoublesShaderInstructions;
+	BOOL ExtendedResourceSharing;
+};
+
+//*************************** Interfaces ***************************
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** object) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+protected:
+	~IUnknown() = default;
+};
+
+struct ID3D11DeviceChild : IUnknown { };
+struct ID3D11Resource : ID3D11DeviceChild { };
+
+struct ID3D11Buffer : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_BUFFER_DESC* desc) = 0;
+};
+
+struct ID3D11Texture2D : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_TEXTURE2D_DESC* desc) = 0;
+};
+
+struct ID3D11View : ID3D11DeviceChild
+{
+	virtual void GetResource(ID3D11Resource** resource) = 0;
+};
+
+struct ID3D11ShaderResourceView : ID3D11View { };
+struct ID3D11UnorderedAccessView : ID3D11View { };
+struct ID3D11RenderTargetView : ID3D11View { };
+struct ID3D11DepthStencilView : ID3D11View { };
+
+struct ID3D11VertexShader : ID3D11DeviceChild { };
+struct ID3D11GeometryShader : ID3D11DeviceChild { };
+struct ID3D11PixelShader : ID3D11DeviceChild { };
+struct ID3D11ComputeShader : ID3D11DeviceChild { };
+struct ID3D11InputLayout : ID3D11DeviceChild { };
+struct ID3D11BlendState : ID3D11DeviceChild { };
+struct ID3D11DepthStencilState : ID3D11DeviceChild { };
+struct ID3D11RasterizerState : ID3D11DeviceChild { };
+struct ID3D11SamplerState : ID3D11DeviceChild { };
+struct ID3D11ClassInstance : ID3D11DeviceChild { };
+struct ID3D11ClassLinkage : ID3D11DeviceChild { };
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+	virtual void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) = 0;
+	virtual void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+	virtual void VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) = 0;
+	virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) = 0;
+	virtual void Draw(UINT vertexCount, UINT startVertex) = 0;
+	virtual HRESULT Map(ID3D11Resource* resource, UINT subresource, D3D11_MAP type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) = 0;
+	virtual void Unmap(ID3D11Resource* resource, UINT subresource) = 0;
+	virtual void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) = 0;
+	virtual void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) = 0;
+	virtual void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance) = 0;
+	virtual void GSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void GSSetShader(ID3D11GeometryShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) = 0;
+	virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+	virtual void VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+	virtual void VSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+	virtual void OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthStencil) = 0;
+	virtual void OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask) = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) = 0;
+	virtual void DrawInstancedIndirect(ID3D11Buffer* args, UINT offset) = 0;
+	virtual void Dispatch(UINT x, UINT y, UINT z) = 0;
+	virtual void DispatchIndirect(ID3D11Buffer* args, UINT offset) = 0;
+	virtual void RSSetState(ID3D11RasterizerState* state) = 0;
+	virtual void RSSetViewports(UINT count, const D3D11_VIEWPORT* viewports) = 0;
+	virtual void CopyResource(ID3D11Resource* destination, ID3D11Resource* source) = 0;
+	virtual void UpdateSubresource(ID3D11Resource* destination, UINT subresource, const D3D11_BOX* box, const void* data,
+		UINT rowPitch, UINT depthPitch) = 0;
+	virtual void CopyStructureCount(ID3D11Buffer* destination, UINT offset, ID3D11UnorderedAccessView* source) = 0;
+	virtual void ClearRenderTargetView(ID3D11RenderTargetView* view, const FLOAT color[4]) = 0;
+	virtual void ClearDepthStencilView(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) = 0;
+	virtual void GenerateMips(ID3D11ShaderResourceView* view) = 0;
+	virtual void CSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) = 0;
+	virtual void CSSetUnorderedAccessViews(UINT startSlot, UINT count, ID3D11UnorderedAccessView* const* views, const UINT* initialCounts) = 0;
+	virtual void CSSetShader(ID3D11ComputeShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) = 0;
+	virtual void CSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void ClearState() = 0;
+	virtual void Flush() = 0;
+};
+
+struct ID3D11Device : IUnknown
+{
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) = 0;
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) = 0;
+	virtual HRESULT CreateShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc,
+		ID3D11ShaderResourceView** view) = 0;
+	virtual HRESULT CreateUnorderedAccessView(ID3D11Resource* resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC* desc,
+		ID3D11UnorderedAccessView** view) = 0;
+	virtual HRESULT CreateRenderTargetView(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc,
+		ID3D11RenderTargetView** view) = 0;
+	virtual HRESULT CreateDepthStencilView(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc,
+		ID3D11DepthStencilView** view) = 0;
+	virtual HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, UINT count, const void* byteCode,
+		SIZE_T byteCodeLength, ID3D11InputLayout** layout) = 0;
+	virtual HRESULT CreateVertexShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11VertexShader** shader) = 0;
+	virtual HRESULT CreateGeometryShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11GeometryShader** shader) = 0;
+	virtual HRESULT CreatePixelShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11PixelShader** shader) = 0;
+	virtual HRESULT CreateComputeShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11ComputeShader** shader) = 0;
+	virtual HRESULT CreateBlendState(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) = 0;
+	virtual HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) = 0;
+	virtual HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) = 0;
+	virtual HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) = 0;
+	virtual HRESULT CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT size) = 0;
+	virtual void GetImmediateContext(ID3D11DeviceContext** context) = 0;
+};
+
+struct IDXGIAdapter : IUnknown { };
+
+struct IDXGISwapChain : IUnknown
+{
+	virtual HRESULT Present(UINT syncInterval, UINT flags) = 0;
+	virtual HRESULT GetBuffer(UINT buffer, REFIID riid, void** surface) = 0;
+};
+
+inline constexpr GUID IID_IUnknown = { 0x00000000, 0x0000, 0x0000, { 0xc0, 0, 0, 0, 0, 0, 0, 0x46 } };
+inline constexpr GUID IID_ID3D11Resource = { 0xdc8e63f3, 0xd12b, 0x4952, { 0xb4, 0x7b, 0x5e, 0x45, 0x02, 0x6a, 0x86, 0x2d } };
+inline constexpr GUID IID_ID3D11Buffer = { 0x48570b85, 0xd1ee, 0x4fcd, { 0xa2, 0x50, 0xeb, 0x35, 0x07, 0x22, 0xb0, 0x37 } };
+inline constexpr GUID IID_ID3D11Texture2D = { 0x6f15aaf2, 0xd208, 0x4e89, { 0x9a, 0xb4, 0x48, 0x95, 0x35, 0xd3, 0x4f, 0x9c } };
+inline constexpr GUID IID_ID3D11DeviceContext = { 0xc0bfa96c, 0xe089, 0x44fb, { 0x8e, 0xaf, 0x26, 0xf8, 0x79, 0x61, 0x90, 0xda } };
+
+HRESULT D3D11CreateDeviceAndSwapChain(IDXGIAdapter* adapter, D3D_DRIVER_TYPE driverType, HMODULE software, UINT flags,
+	const D3D_FEATURE_LEVEL* featureLevels, UINT featureLevelCount, UINT sdkVersion, const DXGI_SWAP_CHAIN_DESC* swapChainDesc,
+	IDXGISwapChain** swapChain, ID3D11Device** device, D3D_FEATURE_LEVEL* featureLevel, ID3D11DeviceContext** context);
@@ -0,0 +1,19 @@
+#pragma once
+
+//Stand-in for the Direct3D 11.1 additions used by the platform independent sources
+
+#include <d3d11.h>
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+	virtual void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+		const UINT* firstConstant, const UINT* constantCount) = 0;
+	virtual void GSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+		const UINT* firstConstant, const UINT* constantCount) = 0;
+	virtual void PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+		const UINT* firstConstant, const UINT* constantCount) = 0;
+	virtual void CSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+		const UINT* firstConstant, const UINT* constantCount) = 0;
+};
+
+inline constexpr GUID IID_ID3D11DeviceContext1 = { 0xbb2c6faa, 0xb5fb, 0x4082, { 0x8e, 0x6b, 0x38, 0x8b, 0x8c, 0xfa, 0x90, 0xe1 } };
@@ -0,0 +1,599 @@
+#include "mockD3D.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace mini::mock;
+
+Buffer::Buffer(const D3D11_BUFFER_DESC& desc, const void* initialData)
+	: m_desc(desc), m_data(desc.ByteWidth), m_initialData(initialData)
+{
+	if (initialData)
+		memcpy(m_data.data(), initialData, m_data.size());
+}
+
+HRESULT Buffer::QueryInterface(REFIID riid, void** object)
+{
+	if (riid == IID_ID3D11Buffer || riid == IID_ID3D11Resource)
+	{
+		AddRef();
+		*object = static_cast<ID3D11Buffer*>(this);
+		return S_OK;
+	}
+	return Object::QueryInterface(riid, object);
+}
+
+Buffer* mini::mock::NewConstantBuffer(UINT size)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = size;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	return new Buffer(desc);
+}
+
+UINT mini::mock::BytesPerPixel(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+		return 12;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R32G32_FLOAT:
+		return 8;
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R32_TYPELESS:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R24G8_TYPELESS:
+	case DXGI_FORMAT_D24_UNORM_S8_UINT:
+	case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		return 4;
+	case DXGI_FORMAT_R8G8_UNORM:
+	case DXGI_FORMAT_R8G8_SNORM:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_UINT:
+	case DXGI_FORMAT_B5G6R5_UNORM:
+	case DXGI_FORMAT_B5G5R5A1_UNORM:
+		return 2;
+	case DXGI_FORMAT_R8_UNORM:
+	case DXGI_FORMAT_A8_UNORM:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+Texture2D::Texture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData)
+	: m_desc(desc)
+{
+	//zero mip levels asks for the full chain
+	if (m_desc.MipLevels == 0)
+		for (auto size = max(m_desc.Width, m_desc.Height); size > 0; size >>= 1)
+			++m_desc.MipLevels;
+	if (m_desc.ArraySize == 0)
+		m_desc.ArraySize = 1;
+	if (BytesPerPixel(m_desc.Format) == 0)
+		return;
+	m_subresources.resize(m_desc.MipLevels * m_desc.ArraySize);
+	for (UINT i = 0; i < m_subresources.size(); ++i)
+	{
+		auto mip = i % m_desc.MipLevels;
+		auto pitch = rowPitch(mip);
+		auto height = max(m_desc.Height >> mip, 1u);
+		m_subresources[i].resize(static_cast<size_t>(pitch) * height);
+		if (!initialData)
+			continue;
+		for (UINT y = 0; y < height; ++y)
+			memcpy(m_subresources[i].data() + static_cast<size_t>(y) * pitch,
+				static_cast<const BYTE*>(initialData[i].pSysMem) + static_cast<size_t>(y) * initialData[i].SysMemPitch, pitch);
+	}
+}
+
+HRESULT Texture2D::QueryInterface(REFIID riid, void** object)
+{
+	if (riid == IID_ID3D11Texture2D || riid == IID_ID3D11Resource)
+	{
+		AddRef();
+		*object = static_cast<ID3D11Texture2D*>(this);
+		return S_OK;
+	}
+	return Object::QueryInterface(riid, object);
+}
+
+UINT Texture2D::rowPitch(UINT mip) const
+{
+	return max(m_desc.Width >> mip, 1u) * BytesPerPixel(m_desc.Format);
+}
+
+size_t Context::Count(const string& name) const
+{
+	return count_if(m_log.begin(), m_log.end(), [&name](const Call& c) { return c.name == name; });
+}
+
+HRESULT Context::QueryInterface(REFIID riid, void** object)
+{
+	if (riid == IID_ID3D11DeviceContext || (m_context1 && riid == IID_ID3D11DeviceContext1))
+	{
+		AddRef();
+		*object = static_cast<ID3D11DeviceContext1*>(this);
+		return S_OK;
+	}
+	return Object::QueryInterface(riid, object);
+}
+
+void Context::Record(const char* name, vector<const void*> objects, vector<UINT> values)
+{
+	m_log.push_back({ name, move(objects), move(values) });
+}
+
+template<typename T>
+void Context::RecordSlots(const char* name, UINT startSlot, UINT count, T* const* objects)
+{
+	Record(name, vector<const void*>(objects, objects + count), { startSlot, count });
+}
+
+void Context::RecordSlots1(const char* name, UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+	const UINT* firstConstant, const UINT* constantCount)
+{
+	//values hold the slot range followed by first constant and constant count of every buffer
+	vector<UINT> values = { startSlot, count };
+	for (UINT i = 0; i < count; ++i)
+	{
+		values.push_back(firstConstant ? firstConstant[i] : 0);
+		values.push_back(constantCount ? constantCount[i] : 0);
+	}
+	Record(name, vector<const void*>(buffers, buffers + count), move(values));
+}
+
+void Context::VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	RecordSlots("VSSetConstantBuffers", startSlot, count, buffers);
+}
+
+void Context::PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+	RecordSlots("PSSetShaderResources", startSlot, count, views);
+}
+
+void Context::PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const*, UINT)
+{
+	Record("PSSetShader", { shader });
+}
+
+void Context::PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+{
+	RecordSlots("PSSetSamplers", startSlot, count, samplers);
+}
+
+void Context::VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const*, UINT)
+{
+	Record("VSSetShader", { shader });
+}
+
+void Context::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+	Record("DrawIndexed", {}, { indexCount, startIndex, static_cast<UINT>(baseVertex) });
+}
+
+void Context::Draw(UINT vertexCount, UINT startVertex)
+{
+	Record("Draw", {}, { vertexCount, startVertex });
+}
+
+HRESULT Context::Map(ID3D11Resource* resource, UINT subresource, D3D11_MAP type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped)
+{
+	Record("Map", { resource }, { subresource, static_cast<UINT>(type), flags });
+	if (FAILED(m_mapResult))
+		return m_mapResult;
+	if (auto buffer = dynamic_cast<Buffer*>(resource))
+	{
+		mapped->pData = buffer->data().data();
+		mapped->RowPitch = mapped->DepthPitch = static_cast<UINT>(buffer->data().size());
+		return S_OK;
+	}
+	auto texture = dynamic_cast<Texture2D*>(resource);
+	if (!texture || subresource >= texture->subresources().size())
+		return E_INVALIDARG;
+	auto& data = texture->subresources()[subresource];
+	mapped->pData = data.data();
+	mapped->RowPitch = texture->rowPitch(subresource % texture->desc().MipLevels);
+	mapped->DepthPitch = static_cast<UINT>(data.size());
+	return S_OK;
+}
+
+void Context::Unmap(ID3D11Resource* resource, UINT subresource)
+{
+	Record("Unmap", { resource }, { subresource });
+}
+
+void Context::PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	RecordSlots("PSSetConstantBuffers", startSlot, count, buffers);
+}
+
+void Context::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	Record("IASetInputLayout", { layout });
+}
+
+void Context::IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+{
+	vector<UINT> values = { startSlot, count };
+	for (UINT i = 0; i < count; ++i)
+	{
+		values.push_back(strides[i]);
+		values.push_back(offsets[i]);
+	}
+	Record("IASetVertexBuffers", vector<const void*>(buffers, buffers + count), move(values));
+}
+
+void Context::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+{
+	Record("IASetIndexBuffer", { buffer }, { static_cast<UINT>(format), offset });
+}
+
+void Context::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance)
+{
+	Record("DrawIndexedInstanced", {}, { indexCount, instanceCount, startIndex, static_cast<UINT>(baseVertex), startInstance });
+}
+
+void Context::DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance)
+{
+	Record("DrawInstanced", {}, { vertexCount, instanceCount, startVertex, startInstance });
+}
+
+void Context::GSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	RecordSlots("GSSetConstantBuffers", startSlot, count, buffers);
+}
+
+void Context::GSSetShader(ID3D11GeometryShader* shader, ID3D11ClassInstance* const*, UINT)
+{
+	Record("GSSetShader", { shader });
+}
+
+void Context::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	Record("IASetPrimitiveTopology", {}, { static_cast<UINT>(topology) });
+}
+
+void Context::VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+	RecordSlots("VSSetShaderResources", startSlot, count, views);
+}
+
+void Context::VSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+{
+	RecordSlots("VSSetSamplers", startSlot, count, samplers);
+}
+
+void Context::OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthStencil)
+{
+	vector<const void*> objects(views, views + count);
+	objects.push_back(depthStencil);
+	Record("OMSetRenderTargets", move(objects), { count });
+}
+
+void Context::OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask)
+{
+	Record("OMSetBlendState", { state, blendFactor }, { sampleMask });
+}
+
+void Context::OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+{
+	Record("OMSetDepthStencilState", { state }, { stencilRef });
+}
+
+void Context::DrawInstancedIndirect(ID3D11Buffer* args, UINT offset)
+{
+	Record("DrawInstancedIndirect", { args }, { offset });
+}
+
+void Context::Dispatch(UINT x, UINT y, UINT z)
+{
+	Record("Dispatch", {}, { x, y, z });
+}
+
+void Context::DispatchIndirect(ID3D11Buffer* args, UINT offset)
+{
+	Record("DispatchIndirect", { args }, { offset });
+}
+
+void Context::RSSetState(ID3D11RasterizerState* state)
+{
+	Record("RSSetState", { state });
+}
+
+void Context::RSSetViewports(UINT count, const D3D11_VIEWPORT*)
+{
+	Record("RSSetViewports", {}, { count });
+}
+
+void Context::CopyResource(ID3D11Resource* destination, ID3D11Resource* source)
+{
+	Record("CopyResource", { destination, source });
+	auto to = dynamic_cast<Buffer*>(destination);
+	auto from = dynamic_cast<Buffer*>(source);
+	if (to && from)
+		copy_n(from->data().begin(), min(to->data().size(), from->data().size()), to->data().begin());
+	auto toTexture = dynamic_cast<Texture2D*>(destination);
+	auto fromTexture = dynamic_cast<Texture2D*>(source);
+	if (toTexture && fromTexture && toTexture->subresources().size() == fromTexture->subresources().size())
+		toTexture->subresources() = fromTexture->subresources();
+}
+
+void Context::UpdateSubresource(ID3D11Resource* destination, UINT subresource, const D3D11_BOX* box, const void* data,
+	UINT, UINT)
+{
+	Record("UpdateSubresource", { destination }, { subresource });
+	if (auto buffer = dynamic_cast<Buffer*>(destination))
+	{
+		UINT offset = box ? box->left : 0;
+		UINT size = box ? box->right - box->left : static_cast<UINT>(buffer->data().size());
+		memcpy(buffer->data().data() + offset, data, size);
+	}
+}
+
+void Context::CopyStructureCount(ID3D11Buffer* destination, UINT offset, ID3D11UnorderedAccessView* source)
+{
+	Record("CopyStructureCount", { destination, source }, { offset });
+}
+
+void Context::ClearRenderTargetView(ID3D11RenderTargetView* view, const FLOAT*)
+{
+	Record("ClearRenderTargetView", { view });
+}
+
+void Context::ClearDepthStencilView(ID3D11DepthStencilView* view, UINT flags, FLOAT, UINT8 stencil)
+{
+	Record("ClearDepthStencilView", { view }, { flags, stencil });
+}
+
+void Context::GenerateMips(ID3D11ShaderResourceView* view)
+{
+	Record("GenerateMips", { view });
+}
+
+void Context::CSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views)
+{
+	RecordSlots("CSSetShaderResources", startSlot, count, views);
+}
+
+void Context::CSSetUnorderedAccessViews(UINT startSlot, UINT count, ID3D11UnorderedAccessView* const* views, const UINT* initialCounts)
+{
+	vector<UINT> values = { startSlot, count };
+	for (UINT i = 0; i < count; ++i)
+		values.push_back(initialCounts ? initialCounts[i] : ~0u);
+	Record("CSSetUnorderedAccessViews", vector<const void*>(views, views + count), move(values));
+}
+
+void Context::CSSetShader(ID3D11ComputeShader* shader, ID3D11ClassInstance* const*, UINT)
+{
+	Record("CSSetShader", { shader });
+}
+
+void Context::CSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers)
+{
+	RecordSlots("CSSetConstantBuffers", startSlot, count, buffers);
+}
+
+void Context::ClearState()
+{
+	Record("ClearState", {});
+}
+
+void Context::Flush()
+{
+	Record("Flush", {});
+}
+
+void Context::VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+	const UINT* firstConstant, const UINT* constantCount)
+{
+	RecordSlots1("VSSetConstantBuffers1", startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void Context::GSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+	const UINT* firstConstant, const UINT* constantCount)
+{
+	RecordSlots1("GSSetConstantBuffers1", startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void Context::PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+	const UINT* firstConstant, const UINT* constantCount)
+{
+	RecordSlots1("PSSetConstantBuffers1", startSlot, count, buffers, firstConstant, constantCount);
+}
+
+void Context::CSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+	const UINT* firstConstant, const UINT* constantCount)
+{
+	RecordSlots1("CSSetConstantBuffers1", startSlot, count, buffers, firstConstant, constantCount);
+}
+
+DeviceOptions& mini::mock::NextDevice()
+{
+	static DeviceOptions options;
+	return options;
+}
+
+Device::Device(const DeviceOptions& options)
+	: m_options(options), m_context(new Context(options.context1))
+{ }
+
+Device::~Device()
+{
+	m_context->Release();
+}
+
+size_t Device::Count(const string& method) const
+{
+	return count(m_created.begin(), m_created.end(), method);
+}
+
+template<typename T, typename Interface>
+HRESULT Device::Create(const char* method, T* object, Interface** result)
+{
+	m_created.push_back(method);
+	*result = object;
+	return S_OK;
+}
+
+HRESULT Device::CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer)
+{
+	return Create("CreateBuffer", new Buffer(*desc, data ? data->pSysMem : nullptr), buffer);
+}
+
+HRESULT Device::CreateTexture2D(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture)
+{
+	return Create("CreateTexture2D", new Texture2D(*desc, data), texture);
+}
+
+HRESULT Device::CreateShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC*,
+	ID3D11ShaderResourceView** view)
+{
+	return Create("CreateShaderResourceView", new ShaderResourceView(resource), view);
+}
+
+HRESULT Device::CreateUnorderedAccessView(ID3D11Resource* resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC*,
+	ID3D11UnorderedAccessView** view)
+{
+	return Create("CreateUnorderedAccessView", new UnorderedAccessView(resource), view);
+}
+
+HRESULT Device::CreateRenderTargetView(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC*,
+	ID3D11RenderTargetView** view)
+{
+	return Create("CreateRenderTargetView", new RenderTargetView(resource), view);
+}
+
+HRESULT Device::CreateDepthStencilView(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC*,
+	ID3D11DepthStencilView** view)
+{
+	return Create("CreateDepthStencilView", new DepthStencilView(resource), view);
+}
+
+HRESULT Device::CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, UINT, const void*, SIZE_T, ID3D11InputLayout** layout)
+{
+	return Create("CreateInputLayout", new InputLayout, layout);
+}
+
+HRESULT Device::CreateVertexShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage*, ID3D11VertexShader** shader)
+{
+	return Create("CreateVertexShader", new VertexShader(byteCode, length), shader);
+}
+
+HRESULT Device::CreateGeometryShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage*, ID3D11GeometryShader** shader)
+{
+	return Create("CreateGeometryShader", new GeometryShader(byteCode, length), shader);
+}
+
+HRESULT Device::CreatePixelShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage*, ID3D11PixelShader** shader)
+{
+	return Create("CreatePixelShader", new PixelShader(byteCode, length), shader);
+}
+
+HRESULT Device::CreateComputeShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage*, ID3D11ComputeShader** shader)
+{
+	return Create("CreateComputeShader", new ComputeShader(byteCode, length), shader);
+}
+
+HRESULT Device::CreateBlendState(const D3D11_BLEND_DESC*, ID3D11BlendState** state)
+{
+	return Create("CreateBlendState", new BlendState, state);
+}
+
+HRESULT Device::CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC*, ID3D11DepthStencilState** state)
+{
+	return Create("CreateDepthStencilState", new DepthStencilState, state);
+}
+
+HRESULT Device::CreateRasterizerState(const D3D11_RASTERIZER_DESC*, ID3D11RasterizerState** state)
+{
+	return Create("CreateRasterizerState", new RasterizerState, state);
+}
+
+HRESULT Device::CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState** state)
+{
+	return Create("CreateSamplerState", new SamplerState, state);
+}
+
+HRESULT Device::CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT size)
+{
+	if (feature != D3D11_FEATURE_D3D11_OPTIONS || size != sizeof(D3D11_FEATURE_DATA_D3D11_OPTIONS))
+		return E_INVALIDARG;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	options.ConstantBufferOffsetting = m_options.constantBufferOffsetting;
+	options.MapNoOverwriteOnDynamicConstantBuffer = m_options.mapNoOverwriteOnDynamicConstantBuffer;
+	memcpy(data, &options, size);
+	return S_OK;
+}
+
+void Device::GetImmediateContext(ID3D11DeviceContext** context)
+{
+	m_context->AddRef();
+	*context = m_context;
+}
+
+SwapChain::SwapChain(const DXGI_SWAP_CHAIN_DESC& desc)
+{
+	D3D11_TEXTURE2D_DESC bufferDesc = {};
+	bufferDesc.Width = desc.BufferDesc.Width;
+	bufferDesc.Height = desc.BufferDesc.Height;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.ArraySize = 1;
+	bufferDesc.Format = desc.BufferDesc.Format;
+	bufferDesc.SampleDesc = desc.SampleDesc;
+	bufferDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+	m_backBuffer = new Texture2D(bufferDesc);
+}
+
+SwapChain::~SwapChain()
+{
+	m_backBuffer->Release();
+}
+
+HRESULT SwapChain::Present(UINT, UINT)
+{
+	++m_presented;
+	return S_OK;
+}
+
+HRESULT SwapChain::GetBuffer(UINT, REFIID riid, void** surface)
+{
+	return m_backBuffer->QueryInterface(riid, surface);
+}
+
+HRESULT D3D11CreateDeviceAndSwapChain(IDXGIAdapter*, D3D_DRIVER_TYPE, HMODULE, UINT, const D3D_FEATURE_LEVEL*, UINT, UINT,
+	const DXGI_SWAP_CHAIN_DESC* swapChainDesc, IDXGISwapChain** swapChain, ID3D11Device** device,
+	D3D_FEATURE_LEVEL* featureLevel, ID3D11DeviceContext** context)
+{
+	auto d = new Device(NextDevice());
+	if (swapChain)
+		*swapChain = new SwapChain(*swapChainDesc);
+	if (context)
+		d->GetImmediateContext(context);
+	if (featureLevel)
+		*featureLevel = D3D_FEATURE_LEVEL_11_1;
+	if (device)
+		*device = d;
+	else
+		d->Release();
+	return S_OK;
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <d3d11_1.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+//Recording stand-ins for the Direct3D objects, used by the tests in place of a real device
+
+namespace mini
+{
+	namespace mock
+	{
+		//Reference counted object deleted on the last Release, like the runtime's
+		template<typename Interface>
+		class Object : public Interface
+		{
+		public:
+			HRESULT QueryInterface(REFIID riid, void** object) override
+			{
+				if (riid == IID_IUnknown)
+				{
+					AddRef();
+					*object = this;
+					return S_OK;
+				}
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+			ULONG AddRef() override { return ++m_refs; }
+			ULONG Release() override
+			{
+				auto refs = --m_refs;
+				if (refs == 0)
+					delete this;
+				return refs;
+			}
+			//Current reference count without changing it
+			ULONG refs() const { return m_refs; }
+
+		protected:
+			virtual ~Object() = default;
+
+		private:
+			std::atomic<ULONG> m_refs{ 1 };
+		};
+
+		//Shader keeping the byte code it was created from, so tests can tell shaders apart
+		template<typename Interface>
+		class Shader : public Object<Interface>
+		{
+		public:
+			Shader() = default;
+			Shader(const void* byteCode, SIZE_T length)
+				: m_byteCode(static_cast<const BYTE*>(byteCode), static_cast<const BYTE*>(byteCode) + length) { }
+
+			const std::vector<BYTE>& byteCode() const { return m_byteCode; }
+
+		private:
+			std::vector<BYTE> m_byteCode;
+		};
+
+		using VertexShader = Shader<ID3D11VertexShader>;
+		using GeometryShader = Shader<ID3D11GeometryShader>;
+		using PixelShader = Shader<ID3D11PixelShader>;
+		using ComputeShader = Shader<ID3D11ComputeShader>;
+		using InputLayout = Object<ID3D11InputLayout>;
+		using BlendState = Object<ID3D11BlendState>;
+		using DepthStencilState = Object<ID3D11DepthStencilState>;
+		using RasterizerState = Object<ID3D11RasterizerState>;
+		using SamplerState = Object<ID3D11SamplerState>;
+
+		//Buffer with CPU memory behind it, so that Map and UpdateSubresource can be checked
+		class Buffer : public Object<ID3D11Buffer>
+		{
+		public:
+			explicit Buffer(const D3D11_BUFFER_DESC& desc, const void* initialData = nullptr);
+
+			HRESULT QueryInterface(REFIID riid, void** object) override;
+			void GetDesc(D3D11_BUFFER_DESC* desc) override { *desc = m_desc; }
+
+			const D3D11_BUFFER_DESC& desc() const { return m_desc; }
+			std::vector<BYTE>& data() { return m_data; }
+			//memory the buffer was created from, null without initial data
+			const void* initialData() const { return m_initialData; }
+
+		private:
+			D3D11_BUFFER_DESC m_desc;
+			std::vector<BYTE> m_data;
+			const void* m_initialData;
+		};
+
+		//Creates a buffer of the given size, bound as a constant buffer and writable by the CPU
+		Buffer* NewConstantBuffer(UINT size);
+
+		//Texture with CPU memory for every mip of uncompressed formats, rows tightly packed
+		class Texture2D : public Object<ID3D11Texture2D>
+		{
+		public:
+			explicit Texture2D(const D3D11_TEXTURE2D_DESC& desc, const D3D11_SUBRESOURCE_DATA* initialData = nullptr);
+
+			HRESULT QueryInterface(REFIID riid, void** object) override;
+			void GetDesc(D3D11_TEXTURE2D_DESC* desc) override { *desc = m_desc; }
+
+			const D3D11_TEXTURE2D_DESC& desc() const { return m_desc; }
+			//Bytes of a row of the given mip, 0 for formats without CPU memory
+			UINT rowPitch(UINT mip) const;
+			std::vector<std::vector<BYTE>>& subresources() { return m_subresources; }
+
+		private:
+			D3D11_TEXTURE2D_DESC m_desc;
+			std::vector<std::vector<BYTE>> m_subresources;
+		};
+
+		//Size of a pixel of uncompressed formats, 0 for the others
+		UINT BytesPerPixel(DXGI_FORMAT format);
+
+		//View keeping a reference to the resource it was created for
+		template<typename Interface>
+		class View : public Object<Interface>
+		{
+		public:
+			explicit View(ID3D11Resource* resource) : m_resource(resource) { if (m_resource) m_resource->AddRef(); }
+
+			void GetResource(ID3D11Resource** resource) override
+			{
+				if (m_resource)
+					m_resource->AddRef();
+				*resource = m_resource;
+			}
+			//The resource without adding a reference
+			ID3D11Resource* resource() const { return m_resource; }
+
+		protected:
+			~View() override { if (m_resource) m_resource->Release(); }
+
+		private:
+			ID3D11Resource* m_resource;
+		};
+
+		using ShaderResourceView = View<ID3D11ShaderResourceView>;
+		using UnorderedAccessView = View<ID3D11UnorderedAccessView>;
+		using RenderTargetView = View<ID3D11RenderTargetView>;
+		using DepthStencilView = View<ID3D11DepthStencilView>;
+
+		//Immediate context that records the calls made on it. Binding calls are logged with the
+		//objects bound and their other arguments, so that tests can compare what reached the device.
+		class Context : public Object<ID3D11DeviceContext1>
+		{
+		public:
+			struct Call
+			{
+				std::string name;
+				std::vector<const void*> objects;
+				std::vector<UINT> values;
+			};
+
+			//Without the 11.1 interface QueryInterface fails like on a Direct3D 11.0 runtime
+			explicit Context(bool context1 = true) : m_context1(context1) { }
+
+			const std::vector<Call>& log() const { return m_log; }
+			void ClearLog() { m_log.clear(); }
+			//Number of logged calls with the given name
+			size_t Count(const std::string& name) const;
+			//Makes every following Map fail with the given result
+			void FailMaps(HRESULT result) { m_mapResult = result; }
+
+			HRESULT QueryInterface(REFIID riid, void** object) override;
+
+			void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) override;
+			void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) override;
+			void PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) override;
+			void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) override;
+			void VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) override;
+			void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+			void Draw(UINT vertexCount, UINT startVertex) override;
+			HRESULT Map(ID3D11Resource* resource, UINT subresource, D3D11_MAP type, UINT flags, D3D11_MAPPED_SUBRESOURCE* mapped) override;
+			void Unmap(ID3D11Resource* resource, UINT subresource) override;
+			void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) override;
+			void IASetInputLayout(ID3D11InputLayout* layout) override;
+			void IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+			void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+			void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) override;
+			void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance) override;
+			void GSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) override;
+			void GSSetShader(ID3D11GeometryShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) override;
+			void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+			void VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) override;
+			void VSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) override;
+			void OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* views, ID3D11DepthStencilView* depthStencil) override;
+			void OMSetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask) override;
+			void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) override;
+			void DrawInstancedIndirect(ID3D11Buffer* args, UINT offset) override;
+			void Dispatch(UINT x, UINT y, UINT z) override;
+			void DispatchIndirect(ID3D11Buffer* args, UINT offset) override;
+			void RSSetState(ID3D11RasterizerState* state) override;
+			void RSSetViewports(UINT count, const D3D11_VIEWPORT* viewports) override;
+			void CopyResource(ID3D11Resource* destination, ID3D11Resource* source) override;
+			void UpdateSubresource(ID3D11Resource* destination, UINT subresource, const D3D11_BOX* box, const void* data,
+				UINT rowPitch, UINT depthPitch) override;
+			void CopyStructureCount(ID3D11Buffer* destination, UINT offset, ID3D11UnorderedAccessView* source) override;
+			void ClearRenderTargetView(ID3D11RenderTargetView* view, const FLOAT color[4]) override;
+			void ClearDepthStencilView(ID3D11DepthStencilView* view, UINT flags, FLOAT depth, UINT8 stencil) override;
+			void GenerateMips(ID3D11ShaderResourceView* view) override;
+			void CSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* views) override;
+			void CSSetUnorderedAccessViews(UINT startSlot, UINT count, ID3D11UnorderedAccessView* const* views, const UINT* initialCounts) override;
+			void CSSetShader(ID3D11ComputeShader* shader, ID3D11ClassInstance* const* instances, UINT instanceCount) override;
+			void CSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) override;
+			void ClearState() override;
+			void Flush() override;
+
+			void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+				const UINT* firstConstant, const UINT* constantCount) override;
+			void GSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+				const UINT* firstConstant, const UINT* constantCount) override;
+			void PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+				const UINT* firstConstant, const UINT* constantCount) override;
+			void CSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+				const UINT* firstConstant, const UINT* constantCount) override;
+
+		private:
+			template<typename T>
+			void RecordSlots(const char* name, UINT startSlot, UINT count, T* const* objects);
+			void RecordSlots1(const char* name, UINT startSlot, UINT count, ID3D11Buffer* const* buffers,
+				const UINT* firstConstant, const UINT* constantCount);
+			void Record(const char* name, std::vector<const void*> objects, std::vector<UINT> values = {});
+
+			bool m_context1;
+			HRESULT m_mapResult = S_OK;
+			std::vector<Call> m_log;
+		};
+
+		//What the devices created by D3D11CreateDeviceAndSwapChain support
+		struct DeviceOptions
+		{
+			bool context1 = true;
+			bool constantBufferOffsetting = true;
+			bool mapNoOverwriteOnDynamicConstantBuffer = true;
+		};
+
+		//Options of the devices created from now on, tests set them before creating a DxDevice
+		DeviceOptions& NextDevice();
+
+		//Device creating the objects above, it counts the objects created of every kind
+		class Device : public Object<ID3D11Device>
+		{
+		public:
+			explicit Device(const DeviceOptions& options = {});
+
+			Context* context() const { return m_context; }
+			const DeviceOptions& options() const { return m_options; }
+			//Number of objects created with the given method, e.g. "CreateBuffer"
+			size_t Count(const std::string& method) const;
+
+			HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Buffer** buffer) override;
+			HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* data, ID3D11Texture2D** texture) override;
+			HRESULT CreateShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc,
+				ID3D11ShaderResourceView** view) override;
+			HRESULT CreateUnorderedAccessView(ID3D11Resource* resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC* desc,
+				ID3D11UnorderedAccessView** view) override;
+			HRESULT CreateRenderTargetView(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc,
+				ID3D11RenderTargetView** view) override;
+			HRESULT CreateDepthStencilView(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc,
+				ID3D11DepthStencilView** view) override;
+			HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, UINT count, const void* byteCode,
+				SIZE_T length, ID3D11InputLayout** layout) override;
+			HRESULT CreateVertexShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11VertexShader** shader) override;
+			HRESULT CreateGeometryShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11GeometryShader** shader) override;
+			HRESULT CreatePixelShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11PixelShader** shader) override;
+			HRESULT CreateComputeShader(const void* byteCode, SIZE_T length, ID3D11ClassLinkage* linkage, ID3D11ComputeShader** shader) override;
+			HRESULT CreateBlendState(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) override;
+			HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) override;
+			HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) override;
+			HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) override;
+			HRESULT CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT size) override;
+			void GetImmediateContext(ID3D11DeviceContext** context) override;
+
+		protected:
+			~Device() override;
+
+		private:
+			template<typename T, typename Interface>
+			HRESULT Create(const char* method, T* object, Interface** result);
+
+			DeviceOptions m_options;
+			Context* m_context;
+			std::vector<std::string> m_created;
+		};
+
+		class SwapChain : public Object<IDXGISwapChain>
+		{
+		public:
+			explicit SwapChain(const DXGI_SWAP_CHAIN_DESC& desc);
+
+			HRESULT Present(UINT syncInterval, UINT flags) override;
+			HRESULT GetBuffer(UINT buffer, REFIID riid, void** surface) override;
+
+			UINT presented() const { return m_presented; }
+
+		protected:
+			~SwapChain() override;
+
+		private:
+			Texture2D* m_backBuffer;
+			UINT m_presented = 0;
+		};
+	}
+}
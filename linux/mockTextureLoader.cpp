@@ -0,0 +1,145 @@
+#include "DDSTextureLoader.h"
+#include "WICTextureLoader.h"
+#include "mockD3D.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+//Stand-ins for the DirectXTK texture loaders. DDS files with a DX10 header or 32-bit RGBA
+//pixels are loaded like the real loader does. Other images can't be decoded here, so their
+//bytes become the pixels of a single row RGBA texture with a full mip chain.
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	constexpr uint32_t DDS_MAGIC = 0x20534444;	//"DDS "
+	constexpr uint32_t DX10_FOURCC = 0x30315844;	//"DX10"
+	constexpr size_t HEADER_SIZE = 124, DX10_HEADER_SIZE = 20;
+
+	HRESULT CreateTexture(ID3D11Device* device, const D3D11_TEXTURE2D_DESC& desc, const vector<D3D11_SUBRESOURCE_DATA>& data,
+		ID3D11Resource** texture, ID3D11ShaderResourceView** view)
+	{
+		ID3D11Texture2D* t = nullptr;
+		auto hr = device->CreateTexture2D(&desc, data.data(), &t);
+		if (FAILED(hr))
+			return hr;
+		if (view && FAILED(hr = device->CreateShaderResourceView(t, nullptr, view)))
+		{
+			t->Release();
+			return hr;
+		}
+		if (texture)
+			*texture = t;
+		else
+			t->Release();
+		return S_OK;
+	}
+
+	vector<uint8_t> ReadFile(const wchar_t* fileName)
+	{
+		ifstream input(filesystem::path(fileName), ios::in | ios::binary);
+		return { istreambuf_iterator<char>(input), istreambuf_iterator<char>() };
+	}
+}
+
+HRESULT DirectX::CreateDDSTextureFromMemory(ID3D11Device* d3dDevice, ID3D11DeviceContext*, const uint8_t* ddsData,
+	size_t ddsDataSize, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, size_t, DDS_ALPHA_MODE* alphaMode) noexcept
+{
+	if (alphaMode)
+		*alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+	uint32_t header[1 + HEADER_SIZE / 4];
+	if (ddsDataSize < sizeof(header))
+		return E_FAIL;
+	memcpy(header, ddsData, sizeof(header));
+	if (header[0] != DDS_MAGIC || header[1] != HEADER_SIZE)
+		return E_FAIL;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Height = header[3];
+	desc.Width = header[4];
+	desc.MipLevels = max(header[7], 1u);
+	desc.ArraySize = 1;
+	desc.SampleDesc.Count = 1;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	size_t offset = sizeof(header);
+	//pixel format fourCC is at byte 84 of the file
+	if (header[21] == DX10_FOURCC)
+	{
+		if (ddsDataSize < offset + DX10_HEADER_SIZE)
+			return E_FAIL;
+		uint32_t format;
+		memcpy(&format, ddsData + offset, sizeof(format));
+		desc.Format = static_cast<DXGI_FORMAT>(format);
+		offset += DX10_HEADER_SIZE;
+	}
+	else
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	auto pixelSize = mock::BytesPerPixel(desc.Format);
+	if (pixelSize == 0)
+		return E_FAIL;
+
+	vector<D3D11_SUBRESOURCE_DATA> data(desc.MipLevels);
+	for (UINT mip = 0; mip < desc.MipLevels; ++mip)
+	{
+		auto pitch = max(desc.Width >> mip, 1u) * pixelSize;
+		auto size = static_cast<size_t>(pitch) * max(desc.Height >> mip, 1u);
+		if (ddsDataSize < offset + size)
+			return E_FAIL;
+		data[mip] = { ddsData + offset, pitch, 0 };
+		offset += size;
+	}
+	return CreateTexture(d3dDevice, desc, data, texture, textureView);
+}
+
+HRESULT DirectX::CreateDDSTextureFromFile(ID3D11Device* d3dDevice, ID3D11DeviceContext* d3dContext, const wchar_t* szFileName,
+	ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, size_t maxsize, DDS_ALPHA_MODE* alphaMode) noexcept
+{
+	auto data = ReadFile(szFileName);
+	if (data.empty())
+		return E_FAIL;
+	return CreateDDSTextureFromMemory(d3dDevice, d3dContext, data.data(), data.size(), texture, textureView, maxsize, alphaMode);
+}
+
+HRESULT DirectX::CreateWICTextureFromMemory(ID3D11Device* d3dDevice, ID3D11DeviceContext*, const uint8_t* wicData,
+	size_t wicDataSize, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, size_t) noexcept
+{
+	if (wicDataSize == 0)
+		return E_FAIL;
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = static_cast<UINT>((wicDataSize + 3) / 4);
+	desc.Height = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	for (auto size = desc.Width; size > 0; size >>= 1)
+		++desc.MipLevels;
+
+	//every mip takes every other pixel of the one above
+	vector<vector<uint32_t>> pixels(desc.MipLevels);
+	pixels[0].resize(desc.Width);
+	memcpy(pixels[0].data(), wicData, wicDataSize);
+	vector<D3D11_SUBRESOURCE_DATA> data(desc.MipLevels);
+	for (UINT mip = 0; mip < desc.MipLevels; ++mip)
+	{
+		if (mip > 0)
+			for (size_t x = 0; x < max(desc.Width >> mip, 1u); ++x)
+				pixels[mip].push_back(pixels[mip - 1][2 * x]);
+		data[mip] = { pixels[mip].data(), static_cast<UINT>(pixels[mip].size() * 4), 0 };
+	}
+	return CreateTexture(d3dDevice, desc, data, texture, textureView);
+}
+
+HRESULT DirectX::CreateWICTextureFromFile(ID3D11Device* d3dDevice, ID3D11DeviceContext* d3dContext, const wchar_t* szFileName,
+	ID3D11Resource** texture, ID3D11ShaderResourceView** textureView, size_t maxsize) noexcept
+{
+	auto data = ReadFile(szFileName);
+	if (data.empty())
+		return E_FAIL;
+	return CreateWICTextureFromMemory(d3dDevice, d3dContext, data.data(), data.size(), texture, textureView, maxsize);
+}
@@ -0,0 +1,38 @@
+#include "window.h"
+
+//Stand-in for the Win32 window, DxDevice only needs its client size
+
+using namespace std;
+using namespace mini;
+
+const int Window::m_defaultWindowWidth = 1280;
+const int Window::m_defaultWindowHeight = 720;
+
+Window::Window(HINSTANCE hInstance, int, int, IWindowMessageHandler* h)
+	: m_hWnd(nullptr), m_hInstance(hInstance), m_messageHandler(h)
+{ }
+
+Window::Window(HINSTANCE hInstance, int, int, const wstring&, IWindowMessageHandler* h)
+	: m_hWnd(nullptr), m_hInstance(hInstance), m_messageHandler(h)
+{ }
+
+Window::~Window()
+{ }
+
+LRESULT Window::WndProc(UINT, WPARAM, LPARAM)
+{
+	return 0;
+}
+
+void Window::Show(int)
+{ }
+
+RECT Window::getClientRectangle() const
+{
+	return { 0, 0, m_defaultWindowWidth, m_defaultWindowHeight };
+}
+
+SIZE Window::getClientSize() const
+{
+	return { m_defaultWindowWidth, m_defaultWindowHeight };
+}
@@ -0,0 +1,159 @@
+#include <Windows.h>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+	thread_local DWORD lastError = 0;
+
+	//Files and mappings are both file descriptors, mappings remember the size to map
+	struct Handle
+	{
+		int fd;
+		size_t size;
+	};
+
+	mutex viewMutex;
+	unordered_map<const void*, size_t> viewSizes;
+
+	string NativePath(LPCWSTR path)
+	{
+		return filesystem::path(path).string();
+	}
+
+	DWORD ErrorFromErrno()
+	{
+		return errno == ENOENT ? ERROR_FILE_NOT_FOUND : static_cast<DWORD>(errno);
+	}
+}
+
+DWORD GetLastError()
+{
+	return lastError;
+}
+
+void SetLastError(DWORD error)
+{
+	lastError = error;
+}
+
+void OutputDebugStringW(LPCWSTR)
+{ }
+
+DWORD FormatMessageW(DWORD, const void*, DWORD, DWORD, LPWSTR, DWORD, void*)
+{
+	//callers fall back to the error location alone
+	return 0;
+}
+
+void* LocalFree(void*)
+{
+	return nullptr;
+}
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = chrono::steady_clock::period::den / chrono::steady_clock::period::num;
+	return TRUE;
+}
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* count)
+{
+	count->QuadPart = chrono::steady_clock::now().time_since_epoch().count();
+	return TRUE;
+}
+
+DWORD GetFileAttributesW(LPCWSTR path)
+{
+	struct stat s;
+	if (stat(NativePath(path).c_str(), &s) != 0)
+	{
+		lastError = ErrorFromErrno();
+		return INVALID_FILE_ATTRIBUTES;
+	}
+	return S_ISDIR(s.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+}
+
+HANDLE CreateFileW(LPCWSTR path, DWORD, DWORD, void*, DWORD, DWORD, HANDLE)
+{
+	int fd = open(NativePath(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		lastError = ErrorFromErrno();
+		return INVALID_HANDLE_VALUE;
+	}
+	return new Handle{ fd, 0 };
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size)
+{
+	struct stat s;
+	if (fstat(static_cast<Handle*>(file)->fd, &s) != 0)
+	{
+		lastError = ErrorFromErrno();
+		return FALSE;
+	}
+	size->QuadPart = s.st_size;
+	return TRUE;
+}
+
+HANDLE CreateFileMappingW(HANDLE file, void*, DWORD, DWORD, DWORD, LPCWSTR)
+{
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+		return nullptr;
+	int fd = dup(static_cast<Handle*>(file)->fd);
+	if (fd < 0)
+	{
+		lastError = ErrorFromErrno();
+		return nullptr;
+	}
+	return new Handle{ fd, static_cast<size_t>(size.QuadPart) };
+}
+
+void* MapViewOfFile(HANDLE mapping, DWORD, DWORD, DWORD, SIZE_T)
+{
+	auto m = static_cast<Handle*>(mapping);
+	void* view = mmap(nullptr, m->size, PROT_READ, MAP_PRIVATE, m->fd, 0);
+	if (view == MAP_FAILED)
+	{
+		lastError = ErrorFromErrno();
+		return nullptr;
+	}
+	lock_guard<mutex> lock(viewMutex);
+	viewSizes[view] = m->size;
+	return view;
+}
+
+BOOL UnmapViewOfFile(const void* view)
+{
+	size_t size;
+	{
+		lock_guard<mutex> lock(viewMutex);
+		auto v = viewSizes.find(view);
+		if (v == viewSizes.end())
+			return FALSE;
+		size = v->second;
+		viewSizes.erase(v);
+	}
+	return munmap(const_cast<void*>(view), size) == 0;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+	auto h = static_cast<Handle*>(handle);
+	bool closed = close(h->fd) == 0;
+	delete h;
+	return closed;
+}
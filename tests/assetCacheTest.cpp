@@ -0,0 +1,88 @@
+#include "test.h"
+#include "assetCache.h"
+#include "mockDevice.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//Fresh cache directory and an image for it, bytes stand for the pixels under the mock WIC loader
+	struct Fixture
+	{
+		filesystem::path directory = filesystem::temp_directory_path() / "assetCacheTest";
+		wstring image;
+
+		Fixture()
+		{
+			filesystem::remove_all(directory);
+			filesystem::create_directories(directory / "source");
+			image = (directory / "source" / "image.png").wstring();
+			vector<char> bytes(4 * 64);
+			for (size_t i = 0; i < bytes.size(); ++i)
+				bytes[i] = static_cast<char>(i * 7);
+			ofstream(filesystem::path(image), ios::binary).write(bytes.data(), bytes.size());
+		}
+
+		wstring cacheDirectory() const { return (directory / "cache").wstring(); }
+	};
+
+	//Loads the image like Robot does, returns the path the texture was created from
+	wstring Load(const DxDevice& device, AssetCache& cache, const wstring& path)
+	{
+		auto texture = ReadTexture(cache, path);
+		auto view = CreateTexture(device, cache, texture);
+		CHECK(view != nullptr);
+		return texture.path;
+	}
+}
+
+TEST(TextureIsCreatedFromTheEntryOnTheSecondRun)
+{
+	Fixture f;
+	auto device = test::CreateMockDevice();
+	AssetCache cache(f.cacheDirectory());
+	CHECK(Load(device, cache, f.image) == f.image);
+	auto entry = Load(device, cache, f.image);
+	CHECK(entry != f.image);
+	CHECK(filesystem::exists(entry));
+	CHECK_EQ(1u, cache.hits());
+	CHECK_EQ(1u, cache.misses());
+}
+
+TEST(DamagedEntriesAreReplacedFromTheSource)
+{
+	Fixture f;
+	auto device = test::CreateMockDevice();
+	AssetCache cache(f.cacheDirectory());
+	Load(device, cache, f.image);
+	auto entry = ReadTexture(cache, f.image).path;
+	auto size = filesystem::file_size(entry);
+
+	//one pixel flipped, then the last mip cut off
+	{
+		fstream file(filesystem::path(entry), ios::in | ios::out | ios::binary);
+		file.seekp(size - 8);
+		file.put('\x55');
+	}
+	CHECK(Load(device, cache, f.image) == f.image);
+	CHECK(Load(device, cache, f.image) == entry);
+	filesystem::resize_file(entry, size - 4);
+	CHECK(Load(device, cache, f.image) == f.image);
+	CHECK(Load(device, cache, f.image) == entry);
+	CHECK_EQ(size, filesystem::file_size(entry));
+}
+
+TEST(DDSFilesBypassTheCache)
+{
+	Fixture f;
+	auto device = test::CreateMockDevice();
+	AssetCache cache(f.cacheDirectory());
+	Load(device, cache, f.image);
+	auto entry = ReadTexture(cache, f.image).path;
+	auto texture = ReadTexture(cache, entry);
+	CHECK(texture.path == entry);
+	CHECK(texture.entry.empty());
+}
@@ -0,0 +1,163 @@
+#include "test.h"
+#include "assetLoader.h"
+#include "exceptions.h"
+#include <atomic>
+#include <future>
+#include <stdexcept>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//Stand-in for the device: creates "resources" from the read bytes and remembers the thread it was used on
+	struct StubDevice
+	{
+		thread::id owner = this_thread::get_id();
+		int created = 0;
+		bool wrongThread = false;
+
+		unique_ptr<string> Create(string&& data)
+		{
+			wrongThread = wrongThread || this_thread::get_id() != owner;
+			++created;
+			return make_unique<string>(move(data));
+		}
+	};
+
+	//Slow read keeping track of how many run at once and whether they left the calling thread
+	struct Reads
+	{
+		thread::id caller = this_thread::get_id();
+		atomic<int> running{ 0 }, mostAtOnce{ 0 }, offThread{ 0 };
+
+		string operator()(const string& contents)
+		{
+			if (this_thread::get_id() != caller)
+				++offThread;
+			int now = ++running;
+			for (int most = mostAtOnce; now > most && !mostAtOnce.compare_exchange_weak(most, now); )
+				;
+			this_thread::sleep_for(chrono::milliseconds(30));
+			--running;
+			return contents;
+		}
+	};
+}
+
+TEST(ReadsRunTogetherOffTheCallingThread)
+{
+	WorkerPool pool(3);
+	StubDevice device;
+	Reads reads;
+	AssetLoader loader(pool);
+	vector<Asset<unique_ptr<string>>> textures;
+	for (int i = 0; i < 6; ++i)
+	{
+		auto contents = "asset" + to_string(i);
+		textures.push_back(loader.Add(L"texture" + to_wstring(i), [&reads, contents] { return reads(contents); },
+			[&device](string&& data) { return device.Create(move(data)); }));
+	}
+	auto byteCode = loader.Add(L"shader", [&reads] { return reads("code"); });
+	loader.Start();
+	CHECK(!byteCode.ready());
+	loader.Wait();
+
+	for (int i = 0; i < 6; ++i)
+		CHECK(textures[i].ready() && *textures[i].get() == "asset" + to_string(i));
+	CHECK(byteCode.ready() && byteCode.get() == "code");
+	CHECK_EQ(6, device.created);
+	//creates run on the thread calling Wait
+	CHECK(!device.wrongThread);
+	CHECK_EQ(7, reads.offThread.load());
+	CHECK(reads.mostAtOnce > 1);
+	CHECK(loader.Trace().find(L"7 assets loaded") == 0);
+}
+
+TEST(CreatesRunInTheOrderAssetsWereAdded)
+{
+	WorkerPool pool(2);
+	AssetLoader loader(pool);
+	vector<int> order;
+	for (int i = 0; i < 5; ++i)
+		//later assets are read faster, so reads finish in the reverse order
+		loader.Add(L"asset", [i] { this_thread::sleep_for(chrono::milliseconds(5 * (5 - i))); return i; },
+			[&order](int&& i) { order.push_back(i); return i; });
+	loader.Start();
+	loader.Wait();
+	CHECK(order == (vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+TEST(FirstReadErrorIsRethrownByWait)
+{
+	WorkerPool pool(2);
+	StubDevice device;
+	AssetLoader loader(pool);
+	auto ok = loader.Add(L"ok", [] { return string("data"); }, [&device](string&& data) { return device.Create(move(data)); });
+	auto missing = loader.Add(L"missing", []() -> string { THROW(L"Unable to open missing"); });
+	loader.Start();
+	CHECK_THROWS(loader.Wait());
+	//nothing is created once a read failed
+	CHECK(!ok.ready());
+	CHECK_EQ(0, device.created);
+}
+
+TEST(DestroyingWithoutWaitCreatesNothing)
+{
+	WorkerPool pool(2);
+	StubDevice device;
+	Reads reads;
+	{
+		AssetLoader loader(pool);
+		loader.Add(L"a", [&reads] { return reads("a"); }, [&device](string&& data) { return device.Create(move(data)); });
+		loader.Add(L"b", [&reads] { return reads("b"); }, [&device](string&& data) { return device.Create(move(data)); });
+		loader.Start();
+	}
+	CHECK_EQ(2, reads.offThread.load());
+	CHECK_EQ(0, device.created);
+}
+
+TEST(PoolWithoutWorkersStillReadsInTheBackground)
+{
+	WorkerPool pool(0);
+	Reads reads;
+	AssetLoader loader(pool);
+	auto a = loader.Add(L"a", [&reads] { return reads("a"); });
+	auto b = loader.Add(L"b", [&reads] { return reads("b"); });
+	loader.Start();
+	loader.Wait();
+	CHECK(a.ready() && b.ready());
+	CHECK_EQ(2, reads.offThread.load());
+	CHECK_EQ(1, reads.mostAtOnce.load());
+}
+
+TEST(PoolCannotBeUsedWhileReadsRun)
+{
+	//the loader's reads hold the pool between Start and Wait, a loop started on it in the meantime
+	//would take over the workers, so it has to fail instead
+	WorkerPool pool(2);
+	promise<void> started, release;
+	auto released = release.get_future().share();
+	atomic<bool> signalled{ false };
+	AssetLoader loader(pool);
+	for (int i = 0; i < 3; ++i)
+		loader.Add(L"blocked", [&started, &signalled, released]
+			{
+				if (!signalled.exchange(true))
+					started.set_value();
+				released.wait();
+				return 0;
+			});
+	loader.Start();
+	started.get_future().wait();
+	int calls = 0;
+	CHECK_THROWS(pool.ParallelFor(4, [&calls](size_t) { ++calls; }));
+	CHECK_EQ(0, calls);
+	release.set_value();
+	loader.Wait();
+
+	//once Wait returned the pool is free again
+	atomic<int> done{ 0 };
+	pool.ParallelFor(4, [&done](size_t) { ++done; });
+	CHECK_EQ(4, done.load());
+}
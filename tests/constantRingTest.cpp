@@ -0,0 +1,229 @@
+#include "test.h"
+#include "mockDevice.h"
+#include "constantRing.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace mini;
+using namespace mini::test;
+
+namespace
+{
+	struct Matrix
+	{
+		float m[16];
+	};
+
+	Matrix Numbered(int n)
+	{
+		Matrix r;
+		for (int k = 0; k < 16; ++k)
+			r.m[k] = n + k * 0.01f;
+		return r;
+	}
+
+	//Contents of the first buffer bound by the last call with the given name
+	const vector<BYTE>& BoundData(const DxDevice& device, const string& call)
+	{
+		auto& log = MockContext(device).log();
+		auto last = find_if(log.rbegin(), log.rend(), [&call](const mock::Context::Call& c) { return c.name == call; });
+		auto buffer = static_cast<ID3D11Buffer*>(const_cast<void*>(last->objects[0]));
+		return dynamic_cast<mock::Buffer&>(*buffer).data();
+	}
+}
+
+TEST(OffsetsNeedTheContext1AndBothOptions)
+{
+	CHECK(ConstantRing(CreateMockDevice(), 4096).offsetsSupported());
+	auto noContext1 = CreateMockDevice({ false, true, true });
+	CHECK(!ConstantRing(noContext1, 4096).offsetsSupported());
+	auto noOffsets = CreateMockDevice({ true, false, true });
+	CHECK(!ConstantRing(noOffsets, 4096).offsetsSupported());
+	auto noNoOverwrite = CreateMockDevice({ true, true, false });
+	CHECK(!ConstantRing(noNoOverwrite, 4096).offsetsSupported());
+}
+
+TEST(PushedRangesAreAlignedTo256Bytes)
+{
+	auto device = CreateMockDevice();
+	ConstantRing ring(device, 64 * 1024);
+	ring.BeginFrame();
+	ring.Map(device.context());
+	auto a = ring.Push(Numbered(1));
+	float color[4] = { 1, 2, 3, 4 };
+	auto b = ring.Push(color);
+	BYTE large[300] = {};
+	auto c = ring.Push(large, sizeof(large));
+	auto d = ring.Push(Numbered(2));
+	ring.Unmap(device.context());
+	//256 bytes are 16 constants, *SetConstantBuffers1 takes multiples of those
+	CHECK_EQ(0u, a.firstConstant);
+	CHECK_EQ(16u, a.constantCount);
+	CHECK_EQ(16u, b.firstConstant);
+	CHECK_EQ(16u, b.constantCount);
+	CHECK_EQ(32u, c.firstConstant);
+	CHECK_EQ(32u, c.constantCount);
+	CHECK_EQ(64u, d.firstConstant);
+}
+
+TEST(RingIsDiscardedOnceThenMappedWithoutOverwrite)
+{
+	auto device = CreateMockDevice();
+	auto& context = MockContext(device);
+	ConstantRing ring(device, 64 * 1024);
+	for (int frame = 0; frame < 4; ++frame)
+	{
+		ring.BeginFrame();
+		ring.Map(device.context());
+		ring.Push(Numbered(frame));
+		ring.Unmap(device.context());
+	}
+	vector<UINT> types;
+	for (auto& call : context.log())
+		if (call.name == "Map")
+			types.push_back(call.values[1]);
+	CHECK(types == (vector<UINT>{ D3D11_MAP_WRITE_DISCARD, D3D11_MAP_WRITE_NO_OVERWRITE,
+		D3D11_MAP_WRITE_NO_OVERWRITE, D3D11_MAP_WRITE_NO_OVERWRITE }));
+	CHECK_EQ(4u, context.Count("Unmap"));
+}
+
+TEST(BindPassesTheRangeWithTheRingBuffer)
+{
+	auto device = CreateMockDevice();
+	auto& context = MockContext(device);
+	StateCache state(device.context().get(), device.context1().get());
+	ConstantRing ring(device, 64 * 1024);
+	ring.BeginFrame();
+	ring.Map(device.context());
+	auto world = ring.Push(Numbered(1));
+	auto color = ring.Push(Numbered(2));
+	ring.Unmap(device.context());
+	ring.Bind(state, ConstantRing::Vertex, 0, world);
+	ring.Bind(state, ConstantRing::Pixel, 1, color);
+	ring.Bind(state, ConstantRing::Vertex, 0, world);
+	CHECK_EQ(1u, context.Count("VSSetConstantBuffers1"));
+	CHECK_EQ(1u, context.Count("PSSetConstantBuffers1"));
+	CHECK(context.log().back().values == (vector<UINT>{ 1, 1, 16, 16 }));
+	auto& data = BoundData(device, "PSSetConstantBuffers1");
+	auto expected = Numbered(2);
+	CHECK(memcmp(data.data() + 256, &expected, sizeof(expected)) == 0);
+	//a single buffer for the whole ring
+	CHECK_EQ(1u, MockDevice(device).Count("CreateBuffer"));
+}
+
+TEST(ConstantsOfThreeFramesInFlightAreNotOverwritten)
+{
+	auto device = CreateMockDevice();
+	StateCache state(device.context().get(), device.context1().get());
+	//room for exactly four frames of four matrices
+	ConstantRing ring(device, 16 * 256, 3);
+	vector<vector<ConstantRange>> frames;
+	for (int frame = 0; frame < 12; ++frame)
+	{
+		ring.BeginFrame();
+		ring.Map(device.context());
+		frames.push_back({});
+		for (int i = 0; i < 4; ++i)
+			frames.back().push_back(ring.Push(Numbered(100 * frame + i)));
+		ring.Unmap(device.context());
+		ring.Bind(state, ConstantRing::Vertex, 0, frames.back()[0]);
+		auto& data = BoundData(device, "VSSetConstantBuffers1");
+		//the frame being recorded and the three the GPU may still read hold their constants
+		for (int kept = max(0, frame - 3); kept <= frame; ++kept)
+			for (int i = 0; i < 4; ++i)
+			{
+				auto expected = Numbered(100 * kept + i);
+				CHECK(memcmp(data.data() + frames[kept][i].firstConstant * 16, &expected, sizeof(expected)) == 0);
+			}
+	}
+	//a fifth frame wouldn't fit, so a full ring throws instead of overwriting frames in flight
+	ring.BeginFrame();
+	ring.Map(device.context());
+	for (int i = 0; i < 4; ++i)
+		ring.Push(Numbered(i));
+	CHECK_THROWS(ring.Push(Numbered(4)));
+	ring.Unmap(device.context());
+}
+
+TEST(WithoutOffsetsEverySlotGetsItsOwnBuffer)
+{
+	auto device = CreateMockDevice({ false, true, true });
+	auto& context = MockContext(device);
+	StateCache state(device.context().get());
+	ConstantRing ring(device, 64 * 1024);
+	ring.BeginFrame();
+	ring.Map(device.context());
+	auto world1 = ring.Push(Numbered(1));
+	auto world2 = ring.Push(Numbered(2));
+	auto color = ring.Push(Numbered(3));
+	ring.Unmap(device.context());
+	//nothing is mapped on the device, the ring lives on the CPU
+	CHECK_EQ(0u, context.Count("Map"));
+
+	ring.Bind(state, ConstantRing::Vertex, 0, world1);
+	ring.Bind(state, ConstantRing::Pixel, 0, color);
+	ring.Bind(state, ConstantRing::Vertex, 0, world2);
+	ring.Bind(state, ConstantRing::Vertex, 0, world2);
+	CHECK_EQ(2u, MockDevice(device).Count("CreateBuffer"));
+	CHECK_EQ(0u, context.Count("VSSetConstantBuffers1"));
+	//the slot buffer stays bound, only its contents change, and not when they're the same
+	CHECK_EQ(1u, context.Count("VSSetConstantBuffers"));
+	CHECK_EQ(1u, context.Count("PSSetConstantBuffers"));
+	CHECK_EQ(3u, context.Count("Map"));
+
+	auto& data = BoundData(device, "VSSetConstantBuffers");
+	auto expected = Numbered(2);
+	CHECK_EQ(256u, data.size());
+	CHECK(memcmp(data.data(), &expected, sizeof(expected)) == 0);
+}
+
+TEST(WithoutOffsetsSlotBuffersGrowWithTheRange)
+{
+	auto device = CreateMockDevice({ false, true, true });
+	StateCache state(device.context().get());
+	ConstantRing ring(device, 64 * 1024);
+	ring.BeginFrame();
+	ring.Map(device.context());
+	auto small = ring.Push(Numbered(1));
+	BYTE large[600] = { 7 };
+	auto big = ring.Push(large, sizeof(large));
+	ring.Unmap(device.context());
+	ring.Bind(state, ConstantRing::Geometry, 2, small);
+	ring.Bind(state, ConstantRing::Geometry, 2, big);
+	ring.Bind(state, ConstantRing::Geometry, 2, small);
+	//the slot is recreated once for the larger range, the smaller one fits afterwards
+	CHECK_EQ(2u, MockDevice(device).Count("CreateBuffer"));
+	auto& context = MockContext(device);
+	CHECK_EQ(2u, context.Count("GSSetConstantBuffers"));
+	auto& data = BoundData(device, "GSSetConstantBuffers");
+	CHECK_EQ(768u, data.size());
+}
+
+TEST(WithoutOffsetsDestroyedRingsAreForgottenByTheCache)
+{
+	auto device = CreateMockDevice({ false, true, true });
+	auto& context = MockContext(device);
+	StateCache state(device.context().get());
+	BYTE constants[256] = { 1, 2, 3 };
+	dx_ptr<ID3D11Buffer> slotBuffer;
+	{
+		ConstantRing ring(device, 64 * 1024);
+		ring.BeginFrame();
+		ring.Map(device.context());
+		auto range = ring.Push(constants, sizeof(constants));
+		ring.Unmap(device.context());
+		ring.Bind(state, ConstantRing::Vertex, 0, range);
+		//kept alive past the ring, as a new buffer at the same address would be
+		auto& log = context.log();
+		auto bind = find_if(log.begin(), log.end(), [](const mock::Context::Call& c) { return c.name == "VSSetConstantBuffers"; });
+		slotBuffer.reset(static_cast<ID3D11Buffer*>(const_cast<void*>(bind->objects[0])));
+		slotBuffer->AddRef();
+		//binding through another cache would leave the first one with stale contents
+		StateCache other(device.context().get());
+		CHECK_THROWS(ring.Bind(other, ConstantRing::Vertex, 0, range));
+	}
+	context.ClearLog();
+	state.UpdateBuffer(slotBuffer.get(), constants, sizeof(constants));
+	CHECK_EQ(1u, context.Count("Map"));
+}
@@ -0,0 +1,90 @@
+#include "test.h"
+#include "mockDevice.h"
+#include "dynamicBuffer.h"
+#include <DirectXMath.h>
+
+using namespace std;
+using namespace mini;
+using namespace mini::test;
+using namespace DirectX;
+
+namespace
+{
+	//Map types recorded since the last ClearLog
+	vector<UINT> MapTypes(const DxDevice& device)
+	{
+		vector<UINT> types;
+		for (auto& call : MockContext(device).log())
+			if (call.name == "Map")
+				types.push_back(call.values[1]);
+		return types;
+	}
+}
+
+TEST(RingAppendsWithoutOverwriteAndDiscardsOnWrap)
+{
+	auto device = CreateMockDevice();
+	auto& context = MockContext(device);
+	DynamicVertexRing<XMFLOAT3> ring(device, 100);
+	context.ClearLog();
+	const XMFLOAT3* start = nullptr;
+	//maxCount, written, expected base of the written vertices
+	const unsigned int writes[][3] = { { 40, 30, 0 }, { 40, 40, 30 }, { 30, 30, 70 }, { 1, 1, 0 }, { 99, 20, 1 }, { 80, 5, 0 } };
+	for (auto& w : writes)
+	{
+		auto out = ring.Map(device.context(), w[0]);
+		if (!start)
+			start = out;
+		CHECK_EQ(static_cast<ptrdiff_t>(w[2]), out - start);
+		ring.Unmap(device.context(), w[1]);
+		CHECK_EQ(w[2], ring.baseVertex());
+		CHECK_EQ(w[1], ring.vertexCount());
+	}
+	//the fourth write doesn't fit behind the first three, the sixth wraps
+	CHECK(MapTypes(device) == (vector<UINT>{ D3D11_MAP_WRITE_DISCARD, D3D11_MAP_WRITE_NO_OVERWRITE,
+		D3D11_MAP_WRITE_NO_OVERWRITE, D3D11_MAP_WRITE_DISCARD, D3D11_MAP_WRITE_NO_OVERWRITE, D3D11_MAP_WRITE_DISCARD }));
+	CHECK_EQ(6u, context.Count("Unmap"));
+}
+
+TEST(RequestsOverTheCapacityAreClamped)
+{
+	auto device = CreateMockDevice();
+	auto& context = MockContext(device);
+	DynamicVertexRing<XMFLOAT3> ring(device, 64);
+	auto start = ring.Map(device.context(), 10);
+	ring.Unmap(device.context(), 10);
+	context.ClearLog();
+	//clamped to the whole buffer, which only fits after a discard
+	auto out = ring.Map(device.context(), 1000);
+	ring.Unmap(device.context(), 64);
+	CHECK(MapTypes(device) == vector<UINT>{ D3D11_MAP_WRITE_DISCARD });
+	CHECK_EQ(0u, ring.baseVertex());
+	CHECK_EQ(start, out);
+	//the ring is full, the next write wraps
+	context.ClearLog();
+	ring.Map(device.context(), 1);
+	ring.Unmap(device.context(), 1);
+	CHECK(MapTypes(device) == vector<UINT>{ D3D11_MAP_WRITE_DISCARD });
+}
+
+TEST(DrawUsesTheLastWrittenRange)
+{
+	auto device = CreateMockDevice();
+	auto& context = MockContext(device);
+	DynamicVertexRing<XMFLOAT3> ring(device, 100);
+	ring.Map(device.context(), 50);
+	ring.Unmap(device.context(), 25);
+	ring.Map(device.context(), 50);
+	ring.Unmap(device.context(), 12);
+	context.ClearLog();
+	ring.Draw(device.context());
+	CHECK_EQ(1u, context.Count("Draw"));
+	CHECK_EQ(12u, context.log()[0].values[0]);
+	CHECK_EQ(25u, context.log()[0].values[1]);
+	//nothing written, nothing drawn
+	ring.Map(device.context(), 50);
+	ring.Unmap(device.context(), 0);
+	context.ClearLog();
+	ring.Draw(device.context());
+	CHECK_EQ(0u, context.Count("Draw"));
+}
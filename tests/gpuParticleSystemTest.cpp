@@ -0,0 +1,598 @@
+#include "test.h"
+#include "gpuParticleSystem.h"
+#include "particleIntegrator.h"
+#include "mockDevice.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <numeric>
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	const float DT = 1.0f / 60.0f;
+	const float KILL_LEVEL = -0.05f;
+
+	//Must match cbSimulation in particleSimulation.hlsli
+	struct SimulationParams
+	{
+		XMFLOAT3 acceleration;
+		float dt;
+		float sizeIncrement;
+		float timeToLive;
+		float killLevel;
+		float trailTime;
+		UINT capacity;
+		UINT emitCount;
+		UINT emitterCount;
+		UINT padding;
+		float minVelocity;
+		float maxVelocity;
+		float tanMaxAngle;
+		float particleSize;
+	};
+
+	//Must match GpuEmitter in particleEmitCS.hlsl
+	struct GpuEmitter
+	{
+		XMFLOAT4 position;
+		XMFLOAT4 direction[3];
+		UINT first;
+		UINT count;
+		UINT seed;
+		UINT padding;
+	};
+
+	//Same as in particleEmitCS.hlsl
+	UINT Hash(UINT x)
+	{
+		UINT state = x * 747796405u + 2891336453u;
+		UINT word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		return (word >> 22u) ^ word;
+	}
+
+	float Random(UINT& state)
+	{
+		state = Hash(state);
+		return (state >> 8) * (1.0f / 16777216.0f);
+	}
+
+	mock::Buffer& BufferOf(ID3D11Resource* resource)
+	{
+		auto buffer = dynamic_cast<mock::Buffer*>(resource);
+		CHECK(buffer != nullptr);
+		return *buffer;
+	}
+
+	template<typename T>
+	T* Object(const void* object) { return static_cast<T*>(const_cast<void*>(object)); }
+
+	ID3D11Resource* ResourceOf(ID3D11View* view)
+	{
+		if (auto uav = dynamic_cast<mock::UnorderedAccessView*>(view))
+			return uav->resource();
+		if (auto srv = dynamic_cast<mock::ShaderResourceView*>(view))
+			return srv->resource();
+		return nullptr;
+	}
+
+	//Runs the calls GpuParticleSystem records on the CPU: compute shaders are replaced by
+	//ports of their HLSL sources and every append/consume buffer gets a hidden counter.
+	//On the way it checks that each dispatch has the shader and resources it needs, that the
+	//counts it reads were copied from the right buffer and that nothing is bound for reading
+	//and writing at once. A failed check throws like any other in the tests.
+	class Emulator
+	{
+	public:
+		explicit Emulator(mock::Context& context) : m_context(context) { }
+
+		//Executes the calls recorded since the last run, they must leave the compute stage unbound
+		void Run()
+		{
+			m_dispatches.clear();
+			m_args = nullptr;
+			auto& log = m_context.log();
+			for (; m_next < log.size(); ++m_next)
+				Execute(log[m_next]);
+			CHECK(m_shader == nullptr);
+			for (auto uav : m_uavs)
+				CHECK(uav == nullptr);
+			for (auto srv : m_srvs)
+				CHECK(srv == nullptr);
+			CHECK(m_vsSrv == nullptr);
+		}
+
+		//Compute shaders dispatched in the last run, in order
+		const vector<string>& dispatches() const { return m_dispatches; }
+		//Particles read by the last indirect draw
+		const vector<GpuParticle>& drawn() const { return m_drawn; }
+
+	private:
+		static string Name(ID3D11ComputeShader* shader)
+		{
+			auto& code = dynamic_cast<mock::ComputeShader&>(*shader).byteCode();
+			return string(code.begin(), code.end());
+		}
+
+		void Execute(const mock::Context::Call& call)
+		{
+			if (call.name == "CSSetShader")
+				m_shader = Object<ID3D11ComputeShader>(call.objects[0]);
+			else if (call.name == "CSSetConstantBuffers")
+				Bind(m_cbs, call, Object<ID3D11Buffer>);
+			else if (call.name == "CSSetShaderResources")
+				Bind(m_srvs, call, Object<ID3D11ShaderResourceView>);
+			else if (call.name == "CSSetUnorderedAccessViews")
+			{
+				Bind(m_uavs, call, Object<ID3D11UnorderedAccessView>);
+				for (size_t i = 0; i < call.objects.size(); ++i)
+					if (call.objects[i] && call.values[2 + i] != ~0u)
+						m_counters[Object<ID3D11UnorderedAccessView>(call.objects[i])] = call.values[2 + i];
+			}
+			else if (call.name == "VSSetShaderResources")
+			{
+				CHECK_EQ(1u, call.values[1]);
+				m_vsSrv = Object<ID3D11ShaderResourceView>(call.objects[0]);
+			}
+			else if (call.name == "CopyStructureCount")
+			{
+				auto& destination = BufferOf(Object<ID3D11Buffer>(call.objects[0]));
+				auto count = m_counters[Object<ID3D11UnorderedAccessView>(call.objects[1])];
+				memcpy(destination.data().data() + call.values[0], &count, sizeof(count));
+			}
+			else if (call.name == "Dispatch")
+			{
+				CHECK(call.values[1] == 1 && call.values[2] == 1);
+				Dispatch(call.values[0]);
+			}
+			else if (call.name == "DispatchIndirect")
+			{
+				auto args = Object<ID3D11Buffer>(call.objects[0]);
+				//the arguments must be computed by particleArgsCS in the same update and unbound since
+				CHECK(args == m_args);
+				for (auto uav : m_uavs)
+					CHECK(uav == nullptr || ResourceOf(uav) != args);
+				UINT groups[3];
+				memcpy(groups, BufferOf(args).data().data() + call.values[0], sizeof(groups));
+				CHECK(groups[1] == 1 && groups[2] == 1);
+				Dispatch(groups[0]);
+			}
+			else if (call.name == "DrawInstancedIndirect")
+				Draw(Object<ID3D11Buffer>(call.objects[0]), call.values[0]);
+		}
+
+		template<typename T, size_t N>
+		static void Bind(T* (&slots)[N], const mock::Context::Call& call, T* (*cast)(const void*))
+		{
+			CHECK(call.values[0] + call.values[1] <= N);
+			for (UINT i = 0; i < call.values[1]; ++i)
+				slots[call.values[0] + i] = cast(call.objects[i]);
+		}
+
+		UINT ParticleCount()
+		{
+			CHECK(m_cbs[1] != nullptr);
+			UINT count;
+			memcpy(&count, BufferOf(m_cbs[1]).data().data(), sizeof(count));
+			return count;
+		}
+
+		SimulationParams Params()
+		{
+			CHECK(m_cbs[0] != nullptr);
+			SimulationParams params;
+			memcpy(&params, BufferOf(m_cbs[0]).data().data(), sizeof(params));
+			return params;
+		}
+
+		void Append(ID3D11UnorderedAccessView* uav, const GpuParticle& p)
+		{
+			auto& buffer = BufferOf(ResourceOf(uav));
+			auto& count = m_counters[uav];
+			CHECK(count < buffer.data().size() / sizeof(GpuParticle));
+			memcpy(buffer.data().data() + count++ * sizeof(GpuParticle), &p, sizeof(p));
+		}
+
+		GpuParticle Consume(ID3D11UnorderedAccessView* uav)
+		{
+			auto& count = m_counters[uav];
+			CHECK(count > 0);
+			GpuParticle p;
+			memcpy(&p, BufferOf(ResourceOf(uav)).data().data() + --count * sizeof(GpuParticle), sizeof(p));
+			return p;
+		}
+
+		void Dispatch(UINT groups)
+		{
+			CHECK(m_shader != nullptr);
+			//no resource can be read through a view while written through another
+			for (auto uav : m_uavs)
+			{
+				if (!uav)
+					continue;
+				for (auto srv : m_srvs)
+					CHECK(srv == nullptr || ResourceOf(srv) != ResourceOf(uav));
+				CHECK(m_vsSrv == nullptr || ResourceOf(m_vsSrv) != ResourceOf(uav));
+			}
+			auto name = Name(m_shader);
+			m_dispatches.push_back(name);
+			if (name == "particleArgsCS")
+				Args(groups);
+			else if (name == "particleSimulateCS")
+				Simulate(groups * GpuParticleSystem::SIMULATE_GROUP);
+			else if (name == "particleEmitCS")
+				Emit(groups * GpuParticleSystem::EMIT_GROUP);
+			else
+				CHECK(false);
+		}
+
+		void Args(UINT groups)
+		{
+			CHECK_EQ(1u, groups);
+			CHECK(m_uavs[0] != nullptr);
+			auto args = static_cast<ID3D11Buffer*>(&BufferOf(ResourceOf(m_uavs[0])));
+			m_argsCount = ParticleCount();
+			const UINT dispatch[3] = { (m_argsCount + GpuParticleSystem::SIMULATE_GROUP - 1) / GpuParticleSystem::SIMULATE_GROUP, 1, 1 };
+			memcpy(BufferOf(args).data().data(), dispatch, sizeof(dispatch));
+			m_args = args;
+		}
+
+		void Simulate(UINT threads)
+		{
+			auto current = m_uavs[0], next = m_uavs[1];
+			CHECK(current != nullptr && next != nullptr && ResourceOf(current) != ResourceOf(next));
+			auto params = Params();
+			auto count = ParticleCount();
+			//the count read by the shader and the one the dispatch was sized for are the consumed buffer's
+			CHECK_EQ(m_counters[current], count);
+			CHECK_EQ(m_argsCount, count);
+			CHECK(threads >= count);
+			auto a = params.acceleration;
+			for (UINT id = 0; id < threads; ++id)
+			{
+				if (id >= count)
+					continue;
+				auto p = Consume(current);
+				p.Age += params.dt;
+				auto v = p.Velocity;
+				p.Velocity = XMFLOAT3(v.x + params.dt * a.x, v.y + params.dt * a.y, v.z + params.dt * a.z);
+				p.Pos = XMFLOAT3(p.Pos.x + params.dt * v.x, p.Pos.y + params.dt * v.y, p.Pos.z + params.dt * v.z);
+				p.Size += params.sizeIncrement;
+				if (p.Age >= params.timeToLive || (p.Pos.y < params.killLevel && p.Velocity.y < 0.0f))
+					continue;
+				float t = min(p.Age, params.trailTime);
+				float b = 0.5f * t * (t + params.dt);
+				p.LastPos = XMFLOAT3(p.Pos.x - t * p.Velocity.x + b * a.x, p.Pos.y - t * p.Velocity.y + b * a.y,
+					p.Pos.z - t * p.Velocity.z + b * a.z);
+				Append(next, p);
+			}
+		}
+
+		void Emit(UINT threads)
+		{
+			auto next = m_uavs[0];
+			CHECK(next != nullptr && m_srvs[0] != nullptr);
+			auto params = Params();
+			auto count = ParticleCount();
+			//emission is clamped with the count left by the simulation
+			CHECK_EQ(m_counters[next], count);
+			CHECK(threads >= params.emitCount);
+			CHECK(params.emitterCount > 0 && params.emitterCount <= GpuParticleSystem::MAX_STEP_EMITTERS);
+			auto emitters = reinterpret_cast<const GpuEmitter*>(BufferOf(ResourceOf(m_srvs[0])).data().data());
+			//ranges of the emitters follow each other and cover every thread
+			for (UINT k = 0, first = 0; k < params.emitterCount; first += emitters[k++].count)
+			{
+				CHECK_EQ(first, emitters[k].first);
+				CHECK(emitters[k].count > 0);
+			}
+			CHECK_EQ(params.emitCount, emitters[params.emitterCount - 1].first + emitters[params.emitterCount - 1].count);
+
+			for (UINT id = 0; id < threads; ++id)
+			{
+				if (id >= params.emitCount || count + id >= params.capacity)
+					continue;
+				UINT lo = 0, hi = params.emitterCount - 1;
+				while (lo < hi)
+				{
+					UINT mid = (lo + hi + 1) / 2;
+					if (emitters[mid].first <= id)
+						lo = mid;
+					else
+						hi = mid - 1;
+				}
+				auto& e = emitters[lo];
+				UINT state = e.seed ^ Hash(id - e.first);
+				float angle = Random(state) * 6.28318530718f;
+				float magnitude = Random(state) * params.tanMaxAngle;
+				float local[3] = { cos(angle) * magnitude, 1.0f, sin(angle) * magnitude };
+				float dir[3] = {};
+				for (int r = 0; r < 3; ++r)
+				{
+					dir[0] += local[r] * e.direction[r].x;
+					dir[1] += local[r] * e.direction[r].y;
+					dir[2] += local[r] * e.direction[r].z;
+				}
+				float length = sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+				float speed = params.minVelocity + Random(state) * (params.maxVelocity - params.minVelocity);
+
+				GpuParticle p;
+				p.Pos = XMFLOAT3(e.position.x, e.position.y, e.position.z);
+				p.Age = 0.0f;
+				p.Velocity = XMFLOAT3(speed * dir[0] / length, speed * dir[1] / length, speed * dir[2] / length);
+				p.Size = params.particleSize;
+				p.LastPos = p.Pos;
+				p.Padding = 0.0f;
+				Append(next, p);
+			}
+		}
+
+		void Draw(ID3D11Buffer* args, UINT offset)
+		{
+			CHECK(m_vsSrv != nullptr);
+			auto particles = ResourceOf(m_vsSrv);
+			for (auto uav : m_uavs)
+				CHECK(uav == nullptr || ResourceOf(uav) != particles);
+			UINT drawArgs[4];
+			memcpy(drawArgs, BufferOf(args).data().data() + offset, sizeof(drawArgs));
+			CHECK(drawArgs[1] == 1 && drawArgs[2] == 0 && drawArgs[3] == 0);
+			//the vertex count has to be the drawn buffer's particle count
+			auto counter = find_if(m_counters.begin(), m_counters.end(),
+				[particles](const auto& c) { return ResourceOf(c.first) == particles; });
+			CHECK(counter != m_counters.end());
+			CHECK_EQ(counter->second, drawArgs[0]);
+			auto data = reinterpret_cast<const GpuParticle*>(BufferOf(particles).data().data());
+			m_drawn.assign(data, data + drawArgs[0]);
+		}
+
+		mock::Context& m_context;
+		size_t m_next = 0;
+
+		ID3D11ComputeShader* m_shader = nullptr;
+		ID3D11Buffer* m_cbs[2] = {};
+		ID3D11ShaderResourceView* m_srvs[1] = {};
+		ID3D11UnorderedAccessView* m_uavs[2] = {};
+		ID3D11ShaderResourceView* m_vsSrv = nullptr;
+		map<ID3D11UnorderedAccessView*, UINT> m_counters;
+
+		ID3D11Buffer* m_args = nullptr;	//arguments written by particleArgsCS in this run
+		UINT m_argsCount = 0;			//particle count they were computed for
+		vector<string> m_dispatches;
+		vector<GpuParticle> m_drawn;
+	};
+
+	//Stand-ins for the compiled shaders holding just their names, written to a directory the
+	//system is created in so that it finds them like the application does next to its executable
+	filesystem::path ShaderStubs()
+	{
+		auto directory = filesystem::temp_directory_path() / "gpuParticleSystemTest";
+		filesystem::create_directories(directory);
+		for (string name : { "particleArgsCS", "particleSimulateCS", "particleEmitCS" })
+			ofstream(directory / (name + ".cso"), ios::out | ios::binary | ios::trunc) << name;
+		return directory;
+	}
+
+	struct Fixture
+	{
+		DxDevice device = test::CreateMockDevice();
+		Emulator emulator{ test::MockContext(device) };
+		GpuParticleSystem system;
+
+		Fixture(size_t capacity, unsigned int seed)
+		{
+			auto previous = filesystem::current_path();
+			filesystem::current_path(ShaderStubs());
+			system = GpuParticleSystem(device, capacity, seed);
+			filesystem::current_path(previous);
+		}
+
+		//Updates and draws the system, returns the particles drawn
+		const vector<GpuParticle>& Step(float dt = DT)
+		{
+			system.Update(device.context(), dt);
+			system.Draw(device.context());
+			emulator.Run();
+			return emulator.drawn();
+		}
+	};
+
+	//Emitter orientation spawning particles around the up axis tilted to the side
+	XMMATRIX Upwards(float tilt = 0.3f) { return XMMatrixRotationX(XM_PIDIV2) * XMMatrixRotationZ(tilt); }
+
+	//Axis of the spawn cone, same transform as ParticleSystem::RandomVelocity
+	XMVECTOR ConeAxis(FXMMATRIX orientation)
+	{
+		return XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f),
+			XMMatrixRotationX(-XM_PIDIV2) * orientation));
+	}
+
+	void CheckNear(float x, float y, float z, XMFLOAT3 actual, float tolerance)
+	{
+		CHECK_NEAR(x, actual.x, tolerance);
+		CHECK_NEAR(y, actual.y, tolerance);
+		CHECK_NEAR(z, actual.z, tolerance);
+	}
+
+	//Compares particles in both systems, matched by their x velocity which never changes
+	void CheckSame(const ParticleStore& cpu, vector<GpuParticle> gpu)
+	{
+		CHECK_EQ(cpu.size(), gpu.size());
+		vector<size_t> order(cpu.size());
+		iota(order.begin(), order.end(), size_t(0));
+		sort(order.begin(), order.end(), [&cpu](size_t a, size_t b) { return cpu.velX[a] < cpu.velX[b]; });
+		sort(gpu.begin(), gpu.end(), [](const GpuParticle& a, const GpuParticle& b) { return a.Velocity.x < b.Velocity.x; });
+		for (size_t k = 0; k < order.size(); ++k)
+		{
+			auto i = order[k];
+			auto& p = gpu[k];
+			CheckNear(cpu.posX[i], cpu.posY[i], cpu.posZ[i], p.Pos, 1e-5f);
+			CheckNear(cpu.velX[i], cpu.velY[i], cpu.velZ[i], p.Velocity, 1e-5f);
+			CHECK_NEAR(cpu.age[i], p.Age, 1e-6f);
+			CHECK_NEAR(cpu.size_[i], p.Size, 1e-6f);
+			//the analytic trail end against the history ring
+			CheckNear(cpu.lastX[i], cpu.lastY[i], cpu.lastZ[i], p.LastPos, 1e-4f);
+		}
+	}
+}
+
+TEST(UpdateDispatchesArgsSimulateAndEmit)
+{
+	Fixture f(1000, 1);
+	f.system.AddBurst(XMFLOAT3(0.0f, 0.5f, 0.0f), Upwards(), 300);
+	CHECK_EQ(300u, f.Step().size());
+	CHECK(f.emulator.dispatches() == (vector<string>{ "particleArgsCS", "particleSimulateCS", "particleEmitCS" }));
+	//nothing to emit, the emission is skipped
+	CHECK_EQ(300u, f.Step().size());
+	CHECK(f.emulator.dispatches() == (vector<string>{ "particleArgsCS", "particleSimulateCS" }));
+	CHECK_EQ(0u, f.system.emittersCount());
+
+	//more than fits, emission is clamped to the capacity
+	f.system.AddBurst(XMFLOAT3(0.0f, 0.5f, 0.0f), Upwards(), 900);
+	CHECK_EQ(1000u, f.Step().size());
+	CHECK_EQ(1000u, f.Step().size());
+}
+
+TEST(SimulationMatchesTheCpuIntegrator)
+{
+	const size_t CAPACITY = 2000;
+	Fixture f(CAPACITY, 5);
+	f.system.SetKillLevel(KILL_LEVEL);
+	f.system.AddBurst(XMFLOAT3(0.2f, 0.5f, -0.1f), Upwards(), 1500);
+	auto& spawned = f.Step();
+	CHECK_EQ(1500u, spawned.size());
+
+	ParticleStore cpu(CAPACITY);
+	for (auto& p : spawned)
+	{
+		CHECK_EQ(0.0f, p.Age);
+		CheckNear(p.Pos.x, p.Pos.y, p.Pos.z, p.LastPos, 0.0f);
+		cpu.Push(p.Pos, p.Velocity, p.Size);
+	}
+	//ParticleSystem::UpdateParticles followed by RemoveBelow
+	ParticleIntegrationParams params{ DT, ParticleSystem::ACCELERATION,
+		ParticleSystem::PARTICLE_SCALE * ParticleSystem::PARTICLE_SIZE * DT, ParticleSystem::TIME_TO_LIVE };
+	vector<uint32_t> dead(CAPACITY);
+	bool killedBelow = false;
+	for (int step = 0; cpu.size() > 0; ++step)
+	{
+		CHECK(step < 200);
+		auto deadCount = IntegrateParticles(cpu, params, dead.data());
+		cpu.AdvanceHistory();
+		for (auto d = deadCount; d-- > 0; )
+			cpu.SwapRemove(dead[d]);
+		for (size_t i = cpu.size(); i-- > 0; )
+			if (cpu.posY[i] < KILL_LEVEL && cpu.velY[i] < 0.0f)
+			{
+				cpu.SwapRemove(i);
+				killedBelow = true;
+			}
+		CheckSame(cpu, f.Step());
+	}
+	CHECK(killedBelow);
+}
+
+TEST(CountsMatchTheCpuSystem)
+{
+	const size_t CAPACITY = 600;
+	Fixture gpu(CAPACITY, 7);
+	ParticleSystem cpu(CAPACITY, 7);
+	auto add = [&](auto addTo)
+	{
+		addTo(gpu.system);
+		addTo(cpu);
+	};
+	add([](auto& s) { s.AddEmitter(XMFLOAT3(0.0f, 0.5f, 0.0f), Upwards(), 400.0f); });
+	add([](auto& s) { s.AddBurst(XMFLOAT3(0.3f, 0.5f, 0.0f), Upwards(-0.2f), 250); });
+
+	bool saturated = false;
+	for (int step = 0; step < 300; ++step)
+	{
+		if (step == 120)
+			add([](auto& s) { s.AddEmitter(XMFLOAT3(-0.3f, 0.4f, 0.2f), Upwards(0.5f), 150.0f, 0.5f); });
+		if (step == 200)
+			add([](auto& s) { s.AddBurst(XMFLOAT3(0.0f, 0.6f, 0.3f), Upwards(), 100); });
+		cpu.Simulate(DT);
+		auto count = gpu.Step().size();
+		CHECK_EQ(cpu.particlesCount(), count);
+		CHECK_EQ(cpu.emittersCount(), gpu.system.emittersCount());
+		saturated = saturated || count == CAPACITY;
+	}
+	CHECK(saturated);
+}
+
+TEST(EmittedVelocitiesFollowTheCpuDistribution)
+{
+	const unsigned int N = 4000;
+	const XMFLOAT3 position(0.0f, 0.5f, 0.0f);
+	auto orientation = Upwards();
+	auto axis = ConeAxis(orientation);
+	Fixture gpu(N, 3);
+	ParticleSystem cpu(N, 3);
+	gpu.system.AddBurst(position, orientation, N);
+	cpu.AddBurst(position, orientation, N);
+
+	struct Stats
+	{
+		double speed = 0.0, angle = 0.0;
+		size_t count = 0;
+
+		void Add(XMVECTOR velocity, FXMVECTOR axis)
+		{
+			auto speed = XMVectorGetX(XMVector3Length(velocity));
+			auto angle = acos(min(1.0f, XMVectorGetX(XMVector3Dot(velocity, axis)) / speed));
+			CHECK(speed >= ParticleSystem::MIN_VELOCITY - 1e-4f && speed <= ParticleSystem::MAX_VELOCITY + 1e-4f);
+			CHECK(angle <= ParticleSystem::MAX_ANGLE + 1e-3f);
+			this->speed += speed;
+			this->angle += angle;
+			++count;
+		}
+	} gpuStats, cpuStats;
+
+	for (auto& p : gpu.Step())
+		gpuStats.Add(XMLoadFloat3(&p.Velocity), axis);
+	//a step after spawning the trail ends at the spawn position, which gives back the velocity
+	cpu.Simulate(DT);
+	for (auto& v : cpu.Update(DT, XMFLOAT4(0.0f, 0.0f, -2.0f, 1.0f)))
+		cpuStats.Add(XMVectorScale(XMLoadFloat3(&v.Pos) - XMLoadFloat3(&v.LastPos), 1.0f / DT), axis);
+
+	CHECK_EQ(size_t(N), gpuStats.count);
+	CHECK_EQ(size_t(N), cpuStats.count);
+	auto mean = 0.5 * (ParticleSystem::MIN_VELOCITY + ParticleSystem::MAX_VELOCITY);
+	CHECK_NEAR(mean, gpuStats.speed / N, 0.03);
+	CHECK_NEAR(cpuStats.speed / N, gpuStats.speed / N, 0.03);
+	CHECK_NEAR(cpuStats.angle / N, gpuStats.angle / N, 0.02);
+}
+
+TEST(EmulatorRejectsIndirectDispatchWithoutArgs)
+{
+	Fixture f(100, 1);
+	const string name = "particleSimulateCS";
+	auto simulate = f.device.CreateComputeShader(vector<BYTE>(name.begin(), name.end()));
+	const UINT groups[4] = { 1, 1, 1, 0 };
+	auto args = f.device.CreateBuffer(groups, BufferDescription::IndirectArgsBufferDescription(sizeof(groups)));
+	auto& context = f.device.context();
+	context->CSSetShader(simulate.get(), nullptr, 0);
+	context->DispatchIndirect(args.get(), 0);
+	CHECK_THROWS(f.emulator.Run());
+}
+
+TEST(EmulatorRejectsParticlesReadWhileWritten)
+{
+	Fixture f(100, 1);
+	f.system.AddBurst(XMFLOAT3(0.0f, 0.5f, 0.0f), Upwards(), 10);
+	CHECK_EQ(10u, f.Step().size());
+	//particles left bound for drawing are consumed by the next simulation
+	auto& log = test::MockContext(f.device).log();
+	auto draw = find_if(log.rbegin(), log.rend(), [](const mock::Context::Call& c) { return c.name == "VSSetShaderResources"; });
+	auto& context = f.device.context();
+	auto particles = Object<ID3D11ShaderResourceView>((draw + 1)->objects[0]);
+	context->VSSetShaderResources(0, 1, &particles);
+	f.system.Update(context, DT);
+	CHECK_THROWS(f.emulator.Run());
+}
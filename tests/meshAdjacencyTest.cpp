@@ -0,0 +1,135 @@
+#include "test.h"
+#include "meshAdjacency.h"
+#include "vertexTypes.h"
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Unit cube with a vertex per face corner, so every corner is split three ways by its normals
+	void SplitNormalCube(vector<VertexPositionNormalTex>& verts, vector<unsigned int>& indices)
+	{
+		const XMFLOAT3 normals[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		for (auto& n : normals)
+		{
+			//two axes spanning the face, u x v = n so the face winds outwards
+			XMVECTOR normal = XMLoadFloat3(&n);
+			XMVECTOR u = XMVectorSet(n.y != 0.0f ? 1.0f : 0.0f, n.y == 0.0f ? 1.0f : 0.0f, 0.0f, 0.0f);
+			u = XMVector3Cross(u, normal);
+			XMVECTOR v = XMVector3Cross(normal, u);
+			auto first = static_cast<unsigned int>(verts.size());
+			for (auto corner : { XMFLOAT2(-1, -1), XMFLOAT2(1, -1), XMFLOAT2(1, 1), XMFLOAT2(-1, 1) })
+			{
+				VertexPositionNormalTex vertex = {};
+				XMStoreFloat3(&vertex.position, 0.5f * (normal + corner.x * u + corner.y * v));
+				vertex.normal = n;
+				verts.push_back(vertex);
+			}
+			indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+		}
+	}
+
+	size_t BorderCount(const MeshAdjacency& adjacency)
+	{
+		size_t borders = 0;
+		for (auto& e : adjacency.edges)
+			borders += e.face1 == MeshAdjacency::NO_FACE;
+		return borders;
+	}
+
+	//Entries for the edge between positions a and b, in order
+	vector<AdjacencyEdge> EdgesBetween(const MeshAdjacency& adjacency, unsigned int a, unsigned int b)
+	{
+		vector<AdjacencyEdge> result;
+		for (auto& e : adjacency.edges)
+			if ((e.v0 == a && e.v1 == b) || (e.v0 == b && e.v1 == a))
+				result.push_back(e);
+		return result;
+	}
+}
+
+TEST(SplitNormalCubeWeldsIntoAClosedSurface)
+{
+	vector<VertexPositionNormalTex> verts;
+	vector<unsigned int> indices;
+	SplitNormalCube(verts, indices);
+	CHECK_EQ(24u, verts.size());
+	auto adjacency = BuildAdjacency(verts, indices);
+	CHECK_EQ(8u, adjacency.positions.size());
+	CHECK_EQ(12u, adjacency.faceCount());
+	//12 cube edges and a diagonal on every side
+	CHECK_EQ(18u, adjacency.edges.size());
+	CHECK_EQ(0u, BorderCount(adjacency));
+	//face1 winds every edge the other way
+	for (auto& e : adjacency.edges)
+	{
+		bool found = false;
+		for (int k = 0; k < 3; ++k)
+			found |= adjacency.faces[3 * e.face1 + k] == e.v1 && adjacency.faces[3 * e.face1 + (k + 1) % 3] == e.v0;
+		CHECK(found);
+	}
+	for (auto& n : adjacency.faceNormals)
+		CHECK_NEAR(1.0f, XMVectorGetX(XMVector3Length(XMLoadFloat3(&n))), 1e-6f);
+}
+
+TEST(OpenQuadHasFourBorderEdges)
+{
+	vector<XMFLOAT3> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+	auto adjacency = BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), { 0, 1, 2, 0, 2, 3 });
+	CHECK_EQ(2u, adjacency.faceCount());
+	CHECK_EQ(5u, adjacency.edges.size());
+	CHECK_EQ(4u, BorderCount(adjacency));
+	auto diagonal = EdgesBetween(adjacency, 0, 2);
+	CHECK_EQ(1u, diagonal.size());
+	CHECK_EQ(0u, diagonal[0].face0);
+	CHECK_EQ(1u, diagonal[0].face1);
+}
+
+TEST(EdgesOfMoreThanTwoFacesAreSplitInFaceOrder)
+{
+	//fins around the edge 0-1, alternating windings
+	vector<XMFLOAT3> positions = { { 0, 0, 0 }, { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 }, { -1, 0, 0 }, { 0, -1, 0 }, { 1, 1, 0 } };
+	vector<unsigned int> indices = { 0, 1, 2, 1, 0, 3, 0, 1, 4, 1, 0, 5, 0, 1, 6 };
+	auto adjacency = BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), indices);
+	CHECK_EQ(5u, adjacency.faceCount());
+	//each face pairs with the next unpaired one winding the edge the other way
+	auto shared = EdgesBetween(adjacency, 0, 1);
+	CHECK_EQ(3u, shared.size());
+	CHECK_EQ(0u, shared[0].face0);
+	CHECK_EQ(1u, shared[0].face1);
+	CHECK_EQ(2u, shared[1].face0);
+	CHECK_EQ(3u, shared[1].face1);
+	CHECK_EQ(4u, shared[2].face0);
+	CHECK(shared[2].face1 == MeshAdjacency::NO_FACE);
+	//the same input always gives the same split
+	auto again = BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), indices);
+	CHECK_EQ(adjacency.edges.size(), again.edges.size());
+	for (size_t i = 0; i < adjacency.edges.size(); ++i)
+	{
+		CHECK_EQ(adjacency.edges[i].v0, again.edges[i].v0);
+		CHECK_EQ(adjacency.edges[i].face0, again.edges[i].face0);
+		CHECK_EQ(adjacency.edges[i].face1, again.edges[i].face1);
+	}
+}
+
+TEST(FacesWindingAnEdgeTheSameWayAreNotPaired)
+{
+	vector<XMFLOAT3> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+	auto adjacency = BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), { 0, 1, 2, 0, 1, 3 });
+	auto shared = EdgesBetween(adjacency, 0, 1);
+	CHECK_EQ(2u, shared.size());
+	CHECK(shared[0].face1 == MeshAdjacency::NO_FACE);
+	CHECK(shared[1].face1 == MeshAdjacency::NO_FACE);
+}
+
+TEST(DegenerateFacesAreDropped)
+{
+	//the second face collapses after welding, the third has zero area
+	vector<XMFLOAT3> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1e-9f, 0, 0 }, { 2, 0, 0 } };
+	auto adjacency = BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), { 0, 1, 2, 0, 3, 2, 0, 1, 4 });
+	CHECK_EQ(4u, adjacency.positions.size());
+	CHECK_EQ(1u, adjacency.faceCount());
+	CHECK_EQ(3u, adjacency.edges.size());
+}
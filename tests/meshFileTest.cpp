@@ -0,0 +1,236 @@
+#include "test.h"
+#include "mesh.h"
+#include "mockDevice.h"
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	const wstring DUCK = L"../Robot/resources/duck/duck.txt";
+
+	//Duck converted like with -convertmesh
+	wstring ConvertedDuck()
+	{
+		auto path = (filesystem::temp_directory_path() / "meshFileTest.mesh").wstring();
+		ConvertTextMesh(DUCK, path);
+		return path;
+	}
+
+	//Copy of the converted duck changed by patch, with the checksum fixed up when resealed
+	wstring PatchedDuck(function<void(vector<char>&, MeshFileHeader&)> patch, bool reseal = true)
+	{
+		auto source = filesystem::path(ConvertedDuck());
+		vector<char> bytes(filesystem::file_size(source));
+		ifstream(source, ios::binary).read(bytes.data(), bytes.size());
+		MeshFileHeader header;
+		memcpy(&header, bytes.data(), sizeof(header));
+		patch(bytes, header);
+		if (reseal)
+			header.checksum = MeshChecksum(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+		memcpy(bytes.data(), &header, sizeof(header));
+		auto path = filesystem::temp_directory_path() / "meshFileTestPatched.mesh";
+		ofstream(path, ios::binary).write(bytes.data(), bytes.size());
+		return path.wstring();
+	}
+
+	bool Parses(const wstring& path)
+	{
+		MappedFile file(path);
+		try
+		{
+			ParseBinaryMesh(file, path);
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	//Vertex and index buffers bound when the mesh is drawn
+	pair<const mock::Buffer*, const mock::Buffer*> DrawnBuffers(const DxDevice& device, const Mesh& mesh, UINT& stride)
+	{
+		auto& context = test::MockContext(device);
+		context.ClearLog();
+		mesh.Render(device.context());
+		const mock::Buffer* vertices = nullptr;
+		const mock::Buffer* indices = nullptr;
+		for (auto& call : context.log())
+			if (call.name == "IASetVertexBuffers")
+			{
+				vertices = static_cast<const mock::Buffer*>(static_cast<const ID3D11Buffer*>(call.objects[0]));
+				stride = call.values[2];
+			}
+			else if (call.name == "IASetIndexBuffer")
+				indices = static_cast<const mock::Buffer*>(static_cast<const ID3D11Buffer*>(call.objects[0]));
+		return { vertices, indices };
+	}
+}
+
+TEST(ConvertedDuckStoresQuantizedVertices)
+{
+	auto path = ConvertedDuck();
+	MappedFile file(path);
+	auto view = ParseBinaryMesh(file, path);
+	CHECK(view.header->vertexFormat == MeshVertexFormat::PositionNormalTexQuantized);
+	CHECK_EQ(sizeof(VertexPositionNormalTexQuantized), size_t(view.header->vertexStride));
+	CHECK(view.dequantization != nullptr);
+	//vertices after the dequantization keep the blob alignment
+	CHECK_EQ(0u, size_t(view.vertices - file.data()) % MeshFileHeader::BLOB_ALIGNMENT);
+
+	auto text = ReadTextMesh(DUCK);
+	auto binary = ReadBinaryMesh(file, path);
+	CHECK_EQ(text.vertices.size(), binary.vertices.size());
+	CHECK(!binary.lods.empty());
+	CHECK(AcceptQuantization(MeasureQuantizationError(binary.vertices, QuantizeVertices(binary.vertices)),
+		BoundingDiagonal(text.vertices)));
+}
+
+TEST(QuantizedDuckIsUploadedFromTheMapping)
+{
+	auto path = ConvertedDuck();
+	auto decoded = Mesh::DecodeMesh(path, true, true);
+	CHECK(decoded.file.has_value());
+	CHECK(decoded.encoding.quantized);
+	//nothing was copied out of the file
+	CHECK(decoded.mesh.vertices.empty());
+	CHECK(decoded.mesh.indices.empty());
+	CHECK(decoded.quantized.vertices.empty());
+	auto vertices = decoded.view.vertices;
+	auto indices = decoded.view.indices;
+	auto faces = decoded.adjacency.faceCount();
+	CHECK(faces > 0);
+
+	auto device = test::CreateMockDevice();
+	auto mesh = Mesh::CreateMesh(device, move(decoded));
+	UINT stride = 0;
+	auto drawn = DrawnBuffers(device, mesh, stride);
+	CHECK(drawn.first && drawn.second);
+	CHECK_EQ(static_cast<const void*>(vertices), drawn.first->initialData());
+	CHECK_EQ(static_cast<const void*>(indices), drawn.second->initialData());
+	CHECK_EQ(sizeof(VertexPositionNormalTexQuantized), size_t(stride));
+	//the adjacency of the text duck, decoded from the quantized positions
+	CHECK_EQ(Mesh::DecodeMesh(DUCK, false, false).adjacency.faceCount(), faces);
+}
+
+TEST(QuantizedFileWithoutEncodingIsDequantized)
+{
+	auto path = ConvertedDuck();
+	auto device = test::CreateMockDevice();
+	auto mesh = Mesh::LoadBinaryMesh(device, path);
+	UINT stride = 0;
+	auto drawn = DrawnBuffers(device, mesh, stride);
+	CHECK(drawn.first != nullptr);
+	CHECK_EQ(sizeof(VertexPositionNormalTex), size_t(stride));
+}
+
+TEST(FloatFilesAreUploadedFromTheMapping)
+{
+	auto path = (filesystem::temp_directory_path() / "meshFileTestFloat.mesh").wstring();
+	WriteBinaryMesh(path, ReadTextMesh(DUCK));
+	auto decoded = Mesh::DecodeMesh(path, true, true);
+	CHECK(!decoded.encoding.quantized);
+	auto vertices = decoded.view.vertices;
+
+	auto device = test::CreateMockDevice();
+	auto mesh = Mesh::CreateMesh(device, move(decoded));
+	UINT stride = 0;
+	auto drawn = DrawnBuffers(device, mesh, stride);
+	CHECK(drawn.first != nullptr);
+	CHECK_EQ(static_cast<const void*>(vertices), drawn.first->initialData());
+	CHECK_EQ(sizeof(VertexPositionNormalTex), size_t(stride));
+}
+
+TEST(CorruptedHeadersAreRejected)
+{
+	CHECK(Parses(PatchedDuck([](vector<char>&, MeshFileHeader&) { })));
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.magic[0] = 'X'; })));
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.version = MeshFileHeader::VERSION + 1; })));
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.indexSize = 3; })));
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.indexCount = 0x40000000u; })));
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.vertexOffset += 1; })));
+	CHECK(!Parses(PatchedDuck([](vector<char>& bytes, MeshFileHeader&) { bytes.back() ^= 1; }, false)));
+}
+
+TEST(IndicesPastTheVerticesAreRejected)
+{
+	//the converted duck has 16-bit indices
+	auto lastIndex = [](vector<char>& bytes, const MeshFileHeader& h)
+	{
+		return reinterpret_cast<uint16_t*>(bytes.data() + h.indexOffset) + h.indexCount - 1;
+	};
+	CHECK(Parses(PatchedDuck([&](vector<char>& bytes, MeshFileHeader& h) { *lastIndex(bytes, h) = uint16_t(h.vertexCount - 1); })));
+	CHECK(!Parses(PatchedDuck([&](vector<char>& bytes, MeshFileHeader& h) { *lastIndex(bytes, h) = uint16_t(h.vertexCount); })));
+	CHECK(!Parses(PatchedDuck([&](vector<char>& bytes, MeshFileHeader& h) { *lastIndex(bytes, h) = 0xffff; })));
+	//a smaller vertex count leaves the stored indices out of range
+	CHECK(!Parses(PatchedDuck([](vector<char>&, MeshFileHeader& h) { h.vertexCount /= 2; })));
+}
+
+TEST(OutOfRange32BitIndicesAreRejected)
+{
+	auto path = (filesystem::temp_directory_path() / "meshFileTestWide.mesh").wstring();
+	//enough vertices for 32-bit indices
+	MeshData mesh;
+	mesh.vertices.resize(65537);
+	mesh.indices = { 0, 1, 65536 };
+	WriteBinaryMesh(path, mesh);
+	{
+		MappedFile file(path);
+		CHECK_EQ(sizeof(uint32_t), size_t(ParseBinaryMesh(file, path).header->indexSize));
+	}
+	mesh.indices = { 0, 1, 65537 };
+	WriteBinaryMesh(path, mesh);
+	CHECK(!Parses(path));
+}
+
+TEST(IndicesWidenPast65536Vertices)
+{
+	//16-bit indices address vertices 0 to 65535
+	CHECK(!Mesh::Needs32BitIndices(0));
+	CHECK(!Mesh::Needs32BitIndices(65535));
+	CHECK(!Mesh::Needs32BitIndices(65536));
+	CHECK(Mesh::Needs32BitIndices(65537));
+}
+
+TEST(CreateMeshPicksTheIndexFormatFromTheVertexCount)
+{
+	auto device = test::CreateMockDevice();
+	auto& context = test::MockContext(device);
+	for (size_t count : { 65536u, 65537u })
+	{
+		auto expected = count > 65536 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+		auto path = (filesystem::temp_directory_path() / "meshFileTestFormat.mesh").wstring();
+		MeshData data;
+		data.vertices.resize(count);
+		data.indices = { 0, 1, static_cast<unsigned int>(count - 1) };
+		WriteBinaryMesh(path, data);
+		//built from memory and uploaded from the mapping
+		DecodedMesh decoded;
+		decoded.mesh = data;
+		vector<Mesh> meshes;
+		meshes.push_back(Mesh::CreateMesh(device, move(decoded)));
+		meshes.push_back(Mesh::CreateMesh(device, Mesh::DecodeMesh(path, true, true)));
+		for (auto& mesh : meshes)
+		{
+			CHECK_EQ(expected, mesh.indexFormat());
+			context.ClearLog();
+			mesh.Render(device.context());
+			CHECK_EQ(1u, context.Count("IASetIndexBuffer"));
+			for (auto& call : context.log())
+				if (call.name == "IASetIndexBuffer")
+				{
+					CHECK_EQ(static_cast<UINT>(expected), call.values[0]);
+					CHECK_EQ(3 * (expected == DXGI_FORMAT_R32_UINT ? 4u : 2u), static_cast<const mock::Buffer*>(
+						static_cast<const ID3D11Buffer*>(call.objects[0]))->desc().ByteWidth);
+				}
+		}
+		//a released mesh is back to the default format
+		Mesh moved(move(meshes[0]));
+		CHECK_EQ(expected, moved.indexFormat());
+		CHECK_EQ(DXGI_FORMAT_R16_UINT, meshes[0].indexFormat());
+	}
+}
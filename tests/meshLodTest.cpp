@@ -0,0 +1,134 @@
+#include "test.h"
+#include "meshLod.h"
+#include "mesh.h"
+#include "mockDevice.h"
+#include <cmath>
+#include <map>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Open side x side grid over the unit square in xz, gently curved so that simplification has
+	//something to measure
+	MeshData Grid(unsigned int side)
+	{
+		MeshData mesh;
+		for (unsigned int y = 0; y <= side; ++y)
+			for (unsigned int x = 0; x <= side; ++x)
+			{
+				float u = float(x) / side, v = float(y) / side;
+				mesh.vertices.push_back({ { u, 0.05f * sinf(3.0f * u) * cosf(2.0f * v), v }, { 0.0f, 1.0f, 0.0f }, { u, v } });
+			}
+		for (unsigned int y = 0; y < side; ++y)
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				unsigned int i = y * (side + 1) + x;
+				mesh.indices.insert(mesh.indices.end(), { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 });
+			}
+		return mesh;
+	}
+
+	//Edges used by a single triangle of the level
+	vector<pair<unsigned int, unsigned int>> BorderEdges(const MeshData& mesh, const MeshLodLevel& level)
+	{
+		map<pair<unsigned int, unsigned int>, int> uses;
+		for (uint32_t t = level.firstIndex; t < level.firstIndex + level.indexCount; t += 3)
+			for (int k = 0; k < 3; ++k)
+			{
+				auto a = mesh.indices[t + k], b = mesh.indices[t + (k + 1) % 3];
+				++uses[{ min(a, b), max(a, b) }];
+			}
+		vector<pair<unsigned int, unsigned int>> borders;
+		for (auto& [edge, count] : uses)
+			if (count == 1)
+				borders.push_back(edge);
+		return borders;
+	}
+
+	bool OnSquareBorder(const XMFLOAT3& p) { return p.x == 0.0f || p.x == 1.0f || p.z == 0.0f || p.z == 1.0f; }
+
+	//Mesh with LOD errors only, SelectLod reads nothing else
+	Mesh WithErrors(const DxDevice& device, initializer_list<float> errors)
+	{
+		DecodedMesh decoded;
+		decoded.mesh = Grid(1);
+		for (auto error : errors)
+			decoded.mesh.lods.push_back({ 0, 6, error, 0 });
+		return Mesh::CreateMesh(device, move(decoded));
+	}
+}
+
+TEST(EveryLevelHasFewerTrianglesAndMoreError)
+{
+	auto mesh = Grid(40);
+	auto fullCount = mesh.indices.size();
+	BuildLodChain(mesh);
+	CHECK(mesh.lods.size() > 2);
+	CHECK_EQ(0u, mesh.lods[0].firstIndex);
+	CHECK_EQ(fullCount, size_t(mesh.lods[0].indexCount));
+	CHECK_EQ(0.0f, mesh.lods[0].error);
+	for (size_t i = 1; i < mesh.lods.size(); ++i)
+	{
+		CHECK(mesh.lods[i].indexCount < mesh.lods[i - 1].indexCount);
+		CHECK(mesh.lods[i].error >= mesh.lods[i - 1].error);
+		CHECK_EQ(0u, mesh.lods[i].indexCount % 3);
+		//levels follow each other in the index buffer
+		CHECK_EQ(mesh.lods[i - 1].firstIndex + mesh.lods[i - 1].indexCount, mesh.lods[i].firstIndex);
+	}
+	auto& last = mesh.lods.back();
+	CHECK_EQ(mesh.indices.size(), size_t(last.firstIndex + last.indexCount));
+}
+
+TEST(OpenGridKeepsItsBorder)
+{
+	auto mesh = Grid(40);
+	BuildLodChain(mesh);
+	CHECK(mesh.lods.size() > 2);
+	for (auto& level : mesh.lods)
+	{
+		//seen from above the outline is the square, with every corner and the full length
+		double length = 0.0;
+		for (auto& [a, b] : BorderEdges(mesh, level))
+		{
+			auto& pa = mesh.vertices[a].position;
+			auto& pb = mesh.vertices[b].position;
+			CHECK(OnSquareBorder(pa) && OnSquareBorder(pb));
+			CHECK(pa.x == pb.x || pa.z == pb.z);
+			length += fabs(pa.x - pb.x) + fabs(pa.z - pb.z);
+		}
+		CHECK_NEAR(4.0, length, 1e-3);
+		for (unsigned int corner : { 0u, 40u, 41u * 40u, 41u * 41u - 1u })
+		{
+			bool used = false;
+			for (uint32_t i = level.firstIndex; i < level.firstIndex + level.indexCount; ++i)
+				used |= mesh.indices[i] == corner;
+			CHECK(used);
+		}
+	}
+}
+
+TEST(SelectLodPicksTheCoarsestLevelWithinThePixelError)
+{
+	auto device = test::CreateMockDevice();
+	auto mesh = WithErrors(device, { 0.0f, 0.01f, 0.04f, 0.16f });
+	CHECK_EQ(4u, mesh.lodCount());
+	//1000 pixels per unit at unit distance, the levels project to 10, 40 and 160 pixels at distance 1
+	const float SCALE = 1000.0f;
+	const XMFLOAT3 center(0.0f, 0.0f, 0.0f);
+	const pair<float, size_t> expected[] = { { 5.0f, 0 }, { 10.5f, 1 }, { 39.0f, 1 }, { 41.0f, 2 }, { 159.0f, 2 }, { 161.0f, 3 }, { 1000.0f, 3 } };
+	for (auto& [distance, lod] : expected)
+	{
+		OrbitCamera camera(center, 0.0f, FLT_MAX, distance);
+		CHECK_EQ(lod, SelectLod(mesh, 1.0f, center, camera, SCALE));
+	}
+	//a larger object or a stricter error keeps more detail
+	OrbitCamera camera(center, 0.0f, FLT_MAX, 50.0f);
+	CHECK_EQ(2u, SelectLod(mesh, 1.0f, center, camera, SCALE));
+	CHECK_EQ(1u, SelectLod(mesh, 2.0f, center, camera, SCALE));
+	CHECK_EQ(0u, SelectLod(mesh, 1.0f, center, camera, SCALE, 0.1f));
+	//distance is measured to the object's center
+	CHECK_EQ(3u, SelectLod(mesh, 1.0f, XMFLOAT3(0.0f, 0.0f, 200.0f), camera, SCALE));
+}
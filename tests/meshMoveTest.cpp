@@ -0,0 +1,155 @@
+#include "test.h"
+#include "mesh.h"
+#include "mockDevice.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using namespace mini;
+
+//Every allocation of the test goes through these, so moves can be shown not to allocate
+namespace
+{
+	atomic<size_t> allocations{ 0 };
+}
+
+void* operator new(size_t size)
+{
+	++allocations;
+	if (auto p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace
+{
+	//Allocations made while it was alive
+	class AllocationCount
+	{
+	public:
+		AllocationCount() : m_start(allocations) { }
+		size_t operator()() const { return allocations - m_start; }
+
+	private:
+		size_t m_start;
+	};
+
+	//Grid with two LODs and adjacency, so every member of Mesh holds memory
+	DecodedMesh Grid(unsigned int side)
+	{
+		DecodedMesh decoded;
+		auto& mesh = decoded.mesh;
+		for (unsigned int y = 0; y <= side; ++y)
+			for (unsigned int x = 0; x <= side; ++x)
+				mesh.vertices.push_back({ { static_cast<float>(x), static_cast<float>(y), 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f } });
+		for (unsigned int y = 0; y < side; ++y)
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				unsigned int v = y * (side + 1) + x;
+				mesh.indices.insert(mesh.indices.end(), { v, v + side + 1, v + 1, v + 1, v + side + 1, v + side + 2 });
+			}
+		auto count = static_cast<uint32_t>(mesh.indices.size());
+		decoded.adjacency = BuildAdjacency(mesh.vertices, mesh.indices);
+		//the coarse level just reuses the first two triangles
+		mesh.lods = { { 0, count, 0.0f, 0 }, { 0, 6, 0.5f, 0 } };
+		mesh.indices.insert(mesh.indices.end(), mesh.indices.begin(), mesh.indices.begin() + 6);
+		mesh.lods[1].firstIndex = count;
+		return decoded;
+	}
+
+	//Objects bound by a draw of the mesh, empty when it draws nothing
+	vector<const void*> Drawn(const DxDevice& device, const Mesh& mesh, size_t lod = 0)
+	{
+		auto& context = test::MockContext(device);
+		context.ClearLog();
+		mesh.Render(device.context(), lod);
+		vector<const void*> objects;
+		for (auto& call : context.log())
+			objects.insert(objects.end(), call.objects.begin(), call.objects.end());
+		return objects;
+	}
+}
+
+TEST(MeshMovesDoNotAllocate)
+{
+	auto device = test::CreateMockDevice();
+	auto mesh = Mesh::CreateMesh(device, Grid(8));
+	CHECK_EQ(2u, mesh.lodCount());
+	CHECK(!mesh.adjacency().empty());
+	auto drawn = Drawn(device, mesh, 1);
+	CHECK(!drawn.empty());
+	auto edges = mesh.adjacency().edges.data();
+
+	AllocationCount count;
+	Mesh moved(move(mesh));
+	Mesh assigned;
+	assigned = move(moved);
+	CHECK_EQ(0u, count());
+
+	//the same buffers and arrays changed hands
+	CHECK(Drawn(device, assigned, 1) == drawn);
+	CHECK_EQ(edges, assigned.adjacency().edges.data());
+	CHECK_EQ(2u, assigned.lodCount());
+}
+
+TEST(MovedFromMeshIsEmpty)
+{
+	auto device = test::CreateMockDevice();
+	auto mesh = Mesh::CreateMesh(device, Grid(4));
+	Mesh moved(move(mesh));
+	CHECK(Drawn(device, mesh).empty());
+	CHECK_EQ(1u, mesh.lodCount());
+	CHECK(mesh.adjacency().empty());
+	CHECK(mesh.adjacency().positions.empty());
+
+	//assigning over a mesh replaces what it had, the source is left empty too
+	auto other = Mesh::CreateMesh(device, Grid(2));
+	auto drawn = Drawn(device, moved);
+	AllocationCount count;
+	other = move(moved);
+	CHECK_EQ(0u, count());
+	CHECK(Drawn(device, other) == drawn);
+	CHECK(Drawn(device, moved).empty());
+
+	//self-assignment keeps the mesh
+	auto& self = other;
+	other = move(self);
+	CHECK(Drawn(device, other) == drawn);
+}
+
+TEST(GrowingAVectorOfMeshesOnlyAllocatesItsStorage)
+{
+	auto device = test::CreateMockDevice();
+	vector<Mesh> meshes;
+	meshes.reserve(1);
+	meshes.push_back(Mesh::CreateMesh(device, Grid(4)));
+	auto drawn = Drawn(device, meshes[0]);
+	auto mesh = Mesh::CreateMesh(device, Grid(3));
+	AllocationCount count;
+	//reallocation moves the meshes since their moves are noexcept, copying would allocate per member
+	meshes.push_back(move(mesh));
+	CHECK_EQ(1u, count());
+	CHECK(Drawn(device, meshes[0]) == drawn);
+}
+
+TEST(AdjacencyMovesDoNotAllocate)
+{
+	auto decoded = Grid(6);
+	auto& adjacency = decoded.adjacency;
+	auto faces = adjacency.faces.data();
+	AllocationCount count;
+	MeshAdjacency moved(move(adjacency));
+	MeshAdjacency assigned;
+	assigned = move(moved);
+	CHECK_EQ(0u, count());
+	CHECK_EQ(faces, assigned.faces.data());
+	//a copy allocates each of the four arrays, the cost the moves avoid
+	AllocationCount copyCount;
+	MeshAdjacency copy(assigned);
+	CHECK_EQ(4u, copyCount());
+	CHECK(copy.edges.size() == assigned.edges.size());
+}
@@ -0,0 +1,150 @@
+#include "test.h"
+#include "meshOptimizer.h"
+#include "meshFile.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//Regular grid of quads with the triangles in random order, the worst case for the vertex cache
+	MeshData ShuffledGrid(unsigned int side)
+	{
+		MeshData mesh;
+		for (unsigned int y = 0; y <= side; ++y)
+			for (unsigned int x = 0; x <= side; ++x)
+				mesh.vertices.push_back({ { static_cast<float>(x), static_cast<float>(y), 0.0f }, { 0.0f, 0.0f, -1.0f },
+					{ static_cast<float>(x) / side, static_cast<float>(y) / side } });
+		vector<array<unsigned int, 3>> triangles;
+		for (unsigned int y = 0; y < side; ++y)
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				unsigned int v = y * (side + 1) + x;
+				triangles.push_back({ v, v + side + 1, v + 1 });
+				triangles.push_back({ v + 1, v + side + 1, v + side + 2 });
+			}
+		shuffle(triangles.begin(), triangles.end(), mt19937{ 7 });
+		for (auto& t : triangles)
+			mesh.indices.insert(mesh.indices.end(), t.begin(), t.end());
+		return mesh;
+	}
+
+	//Triangles as position triples rotated to a canonical first corner, so that the
+	//comparison ignores triangle order and vertex renumbering but not the winding
+	vector<array<float, 9>> Triangles(const MeshData& mesh)
+	{
+		vector<array<float, 9>> result;
+		for (size_t t = 0; t < mesh.indices.size(); t += 3)
+		{
+			array<float, 9> corners;
+			for (int k = 0; k < 3; ++k)
+			{
+				auto& p = mesh.vertices[mesh.indices[t + k]].position;
+				corners[3 * k] = p.x;
+				corners[3 * k + 1] = p.y;
+				corners[3 * k + 2] = p.z;
+			}
+			auto best = corners;
+			for (int r = 1; r < 3; ++r)
+			{
+				array<float, 9> rotated;
+				for (int k = 0; k < 9; ++k)
+					rotated[k] = corners[(k + 3 * r) % 9];
+				best = min(best, rotated);
+			}
+			result.push_back(best);
+		}
+		sort(result.begin(), result.end());
+		return result;
+	}
+}
+
+TEST(AnalyzeVertexCacheCountsFifoMisses)
+{
+	//second triangle shares an edge, the third one reuses nothing
+	vector<unsigned int> indices = { 0, 1, 2, 2, 1, 3, 4, 5, 6 };
+	auto stats = AnalyzeVertexCache(indices, 7);
+	CHECK_NEAR(7.0 / 3.0, stats.acmr, 1e-6);
+	CHECK_NEAR(1.0, stats.atvr, 1e-6);
+	//a cache of three only holds the last triangle
+	auto small = AnalyzeVertexCache({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3);
+	CHECK_NEAR(3.0, small.acmr, 1e-6);
+}
+
+TEST(OptimizeVertexCacheKeepsTrianglesAndImprovesAcmr)
+{
+	auto mesh = ShuffledGrid(32);
+	auto before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	auto indices = OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	CHECK_EQ(mesh.indices.size(), indices.size());
+	auto after = AnalyzeVertexCache(indices, mesh.vertices.size());
+	CHECK(before.acmr > 2.0f);
+	CHECK(after.acmr < 0.8f);
+
+	auto expected = Triangles(mesh);
+	mesh.indices = indices;
+	CHECK(expected == Triangles(mesh));
+}
+
+TEST(OptimizeOverdrawKeepsTriangles)
+{
+	auto mesh = ShuffledGrid(16);
+	auto expected = Triangles(mesh);
+	mesh.indices = OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	auto cached = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	mesh.indices = OptimizeOverdraw(mesh.indices, &mesh.vertices[0].position.x, mesh.vertices.size(),
+		sizeof(VertexPositionNormalTex));
+	CHECK(expected == Triangles(mesh));
+	//clusters are cut where the cache restarts, so the ratio barely moves
+	CHECK(AnalyzeVertexCache(mesh.indices, mesh.vertices.size()).acmr < cached.acmr * 1.05f);
+}
+
+TEST(VertexFetchRemapOrdersByFirstUse)
+{
+	size_t used;
+	auto remap = VertexFetchRemap({ 3, 1, 4, 1, 3, 0 }, 6, used);
+	CHECK_EQ(4u, used);
+	CHECK_EQ(0u, remap[3]);
+	CHECK_EQ(1u, remap[1]);
+	CHECK_EQ(2u, remap[4]);
+	CHECK_EQ(3u, remap[0]);
+	CHECK_EQ(UNUSED_VERTEX, remap[2]);
+	CHECK_EQ(UNUSED_VERTEX, remap[5]);
+}
+
+TEST(OptimizeVertexFetchDropsUnusedVertices)
+{
+	vector<int> verts = { 10, 11, 12, 13, 14 };
+	vector<unsigned int> indices = { 4, 2, 0, 0, 2, 4 };
+	OptimizeVertexFetch(verts, indices);
+	CHECK(verts == (vector<int>{ 14, 12, 10 }));
+	CHECK(indices == (vector<unsigned int>{ 0, 1, 2, 2, 1, 0 }));
+}
+
+TEST(OptimizeMeshReportsStats)
+{
+	auto mesh = ShuffledGrid(24);
+	auto expected = Triangles(mesh);
+	//an unreferenced vertex is dropped by the fetch ordering
+	mesh.vertices.push_back({ { -1.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f } });
+	auto stats = OptimizeMesh(mesh);
+	CHECK(stats.after.acmr < stats.before.acmr);
+	CHECK_EQ(25u * 25u, mesh.vertices.size());
+	CHECK(expected == Triangles(mesh));
+	size_t used;
+	auto remap = VertexFetchRemap(mesh.indices, mesh.vertices.size(), used);
+	vector<unsigned int> identity(mesh.vertices.size());
+	iota(identity.begin(), identity.end(), 0u);
+	CHECK(remap == identity);
+}
+
+TEST(OptimizeMeshAcceptsEmptyMesh)
+{
+	MeshData mesh;
+	auto stats = OptimizeMesh(mesh);
+	CHECK_EQ(0.0f, stats.after.acmr);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "dxDevice.h"
+#include "mockD3D.h"
+
+//DxDevice over the recording mock device
+
+namespace mini
+{
+	namespace test
+	{
+		inline DxDevice CreateMockDevice(const mock::DeviceOptions& options = {})
+		{
+			mock::NextDevice() = options;
+			Window window(nullptr, Window::m_defaultWindowWidth, Window::m_defaultWindowHeight);
+			return DxDevice(window);
+		}
+
+		inline mock::Device& MockDevice(const DxDevice& device)
+		{
+			return dynamic_cast<mock::Device&>(*device.operator->());
+		}
+
+		inline mock::Context& MockContext(const DxDevice& device)
+		{
+			return dynamic_cast<mock::Context&>(*device.context());
+		}
+	}
+}
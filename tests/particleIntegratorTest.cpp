@@ -0,0 +1,106 @@
+#include "test.h"
+#include "particleIntegrator.h"
+#include <random>
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	const ParticleIntegrationParams PARAMS = { 1.0f / 60.0f, { 0.0f, -9.81f, 0.5f }, 0.003f, 3.0f };
+
+	//Particles with random state, a few blocks of 16 and a tail. Ages are spread so that deaths
+	//land in different lanes of the first and later blocks and in the tail.
+	ParticleStore RandomStore(size_t count)
+	{
+		ParticleStore store(count);
+		mt19937 random(5);
+		uniform_real_distribution<float> coordinate(-2.0f, 2.0f), age(0.0f, PARAMS.timeToLive);
+		for (size_t i = 0; i < count; ++i)
+		{
+			store.Push({ coordinate(random), coordinate(random), coordinate(random) },
+				{ coordinate(random), coordinate(random), coordinate(random) }, 0.1f + 0.01f * i);
+			store.age[i] = i % 5 == 0 || i % 7 == 3 || i + 3 >= count ? PARAMS.timeToLive - 0.5f * PARAMS.dt : age(random);
+		}
+		return store;
+	}
+
+	bool SameParticles(const ParticleStore& a, const ParticleStore& b)
+	{
+		return a.posX == b.posX && a.posY == b.posY && a.posZ == b.posZ &&
+			a.velX == b.velX && a.velY == b.velY && a.velZ == b.velZ &&
+			a.age == b.age && a.size_ == b.size_ &&
+			a.lastX == b.lastX && a.lastY == b.lastY && a.lastZ == b.lastZ &&
+			a.historyX == b.historyX && a.historyY == b.historyY && a.historyZ == b.historyZ;
+	}
+
+	//SIMD levels this CPU can run besides Scalar
+	vector<SimdLevel> SupportedLevels()
+	{
+		vector<SimdLevel> levels;
+		for (auto level : { SimdLevel::AVX2, SimdLevel::AVX512 })
+			if (level <= DetectSimdLevel())
+				levels.push_back(level);
+		return levels;
+	}
+}
+
+TEST(EverySimdLevelMatchesScalar)
+{
+	const size_t count = 6 * 16 + 11;
+	for (auto level : SupportedLevels())
+	{
+		auto expected = RandomStore(count), actual = RandomStore(count);
+		vector<uint32_t> expectedDead(count), actualDead(count);
+		//a few steps, so the trail planes and later deaths are compared too
+		for (int step = 0; step < 3; ++step)
+		{
+			auto expectedCount = IntegrateParticles(expected, PARAMS, expectedDead.data(), SimdLevel::Scalar);
+			auto actualCount = IntegrateParticles(actual, PARAMS, actualDead.data(), level);
+			CHECK(expectedCount > 0);
+			CHECK_EQ(expectedCount, actualCount);
+			CHECK(equal(expectedDead.begin(), expectedDead.begin() + expectedCount, actualDead.begin()));
+			CHECK(SameParticles(expected, actual));
+			expected.AdvanceHistory();
+			actual.AdvanceHistory();
+		}
+	}
+}
+
+TEST(DeadIndicesAscendAcrossBlocksAndTail)
+{
+	const size_t count = 3 * 16 + 5;
+	for (auto level : SupportedLevels())
+	{
+		auto store = RandomStore(count);
+		//everything dies, every lane of every block and the whole tail
+		for (auto& age : store.age)
+			age = PARAMS.timeToLive;
+		vector<uint32_t> dead(count);
+		CHECK_EQ(count, IntegrateParticles(store, PARAMS, dead.data(), level));
+		for (size_t i = 0; i < count; ++i)
+			CHECK_EQ(static_cast<uint32_t>(i), dead[i]);
+	}
+}
+
+TEST(RangesStartingMidBlockMatchScalar)
+{
+	const size_t count = 5 * 16 + 9;
+	for (auto level : SupportedLevels())
+	{
+		auto expected = RandomStore(count), actual = RandomStore(count);
+		vector<uint32_t> expectedDead(count), actualDead(count);
+		//two ranges, as worker threads split them, neither aligned to a block
+		size_t expectedCount = IntegrateParticles(expected, PARAMS, expectedDead.data(), 3, 40, SimdLevel::Scalar);
+		expectedCount += IntegrateParticles(expected, PARAMS, expectedDead.data() + expectedCount, 40, count - 2, SimdLevel::Scalar);
+		size_t actualCount = IntegrateParticles(actual, PARAMS, actualDead.data(), 3, 40, level);
+		actualCount += IntegrateParticles(actual, PARAMS, actualDead.data() + actualCount, 40, count - 2, level);
+		CHECK_EQ(expectedCount, actualCount);
+		CHECK(equal(expectedDead.begin(), expectedDead.begin() + expectedCount, actualDead.begin()));
+		CHECK(SameParticles(expected, actual));
+		//particles outside the ranges are left alone
+		CHECK_EQ(RandomStore(count).posX[count - 1], actual.posX[count - 1]);
+	}
+}
@@ -0,0 +1,107 @@
+#include "test.h"
+#include "particleSort.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	struct Particles
+	{
+		vector<float> x, y, z;
+
+		size_t size() const { return x.size(); }
+		void Add(float px, float py, float pz)
+		{
+			x.push_back(px);
+			y.push_back(py);
+			z.push_back(pz);
+		}
+		float Distance2(uint32_t i, XMFLOAT4 camera) const
+		{
+			float dx = x[i] - camera.x, dy = y[i] - camera.y, dz = z[i] - camera.z;
+			return dx * dx + dy * dy + dz * dz;
+		}
+	};
+
+	Particles Random(size_t count, unsigned int seed)
+	{
+		Particles p;
+		mt19937 random(seed);
+		uniform_real_distribution<float> coordinate(-2.0f, 2.0f);
+		for (size_t i = 0; i < count; ++i)
+			p.Add(coordinate(random), coordinate(random), coordinate(random));
+		return p;
+	}
+
+	//Every particle exactly once, from the farthest to the nearest
+	void CheckBackToFront(const vector<uint32_t>& order, const Particles& p, XMFLOAT4 camera)
+	{
+		CHECK_EQ(p.size(), order.size());
+		vector<uint32_t> sorted(order);
+		sort(sorted.begin(), sorted.end());
+		vector<uint32_t> all(p.size());
+		iota(all.begin(), all.end(), 0u);
+		CHECK(sorted == all);
+		for (size_t k = 1; k < order.size(); ++k)
+			CHECK(p.Distance2(order[k - 1], camera) >= p.Distance2(order[k], camera));
+	}
+}
+
+TEST(ParticlesAreOrderedBackToFront)
+{
+	auto p = Random(5000, 1);
+	DepthSorter sorter;
+	XMFLOAT4 camera(0.3f, 1.5f, -3.0f, 1.0f);
+	CheckBackToFront(sorter.Sort(p.x.data(), p.y.data(), p.z.data(), p.size(), camera), p, camera);
+	CHECK(&sorter.order() == &sorter.Sort(p.x.data(), p.y.data(), p.z.data(), p.size(), camera));
+}
+
+TEST(EqualDistancesKeepParticleOrder)
+{
+	//particles on a sphere around the camera, with one nearer and one further away
+	Particles p;
+	p.Add(1.0f, 0.0f, 0.0f);
+	p.Add(0.0f, 1.0f, 0.0f);
+	p.Add(0.0f, 0.0f, 0.5f);
+	p.Add(0.0f, 0.0f, -1.0f);
+	p.Add(0.0f, -3.0f, 0.0f);
+	p.Add(-1.0f, 0.0f, 0.0f);
+	DepthSorter sorter;
+	auto& order = sorter.Sort(p.x.data(), p.y.data(), p.z.data(), p.size(), { 0.0f, 0.0f, 0.0f, 1.0f });
+	CHECK(order == (vector<uint32_t>{ 4, 0, 1, 3, 5, 2 }));
+}
+
+TEST(ConstantDigitsAreSkipped)
+{
+	//distances differing only in their lowest bits leave the upper passes out, the order still holds
+	Particles p;
+	for (int i = 0; i < 300; ++i)
+		p.Add(1.0f + (i * 7919 % 300) * 1e-6f, 0.0f, 0.0f);
+	DepthSorter sorter;
+	XMFLOAT4 camera(0.0f, 0.0f, 0.0f, 1.0f);
+	CheckBackToFront(sorter.Sort(p.x.data(), p.y.data(), p.z.data(), p.size(), camera), p, camera);
+	//all at the same distance, no pass runs and the order is the identity
+	Particles same;
+	for (int i = 0; i < 10; ++i)
+		same.Add(2.0f, 0.0f, 0.0f);
+	auto& order = sorter.Sort(same.x.data(), same.y.data(), same.z.data(), same.size(), camera);
+	for (uint32_t i = 0; i < 10; ++i)
+		CHECK_EQ(i, order[i]);
+}
+
+TEST(SorterIsReusedAcrossCounts)
+{
+	DepthSorter sorter(64);
+	XMFLOAT4 camera(1.0f, 2.0f, 3.0f, 1.0f);
+	for (size_t count : { 1000u, 10u, 0u, 3000u, 1u })
+	{
+		auto p = Random(count, static_cast<unsigned int>(count));
+		CheckBackToFront(sorter.Sort(p.x.data(), p.y.data(), p.z.data(), p.size(), camera), p, camera);
+	}
+}
@@ -0,0 +1,123 @@
+#include "test.h"
+#include "particleSystem.h"
+#include <algorithm>
+
+using namespace std;
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+
+namespace
+{
+	const float DT = 1.0f / 60.0f;
+	//room for several integration chunks
+	const size_t CAPACITY = 3 * ParticleSystem::PARALLEL_CHUNK + 1000;
+
+	XMMATRIX Tilted(float angle) { return XMMatrixRotationZ(angle); }
+
+	//Permanent, timed and burst emitters added and expiring while the store fills up
+	ParticleSystem Run(WorkerPool* pool)
+	{
+		ParticleSystem system(Tilted(0.0f), XMFLOAT3(0.0f, 0.5f, 0.0f), CAPACITY, 11);
+		system.SetWorkerPool(pool);
+		for (int k = 0; k < 4; ++k)
+			system.AddEmitter(XMFLOAT3(0.2f * k, 0.4f, 0.0f), Tilted(0.1f * k), 6000.0f, 0.1f + 0.15f * k);
+		for (int step = 0; step < 120; ++step)
+		{
+			if (step % 25 == 5)
+			{
+				system.AddBurst(XMFLOAT3(-0.3f, 0.6f, 0.1f * step), Tilted(-0.2f), 3000);
+				system.AddEmitter(XMFLOAT3(0.0f, 0.3f, -0.2f), Tilted(0.3f), 9000.0f, 0.2f);
+			}
+			system.Simulate(DT);
+		}
+		return system;
+	}
+
+	bool SameParticles(const ParticleStore& a, const ParticleStore& b)
+	{
+		return a.size() == b.size() && a.historyHead == b.historyHead &&
+			a.posX == b.posX && a.posY == b.posY && a.posZ == b.posZ &&
+			a.velX == b.velX && a.velY == b.velY && a.velZ == b.velZ &&
+			a.age == b.age && a.size_ == b.size_ &&
+			a.lastX == b.lastX && a.lastY == b.lastY && a.lastZ == b.lastZ &&
+			a.historyX == b.historyX && a.historyY == b.historyY && a.historyZ == b.historyZ;
+	}
+}
+
+TEST(ResultsDoNotDependOnTheWorkerCount)
+{
+	auto serial = Run(nullptr);
+	//the store saturated, so integration ran in several chunks
+	CHECK(serial.particlesCount() > 2 * ParticleSystem::PARALLEL_CHUNK);
+	CHECK_EQ(1u, serial.emittersCount());
+	for (unsigned int workers : { 1u, 4u })
+	{
+		WorkerPool pool(workers);
+		auto parallel = Run(&pool);
+		CHECK_EQ(serial.emittersCount(), parallel.emittersCount());
+		CHECK(SameParticles(serial.particles(), parallel.particles()));
+	}
+}
+
+TEST(ExpiredEmitterSlotsAreReused)
+{
+	EmitterSet emitters;
+	emitters.Reserve(4);
+	auto add = [&emitters](float lifetime)
+	{
+		return &emitters.Add(MakeEmitter(XMFLOAT3(lifetime, 0.0f, 0.0f), XMMatrixIdentity(), 1.0f, lifetime, 3, 0));
+	};
+	auto permanent = add(-1.0f);
+	auto first = add(0.5f);
+	auto second = add(1.5f);
+	auto third = add(2.5f);
+	emitters.Expire(1.0f);
+	//the last live emitter takes the place of the expired one, nothing moves in memory
+	CHECK_EQ(3u, emitters.size());
+	CHECK_EQ(permanent, &emitters[0]);
+	CHECK_EQ(third, &emitters[1]);
+	CHECK_EQ(second, &emitters[2]);
+	CHECK_NEAR(0.5f, second->lifetime, 1e-6f);
+	CHECK_NEAR(1.5f, third->lifetime, 1e-6f);
+	CHECK_EQ(first, add(4.0f));
+	emitters.Expire(1.0f);
+	CHECK_EQ(3u, emitters.size());
+	CHECK_EQ(permanent, &emitters[0]);
+	CHECK_EQ(third, &emitters[1]);
+	CHECK_EQ(first, &emitters[2]);
+	CHECK_NEAR(-1.0f, permanent->lifetime, 1e-6f);
+}
+
+TEST(TruncatedOutputKeepsTheNearestParticles)
+{
+	const XMFLOAT4 camera(0.5f, 1.0f, -2.0f, 1.0f);
+	ParticleSystem full(Tilted(0.0f), XMFLOAT3(0.0f, 0.5f, 0.0f), 2000, 5), truncated(Tilted(0.0f), XMFLOAT3(0.0f, 0.5f, 0.0f), 2000, 5);
+	for (int step = 0; step < 90; ++step)
+	{
+		full.Simulate(DT);
+		truncated.Simulate(DT);
+	}
+	auto& all = full.Update(DT, camera);
+	vector<ParticleVertex> out(all.size());
+	const size_t CAPACITY = all.size() / 3;
+	CHECK(CAPACITY > 10);
+	CHECK_EQ(CAPACITY, truncated.Update(DT, camera, out.data(), CAPACITY));
+
+	//the tail of the full back to front order, still back to front
+	auto distance = [&camera](const ParticleVertex& v)
+	{
+		return XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&v.Pos) - XMLoadFloat4(&camera)));
+	};
+	size_t first = all.size() - CAPACITY;
+	for (size_t k = 0; k < CAPACITY; ++k)
+	{
+		CHECK_EQ(all[first + k].Pos.x, out[k].Pos.x);
+		CHECK_EQ(all[first + k].Age, out[k].Age);
+	}
+	float nearestDropped = distance(all[0]);
+	for (size_t k = 0; k < first; ++k)
+		nearestDropped = min(nearestDropped, distance(all[k]));
+	for (size_t k = 0; k < CAPACITY; ++k)
+		CHECK(distance(out[k]) <= nearestDropped);
+}
@@ -0,0 +1,104 @@
+#include "test.h"
+#include "pipelineState.h"
+#include "mockD3D.h"
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	struct Fixture
+	{
+		dx_ptr<mock::Context> context{ new mock::Context };
+		StateCache state{ context.get(), context.get() };
+		dx_ptr<mock::InputLayout> layout{ new mock::InputLayout };
+		dx_ptr<mock::VertexShader> vs{ new mock::VertexShader };
+		dx_ptr<mock::PixelShader> ps1{ new mock::PixelShader }, ps2{ new mock::PixelShader };
+		dx_ptr<mock::BlendState> blend{ new mock::BlendState };
+		dx_ptr<mock::DepthStencilState> depth{ new mock::DepthStencilState };
+		dx_ptr<mock::RasterizerState> rasterizer{ new mock::RasterizerState };
+
+		PipelineStateDesc Desc(ID3D11PixelShader* ps) const
+		{
+			PipelineStateDesc desc;
+			desc.inputLayout = layout.get();
+			desc.vs = vs.get();
+			desc.ps = ps;
+			desc.blendState = blend.get();
+			desc.depthStencilState = depth.get();
+			desc.stencilRef = 1;
+			desc.rasterizerState = rasterizer.get();
+			return desc;
+		}
+	};
+}
+
+TEST(EqualDescriptionsShareAnId)
+{
+	Fixture f;
+	PipelineCache cache;
+	auto a = f.Desc(f.ps1.get());
+	auto b = f.Desc(f.ps2.get());
+	auto c = a;
+	c.topology = D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+	auto d = a;
+	d.stencilRef = 2;
+	//ids are dense in creation order
+	CHECK_EQ(0u, cache.Get(a));
+	CHECK_EQ(1u, cache.Get(b));
+	CHECK_EQ(0u, cache.Get(f.Desc(f.ps1.get())));
+	CHECK_EQ(2u, cache.Get(c));
+	CHECK_EQ(3u, cache.Get(d));
+	CHECK_EQ(1u, cache.Get(b));
+	CHECK_EQ(4u, cache.size());
+	CHECK(cache[2].desc() == c);
+	CHECK(cache[3].desc() == d);
+}
+
+TEST(StatesHoldTheirObjectsUntilTheCacheIsDestroyed)
+{
+	Fixture f;
+	{
+		PipelineCache cache;
+		cache.Get(f.Desc(f.ps1.get()));
+		CHECK_EQ(2u, f.vs->refs());
+		CHECK_EQ(2u, f.ps1->refs());
+		//an existing state takes no more references
+		cache.Get(f.Desc(f.ps1.get()));
+		CHECK_EQ(2u, f.vs->refs());
+		cache.Get(f.Desc(f.ps2.get()));
+		CHECK_EQ(3u, f.vs->refs());
+		CHECK_EQ(3u, f.rasterizer->refs());
+		CHECK_EQ(2u, f.ps1->refs());
+		CHECK_EQ(2u, f.ps2->refs());
+	}
+	for (ULONG refs : { f.layout->refs(), f.vs->refs(), f.ps1->refs(), f.ps2->refs(), f.blend->refs(), f.depth->refs(), f.rasterizer->refs() })
+		CHECK_EQ(1u, refs);
+}
+
+TEST(BindingSendsOnlyTheChangedParts)
+{
+	Fixture f;
+	PipelineCache cache;
+	auto a = cache.Get(f.Desc(f.ps1.get()));
+	auto desc = f.Desc(f.ps2.get());
+	desc.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+	auto b = cache.Get(desc);
+
+	//the first bind reaches the context for every part, null geometry shader included
+	cache.Bind(f.state, a);
+	CHECK_EQ(8u, f.context->log().size());
+	CHECK_EQ(1u, f.context->Count("GSSetShader"));
+	f.context->ClearLog();
+	cache.Bind(f.state, a);
+	CHECK_EQ(0u, f.context->log().size());
+
+	cache.Bind(f.state, b);
+	CHECK_EQ(2u, f.context->log().size());
+	CHECK_EQ(1u, f.context->Count("PSSetShader"));
+	CHECK_EQ(1u, f.context->Count("IASetPrimitiveTopology"));
+	f.context->ClearLog();
+	cache.Bind(f.state, a);
+	CHECK_EQ(2u, f.context->log().size());
+	CHECK(f.context->log()[1].objects == vector<const void*>{ f.ps1.get() });
+}
@@ -0,0 +1,170 @@
+#include "test.h"
+#include "renderCommands.h"
+#include <string>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	//Backend writing every command it receives as a line of text
+	class RecordingBackend : public CommandBackend
+	{
+	public:
+		void SetPipeline(uint32_t pipeline) override { log.push_back("pipeline " + to_string(pipeline)); }
+		void BindConstants(uint8_t stage, uint8_t slot, uint32_t firstConstant, uint32_t constantCount) override
+		{
+			log.push_back("constants " + to_string(stage) + " " + to_string(slot) + " " +
+				to_string(firstConstant) + " " + to_string(constantCount));
+		}
+		void BindTextures(uint32_t textures) override { log.push_back("textures " + to_string(textures)); }
+		void Draw(uint32_t mesh, uint32_t lod) override { log.push_back("draw " + to_string(mesh) + " " + to_string(lod)); }
+
+		vector<string> log;
+	};
+
+	//Packet drawing mesh with the given state
+	void Packet(CommandRecorder& recorder, uint64_t key, uint32_t pipeline, uint32_t textures, uint32_t constants, uint32_t mesh)
+	{
+		recorder.Begin(key);
+		recorder.SetPipeline(pipeline);
+		recorder.BindTextures(textures);
+		recorder.BindConstants(0, 0, constants, 16);
+		recorder.Draw(mesh);
+	}
+
+	vector<uint32_t> DrawnMeshes(const RecordingBackend& backend)
+	{
+		vector<uint32_t> meshes;
+		for (auto& line : backend.log)
+			if (line.compare(0, 5, "draw ") == 0)
+				meshes.push_back(stoul(line.substr(5)));
+		return meshes;
+	}
+}
+
+TEST(DrawKeyFieldsAreOrderedPassPipelineMaterialDepth)
+{
+	CHECK_EQ(0x0100000000000000ull, DrawKey(1, 0, 0, 0.0f));
+	CHECK_EQ(0x0000100000000000ull, DrawKey(0, 1, 0, 0.0f));
+	CHECK_EQ(0x0000000100000000ull, DrawKey(0, 0, 1, 0.0f));
+	//the widest ids fill their own field and nothing else
+	CHECK_EQ(0xff00000000000000ull, DrawKey(0xff, 0, 0, 0.0f));
+	CHECK_EQ(0x00fff00000000000ull, DrawKey(0, 0xfff, 0, 0.0f));
+	CHECK_EQ(0x00000fff00000000ull, DrawKey(0, 0, 0xfff, 0.0f));
+
+	//a more significant field wins over everything below it
+	CHECK(DrawKey(1, 0, 0, 0.0f) > DrawKey(0, 0xfff, 0xfff, 1e30f));
+	CHECK(DrawKey(0, 1, 0, 0.0f) > DrawKey(0, 0, 0xfff, 1e30f));
+	CHECK(DrawKey(0, 0, 1, 0.0f) > DrawKey(0, 0, 0, 1e30f));
+}
+
+TEST(DrawKeyDepthOrder)
+{
+	CHECK(DrawKey(0, 3, 4, 1.0f) < DrawKey(0, 3, 4, 2.0f));
+	CHECK(DrawKey(0, 3, 4, 1.0f, true) > DrawKey(0, 3, 4, 2.0f, true));
+	//back to front only flips depth, not the fields above it
+	CHECK(DrawKey(0, 3, 4, 100.0f, true) < DrawKey(0, 3, 5, 1.0f, true));
+	//negative depths are clamped to the near plane
+	CHECK_EQ(DrawKey(0, 3, 4, 0.0f), DrawKey(0, 3, 4, -5.0f));
+}
+
+TEST(SortKeepsRecordingOrderOfEqualKeys)
+{
+	CommandQueue queue(3);
+	//recorded out of recorder order on purpose
+	Packet(queue.recorder(2), 5, 1, 1, 0, 20);
+	Packet(queue.recorder(0), 5, 1, 1, 0, 0);
+	Packet(queue.recorder(1), 5, 1, 1, 0, 10);
+	Packet(queue.recorder(0), 5, 1, 1, 0, 1);
+	Packet(queue.recorder(1), 2, 1, 1, 0, 11);
+	Packet(queue.recorder(2), 5, 1, 1, 0, 21);
+	Packet(queue.recorder(0), 9, 1, 1, 0, 2);
+	queue.Sort();
+	CHECK_EQ(7u, queue.packetCount());
+
+	RecordingBackend backend;
+	queue.Replay(backend);
+	CHECK(DrawnMeshes(backend) == (vector<uint32_t>{ 11, 0, 1, 10, 20, 21, 2 }));
+}
+
+TEST(CommandsBeforeBeginGetKeyZero)
+{
+	CommandQueue queue(1);
+	auto& recorder = queue.recorder(0);
+	recorder.Draw(7, 2);
+	Packet(recorder, 1, 1, 1, 0, 8);
+	CHECK_EQ(2u, recorder.packetCount());
+	queue.Sort();
+	RecordingBackend backend;
+	queue.Replay(backend);
+	CHECK(backend.log.front() == "draw 7 2");
+}
+
+TEST(ReplayDropsRedundantBinds)
+{
+	CommandQueue queue(2);
+	Packet(queue.recorder(0), DrawKey(0, 1, 1, 1.0f), 1, 1, 0, 0);
+	Packet(queue.recorder(1), DrawKey(0, 1, 1, 2.0f), 1, 1, 16, 1);
+	//same constants as the packet before, only the draw gets through
+	Packet(queue.recorder(0), DrawKey(0, 1, 1, 3.0f), 1, 1, 16, 2);
+	Packet(queue.recorder(1), DrawKey(0, 1, 2, 0.0f), 1, 2, 16, 3);
+	Packet(queue.recorder(0), DrawKey(0, 2, 2, 0.0f), 2, 2, 16, 4);
+	queue.Sort();
+
+	RecordingBackend backend;
+	auto stats = queue.Replay(backend);
+	CHECK(backend.log == (vector<string>{
+		"pipeline 1", "textures 1", "constants 0 0 0 16", "draw 0 0",
+		"constants 0 0 16 16", "draw 1 0",
+		"draw 2 0",
+		"textures 2", "draw 3 0",
+		"pipeline 2", "draw 4 0" }));
+	CHECK_EQ(5u, stats.draws);
+	CHECK_EQ(3u, stats.batches);
+	CHECK_EQ(6u, stats.stateChanges);
+	CHECK_EQ(9u, stats.redundant);
+}
+
+TEST(ConstantsAreTrackedPerStageAndSlot)
+{
+	CommandQueue queue(1);
+	auto& recorder = queue.recorder(0);
+	recorder.BindConstants(0, 1, 0, 16);
+	recorder.BindConstants(1, 1, 0, 16);
+	recorder.BindConstants(0, 2, 0, 16);
+	recorder.BindConstants(0, 1, 0, 16);
+	//a different count at the same offset is a different range
+	recorder.BindConstants(0, 1, 0, 32);
+	//slots past the tracked table always reach the backend
+	recorder.BindConstants(0, RenderCommand::CONSTANT_SLOTS, 0, 16);
+	recorder.BindConstants(0, RenderCommand::CONSTANT_SLOTS, 0, 16);
+	recorder.BindConstants(RenderCommand::STAGES, 0, 0, 16);
+	recorder.BindConstants(RenderCommand::STAGES, 0, 0, 16);
+	queue.Sort();
+
+	RecordingBackend backend;
+	auto stats = queue.Replay(backend);
+	CHECK_EQ(8u, backend.log.size());
+	CHECK_EQ(8u, stats.stateChanges);
+	CHECK_EQ(1u, stats.redundant);
+}
+
+TEST(PartialReplaysStartFromUnknownState)
+{
+	CommandQueue queue(1);
+	for (uint32_t i = 0; i < 4; ++i)
+		Packet(queue.recorder(0), i, 1, 1, 0, i);
+	queue.Sort();
+
+	RecordingBackend first, second;
+	auto a = queue.Replay(first, 0, 2);
+	//the second context hasn't seen the first half, so it binds everything again
+	auto b = queue.Replay(second, 2, 10);
+	CHECK(second.log == (vector<string>{ "pipeline 1", "textures 1", "constants 0 0 0 16", "draw 2 0", "draw 3 0" }));
+	a += b;
+	CHECK_EQ(4u, a.draws);
+	CHECK_EQ(2u, a.batches);
+	CHECK_EQ(6u, a.stateChanges);
+	CHECK_EQ(6u, a.redundant);
+}
@@ -0,0 +1,135 @@
+#include "test.h"
+#include "ringAllocator.h"
+#include <random>
+#include <utility>
+
+using namespace std;
+using namespace mini;
+
+TEST(BlocksAreAligned)
+{
+	RingAllocator ring(4096, 256, 3);
+	CHECK_EQ(0u, ring.Allocate(1));
+	CHECK_EQ(256u, ring.Allocate(256));
+	CHECK_EQ(512u, ring.Allocate(300));
+	CHECK_EQ(1024u, ring.Allocate(16));
+	CHECK_EQ(1280u, ring.used());
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(0));
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(4096));
+	//capacity is rounded down to the alignment
+	CHECK_EQ(768u, RingAllocator(1000, 256, 3).capacity());
+}
+
+TEST(BlocksAreKeptForThreeFramesInFlight)
+{
+	RingAllocator ring(4096, 256, 3);
+	CHECK_EQ(0u, ring.Allocate(1024));	//frame 0
+	//the GPU may still read frame 0 while frames 1 to 3 are recorded
+	for (int frame = 1; frame <= 3; ++frame)
+	{
+		ring.BeginFrame();
+		CHECK_EQ(1024u + (frame - 1) * 768u, ring.used());
+		ring.Allocate(768);
+	}
+	CHECK_EQ(1024u + 3 * 768u, ring.used());
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(1024));
+	//beginning frame 4 releases frame 0 and only frame 0
+	ring.BeginFrame();
+	CHECK_EQ(3 * 768u, ring.used());
+	CHECK_EQ(0u, ring.Allocate(1024));
+}
+
+TEST(EmptyFramesStillCountTowardsTheFence)
+{
+	RingAllocator ring(4096, 256, 3);
+	ring.Allocate(4096);
+	ring.BeginFrame();
+	ring.BeginFrame();
+	ring.BeginFrame();
+	CHECK_EQ(4096u, ring.used());
+	ring.BeginFrame();
+	CHECK_EQ(0u, ring.used());
+}
+
+TEST(WrapAroundSkipsTheTail)
+{
+	RingAllocator ring(1024, 256, 1);
+	CHECK_EQ(0u, ring.Allocate(512));	//frame 0
+	ring.BeginFrame();
+	CHECK_EQ(512u, ring.Allocate(256));	//frame 1
+	ring.BeginFrame();
+	CHECK_EQ(256u, ring.used());
+	//256 bytes are left at the end, the block goes to the front and the end counts as used
+	CHECK_EQ(0u, ring.Allocate(512));	//frame 2
+	CHECK_EQ(1024u, ring.used());
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(256));
+	//the skipped bytes are released with the frame that skipped them
+	ring.BeginFrame();
+	CHECK_EQ(768u, ring.used());
+	ring.BeginFrame();
+	CHECK_EQ(0u, ring.used());
+}
+
+TEST(WrappedFreeSpaceIsBetweenHeadAndTail)
+{
+	RingAllocator ring(1024, 256, 1);
+	CHECK_EQ(0u, ring.Allocate(768));	//frame 0
+	ring.BeginFrame();
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(512));	//frame 0 still in flight
+	CHECK_EQ(768u, ring.Allocate(256));	//frame 1 fills the end
+	ring.BeginFrame();
+	//frame 0 is released, the used bytes now wrap and only the front is free
+	CHECK_EQ(256u, ring.used());
+	CHECK_EQ(0u, ring.Allocate(512));
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(512));
+	CHECK_EQ(512u, ring.Allocate(256));
+	CHECK_EQ(RingAllocator::NO_SPACE, ring.Allocate(256));
+	ring.BeginFrame();
+	CHECK_EQ(768u, ring.used());
+}
+
+TEST(EmptyRingStartsOver)
+{
+	RingAllocator ring(1024, 256, 1);
+	ring.Allocate(768);
+	ring.BeginFrame();
+	ring.BeginFrame();
+	CHECK_EQ(0u, ring.used());
+	//no bytes are skipped at the end when nothing is in flight
+	CHECK_EQ(0u, ring.Allocate(1024));
+}
+
+TEST(LiveBlocksNeverOverlap)
+{
+	mt19937 random(7);
+	for (unsigned int framesInFlight : { 1u, 2u, 3u })
+	{
+		RingAllocator ring(64 * 1024, 256, framesInFlight);
+		//blocks of the frame being recorded and of the ones in flight
+		vector<vector<pair<size_t, size_t>>> live;
+		size_t allocated = 0;
+		for (int frame = 0; frame < 5000; ++frame)
+		{
+			ring.BeginFrame();
+			live.push_back({});
+			if (live.size() > framesInFlight + 1)
+				live.erase(live.begin());
+			int count = random() % 40;
+			for (int i = 0; i < count; ++i)
+			{
+				size_t size = 16 + random() % 1500;
+				auto offset = ring.Allocate(size);
+				if (offset == RingAllocator::NO_SPACE)
+					continue;
+				++allocated;
+				CHECK_EQ(0u, offset % 256);
+				CHECK(offset + size <= ring.capacity());
+				for (auto& blocks : live)
+					for (auto& [begin, end] : blocks)
+						CHECK(offset >= end || begin >= offset + size);
+				live.back().push_back({ offset, offset + size });
+			}
+		}
+		CHECK(allocated > 50000);
+	}
+}
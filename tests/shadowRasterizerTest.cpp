@@ -0,0 +1,340 @@
+#include "test.h"
+#include "shadowRasterizer.h"
+#include "shadowMap.h"
+#include "mockDevice.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Scene of Robot: a point light above the far edge of the water sheet and the duck floating on it
+	const XMFLOAT4 LIGHT_POS(0.0f, 0.5f, 1.0f, 1.0f);
+	const float SHEET_Y = -0.05f, KACZOR_SIZE = 0.0015f;
+	const XMFLOAT3 RECEIVERS[] = {
+		{ -1.0f, SHEET_Y, -1.0f }, { 1.0f, SHEET_Y, -1.0f }, { -1.0f, SHEET_Y, 1.0f }, { 1.0f, SHEET_Y, 1.0f },
+		{ -1.0f, 0.5f, -1.0f }, { 1.0f, 0.5f, -1.0f }, { -1.0f, 0.5f, 1.0f }, { 1.0f, 0.5f, 1.0f } };
+
+	XMFLOAT4X4 Store(FXMMATRIX m)
+	{
+		XMFLOAT4X4 result;
+		XMStoreFloat4x4(&result, m);
+		return result;
+	}
+
+	//Screen filling quad in clip space with clockwise triangles, z = a + b * x
+	void DrawPlane(ShadowRasterizer& map, float a, float b, int depthBias = 0, float slopeScaledDepthBias = 0.0f)
+	{
+		vector<XMFLOAT3> positions = { { -1.0f, 1.0f, a - b }, { 1.0f, 1.0f, a + b }, { -1.0f, -1.0f, a - b }, { 1.0f, -1.0f, a + b } };
+		map.DrawTriangles(positions, { 0, 1, 2, 1, 3, 2 }, Store(XMMatrixIdentity()), depthBias, slopeScaledDepthBias);
+	}
+
+	struct Triangles
+	{
+		vector<XMFLOAT3> positions;
+		vector<unsigned int> indices;
+	};
+
+	//Positions and triangles of the duck in duck.txt
+	Triangles LoadDuck()
+	{
+		ifstream file("../Robot/resources/duck/duck.txt");
+		Triangles duck;
+		size_t count;
+		file >> count;
+		duck.positions.resize(count);
+		for (auto& p : duck.positions)
+		{
+			float ignored;
+			file >> p.x >> p.y >> p.z;
+			for (int k = 0; k < 5; ++k)
+				file >> ignored;
+		}
+		file >> count;
+		duck.indices.resize(3 * count);
+		for (auto& i : duck.indices)
+			file >> i;
+		CHECK(file && !duck.indices.empty());
+		return duck;
+	}
+
+	//The water sheet, a unit rectangle in the xy plane scaled and laid flat like in Robot::CreateSheetMtx
+	Triangles Sheet()
+	{
+		return { { { -0.5f, -0.5f, 0.0f }, { -0.5f, 0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f } }, { 1, 2, 0, 2, 1, 3 } };
+	}
+
+	XMMATRIX SheetMtx()
+	{
+		return XMMatrixScaling(2.0f, 2.0f, 1.0f) * XMMatrixRotationX(XM_PIDIV2) * XMMatrixTranslation(0.0f, SHEET_Y, 0.0f);
+	}
+
+	CascadeCamera Camera(XMFLOAT3 eye)
+	{
+		CascadeCamera camera;
+		camera.view = Store(XMMatrixLookAtLH(XMLoadFloat3(&eye), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+		camera.fovY = XM_PIDIV4;
+		camera.aspect = 16.0f / 9.0f;
+		camera.nearZ = 0.01f;
+		camera.farZ = 100.0f;
+		return camera;
+	}
+
+	//Cascade shadowReceiverPS picks for a view depth
+	unsigned int Cascade(const ShadowCascades& cascades, float depth)
+	{
+		unsigned int c = 0;
+		while (c + 1 < cascades.count && depth > cascades.splits[c])
+			++c;
+		return c;
+	}
+
+	bool Visible(FXMVECTOR point, const CascadeCamera& camera)
+	{
+		auto viewProj = XMLoadFloat4x4(&camera.view) * XMMatrixPerspectiveFovLH(camera.fovY, camera.aspect, camera.nearZ, camera.farZ);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(point, 1.0f), viewProj));
+		return clip.w > 0.0f && fabs(clip.x) <= clip.w && fabs(clip.y) <= clip.w;
+	}
+
+	float ViewDepth(FXMVECTOR point, const CascadeCamera& camera)
+	{
+		return XMVectorGetZ(XMVector3TransformCoord(point, XMLoadFloat4x4(&camera.view)));
+	}
+}
+
+TEST(DepthIsInterpolatedAtPixelCentres)
+{
+	ShadowRasterizer map(64);
+	DrawPlane(map, 0.5f, 0.25f);
+	for (unsigned int x = 0; x < 64; x += 7)
+		for (unsigned int y = 0; y < 64; y += 9)
+			CHECK_NEAR(0.5 + 0.25 * ((x + 0.5) / 32.0 - 1.0), map.depth(x, y), 1e-5);
+	//nearer depths win, further ones are rejected
+	DrawPlane(map, 0.6f, 0.0f);
+	CHECK_NEAR(0.25 + 0.25 / 64, map.depth(0, 0), 1e-5);
+	CHECK_NEAR(0.6, map.depth(63, 0), 1e-5);
+	map.Clear();
+	CHECK_EQ(1.0f, map.depth(5, 5));
+}
+
+TEST(BackFacesAreCulled)
+{
+	ShadowRasterizer map(16);
+	vector<XMFLOAT3> positions = { { -1.0f, 1.0f, 0.5f }, { 1.0f, 1.0f, 0.5f }, { -1.0f, -1.0f, 0.5f }, { 1.0f, -1.0f, 0.5f } };
+	map.DrawTriangles(positions, { 0, 2, 1, 1, 2, 3 }, Store(XMMatrixIdentity()));
+	for (unsigned int i = 0; i < 16; ++i)
+		CHECK_EQ(1.0f, map.depth(i, i));
+}
+
+TEST(SharedEdgesAreFilledOnce)
+{
+	//two halves of a quad split by its diagonal and drawn at different depths: every pixel centre on
+	//the diagonal belongs to exactly one of them, so the diagonal holds the depth of a single half
+	ShadowRasterizer upper(16), lower(16);
+	vector<XMFLOAT3> positions = { { -1.0f, 1.0f, 0.5f }, { 1.0f, 1.0f, 0.5f }, { -1.0f, -1.0f, 0.5f }, { 1.0f, -1.0f, 0.5f } };
+	auto identity = Store(XMMatrixIdentity());
+	upper.DrawTriangles(positions, { 0, 1, 2 }, identity);
+	lower.DrawTriangles(positions, { 1, 3, 2 }, identity);
+	unsigned int covered = 0;
+	for (unsigned int y = 0; y < 16; ++y)
+		for (unsigned int x = 0; x < 16; ++x)
+		{
+			bool a = upper.depth(x, y) < 1.0f, b = lower.depth(x, y) < 1.0f;
+			CHECK(!(a && b));
+			covered += a || b;
+		}
+	CHECK_EQ(256u, covered);
+}
+
+TEST(ConstantBiasScalesWithTheDepthExponent)
+{
+	//a 32-bit float depth buffer offsets by depthBias units of the largest depth's exponent
+	ShadowRasterizer map(32);
+	DrawPlane(map, 0.25f, 0.0f, 64);
+	CHECK_NEAR(0.25 + 64 * ldexp(1.0, -2 - 23), map.depth(10, 10), 1e-9);
+	map.Clear();
+	DrawPlane(map, 0.75f, 0.0f, 64);
+	CHECK_NEAR(0.75 + 64 * ldexp(1.0, -1 - 23), map.depth(10, 10), 1e-9);
+}
+
+TEST(SlopeScaledBiasFollowsTheDepthSlope)
+{
+	//z changes by 2 * b over the width of the map
+	const unsigned int size = 32;
+	const float b = 0.125f;
+	ShadowRasterizer flat(size), biased(size);
+	DrawPlane(flat, 0.5f, b);
+	DrawPlane(biased, 0.5f, b, 0, 2.0f);
+	CHECK_NEAR(2.0 * 2.0 * b / size, biased.depth(7, 3) - flat.depth(7, 3), 1e-6);
+}
+
+TEST(VisibilityComparesWithTheStoredDepth)
+{
+	ShadowRasterizer map(64);
+	auto identity = Store(XMMatrixIdentity());
+	//nothing drawn yet
+	CHECK_EQ(1.0f, map.Visibility({ 0.1f, 0.2f, 0.9f }, identity));
+	DrawPlane(map, 0.5f, 0.0f);
+	CHECK_EQ(0.0f, map.Visibility({ 0.1f, 0.2f, 0.9f }, identity));
+	CHECK_EQ(1.0f, map.Visibility({ 0.1f, 0.2f, 0.4f }, identity));
+	//equal depth passes LESS_EQUAL
+	CHECK_EQ(1.0f, map.Visibility({ 0.1f, 0.2f, 0.5f }, identity));
+	//positions outside of the map are lit
+	CHECK_EQ(1.0f, map.Visibility({ 1.5f, 0.2f, 0.9f }, identity));
+}
+
+TEST(PcfBlendsAcrossAShadowEdge)
+{
+	//left half of the map covered, a receiver right on the edge sees light through about half the taps
+	ShadowRasterizer map(64);
+	vector<XMFLOAT3> positions = { { -1.0f, 1.0f, 0.5f }, { 0.0f, 1.0f, 0.5f }, { -1.0f, -1.0f, 0.5f }, { 0.0f, -1.0f, 0.5f } };
+	auto identity = Store(XMMatrixIdentity());
+	map.DrawTriangles(positions, { 0, 1, 2, 1, 3, 2 }, identity);
+	float edge = map.Visibility({ 0.0f, 0.0f, 0.9f }, identity);
+	CHECK(edge > 0.3f && edge < 0.7f);
+	CHECK(map.Visibility({ 0.0f, 0.0f, 0.9f }, identity, 4.0f) > 0.3f);
+	CHECK_EQ(0.0f, map.Visibility({ -0.5f, 0.0f, 0.9f }, identity));
+	CHECK_EQ(1.0f, map.Visibility({ 0.5f, 0.0f, 0.9f }, identity));
+}
+
+TEST(ReceiversFitInsideTheirCascade)
+{
+	//points of the sheet and the walls the camera sees land in the light frustum of the cascade
+	//the receiver shader picks for them, unless the light fit cut them off on purpose
+	auto lightView = XMMatrixLookToLH(XMLoadFloat4(&LIGHT_POS), XMVector3Normalize(XMVectorSet(0.0f, -0.275f, -1.0f, 0.0f)),
+		XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMFLOAT3 eyes[] = { { 0.0f, 0.6f, -0.9f }, { 0.9f, 0.9f, 0.9f }, { -0.5f, 0.2f, 0.2f }, { 0.0f, 3.0f, -3.0f } };
+	unsigned int checked = 0;
+	for (unsigned int count = 1; count <= MAX_SHADOW_CASCADES; count *= 2)
+		for (auto& eye : eyes)
+		{
+			auto camera = Camera(eye);
+			auto cascades = FitCascades(LIGHT_POS, RECEIVERS, size(RECEIVERS), camera, count);
+			CHECK_EQ(count, cascades.count);
+			for (int i = 0; i <= 20; ++i)
+				for (int j = 0; j <= 20; ++j)
+					for (int face = 0; face < 4; ++face)
+					{
+						float u = -1.0f + i / 10.0f, v = -1.0f + j / 10.0f, h = SHEET_Y + (v + 1.0f) * 0.275f;
+						XMFLOAT3 p = face == 0 ? XMFLOAT3(u, SHEET_Y, v) : face == 1 ? XMFLOAT3(u, h, -1.0f) :
+							face == 2 ? XMFLOAT3(-1.0f, h, u) : XMFLOAT3(1.0f, h, u);
+						auto point = XMLoadFloat3(&p);
+						if (!Visible(point, camera))
+							continue;
+						XMFLOAT3 l;
+						XMStoreFloat3(&l, XMVector3TransformCoord(point, lightView));
+						if (l.z < 0.05f || fabs(l.x / l.z) > 4.0f || fabs(l.y / l.z) > 4.0f)
+							continue;
+						auto c = Cascade(cascades, ViewDepth(point, camera));
+						XMFLOAT4 clip;
+						XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(point, 1.0f), XMLoadFloat4x4(&cascades.viewProj[c])));
+						CHECK(clip.w > 0.0f);
+						CHECK(fabs(clip.x / clip.w) <= 1.0001f && fabs(clip.y / clip.w) <= 1.0001f);
+						CHECK(clip.z / clip.w >= 0.0f && clip.z / clip.w <= 1.0f);
+						++checked;
+					}
+		}
+	CHECK(checked > 1000);
+}
+
+TEST(DefaultBiasHasNoAcneAndNoPeterPanning)
+{
+	//the duck and the sheet are drawn with the ShadowMap defaults into every cascade. Sheet points away
+	//from the duck's shadow have to be lit, and the sheet right behind the duck's bottom shadowed.
+	ShadowMapSettings settings;
+	auto duck = LoadDuck();
+	auto sheet = Sheet();
+	auto light = XMLoadFloat4(&LIGHT_POS);
+	XMFLOAT3 duckAt[] = { { 0.0f, SHEET_Y, 0.0f }, { 0.5f, SHEET_Y, -0.6f } };
+	XMFLOAT3 eyes[] = { { 0.0f, 0.6f, -0.9f }, { 0.0f, 3.0f, -3.0f } };
+	unsigned int lit = 0, contacts = 0, acne = 0, acneWithoutBias = 0;
+	for (unsigned int count : { 1u, 4u })
+		for (auto& eye : eyes)
+			for (auto& at : duckAt)
+			{
+				auto camera = Camera(eye);
+				auto cascades = FitCascades(LIGHT_POS, RECEIVERS, size(RECEIVERS), camera, count);
+				auto duckMtx = XMMatrixScaling(KACZOR_SIZE, KACZOR_SIZE, KACZOR_SIZE) * XMMatrixRotationY(0.7f) *
+					XMMatrixTranslation(at.x, at.y, at.z);
+				vector<ShadowRasterizer> maps, unbiased;
+				for (unsigned int c = 0; c < cascades.count; ++c)
+				{
+					auto viewProj = XMLoadFloat4x4(&cascades.viewProj[c]);
+					maps.emplace_back(settings.resolution);
+					maps[c].DrawTriangles(duck.positions, duck.indices, Store(duckMtx * viewProj), settings.depthBias, settings.slopeScaledDepthBias);
+					maps[c].DrawTriangles(sheet.positions, sheet.indices, Store(SheetMtx() * viewProj), settings.depthBias, settings.slopeScaledDepthBias);
+					unbiased.emplace_back(settings.resolution);
+					unbiased[c].DrawTriangles(sheet.positions, sheet.indices, Store(SheetMtx() * viewProj));
+				}
+
+				auto duckCenter = XMLoadFloat3(&at) + XMVectorSet(0.0f, 0.05f, 0.0f, 0.0f);
+				for (int i = 1; i < 30; ++i)
+					for (int j = 1; j < 30; ++j)
+					{
+						XMFLOAT3 p(-1.0f + i / 15.0f, SHEET_Y, -1.0f + j / 15.0f);
+						auto point = XMLoadFloat3(&p);
+						auto toPoint = XMVector3Normalize(point - light), toDuck = XMVector3Normalize(duckCenter - light);
+						if (XMVectorGetX(XMVector3Dot(toPoint, toDuck)) > 0.97f || !Visible(point, camera))
+							continue;
+						auto c = Cascade(cascades, ViewDepth(point, camera));
+						++lit;
+						acne += maps[c].Visibility(p, cascades.viewProj[c], settings.pcfSpacing) < 1.0f;
+						acneWithoutBias += unbiased[c].Visibility(p, cascades.viewProj[c], settings.pcfSpacing) < 1.0f;
+					}
+
+				//bottom of the duck a few millimetres up, projected onto the sheet away from the light
+				for (float height : { 0.006f, 0.009f })
+				{
+					auto bottom = XMVectorSet(at.x, SHEET_Y + height, at.z, 1.0f);
+					auto d = bottom - light;
+					auto hit = light + d * ((SHEET_Y - LIGHT_POS.y) / XMVectorGetY(d));
+					if (!Visible(hit, camera))
+						continue;
+					XMFLOAT3 p;
+					XMStoreFloat3(&p, hit);
+					auto c = Cascade(cascades, ViewDepth(hit, camera));
+					++contacts;
+					CHECK(maps[c].Visibility(p, cascades.viewProj[c], settings.pcfSpacing) <= 0.5f);
+				}
+			}
+	CHECK(lit > 1000);
+	CHECK(contacts > 0);
+	CHECK_EQ(0u, acne);
+	//the check above means something only if the sheet shadows itself without the bias
+	CHECK(acneWithoutBias > lit / 2);
+}
+
+TEST(ShadowMapConstantsCarryTheCascades)
+{
+	auto device = test::CreateMockDevice();
+	ShadowMapSettings settings;
+	settings.resolution = 256;
+	settings.cascadeCount = 2;
+	settings.pcfSpacing = 1.5f;
+	ShadowMap map(device, settings);
+	CHECK_EQ(2u, map.cascadeCount());
+	CHECK(!map.empty());
+
+	auto cascades = FitCascades(LIGHT_POS, RECEIVERS, size(RECEIVERS), Camera({ 0.0f, 0.6f, -0.9f }), 4);
+	auto constants = map.Constants(cascades, 0.5f);
+	//only the cascades the map has are passed on
+	CHECK(memcmp(&constants.lightViewProj[1], &cascades.viewProj[1], sizeof(XMFLOAT4X4)) == 0);
+	CHECK_EQ(0.0f, constants.lightViewProj[2]._11);
+	CHECK_EQ(cascades.splits[0], constants.cascadeSplits.x);
+	CHECK_EQ(0.0f, constants.cascadeSplits.z);
+	CHECK_NEAR(1.5 / 256, constants.parameters.x, 1e-9);
+	CHECK_EQ(2.0f, constants.parameters.y);
+	CHECK_EQ(0.5f, constants.parameters.z);
+
+	//out of range settings are clamped
+	settings.resolution = 1;
+	settings.cascadeCount = 9;
+	ShadowMap clamped(device, settings);
+	CHECK_EQ(16u, clamped.resolution());
+	CHECK_EQ(MAX_SHADOW_CASCADES, clamped.cascadeCount());
+}
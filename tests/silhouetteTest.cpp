@@ -0,0 +1,210 @@
+#include "test.h"
+#include "silhouette.h"
+#include "meshFile.h"
+#include "workerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	MeshAdjacency Duck()
+	{
+		auto duck = ReadTextMesh(L"../Robot/resources/duck/duck.txt");
+		return BuildAdjacency(duck.vertices, duck.indices);
+	}
+
+	//Closed torus, rings x segments quads split into triangles
+	MeshAdjacency Torus(unsigned int rings, unsigned int segments)
+	{
+		vector<XMFLOAT3> positions;
+		for (unsigned int r = 0; r < rings; ++r)
+			for (unsigned int s = 0; s < segments; ++s)
+			{
+				float u = XM_2PI * r / rings, v = XM_2PI * s / segments;
+				positions.emplace_back((1.0f + 0.3f * cosf(v)) * cosf(u), 0.3f * sinf(v), (1.0f + 0.3f * cosf(v)) * sinf(u));
+			}
+		vector<unsigned int> indices;
+		for (unsigned int r = 0; r < rings; ++r)
+			for (unsigned int s = 0; s < segments; ++s)
+			{
+				unsigned int a = r * segments + s, b = r * segments + (s + 1) % segments;
+				unsigned int c = (r + 1) % rings * segments + s, d = (r + 1) % rings * segments + (s + 1) % segments;
+				indices.insert(indices.end(), { a, b, c, b, d, c });
+			}
+		return BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), indices);
+	}
+
+	//Open side x side grid in the xz plane, bumpy so that lit and dark faces mix
+	MeshAdjacency Grid(unsigned int side)
+	{
+		vector<XMFLOAT3> positions;
+		for (unsigned int y = 0; y <= side; ++y)
+			for (unsigned int x = 0; x <= side; ++x)
+			{
+				float u = float(x) / side, v = float(y) / side;
+				positions.emplace_back(u, 0.2f * sinf(9.0f * u) * cosf(7.0f * v), v);
+			}
+		vector<unsigned int> indices;
+		for (unsigned int y = 0; y < side; ++y)
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				unsigned int i = y * (side + 1) + x;
+				indices.insert(indices.end(), { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 });
+			}
+		return BuildAdjacency(&positions[0].x, sizeof(XMFLOAT3), positions.size(), indices);
+	}
+
+	//Point lights around and inside the mesh and directional lights
+	const XMFLOAT4 LIGHTS[] = {
+		{ 0.0f, 3.0f, 0.0f, 1.0f }, { 2.0f, 0.5f, -1.5f, 1.0f }, { 0.1f, 0.05f, 0.0f, 1.0f },
+		{ 0.3f, 1.0f, 0.2f, 0.0f }, { -1.0f, 0.0f, 0.0f, 0.0f }
+	};
+
+	bool SameVertices(const vector<XMFLOAT3>& a, const vector<XMFLOAT3>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); ++i)
+			if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z)
+				return false;
+		return true;
+	}
+
+	//Sides and caps of the last extracted silhouette
+	vector<XMFLOAT3> Volume(const SilhouetteExtractor& extractor)
+	{
+		vector<XMFLOAT3> verts(6 * (extractor.silhouetteEdgeCount() + extractor.darkFaceCount()));
+		auto sides = extractor.WriteQuads(verts.data(), verts.size(), 10.0f);
+		extractor.WriteCaps(verts.data() + sides, verts.size() - sides, 10.0f);
+		return verts;
+	}
+
+	using Point = tuple<float, float, float>;
+	Point Key(const XMFLOAT3& p) { return { p.x, p.y, p.z }; }
+
+	//Whether every directed edge of the triangle list is matched by one running the other way
+	bool IsClosed(const vector<XMFLOAT3>& triangles)
+	{
+		map<pair<Point, Point>, int> edges;
+		for (size_t t = 0; t < triangles.size(); t += 3)
+			for (int k = 0; k < 3; ++k)
+				++edges[{ Key(triangles[t + k]), Key(triangles[t + (k + 1) % 3]) }];
+		for (auto& [edge, count] : edges)
+		{
+			auto reverse = edges.find({ edge.second, edge.first });
+			if (reverse == edges.end() || reverse->second != count)
+				return false;
+		}
+		return true;
+	}
+
+	//Silhouette edges of the sides, wound like the lit face
+	vector<pair<Point, Point>> SideEdges(const vector<XMFLOAT3>& volume, size_t edgeCount)
+	{
+		vector<pair<Point, Point>> edges;
+		for (size_t e = 0; e < edgeCount; ++e)
+			edges.emplace_back(Key(volume[6 * e]), Key(volume[6 * e + 4]));
+		sort(edges.begin(), edges.end());
+		return edges;
+	}
+
+	//Silhouette edges shadowVolumeGS.hlsl finds in the adjacency index list, wound like the lit face
+	vector<pair<Point, Point>> GeometryShaderEdges(const MeshAdjacency& mesh, const XMFLOAT4& light)
+	{
+		auto lit = [&light](const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+		{
+			XMVECTOR pa = XMLoadFloat3(&a);
+			XMVECTOR n = XMVector3Cross(XMLoadFloat3(&b) - pa, XMLoadFloat3(&c) - pa);
+			XMVECTOR l = XMLoadFloat4(&light);
+			return XMVectorGetX(XMVector3Dot(n, l - pa * XMVectorSplatW(l))) > 0.0f;
+		};
+		auto indices = BuildAdjacencyIndices(mesh);
+		vector<pair<Point, Point>> edges;
+		for (size_t f = 0; f < indices.size(); f += 6)
+		{
+			XMFLOAT3 p[6];
+			for (int k = 0; k < 6; ++k)
+				p[k] = mesh.positions[indices[f + k]];
+			if (lit(p[0], p[2], p[4]))
+				continue;
+			for (int a = 0; a < 6; a += 2)
+			{
+				int b = (a + 2) % 6;
+				if (lit(p[b], p[a], p[a + 1]))
+					edges.emplace_back(Key(p[b]), Key(p[a]));
+			}
+		}
+		sort(edges.begin(), edges.end());
+		return edges;
+	}
+}
+
+TEST(AVX2FacingBitsMatchScalar)
+{
+	if (gk2::DetectSimdLevel() == gk2::SimdLevel::Scalar)
+		return;
+	for (auto& mesh : { Duck(), Torus(37, 23) })
+	{
+		SilhouetteExtractor scalar(mesh), simd(mesh);
+		for (auto& light : LIGHTS)
+		{
+			CHECK_EQ(scalar.Extract(light, nullptr, gk2::SimdLevel::Scalar), simd.Extract(light, nullptr, gk2::SimdLevel::AVX2));
+			CHECK_EQ(scalar.darkFaceCount(), simd.darkFaceCount());
+			bool same = true;
+			for (uint32_t f = 0; f < mesh.faceCount(); ++f)
+				same &= scalar.faceLit(f) == simd.faceLit(f);
+			CHECK(same);
+			CHECK(SameVertices(Volume(scalar), Volume(simd)));
+		}
+	}
+}
+
+TEST(ChunkedExtractionMatchesSingleChunk)
+{
+	//enough faces for several chunks
+	auto mesh = Torus(200, 100);
+	WorkerPool pool(3);
+	SilhouetteExtractor single(mesh), chunked(mesh);
+	for (auto& light : LIGHTS)
+	{
+		CHECK_EQ(single.Extract(light), chunked.Extract(light, &pool));
+		CHECK(SameVertices(Volume(single), Volume(chunked)));
+	}
+}
+
+TEST(ShadowVolumesAreClosed)
+{
+	for (auto& mesh : { Duck(), Torus(37, 23), Grid(16) })
+	{
+		SilhouetteExtractor extractor(mesh);
+		size_t silhouetteEdges = 0;
+		for (auto& light : LIGHTS)
+		{
+			silhouetteEdges += extractor.Extract(light);
+			CHECK(IsClosed(Volume(extractor)));
+		}
+		CHECK(silhouetteEdges > 0);
+	}
+}
+
+TEST(GeometryShaderFindsTheSameSilhouette)
+{
+	for (auto& mesh : { Duck(), Torus(37, 23), Grid(16) })
+	{
+		SilhouetteExtractor extractor(mesh);
+		for (auto& light : LIGHTS)
+		{
+			auto count = extractor.Extract(light);
+			auto expected = SideEdges(Volume(extractor), count);
+			auto actual = GeometryShaderEdges(mesh, light);
+			CHECK_EQ(count, actual.size());
+			CHECK(expected == actual);
+		}
+	}
+}
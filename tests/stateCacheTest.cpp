@@ -0,0 +1,214 @@
+#include "test.h"
+#include "stateCache.h"
+#include "mockD3D.h"
+#include <cstring>
+
+using namespace std;
+using namespace mini;
+
+namespace
+{
+	struct Fixture
+	{
+		dx_ptr<mock::Context> context{ new mock::Context };
+		StateCache state{ context.get(), context.get() };
+
+		const mock::Context::Call& last() const { return context->log().back(); }
+		size_t calls() const { return context->log().size(); }
+	};
+
+	vector<const void*> Objects(initializer_list<const void*> objects) { return objects; }
+}
+
+TEST(RepeatedShaderBindsAreDropped)
+{
+	Fixture f;
+	dx_ptr<mock::VertexShader> vs1{ new mock::VertexShader }, vs2{ new mock::VertexShader };
+	dx_ptr<mock::PixelShader> ps{ new mock::PixelShader };
+	//the first bind always reaches the context, even of null
+	f.state.VSSetShader(nullptr);
+	f.state.VSSetShader(nullptr);
+	CHECK_EQ(1u, f.calls());
+	f.state.VSSetShader(vs1.get());
+	f.state.VSSetShader(vs1.get());
+	f.state.VSSetShader(vs2.get());
+	f.state.PSSetShader(ps.get());
+	f.state.PSSetShader(ps.get());
+	CHECK_EQ(3u, f.context->Count("VSSetShader"));
+	CHECK_EQ(1u, f.context->Count("PSSetShader"));
+	CHECK(f.last().objects == Objects({ ps.get() }));
+
+	auto& counters = f.state.counters();
+	CHECK_EQ(3u, counters.issued[StateCache::VertexShader]);
+	CHECK_EQ(2u, counters.elided[StateCache::VertexShader]);
+	CHECK_EQ(1u, counters.elided[StateCache::PixelShader]);
+}
+
+TEST(SlotRangesAreNarrowedToChangedSlots)
+{
+	Fixture f;
+	auto a = reinterpret_cast<ID3D11ShaderResourceView*>(0x10), b = reinterpret_cast<ID3D11ShaderResourceView*>(0x20),
+		c = reinterpret_cast<ID3D11ShaderResourceView*>(0x30);
+	ID3D11ShaderResourceView* views[] = { a, b, c };
+	f.state.PSSetShaderResources(0, 3, views);
+	CHECK(f.last().values == (vector<UINT>{ 0, 3 }));
+	f.state.PSSetShaderResources(0, 3, views);
+	CHECK_EQ(1u, f.calls());
+
+	ID3D11ShaderResourceView* changed[] = { a, c, c };
+	f.state.PSSetShaderResources(0, 3, changed);
+	CHECK_EQ(2u, f.calls());
+	CHECK(f.last().values == (vector<UINT>{ 1, 1 }));
+	CHECK(f.last().objects == Objects({ c }));
+
+	ID3D11ShaderResourceView* none = nullptr;
+	f.state.PSSetShaderResources(2, 1, &none);
+	CHECK(f.last().values == (vector<UINT>{ 2, 1 }));
+	CHECK_EQ(1u, f.state.counters().elided[StateCache::ShaderResources]);
+}
+
+TEST(ConstantBufferSlotsArePerStage)
+{
+	Fixture f;
+	dx_ptr<mock::Buffer> cb0{ mock::NewConstantBuffer(16) }, cb1{ mock::NewConstantBuffer(16) };
+	ID3D11Buffer* buffers[] = { cb0.get(), cb1.get() };
+	f.state.VSSetConstantBuffers(1, 2, buffers);
+	f.state.VSSetConstantBuffers(1, 2, buffers);
+	f.state.PSSetConstantBuffers(1, 2, buffers);
+	CHECK_EQ(1u, f.context->Count("VSSetConstantBuffers"));
+	CHECK_EQ(1u, f.context->Count("PSSetConstantBuffers"));
+
+	ID3D11Buffer* swapped[] = { cb1.get(), cb1.get() };
+	f.state.VSSetConstantBuffers(1, 2, swapped);
+	CHECK(f.last().values == (vector<UINT>{ 1, 1 }));
+	CHECK(f.last().objects == Objects({ cb1.get() }));
+}
+
+TEST(ConstantBufferRangesAreComparedWithTheBuffer)
+{
+	Fixture f;
+	dx_ptr<mock::Buffer> ring{ mock::NewConstantBuffer(1024) };
+	ID3D11Buffer* buffer = ring.get();
+	UINT first = 0, count = 16;
+	f.state.VSSetConstantBuffers1(0, 1, &buffer, &first, &count);
+	f.state.VSSetConstantBuffers1(0, 1, &buffer, &first, &count);
+	CHECK_EQ(1u, f.context->Count("VSSetConstantBuffers1"));
+	//same buffer at another offset is a different binding
+	first = 16;
+	f.state.VSSetConstantBuffers1(0, 1, &buffer, &first, &count);
+	CHECK(f.last().values == (vector<UINT>{ 0, 1, 16, 16 }));
+	//binding the whole buffer differs from binding its first range
+	f.state.VSSetConstantBuffers(0, 1, &buffer);
+	CHECK_EQ(1u, f.context->Count("VSSetConstantBuffers"));
+}
+
+TEST(StatesAreComparedWithTheirParameters)
+{
+	Fixture f;
+	dx_ptr<mock::BlendState> blend{ new mock::BlendState };
+	float factor[4] = {};
+	f.state.OMSetBlendState(blend.get());
+	f.state.OMSetBlendState(blend.get());
+	f.state.OMSetBlendState(blend.get(), nullptr, 1);
+	//a blend factor is never compared, and makes the next bind go through
+	f.state.OMSetBlendState(blend.get(), factor, 1);
+	f.state.OMSetBlendState(blend.get(), nullptr, 1);
+	CHECK_EQ(4u, f.context->Count("OMSetBlendState"));
+
+	dx_ptr<mock::DepthStencilState> depth{ new mock::DepthStencilState };
+	f.state.OMSetDepthStencilState(depth.get(), 0);
+	f.state.OMSetDepthStencilState(depth.get(), 0);
+	f.state.OMSetDepthStencilState(depth.get(), 1);
+	CHECK_EQ(2u, f.context->Count("OMSetDepthStencilState"));
+
+	f.state.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	f.state.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CHECK_EQ(1u, f.context->Count("IASetPrimitiveTopology"));
+}
+
+TEST(InvalidateMakesEveryBindGoThrough)
+{
+	Fixture f;
+	dx_ptr<mock::VertexShader> vs{ new mock::VertexShader };
+	dx_ptr<mock::RasterizerState> rs{ new mock::RasterizerState };
+	f.state.VSSetShader(vs.get());
+	f.state.RSSetState(rs.get());
+	f.state.Invalidate();
+	f.state.VSSetShader(vs.get());
+	f.state.RSSetState(rs.get());
+	CHECK_EQ(2u, f.context->Count("VSSetShader"));
+	CHECK_EQ(2u, f.context->Count("RSSetState"));
+}
+
+TEST(UpdateBufferSkipsUnchangedContents)
+{
+	Fixture f;
+	dx_ptr<mock::Buffer> buffer{ mock::NewConstantBuffer(16) };
+	float x[4] = { 1, 2, 3, 4 };
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	CHECK_EQ(1u, f.context->Count("Map"));
+	CHECK_EQ(1u, f.context->Count("Unmap"));
+	CHECK(f.context->log()[0].values[1] == D3D11_MAP_WRITE_DISCARD);
+	CHECK(memcmp(buffer->data().data(), x, sizeof(x)) == 0);
+
+	x[3] = 5;
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	CHECK_EQ(2u, f.context->Count("Map"));
+	CHECK(memcmp(buffer->data().data(), x, sizeof(x)) == 0);
+	//a shorter write is a different update even with the same leading bytes
+	f.state.UpdateBuffer(buffer.get(), x, 8);
+	CHECK_EQ(3u, f.context->Count("Map"));
+
+	auto& counters = f.state.counters();
+	CHECK_EQ(3u, counters.issued[StateCache::BufferUpdate]);
+	CHECK_EQ(1u, counters.elided[StateCache::BufferUpdate]);
+}
+
+TEST(UpdateBufferTakesNoReferences)
+{
+	dx_ptr<mock::Buffer> a{ mock::NewConstantBuffer(16) }, b{ mock::NewConstantBuffer(32) };
+	{
+		Fixture f;
+		float x[8] = {};
+		f.state.UpdateBuffer(a.get(), x, 16);
+		f.state.UpdateBuffer(b.get(), x, 32);
+		x[0] = 1;
+		f.state.UpdateBuffer(a.get(), x, 16);
+		f.state.UpdateBuffer(a.get(), x, 16);
+		CHECK_EQ(1u, a->refs());
+		CHECK_EQ(1u, b->refs());
+	}
+	CHECK_EQ(1u, a->refs());
+	CHECK_EQ(1u, b->refs());
+}
+
+TEST(ForgottenBuffersAreWrittenAgain)
+{
+	Fixture f;
+	dx_ptr<mock::Buffer> buffer{ mock::NewConstantBuffer(16) };
+	float x[4] = { 1, 2, 3, 4 };
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	//what an owner does before releasing the buffer, another one may take its address
+	f.state.Forget(buffer.get());
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	CHECK_EQ(2u, f.context->Count("Map"));
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	CHECK_EQ(2u, f.context->Count("Map"));
+}
+
+TEST(FailedMapDoesNotTrackTheBuffer)
+{
+	Fixture f;
+	dx_ptr<mock::Buffer> buffer{ mock::NewConstantBuffer(16) };
+	float x[4] = {};
+	f.context->FailMaps(E_OUTOFMEMORY);
+	CHECK_THROWS(f.state.UpdateBuffer(buffer.get(), x, sizeof(x)));
+	CHECK_EQ(1u, buffer->refs());
+	CHECK_EQ(0u, f.context->Count("Unmap"));
+	//the contents weren't written, so the same update has to be retried
+	f.context->FailMaps(S_OK);
+	f.state.UpdateBuffer(buffer.get(), x, sizeof(x));
+	CHECK_EQ(2u, f.context->Count("Map"));
+	CHECK_EQ(1u, buffer->refs());
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//Minimal self-registering test framework, every test file is linked with testMain.cpp
+//into its own executable
+
+namespace mini
+{
+	namespace test
+	{
+		struct TestCase
+		{
+			const char* name;
+			std::function<void()> body;
+		};
+
+		inline std::vector<TestCase>& Registry()
+		{
+			static std::vector<TestCase> tests;
+			return tests;
+		}
+
+		struct Registrar
+		{
+			Registrar(const char* name, std::function<void()> body) { Registry().push_back({ name, std::move(body) }); }
+		};
+
+		class Failure : public std::runtime_error
+		{
+		public:
+			using std::runtime_error::runtime_error;
+		};
+
+		inline void Fail(const char* file, int line, const std::string& message)
+		{
+			std::ostringstream str;
+			str << file << "(" << line << "): " << message;
+			throw Failure(str.str());
+		}
+	}
+}
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_(a, b)
+
+#define TEST(name) \
+	static void name(); \
+	static mini::test::Registrar TEST_CONCAT(name, _registrar)(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) mini::test::Fail(__FILE__, __LINE__, "CHECK(" #condition ") failed"); } while (false)
+
+#define CHECK_EQ(expected, actual) \
+	do { \
+		auto&& e_ = (expected); auto&& a_ = (actual); \
+		if (!(e_ == a_)) { \
+			std::ostringstream s_; \
+			s_ << "CHECK_EQ(" #expected ", " #actual ") failed: " << e_ << " != " << a_; \
+			mini::test::Fail(__FILE__, __LINE__, s_.str()); \
+		} \
+	} while (false)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+	do { \
+		double e_ = (expected), a_ = (actual); \
+		if (!(std::abs(e_ - a_) <= (tolerance))) { \
+			std::ostringstream s_; \
+			s_ << "CHECK_NEAR(" #expected ", " #actual ") failed: " << e_ << " vs " << a_; \
+			mini::test::Fail(__FILE__, __LINE__, s_.str()); \
+		} \
+	} while (false)
+
+#define CHECK_THROWS(expression) \
+	do { \
+		bool thrown_ = false; \
+		try { expression; } catch (...) { thrown_ = true; } \
+		if (!thrown_) mini::test::Fail(__FILE__, __LINE__, "CHECK_THROWS(" #expression ") did not throw"); \
+	} while (false)
@@ -0,0 +1,32 @@
+#include "test.h"
+#include "exceptions.h"
+#include <cstdio>
+#include <exception>
+
+using namespace std;
+using namespace mini::test;
+
+int main()
+{
+	int failed = 0;
+	for (auto& test : Registry())
+	{
+		try
+		{
+			test.body();
+			printf("[ OK ] %s\n", test.name);
+		}
+		catch (const exception& e)
+		{
+			printf("[FAIL] %s\n       %s\n", test.name, e.what());
+			++failed;
+		}
+		catch (const mini::Exception& e)
+		{
+			printf("[FAIL] %s\n       %ls\n", test.name, e.getMessage().c_str());
+			++failed;
+		}
+	}
+	printf("%zu tests, %d failed\n", Registry().size(), failed);
+	return failed == 0 ? 0 : 1;
+}
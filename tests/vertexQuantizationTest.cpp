@@ -0,0 +1,133 @@
+#include "test.h"
+#include "vertexQuantization.h"
+#include <cmath>
+#include <fstream>
+#include <random>
+
+using namespace std;
+using namespace mini;
+using namespace DirectX;
+
+namespace
+{
+	//Vertices of duck.txt: position, normal and texture coordinates
+	vector<VertexPositionNormalTex> LoadDuck()
+	{
+		ifstream file("../Robot/resources/duck/duck.txt");
+		size_t count = 0;
+		file >> count;
+		vector<VertexPositionNormalTex> verts(count);
+		for (auto& v : verts)
+			file >> v.position.x >> v.position.y >> v.position.z >> v.normal.x >> v.normal.y >> v.normal.z >> v.tex.x >> v.tex.y;
+		CHECK(file && count > 0);
+		return verts;
+	}
+
+	float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		float c = XMVectorGetX(XMVector3Dot(XMVector3Normalize(XMLoadFloat3(&a)), XMVector3Normalize(XMLoadFloat3(&b))));
+		return XMConvertToDegrees(acos(min(max(c, -1.0f), 1.0f)));
+	}
+}
+
+TEST(DuckRoundTripStaysWithinTheAcceptedError)
+{
+	auto verts = LoadDuck();
+	auto quantized = QuantizeVertices(verts);
+	auto decoded = DequantizeVertices(quantized);
+	CHECK_EQ(verts.size(), decoded.size());
+
+	auto diagonal = BoundingDiagonal(verts);
+	QuantizationTolerance tolerance;
+	auto error = MeasureQuantizationError(verts, quantized);
+	CHECK(AcceptQuantization(error, diagonal, tolerance));
+	//the measured error is the real one, recomputed here vertex by vertex
+	auto& scale = quantized.dequantization.scale;
+	//rounding to 16 bits is off by at most half a step on every axis
+	float positionBound = 0.5f / 65535.0f * sqrt(scale.x * scale.x + scale.y * scale.y + scale.z * scale.z) * 1.01f;
+	float maxPosition = 0.0f, maxNormal = 0.0f, maxTex = 0.0f;
+	for (size_t i = 0; i < verts.size(); ++i)
+	{
+		auto& a = verts[i];
+		auto& b = decoded[i];
+		maxPosition = max(maxPosition, XMVectorGetX(XMVector3Length(XMLoadFloat3(&a.position) - XMLoadFloat3(&b.position))));
+		maxNormal = max(maxNormal, AngleDegrees(a.normal, b.normal));
+		maxTex = max({ maxTex, fabs(a.tex.x - b.tex.x), fabs(a.tex.y - b.tex.y) });
+	}
+	CHECK(maxPosition <= positionBound);
+	CHECK(maxPosition <= tolerance.position * diagonal);
+	CHECK(maxNormal <= tolerance.normalDegrees);
+	CHECK(maxTex <= tolerance.tex);
+	CHECK_NEAR(maxPosition, error.maxPosition, 1e-6);
+	CHECK_NEAR(maxNormal, error.maxNormalDegrees, 1e-3);
+	CHECK_NEAR(maxTex, error.maxTex, 1e-7);
+	CHECK(error.rmsPosition <= error.maxPosition && error.rmsNormalDegrees <= error.maxNormalDegrees);
+}
+
+TEST(NormalsOfEveryOctantRoundTrip)
+{
+	mt19937 random(3);
+	normal_distribution<float> coordinate;
+	vector<VertexPositionNormalTex> verts(20000);
+	for (auto& v : verts)
+	{
+		XMStoreFloat3(&v.normal, XMVector3Normalize(XMVectorSet(coordinate(random), coordinate(random), coordinate(random), 0.0f)));
+		v.position = { coordinate(random), coordinate(random), coordinate(random) };
+	}
+	//the poles and the folded diagonals of the octahedron
+	verts[0].normal = { 0.0f, 0.0f, 1.0f };
+	verts[1].normal = { 0.0f, 0.0f, -1.0f };
+	verts[2].normal = { 1.0f, 0.0f, 0.0f };
+	verts[3].normal = { 0.0f, -1.0f, 0.0f };
+	verts[4].normal = { -0.70710678f, 0.0f, -0.70710678f };
+	auto error = MeasureQuantizationError(verts, QuantizeVertices(verts));
+	CHECK(error.maxNormalDegrees <= QuantizationTolerance().normalDegrees);
+	for (int i = 0; i < 5; ++i)
+	{
+		auto n = OctahedralDecode(OctahedralEncode(verts[i].normal));
+		CHECK(AngleDegrees(verts[i].normal, n) < 1e-3f);
+	}
+}
+
+TEST(FlatMeshesKeepTheirFlatAxis)
+{
+	vector<VertexPositionNormalTex> verts(3);
+	verts[0].position = { 0.0f, 0.0f, 2.5f };
+	verts[1].position = { 1.0f, 0.0f, 2.5f };
+	verts[2].position = { 0.0f, 1.0f, 2.5f };
+	auto quantized = QuantizeVertices(verts);
+	CHECK_EQ(1.0f, quantized.dequantization.scale.z);
+	for (auto& v : DequantizeVertices(quantized))
+		CHECK_EQ(2.5f, v.position.z);
+}
+
+TEST(ErrorsAboveTheToleranceAreRejected)
+{
+	QuantizationTolerance tolerance;
+	QuantizationError error = {};
+	error.maxPosition = tolerance.position * 10.0f;
+	error.maxNormalDegrees = tolerance.normalDegrees;
+	error.maxTex = tolerance.tex;
+	//bounds are inclusive, the position one scales with the mesh
+	CHECK(AcceptQuantization(error, 10.0f, tolerance));
+	CHECK(!AcceptQuantization(error, 9.0f, tolerance));
+	error.maxNormalDegrees *= 1.5f;
+	CHECK(!AcceptQuantization(error, 10.0f, tolerance));
+	error.maxNormalDegrees = 0.0f;
+	error.maxTex *= 1.5f;
+	CHECK(!AcceptQuantization(error, 10.0f, tolerance));
+}
+
+TEST(TiledTextureCoordinatesAreRejected)
+{
+	//half floats lose too much precision far above 1, such meshes stay in the float layout
+	auto verts = LoadDuck();
+	for (auto& v : verts)
+	{
+		v.tex.x = v.tex.x * 40.0f + 3.0f;
+		v.tex.y *= 40.0f;
+	}
+	auto error = MeasureQuantizationError(verts, QuantizeVertices(verts));
+	CHECK(error.maxTex > QuantizationTolerance().tex);
+	CHECK(!AcceptQuantization(error, BoundingDiagonal(verts)));
+}